@@ -1,3 +1,4 @@
+#define _GNU_SOURCE // wcwidth
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -10,9 +11,30 @@
 #include <sys/types.h>
 #include <stdint.h>
 #include <time.h>
+#include <locale.h>
+#include <wchar.h>
 
 #include "ntfs.h"
 #include "hexEditor.h"
+#include "ntfsVolumen.h"
+#include "tablaMft.h"
+#include "ordenMft.h"
+#include "tiposArchivo.h"
+#include "fechas.h"
+#include "firmas.h"
+#include "tallado.h"
+#include "bitmapNtfs.h"
+#include "compresion.h"
+#include "extraer.h"
+#include "hashes.h"
+#include "exportar.h"
+#include "hashImagen.h"
+#include "lineaTiempo.h"
+#include "usnJrnl.h"
+#include "contadores.h"
+#include "residencia.h"
+#include "imagen.h"
+#include "ewf.h"
 
 #define MBR_PARTITION_TABLE_OFFSET 0x1BE // Donde empieza la tabla de particiones (4 entradas x 16 bytes)
 #define MBR_SIGNATURE_OFFSET       0x1FE // Donde está la firma 0x55AA
@@ -23,32 +45,33 @@
 #define PART_START_CHS_OFFSET      0x01
 #define PART_END_CHS_OFFSET        0x05
 
-int fd;
 long mapped_file_size = 0;
 
 
-char *mapFile(char *filePath) {
-    /* Abre archivo */
-    fd = open(filePath, O_RDONLY);
-    if (fd == -1) {
-        perror("Error abriendo el archivo");
-        return(NULL);
-    }
+Imagen imagen;
 
-    /* Mapea archivo */
-    struct stat st;
-    fstat(fd,&st);
-    long fs = st.st_size;
-    mapped_file_size = fs;
+// En el visor hex: en que segmento de una imagen partida o en que chunk de la E01 cae el offset
+static void ubicar_en_imagen(uint64_t off, char *buf, size_t n) {
+    imagen_ubicar(&imagen, off, buf, n);
+}
 
-    char *map = mmap(0, fs, PROT_READ, MAP_SHARED, fd, 0);
-    if (map == MAP_FAILED) {
-        close(fd);
-        perror("Error mapeando el archivo");
-        return(NULL);
+char *mapFile(char *filePath) {
+    /* Abre y mapea la imagen; una partida (.001, .002...) o una E01 quedan como un solo mapa contiguo */
+    if (abrir_imagen(filePath, &imagen) != 0) return(NULL);
+    mapped_file_size = (long)imagen.tamano;
+    if (imagen.ewf) {
+        hex_ubicar = ubicar_en_imagen;
+        unsigned char md5[LARGO_MD5];
+        char hex[2 * LARGO_MD5 + 1] = "(no guardado)";
+        if (ewf_md5(imagen.ewf, md5) == 0) hash_a_hex(md5, LARGO_MD5, hex);
+        fprintf(stderr, "%s: EWF, %d archivos, %llu bytes; MD5 de la adquisicion %s\n", filePath, imagen.n_seg,
+                (unsigned long long)imagen.tamano, hex);
+    } else if (imagen.n_seg > 1) {
+        hex_ubicar = ubicar_en_imagen;
+        fprintf(stderr, "%s: %d segmentos, %llu bytes\n", filePath, imagen.n_seg,
+                (unsigned long long)imagen.tamano);
     }
-
-    return map;
+    return (char *)imagen.map;
 }
 
 
@@ -129,7 +152,8 @@ void mostrar_particiones(char *map, int selected_partition_index) {
         }
     }
     mvprintw(10, 0, "Presiona 'q' para salir.");
-    mvprintw(11, 0, "Usa ARRIBA/ABAJO para seleccionar particion. Presiona ENTER para ver detalles.");
+    mvprintw(11, 0, "Usa ARRIBA/ABAJO para seleccionar particion. Presiona ENTER para ver detalles, 't' carving, 'T' carving de clusters libres,");
+    mvprintw(12, 0, "'h' hash de la particion, 'H' hash de la imagen entera.");
     refresh();
 }
 
@@ -180,60 +204,43 @@ void detalles_particion(unsigned char *mbr_data, int index) {
     mvprintw(10, 0, "End of sector marker (esperado 0xAA55): 0x%04X", end_marker);
     mvprintw(11, 0, "LBA de Inicio: %u (sector)", start_lba);
     mvprintw(12, 0, "Número de Sectores: %u", num_sectors);
-    mvprintw(14, 0, "Presiona cualquier tecla para volver...");
+
+    // Espacio usado/libre segun $Bitmap (solo NTFS)
+    VolumenNtfs vol;
+    BitmapNtfs bm;
+    if (abrir_volumen(mbr_data, mapped_file_size, lba_inicio, &vol) == 0 && leer_bitmap(&vol, &bm) == 0) {
+        uint64_t libres = bm.num_clusters - bm.usados;
+        mvprintw(13, 0, "Clusters: %llu de %u bytes | usados: %llu (%.1f%%, %.1f MB) | libres: %llu (%.1f MB)",
+                 (unsigned long long)bm.num_clusters, vol.tam_cluster,
+                 (unsigned long long)bm.usados, 100.0 * bm.usados / bm.num_clusters,
+                 bm.usados * (double)vol.tam_cluster / 1e6,
+                 (unsigned long long)libres, libres * (double)vol.tam_cluster / 1e6);
+        int64_t primer_libre = siguiente_libre(&bm, 0);
+        if (primer_libre >= 0) mvprintw(14, 0, "Primer cluster libre: %lld", (long long)primer_libre);
+        liberar_bitmap(&bm);
+    } else {
+        mvprintw(13, 0, "Espacio usado/libre: no disponible ($Bitmap ilegible o no es NTFS)");
+    }
+    cerrar_volumen(&vol);
+    mvprintw(16, 0, "Presiona cualquier tecla para volver...");
     refresh();
 
     getch(); // Espera a que el usuario presione una tecla
 }
 
-void determinar_tipo_archivo(const char *nombre, char *tipo) {
-    const char *ext = strrchr(nombre, '.');
-    if (!ext) {
-        strcpy(tipo, "Archivo");
-        return;
-    }
-    
-    ext++; // Saltar el punto
-    
-    if (strcasecmp(ext, "txt") == 0) strcpy(tipo, "Texto");
-    else if (strcasecmp(ext, "html") == 0 || strcasecmp(ext, "htm") == 0) strcpy(tipo, "HTML");
-    else if (strcasecmp(ext, "exe") == 0 || strcasecmp(ext, "dll") == 0) strcpy(tipo, "Ejecutable");
-    else if (strcasecmp(ext, "jpg") == 0 || strcasecmp(ext, "jpeg") == 0) strcpy(tipo, "Imagen JPEG");
-    else if (strcasecmp(ext, "png") == 0) strcpy(tipo, "Imagen PNG");
-    else if (strcasecmp(ext, "pdf") == 0) strcpy(tipo, "PDF");
-    else if (strcasecmp(ext, "doc") == 0 || strcasecmp(ext, "docx") == 0) strcpy(tipo, "Documento Word");
-    else if (strcasecmp(ext, "xls") == 0 || strcasecmp(ext, "xlsx") == 0) strcpy(tipo, "Hoja de cálculo");
-    else strcpy(tipo, "Archivo");
-}
-
-void filetime_to_str(LONGLONG ft, char *out, size_t out_sz) {
-    // 116444736000000000 = diferencia entre 1601 y 1970 en unidades de 100ns
-    if (ft == 0) {
-        strncpy(out, "(sin fecha)", out_sz);
-        out[out_sz-1] = '\0';
-        return;
-    }
-    uint64_t unix_time_sec = (uint64_t)((ft - 116444736000000000ULL) / 10000000ULL);
-    time_t t = (time_t)unix_time_sec;
-    struct tm tm;
-    gmtime_r(&t, &tm); // o localtime_r si prefieres hora local
-    strftime(out, out_sz, "%Y-%m-%d %H:%M:%S", &tm);
-}
-
-void descargar_archivo(unsigned char *map, off_t offset, size_t longitud, const char *nombre_original) {
-    char nombre_destino[256];
-    
+// Pide el nombre del archivo de destino y lo abre; NULL si se cancela o no se puede crear
+static FILE *pedir_destino(const char *nombre_original, char *nombre_destino, size_t sz) {
     mvprintw(LINES - 2, 0, "Guardar como (ESC para cancelar): ");
     echo();
     curs_set(1); // Con esto solo mostramos el cursos a la hora de escribir el nombre del archivo 
 
     
-    strncpy(nombre_destino, nombre_original, sizeof(nombre_destino) - 1);
-    nombre_destino[sizeof(nombre_destino) - 1] = '\0';
+    strncpy(nombre_destino, nombre_original, sz - 1);
+    nombre_destino[sz - 1] = '\0';
     
     
     move(LINES - 2, strlen("Guardar como (ESC para cancelar): "));
-    getnstr(nombre_destino, sizeof(nombre_destino) - 1);
+    getnstr(nombre_destino, (int)sz - 1);
 
     // Restaurar la configuración normal de ncurses
     noecho();
@@ -244,7 +251,7 @@ void descargar_archivo(unsigned char *map, off_t offset, size_t longitud, const
         mvprintw(LINES - 2, 0, "Descarga cancelada. Presiona cualquier tecla para continuar.");
         refresh();
         getch();
-        return;
+        return NULL;
     }
 
     // Aquí solo abrimos el archivo para escritura binaria
@@ -253,16 +260,16 @@ void descargar_archivo(unsigned char *map, off_t offset, size_t longitud, const
         mvprintw(LINES - 2, 0, "Error: No se pudo crear el archivo '%s'. Presiona cualquier tecla.", nombre_destino);
         refresh();
         getch();
-        return;
+        return NULL;
     }
+    return outfile;
+}
 
-    /* Escribir los datos desde el mapa de memoria al archivo
-    La magia está aquí: map + offset es el puntero al inicio de los datos.*/
-    size_t bytes_escritos = fwrite(map + offset, 1, longitud, outfile);
-    
-    //Cerramos el archivo
-    fclose(outfile); 
-    if (bytes_escritos == longitud) {
+static void informar_descarga(const char *nombre_destino, size_t bytes_escritos, size_t longitud, uint64_t huecos) {
+    if (bytes_escritos == longitud && huecos) {
+        mvprintw(LINES - 2, 0, "Archivo '%s' guardado con exito (%zu bytes, %llu como huecos dispersos). Presiona cualquier tecla.",
+                 nombre_destino, bytes_escritos, (unsigned long long)huecos);
+    } else if (bytes_escritos == longitud) {
         mvprintw(LINES - 2, 0, "Archivo '%s' guardado con exito (%zu bytes). Presiona cualquier tecla.", nombre_destino, bytes_escritos);
     } else {
         mvprintw(LINES - 2, 0, "Error al escribir en '%s'. Se escribieron %zu de %zu bytes. Presiona cualquier tecla.", nombre_destino, bytes_escritos, longitud);
@@ -271,198 +278,727 @@ void descargar_archivo(unsigned char *map, off_t offset, size_t longitud, const
     refresh();
     getch();
 }
+
+void descargar_archivo(unsigned char *map, off_t offset, size_t longitud, const char *nombre_original) {
+    char nombre_destino[256];
+    FILE *outfile = pedir_destino(nombre_original, nombre_destino, sizeof(nombre_destino));
+    if (!outfile) return;
+
+    /* Escribir los datos desde el mapa de memoria al archivo
+    La magia está aquí: map + offset es el puntero al inicio de los datos.*/
+    size_t bytes_escritos = escribir_mapa(map + offset, longitud, outfile);
+    
+    //Cerramos el archivo
+    fclose(outfile); 
+    informar_descarga(nombre_destino, bytes_escritos, longitud, 0);
+}
+
+// Descarga un flujo no residente siguiendo su runlist completo hasta 'tamano' bytes;
+// los tramos dispersos quedan como huecos en el archivo de salida
+static void descargar_tramos(const VolumenNtfs *vol, const Extent *ext, int n, uint64_t tamano,
+                             const char *nombre_original) {
+    char nombre_destino[256];
+    FILE *outfile = pedir_destino(nombre_original, nombre_destino, sizeof(nombre_destino));
+    if (!outfile) return;
+
+    uint64_t huecos;
+    MarcaFase m;
+    fase_empezar(&m);
+    uint64_t escritos = extraer_tramos(vol, ext, n, tamano, outfile, &huecos);
+    fase_terminar(&m, FASE_EXTRAER);
+    contar_bytes(escritos - huecos);
+    fclose(outfile);
+    informar_descarga(nombre_destino, (size_t)escritos, (size_t)tamano, huecos);
+}
+
+// Descarga un $DATA comprimido (LZNT1) ya descomprimido; las unidades se descomprimen en paralelo
+static void descargar_comprimido(const VolumenNtfs *vol, const Extent *ext, int n, uint64_t tamano,
+                                 int log2_unidad, const char *nombre_original) {
+    LectorComprimido lector;
+    if (lector_abrir(&lector, vol, ext, n, tamano, log2_unidad) != 0) {
+        mvprintw(LINES - 2, 0, "Sin memoria para descomprimir. Presiona cualquier tecla.");
+        refresh();
+        getch();
+        return;
+    }
+    char nombre_destino[256];
+    FILE *outfile = pedir_destino(nombre_original, nombre_destino, sizeof(nombre_destino));
+    if (outfile) {
+        mvprintw(LINES - 2, 0, "Descomprimiendo %llu bytes...", (unsigned long long)tamano);
+        refresh();
+        uint64_t huecos;
+        MarcaFase m;
+        fase_empezar(&m);
+        uint64_t escritos = extraer_comprimido(&lector, outfile, &huecos);
+        fase_terminar(&m, FASE_EXTRAER);
+        contar_bytes(escritos - huecos);
+        fclose(outfile);
+        informar_descarga(nombre_destino, (size_t)escritos, (size_t)tamano, huecos);
+    }
+    lector_cerrar(&lector);
+}
+
+static size_t leer_comprimido(void *ctx, uint64_t off, unsigned char *buf, size_t n) {
+    return lector_leer(ctx, off, buf, n);
+}
+
+// Visor hex sobre el contenido descomprimido; solo se descomprimen las unidades que se ven
+static void ver_comprimido(const VolumenNtfs *vol, const Extent *ext, int n, uint64_t tamano, int log2_unidad) {
+    LectorComprimido lector;
+    if (lector_abrir(&lector, vol, ext, n, tamano, log2_unidad) != 0) {
+        mvprintw(LINES - 2, 0, "Sin memoria para descomprimir. Presiona cualquier tecla.");
+        refresh();
+        getch();
+        return;
+    }
+    FuenteHex fuente = { leer_comprimido, NULL, &lector, tamano };
+    hex_viewer_fuente(&fuente, 0, tamano);
+    lector_cerrar(&lector);
+}
+
+static size_t leer_tramos(void *ctx, uint64_t off, unsigned char *buf, size_t n) {
+    return tramos_leer(ctx, off, buf, n);
+}
+
+static long long fisico_tramos(void *ctx, uint64_t off) {
+    return tramos_fisico(ctx, off);
+}
+
+// Visor hex sobre el archivo entero como si fuera contiguo, aunque este fragmentado
+static void ver_tramos(const VolumenNtfs *vol, const Extent *ext, int n, uint64_t tamano) {
+    LectorTramos lector;
+    tramos_abrir(&lector, vol, ext, n, tamano);
+    FuenteHex fuente = { leer_tramos, fisico_tramos, &lector, tamano };
+    hex_viewer_fuente(&fuente, 0, tamano);
+}
+
+// Un $DATA residente tal como lo copio escanear_mft() del registro ya corregido
+typedef struct {
+    const unsigned char *datos;
+    size_t largo;
+    long en_imagen;     // offset del valor en el mapa, -1 si el registro cruza tramos del $MFT
+} FuenteResidente;
+
+static size_t leer_residente(void *ctx, uint64_t off, unsigned char *buf, size_t n) {
+    const FuenteResidente *r = ctx;
+    if (off >= r->largo) return 0;
+    if (n > r->largo - off) n = r->largo - off;
+    memcpy(buf, r->datos + off, n);
+    return n;
+}
+
+static long long fisico_residente(void *ctx, uint64_t off) {
+    const FuenteResidente *r = ctx;
+    return r->en_imagen >= 0 ? r->en_imagen + (long long)off : -1;
+}
+
+// Visor hex de un $DATA residente: en el mapa los 2 ultimos bytes de cada sector del registro
+// son el numero de secuencia, asi que se muestra la copia con los fixups aplicados
+static void ver_residente(const unsigned char *datos, size_t largo, long en_imagen) {
+    FuenteResidente r = { datos, largo, en_imagen };
+    FuenteHex fuente = { leer_residente, fisico_residente, &r, largo };
+    hex_viewer_fuente(&fuente, 0, largo);
+}
+
+// Copia 's' (UTF-8) en 'out' ocupando exactamente 'ancho' columnas de la terminal:
+// corta sin partir caracteres, cambia lo no imprimible por '?' y rellena con espacios
+static void ajustar_ancho(const char *s, int ancho, char *out, size_t outsz) {
+    mbstate_t st;
+    memset(&st, 0, sizeof(st));
+    size_t o = 0;
+    int col = 0;
+    while (*s) {
+        wchar_t wc;
+        size_t n = mbrtowc(&wc, s, MB_CUR_MAX, &st);
+        int w = -1;
+        if (n != (size_t)-1 && n != (size_t)-2 && n != 0) w = wcwidth(wc);
+        if (w < 0) { // secuencia invalida (p.ej. sustituto suelto) o caracter de control
+            if (n == (size_t)-1 || n == (size_t)-2 || n == 0) n = 1;
+            memset(&st, 0, sizeof(st));
+            if (col + 1 > ancho || o + 1 >= outsz) break;
+            out[o++] = '?';
+            col++;
+            s += n;
+            continue;
+        }
+        if (col + w > ancho || o + n >= outsz) break;
+        memcpy(out + o, s, n);
+        o += n;
+        s += n;
+        col += w;
+    }
+    while (col < ancho && o + 1 < outsz) {
+        out[o++] = ' ';
+        col++;
+    }
+    out[o] = '\0';
+}
+
+// Estado del scroll virtual de la lista: solo se dibujan las filas visibles,
+// asi el costo por tecla no depende del numero de entradas.
+typedef struct {
+    size_t total; // filas en la lista
+    size_t top;   // primera fila visible
+    size_t sel;   // fila seleccionada
+    size_t rows;  // filas de pantalla disponibles
+} VistaLista;
+
+static void vista_ajustar(VistaLista *vl) {
+    if (vl->total == 0) {
+        vl->sel = vl->top = 0;
+        return;
+    }
+    if (vl->sel >= vl->total) vl->sel = vl->total - 1;
+    if (vl->sel < vl->top) vl->top = vl->sel;
+    if (vl->sel >= vl->top + vl->rows) vl->top = vl->sel - vl->rows + 1;
+}
+
+// Teclas de navegacion comunes. Devuelve 1 si la tecla fue de movimiento.
+static int vista_tecla(VistaLista *vl, int c) {
+    if (vl->total == 0) return 0;
+    switch (c) {
+        case KEY_UP:
+            vl->sel = (vl->sel > 0) ? vl->sel - 1 : vl->total - 1;
+            break;
+        case KEY_DOWN:
+            vl->sel = (vl->sel < vl->total - 1) ? vl->sel + 1 : 0;
+            break;
+        case KEY_PPAGE:
+            vl->sel = (vl->sel > vl->rows) ? vl->sel - vl->rows : 0;
+            vl->top = (vl->top > vl->rows) ? vl->top - vl->rows : 0;
+            break;
+        case KEY_NPAGE:
+            vl->sel += vl->rows;
+            vl->top += vl->rows;
+            if (vl->sel >= vl->total) vl->sel = vl->total - 1;
+            if (vl->top + vl->rows > vl->total) vl->top = (vl->total > vl->rows) ? vl->total - vl->rows : 0;
+            break;
+        case KEY_HOME:
+            vl->sel = vl->top = 0;
+            break;
+        case KEY_END:
+            vl->sel = vl->total - 1;
+            break;
+        default:
+            return 0;
+    }
+    vista_ajustar(vl);
+    return 1;
+}
+
+// Pide una linea de texto en la penultima fila de la pantalla
+static void pedir_texto(const char *prompt, char *buf, int bufsz) {
+    echo();
+    curs_set(1);
+    mvprintw(LINES - 2, 0, "%s", prompt);
+    clrtoeol();
+    getnstr(buf, bufsz - 1);
+    noecho();
+    curs_set(0);
+}
+
+// Pide un numero de fila y mueve la seleccion ahi (la fila queda arriba de la pantalla)
+static void vista_ir_a(VistaLista *vl) {
+    char input[32], prompt[64];
+    snprintf(prompt, sizeof(prompt), "Ir a fila (0-%zu): ", vl->total ? vl->total - 1 : 0);
+    pedir_texto(prompt, input, sizeof(input));
+    char *fin;
+    unsigned long long fila = strtoull(input, &fin, 0);
+    if (fin == input || vl->total == 0) return;
+    vl->sel = (fila < vl->total) ? fila : vl->total - 1;
+    vl->top = vl->sel;
+    if (vl->top + vl->rows > vl->total) vl->top = (vl->total > vl->rows) ? vl->total - vl->rows : 0;
+    vista_ajustar(vl);
+}
+
+// En la vista, los flujos alternativos van debajo de su archivo con este bit puesto
+#define VISTA_FLUJO 0x80000000u
+
+static size_t fila_de_vista(const TablaMft *tabla, uint32_t v) {
+    return (v & VISTA_FLUJO) ? tabla->flujo_fila[v & ~VISTA_FLUJO] : v;
+}
+
+// Inserta detras de cada fila sus flujos; se hace de atras hacia adelante en el mismo
+// arreglo, que tiene lugar para tabla->n + tabla->flujos_n entradas
+static size_t intercalar_flujos(const TablaMft *tabla, uint32_t *vista, size_t n) {
+    size_t total = n;
+    for (size_t i = 0; i < n; i++) total += tabla->flujo_cnt[vista[i]];
+    size_t w = total;
+    for (size_t i = n; i-- > 0;) {
+        uint32_t k = vista[i];
+        for (uint32_t c = tabla->flujo_cnt[k]; c-- > 0;) vista[--w] = VISTA_FLUJO | (tabla->flujo_ini[k] + c);
+        vista[--w] = k;
+    }
+    return total;
+}
+
+// Aplica filtro y orden a la tabla y deja el resultado en 'vista'
+static void rehacer_vista(const TablaMft *tabla, const FiltroMft *filtro, const ClaveOrden *claves, int nclaves,
+                          uint32_t *vista, VistaLista *vl) {
+    MarcaFase m;
+    fase_empezar(&m);
+    vl->total = filtrar_tabla(tabla, filtro, vista);
+    if (ordenar_vista(tabla, vista, vl->total, claves, nclaves) != 0) {
+        mvprintw(LINES - 2, 0, "Sin memoria para ordenar; se deja el orden del MFT. Presiona una tecla...");
+        getch();
+    }
+    vl->total = intercalar_flujos(tabla, vista, vl->total);
+    vl->sel = vl->top = 0;
+    fase_terminar(&m, FASE_ORDEN);
+}
+
+#define MAX_LINEAS_PANEL (NUM_FASES + 4) // cabecera, una por fase y los totales
+
+// Porcentaje del $MFT fuera de la cache de paginas antes o despues de escanearlo (panel 'e' y -S)
+static void anotar_frio(const VolumenNtfs *vol, int despues) {
+    if (!contadores.activos) return;
+    if (despues) {
+        contadores.frio_despues = frio_mft(vol);
+        contadores.frio_medido = 1;
+    } else {
+        contadores.frio_antes = frio_mft(vol);
+    }
+}
+
+// Barra de residencia de 'rangos' en hasta max_filas filas del ancho de la pantalla desde 'fila';
+// devuelve la fila siguiente
+static int dibujar_residencia(const VolumenNtfs *vol, const char *titulo, const RangoImagen *rangos, int n,
+                              int fila, int max_filas) {
+    int ancho = COLS > 2 ? COLS - 2 : 1, filas = max_filas > 0 ? max_filas : 1;
+    char *barra = malloc((size_t)ancho * (size_t)filas);
+    Residencia r;
+    int res = barra ? medir_residencia(vol->map, (uint64_t)vol->map_size, rangos, n, barra, ancho * filas, &r) : -2;
+    if (res != 0) {
+        mvprintw(fila, 0, "%s: %s", titulo, res == -2 ? "sin memoria" : "mincore fallo");
+        free(barra);
+        return fila + 2;
+    }
+    uint64_t bytes = 0;
+    for (int i = 0; i < n; i++) bytes += rangos[i].largo;
+    double celda = (double)bytes / (ancho * filas);
+    mvprintw(fila++, 0, "%s: %.1f MB, %.1f%% en cache (%llu de %llu paginas), cada celda %.0f KB", titulo,
+             bytes / 1e6, r.paginas ? 100.0 * r.en_cache / r.paginas : 0.0, (unsigned long long)r.en_cache,
+             (unsigned long long)r.paginas, celda / 1024);
+    for (int f = 0; f < filas; f++) mvprintw(fila++, 0, "|%.*s|", ancho, barra + (size_t)f * ancho);
+    free(barra);
+    return fila + 1;
+}
+
+// Que parte de la particion y del $MFT esta en la cache de paginas: si un escaneo o el visor se
+// traban por leer del disco, aca se ve si vale la pena precalentar
+static void mostrar_residencia(const VolumenNtfs *vol) {
+    int c;
+    do {
+        erase();
+        mvprintw(0, 0, "--- Cache de paginas (mincore) --- particion desde el byte %lld, paginas de %ld bytes",
+                 vol->base, sysconf(_SC_PAGESIZE));
+        mvprintw(2, 0, "Midiendo...");
+        refresh();
+        RangoImagen particion = { (uint64_t)vol->base, vol->num_clusters * vol->tam_cluster };
+        int n;
+        RangoImagen *mft = rangos_mft(vol, &n);
+        // compacta: hasta 8 filas para la particion y 4 para el $MFT
+        int libres = LINES - 8, filas_mft = libres / 3 < 1 ? 1 : libres / 3 > 4 ? 4 : libres / 3;
+        int filas_particion = libres - filas_mft < 1 ? 1 : libres - filas_mft > 8 ? 8 : libres - filas_mft;
+        int fila = dibujar_residencia(vol, "Particion", &particion, 1, 2, filas_particion);
+        if (mft) {
+            char titulo[64];
+            snprintf(titulo, sizeof(titulo), "$MFT (%d tramos)", n);
+            fila = dibujar_residencia(vol, titulo, mft, n, fila, filas_mft);
+            free(mft);
+        }
+        mvprintw(fila, 0, "'#' todo en cache  '+' mas de la mitad  '.' algo  ' ' nada");
+        mvprintw(LINES - 1, 0, "m=volver a medir  cualquier otra tecla=volver");
+        clrtoeol();
+        refresh();
+        c = getch();
+    } while (c == 'm' || c == 'M');
+}
+
 //Recorrer MFT y mostrar atributos
-// reemplaza tu recorrer_mft() por esto
 void recorrer_mft(unsigned char *map, unsigned int lba_inicio){
     clear();
     mvprintw(0, 0, "--- Entrada del MFT ---");
 
-    unsigned char *mft_base = map + (lba_inicio * 512);
-
-    unsigned short bytes_por_sector = *(unsigned short *)&mft_base[0x0B];
-    unsigned char sectores_por_cluster = mft_base[0x0D];
-    LONGLONG mft_cluster = *(LONGLONG *)&mft_base[0x30];
-    int tamaño_cluster = bytes_por_sector * sectores_por_cluster;
-    int entry_size = 1024;
-
     // Necesario: tamaño total del mapa (mapFile debe haberlo guardado en mapped_file_size)
     extern long mapped_file_size; // declarada arriba en tu fichero
 
-    // almacenaremos info de los archivos listados para poder abrir el hex viewer
-    #define MAX_ENTRIES 1024
-    long entry_data_offset[MAX_ENTRIES];
-    size_t entry_data_len[MAX_ENTRIES];
-    char entry_name[MAX_ENTRIES][64];
-    int entry_count = 0;
-
-    unsigned char *mft = map + (lba_inicio * 512) + (mft_cluster * tamaño_cluster);
-
-    // Primera pasada: recolectar entradas y metadatos
-    for (int i = 0; i < 150 && entry_count < MAX_ENTRIES; i++) {
-        struct NTFS_MFT_FILE *mft_file = (struct NTFS_MFT_FILE *)(mft + (i * entry_size));
-        if (memcmp(mft_file->szSignature, "FILE", 4) != 0) continue;
-
-        char nombre[256] = "(sin nombre)";
-        char tipo[16] = "Archivo";
-        char atributos[64] = "";
-        int tiene_nombre_valido = 0;
-        int es_directorio = 0;
-        uint64_t tamaño_real = 0;
-        char fecha_mod[20] = "(sin fecha)";
-
-        long found_data_offset = -1;
-        size_t found_data_len = 0;
-
-        NTFS_ATTRIBUTE *attr = (NTFS_ATTRIBUTE *)((char *)mft_file + mft_file->wAttribOffset);
-        while ((char *)attr < (char *)mft_file + mft_file->dwRecLength &&
-               attr->dwType != 0xFFFFFFFF) {
-
-            // Standard info (opcional)
-            if (attr->dwType == 0x10) {
-                if (attr->uchNonResFlag == 0) {
-                    ATTR_STANDARD *std_info = (ATTR_STANDARD *)((char *)attr + attr->Attr.Resident.wAttrOffset);
-                    uint32_t flags = std_info->dwFATAttributes;
-                    if (flags & 0x01) strcat(atributos, "RO ");
-                    if (flags & 0x02) strcat(atributos, "Oculto ");
-                    if (flags & 0x04) strcat(atributos, "Sistema ");
-                    if (flags & 0x20) strcat(atributos, "Archive ");
-                }
-            }
-            else if (attr->dwType == 0x30) { // File Name
-                if (attr->uchNonResFlag == 0) {
-                    ATTR_FILENAME *fn = (ATTR_FILENAME *)((char *)attr + attr->Attr.Resident.wAttrOffset);
-                    int len = fn->chFileNameLength;
-                    for (int j = 0; j < len && j < 255; j++) {
-                        nombre[j] = (fn->wFilename[j] < 128) ? fn->wFilename[j] : '?';
-                    }
-                    nombre[len] = '\0';
-                    tiene_nombre_valido = 1;
-
-                    if (fn->dwFlags & 0x10000000) es_directorio = 1;
-                    tamaño_real = fn->n64RealSize;
-                    // convertir fecha
-                    filetime_to_str(fn->n64Modify, fecha_mod, sizeof(fecha_mod));
-                }
-            }
-            else if (attr->dwType == 0x80) { // DATA attribute
-                if (attr->uchNonResFlag == 0) {
-                    // residente: data en el mismo atributo
-                    unsigned char *data_ptr = (unsigned char *)attr + attr->Attr.Resident.wAttrOffset;
-                    found_data_offset = data_ptr - map; // offset absoluto dentro del mmap
-                    found_data_len = attr->Attr.Resident.dwLength;
-                } else {
-                    // no-resident: parsear data runs y tomar el primer run como inicio
-                    unsigned char *datarun = (unsigned char *)attr + attr->Attr.NonResident.wDatarunOffset;
-                    // parse minimal: primer run
-                    long long prev_lcn = 0;
-                    int pos = 0;
-                    if (datarun[pos] != 0) {
-                        unsigned char header = datarun[pos++];
-                        int len_len = header & 0x0F;
-                        int off_len = (header >> 4) & 0x0F;
-                        // leer length (clusters)
-                        unsigned long long cluster_count = 0;
-                        for (int k = 0; k < len_len; k++) {
-                            cluster_count |= ((unsigned long long)datarun[pos++]) << (8 * k);
-                        }
-                        // leer offset (LCN) (signed)
-                        long long cluster_offset = 0;
-                        if (off_len > 0) {
-                            // little-endian signed
-                            unsigned long long tmp = 0;
-                            for (int k = 0; k < off_len; k++) {
-                                tmp |= ((unsigned long long)datarun[pos++]) << (8 * k);
-                            }
-                            // sign extend
-                            unsigned long long signbit = 1ULL << (off_len*8 - 1);
-                            if (tmp & signbit) {
-                                // negativo
-                                unsigned long long mask = (~0ULL) << (off_len*8);
-                                tmp |= mask;
-                            }
-                            cluster_offset = (long long)tmp;
-                        }
-                        prev_lcn += cluster_offset;
-                        // Calcular offset absoluta: LBA de partición + prev_lcn * sectors_per_cluster
-                        long long abs_sector = (long long)lba_inicio + (prev_lcn * (long long)sectores_por_cluster);
-                        long long abs_byte_offset = abs_sector * (long long)bytes_por_sector;
-                        // longitud en bytes aproximada:
-                        size_t approx_bytes = (size_t)cluster_count * (size_t)tamaño_cluster;
-
-                        // verificar límites y asignar
-                        if (abs_byte_offset >= 0 && abs_byte_offset < mapped_file_size) {
-                            found_data_offset = abs_byte_offset;
-                            found_data_len = approx_bytes;
-                        }
-                    }
-                }
-            }
+    MarcaFase m;
+    fase_empezar(&m);
+    VolumenNtfs vol;
+    if (abrir_volumen(map, mapped_file_size, lba_inicio, &vol) != 0) {
+        mvprintw(2, 0, "La particion no parece NTFS (boot sector o registro $MFT invalido). Presiona cualquier tecla...");
+        refresh();
+        getch();
+        cerrar_volumen(&vol);
+        return;
+    }
 
-            attr = (NTFS_ATTRIBUTE *)((char *)attr + attr->dwFullLength);
-        }
+    mvprintw(2, 0, "Escaneando %llu registros del MFT...", (unsigned long long)vol.num_registros);
+    refresh();
 
-        if (tiene_nombre_valido || nombre[0] == '$') {
-            // almacenar para interfaz
-            strncpy(entry_name[entry_count], nombre, 63);
-            entry_name[entry_count][63] = '\0';
-            entry_data_offset[entry_count] = found_data_offset;
-            entry_data_len[entry_count] = found_data_len;
-            entry_count++;
-        }
+    // almacenaremos info de los archivos listados para poder abrir el hex viewer
+    // $Bitmap para saber que parte de cada archivo borrado sigue libre; si no se puede leer
+    // los borrados se listan igual, sin porcentaje
+    BitmapNtfs bm;
+    int hay_bitmap = leer_bitmap(&vol, &bm) == 0;
+    fase_terminar(&m, FASE_VOLUMEN);
+
+    TablaMft tabla;
+    anotar_frio(&vol, 0);
+    fase_empezar(&m);
+    int error_escaneo = escanear_mft(&vol, hay_bitmap ? &bm : NULL, &tabla);
+    fase_terminar(&m, FASE_ESCANEO);
+    anotar_frio(&vol, 1);
+    if (hay_bitmap) liberar_bitmap(&bm);
+    if (error_escaneo != 0) {
+        mvprintw(3, 0, "Sin memoria para la tabla del MFT. Presiona cualquier tecla...");
+        refresh();
+        getch();
+        tabla_liberar(&tabla);
+        cerrar_volumen(&vol);
+        return;
     }
 
+    // vista = indices de la tabla que pasan el filtro, en el orden elegido
+    uint32_t *vista = malloc((tabla.n + tabla.flujos_n + 1) * sizeof(uint32_t));
+    if (!vista) {
+        mvprintw(3, 0, "Sin memoria para la lista. Presiona cualquier tecla...");
+        refresh();
+        getch();
+        tabla_liberar(&tabla);
+        cerrar_volumen(&vol);
+        return;
+    }
+    FiltroMft filtro = { 0 };
+    ClaveOrden claves[MAX_CLAVES_ORDEN] = { { CAMPO_REGISTRO, 0 } };
+    int nclaves = 1;
+    char texto_orden[128] = "registro", texto_filtro[128] = "";
+    char texto_contenido[128] = "";
+    if (contadores.frio_antes >= 0 && contadores.frio_despues >= 0)
+        snprintf(texto_contenido, sizeof(texto_contenido),
+                 "$MFT fuera de la cache de paginas: %.1f%% antes del escaneo, %.1f%% despues (m = mapa de la cache)",
+                 contadores.frio_antes, contadores.frio_despues);
+    int hora_local = 0, ver_contadores = 0;
+    fechas_iniciar(hora_local);
+
     // Interfaz interactiva: mover selección con flechas y Enter para ver hex
-    int sel = 0;
+    int start_row = 2;
+    VistaLista vl = { 0, 0, 0, 1 };
+    rehacer_vista(&tabla, &filtro, claves, nclaves, vista, &vl);
     int c;
     do {
-        clear();
-        mvprintw(0, 0, "--- Entrada del MFT (Selecciona con flechas y ENTER para ver hex) ---");
-        int start_row = 2;
-        int rows = LINES - 4;
-        int base = 0;
-        // paginación básica: si sel fuera de ventana, ajustamos base
-        if (sel >= base + rows) base = sel - rows + 1;
-        if (sel < base) base = sel;
-
-        for (int i = 0; i < rows && (base + i) < entry_count; i++) {
-            int idx = base + i;
-            if (idx == sel) attron(A_REVERSE);
-            char display_name[30];
-            strncpy(display_name, entry_name[idx], 28);
-            display_name[28] = '\0';
-            mvprintw(start_row + i, 0, "%3d | %-28s | off: %-10lx | len: %-8zu", idx, display_name, (unsigned long)entry_data_offset[idx], entry_data_len[idx]);
-            if (idx == sel) attroff(A_REVERSE);
+        // con hashes calculados quedan dos lineas mas abajo para los de la fila elegida
+        int abajo = tabla.hashes ? 7 : 5;
+        // el panel de contadores va justo encima y le quita filas a la lista, hasta la mitad
+        char panel[MAX_LINEAS_PANEL][256];
+        int lineas_panel = 0;
+        while (ver_contadores && lineas_panel < MAX_LINEAS_PANEL && lineas_panel < LINES / 2 &&
+               contadores_linea(lineas_panel, panel[lineas_panel], sizeof(panel[0])))
+            lineas_panel++;
+        int fila_panel = LINES - abajo + 2 - lineas_panel;
+        abajo += lineas_panel;
+        vl.rows = (LINES > abajo) ? (size_t)(LINES - abajo) : 1;
+        vista_ajustar(&vl);
+
+        fase_empezar(&m);
+        erase(); // a diferencia de clear() no fuerza a repintar toda la terminal
+        mvprintw(0, 0, "--- Entrada del MFT --- fila %zu de %zu | orden: %s | filtro: %s | hora: %s",
+                 vl.total ? vl.sel + 1 : 0, vl.total, texto_orden, texto_filtro[0] ? texto_filtro : "(ninguno)",
+                 hora_local ? "local" : "UTC");
+        mvprintw(1, 0, "%8s |   %-28s | %-15s | %4s | %12s | %-19s | %-15s | %s",
+                 "Registro", "Nombre", "Tipo", "Rec", "Tamano", "Modificado", "Offset", "Longitud");
+
+        // las fechas quedan en la tabla como FILETIME y solo se formatean las filas visibles
+
+        for (size_t i = 0; i < vl.rows && vl.top + i < vl.total; i++) {
+            uint32_t entrada = vista[vl.top + i];
+            size_t idx = fila_de_vista(&tabla, entrada);
+            char linea[512], visible[sizeof(linea)];
+            char col_fecha[FECHA_LARGO + 1];
+            filetime_to_str(tabla.modificado[idx], col_fecha, sizeof(col_fecha));
+            if (vl.top + i == vl.sel) attron(A_REVERSE);
+            if (entrada & VISTA_FLUJO) {
+                // flujo alternativo: "  :nombre" debajo de su archivo
+                size_t f = entrada & ~VISTA_FLUJO;
+                char nombre[600], col_nombre[28 * 4 + 1];
+                snprintf(nombre, sizeof(nombre), "  :%s", flujo_nombre(&tabla, f));
+                ajustar_ancho(nombre, 28, col_nombre, sizeof(col_nombre));
+                snprintf(linea, sizeof(linea), "%8u |   %s | %-15s | %4s | %12llu | %-19s | off: %-10lx | len: %-8zu",
+                         tabla.registro[idx], col_nombre, "Flujo alterno", "",
+                         (unsigned long long)tabla.flujo_tamano[f], col_fecha,
+                         (unsigned long)tabla.flujo_off[f], tabla.flujo_len[f]);
+                ajustar_ancho(linea, COLS, visible, sizeof(visible));
+                mvaddstr(start_row + (int)i, 0, visible);
+                if (vl.top + i == vl.sel) attroff(A_REVERSE);
+                continue;
+            }
+            char col_nombre[28 * 4 + 1], col_tipo[15 * 4 + 1];
+            ajustar_ancho(tabla_nombre(&tabla, idx), 28, col_nombre, sizeof(col_nombre));
+            ajustar_ancho(nombre_tipo(tabla.tipo[idx]), 15, col_tipo, sizeof(col_tipo));
+            // 'B' = borrado, '!' = la extension no cuadra con el contenido;
+            // Rec = % de los clusters de un borrado que siguen libres
+            char col_rec[8] = "";
+            if ((tabla.marcas[idx] & MARCA_BORRADO) && tabla.recuperable[idx] != RECUPERABLE_NS)
+                snprintf(col_rec, sizeof(col_rec), "%3u%%", tabla.recuperable[idx]);
+            else if (tabla.marcas[idx] & MARCA_BORRADO)
+                strcpy(col_rec, "?");
+            snprintf(linea, sizeof(linea), "%8u | %c%c%s | %s | %4s | %12llu | %-19s | off: %-10lx | len: %-8zu",
+                     tabla.registro[idx], (tabla.marcas[idx] & MARCA_BORRADO) ? 'B' : ' ',
+                     (tabla.marcas[idx] & MARCA_DISCORDANTE) ? '!' : ' ', col_nombre, col_tipo, col_rec,
+                     (unsigned long long)tabla.tamano[idx], col_fecha,
+                     (unsigned long)tabla.data_off[idx], tabla.data_len[idx]);
+            // recortada al ancho de la terminal para que no se envuelva sobre la fila siguiente
+            ajustar_ancho(linea, COLS, visible, sizeof(visible));
+            mvaddstr(start_row + (int)i, 0, visible);
+            if (vl.top + i == vl.sel) attroff(A_REVERSE);
         }
 
-        mvprintw(LINES - 1, 0, "q=volver  UP/DOWN=mover  ENTER=abrir hex (si se conoce offset)  d/D=descargar archivo");
+        for (int i = 0; i < lineas_panel; i++) mvprintw(fila_panel + i, 0, "%s", panel[i]);
+        if (texto_contenido[0]) mvprintw(LINES - 3, 0, "%s", texto_contenido);
+        if (tabla.hashes && vl.total > 0) {
+            size_t idx = fila_de_vista(&tabla, vista[vl.sel]);
+            if ((tabla.marcas[idx] & MARCA_HASH) && !(vista[vl.sel] & VISTA_FLUJO)) {
+                char md5[2 * LARGO_MD5 + 1], sha1[2 * LARGO_SHA1 + 1], sha256[2 * LARGO_SHA256 + 1];
+                hash_a_hex(hash_md5(&tabla, idx), LARGO_MD5, md5);
+                hash_a_hex(hash_sha1(&tabla, idx), LARGO_SHA1, sha1);
+                hash_a_hex(hash_sha256(&tabla, idx), LARGO_SHA256, sha256);
+                mvprintw(LINES - 5, 0, "MD5: %s   SHA-1: %s", md5, sha1);
+                mvprintw(LINES - 4, 0, "SHA-256: %s", sha256);
+            } else {
+                mvprintw(LINES - 5, 0, "(sin hashes: directorio, flujo o datos ilegibles)");
+            }
+        }
+        if (vl.total > 0) {
+            // fila seleccionada con precision completa (100 ns)
+            char creado[FECHA_LARGO_PREC + 1], modificado[FECHA_LARGO_PREC + 1];
+            size_t idx = fila_de_vista(&tabla, vista[vl.sel]);
+            filetime_to_str_prec(tabla.creado[idx], 7, creado, sizeof(creado));
+            filetime_to_str_prec(tabla.modificado[idx], 7, modificado, sizeof(modificado));
+            mvprintw(LINES - 2, 0, "Creado: %s   Modificado: %s", creado, modificado);
+            if (tabla.contenido[idx] != TIPO_ARCHIVO) printw("   Contenido: %s", nombre_tipo(tabla.contenido[idx]));
+            if ((tabla.marcas[idx] & MARCA_BORRADO) && tabla.recuperable[idx] != RECUPERABLE_NS)
+                printw("   Borrado, %u%% de sus clusters siguen libres", tabla.recuperable[idx]);
+            if (vista[vl.sel] & VISTA_FLUJO) {
+                size_t f = vista[vl.sel] & ~VISTA_FLUJO;
+                printw("   Flujo %s:%s, %u tramos", tabla_nombre(&tabla, idx), flujo_nombre(&tabla, f),
+                       tabla.flujo_tramo_n[f]);
+            } else if (tabla.flujo_cnt[idx]) {
+                printw("   %u flujos alternativos", tabla.flujo_cnt[idx]);
+            }
+            if (!(vista[vl.sel] & VISTA_FLUJO) && tabla.compresion[idx])
+                printw("   Comprimido (LZNT1, unidades de %u clusters)", 1u << tabla.compresion[idx]);
+            clrtoeol();
+        }
+        mvprintw(LINES - 1, 0, "q=volver  flechas/PGUP/PGDN/HOME/END=mover  g=ir a fila  o=ordenar  f=filtrar  b=borrados  c=contenido  h=hashes  a=actualizar  u=UTC/local  e=estadisticas  m=cache  ENTER=abrir hex  r=hex crudo  d/D=descargar");
         clrtoeol();
+        fase_terminar(&m, FASE_FORMATO);
+        fase_empezar(&m);
         refresh();
+        fase_terminar(&m, FASE_PANTALLA);
 
         c = getch();
-        switch (c) {
-            case KEY_UP:
-                sel = (sel > 0) ? sel - 1 : entry_count - 1;
+        if (vista_tecla(&vl, c)) continue;
+        if (c == 'o' || c == 'O') {
+            char input[16];
+            ClaveOrden nuevas[MAX_CLAVES_ORDEN];
+            pedir_texto("Ordenar por (r=registro n=nombre t=tamano c=creado m=modificado y=tipo, MAYUS=desc, ej. Tn): ",
+                        input, sizeof(input));
+            int n = parsear_orden(input, nuevas);
+            if (n > 0) {
+                memcpy(claves, nuevas, sizeof(nuevas));
+                nclaves = n;
+                describir_orden(claves, nclaves, texto_orden, sizeof(texto_orden));
+                rehacer_vista(&tabla, &filtro, claves, nclaves, vista, &vl);
+            }
+            continue;
+        }
+        if (c == 'f' || c == 'F') {
+            char input[128];
+            FiltroMft nuevo;
+            pedir_texto("Filtro (tipo=pdf,imagen tam=1K-20M attr=+H-S discordantes borrados|vivos flujos; vacio=quitar): ", input, sizeof(input));
+            if (parsear_filtro(input, &nuevo) == 0) {
+                filtro = nuevo;
+                strcpy(texto_filtro, input);
+                rehacer_vista(&tabla, &filtro, claves, nclaves, vista, &vl);
+            } else {
+                mvprintw(LINES - 2, 0, "Filtro no valido: %s. Presiona una tecla...", input);
+                clrtoeol();
+                getch();
+            }
+            continue;
+        }
+        if (c == 'c' || c == 'C') {
+            EstadisticaContenido est;
+            mvprintw(LINES - 2, 0, "Leyendo el principio de cada archivo...");
+            clrtoeol();
+            refresh();
+            fase_empezar(&m);
+            int r = analizar_contenido(&vol, &tabla, &est);
+            fase_terminar(&m, FASE_CONTENIDO);
+            if (r != 0) {
+                snprintf(texto_contenido, sizeof(texto_contenido), "Sin memoria para analizar el contenido");
+            } else {
+                contar_bytes(est.bytes);
+                snprintf(texto_contenido, sizeof(texto_contenido),
+                         "Contenido: %zu archivos en %.2f s (%.0f archivos/s, %.1f MB), %zu reconocidos, %zu discordantes (!)",
+                         est.archivos, est.segundos, est.segundos > 0 ? est.archivos / est.segundos : 0.0,
+                         est.bytes / 1e6, est.reconocidos, est.discordantes);
+            }
+            rehacer_vista(&tabla, &filtro, claves, nclaves, vista, &vl); // por si se filtra por discordantes
+            continue;
+        }
+        if (c == 'h' || c == 'H') {
+            EstadisticaHash est;
+            mvprintw(LINES - 2, 0, "Calculando MD5, SHA-1 y SHA-256 de cada archivo...");
+            clrtoeol();
+            refresh();
+            fase_empezar(&m);
+            int r = calcular_hashes(&vol, &tabla, &est);
+            fase_terminar(&m, FASE_HASHES);
+            if (r != 0) {
+                snprintf(texto_contenido, sizeof(texto_contenido), "Sin memoria para calcular los hashes");
+            } else {
+                contar_bytes(est.bytes);
+                snprintf(texto_contenido, sizeof(texto_contenido),
+                         "Hashes: %zu archivos, %.1f MB en %.2f s (%.1f MB/s, %d hilos)",
+                         est.archivos, est.bytes / 1e6, est.segundos,
+                         est.segundos > 0 ? est.bytes / 1e6 / est.segundos : 0.0, est.hilos);
+            }
+            continue;
+        }
+        if (c == 'b' || c == 'B') {
+            // atajo al modo de borrados (otra 'b' vuelve a la lista completa)
+            const char *nuevo = strcmp(texto_filtro, "borrados") == 0 ? "" : "borrados";
+            parsear_filtro(nuevo, &filtro);
+            strcpy(texto_filtro, nuevo);
+            rehacer_vista(&tabla, &filtro, claves, nclaves, vista, &vl);
+            continue;
+        }
+        if (c == 'a' || c == 'A') {
+            // la imagen cambio debajo del mapa (adquisicion en vivo, disco de una VM): solo se
+            // vuelven a interpretar los trozos del $MFT que cambiaron
+            mvprintw(LINES - 2, 0, "Releyendo el $MFT...");
+            clrtoeol();
+            refresh();
+            fase_empezar(&m);
+            VolumenNtfs nuevo;
+            if (abrir_volumen(map, mapped_file_size, lba_inicio, &nuevo) != 0) {
+                cerrar_volumen(&nuevo);
+                fase_terminar(&m, FASE_VOLUMEN);
+                snprintf(texto_contenido, sizeof(texto_contenido), "La particion ya no parece NTFS; no se actualizo");
+                continue;
+            }
+            cerrar_volumen(&vol);
+            vol = nuevo;
+            uint32_t registro_sel = vl.total ? tabla.registro[fila_de_vista(&tabla, vista[vl.sel])] : 0;
+            hay_bitmap = leer_bitmap(&vol, &bm) == 0;
+            fase_terminar(&m, FASE_VOLUMEN);
+            EstadisticaReescaneo est;
+            anotar_frio(&vol, 0);
+            fase_empezar(&m);
+            int error_reescaneo = reescanear_mft(&vol, hay_bitmap ? &bm : NULL, &tabla, &est);
+            fase_terminar(&m, FASE_REESCANEO);
+            anotar_frio(&vol, 1);
+            if (hay_bitmap) liberar_bitmap(&bm);
+            uint32_t *nueva_vista = error_reescaneo ? NULL : realloc(vista, (tabla.n + tabla.flujos_n + 1) * sizeof(uint32_t));
+            if (!nueva_vista) {
+                mvprintw(LINES - 2, 0, "Sin memoria para actualizar la tabla del MFT. Presiona cualquier tecla...");
+                clrtoeol();
+                getch();
                 break;
-            case KEY_DOWN:
-                sel = (sel < entry_count - 1) ? sel + 1 : 0;
+            }
+            vista = nueva_vista;
+            rehacer_vista(&tabla, &filtro, claves, nclaves, vista, &vl);
+            for (size_t i = 0; i < vl.total; i++) {
+                if (!(vista[i] & VISTA_FLUJO) && tabla.registro[vista[i]] == registro_sel) {
+                    vl.sel = i;
+                    break;
+                }
+            }
+            snprintf(texto_contenido, sizeof(texto_contenido),
+                     "Actualizado: %zu de %zu trozos cambiados, %zu registros releidos, %zu filas por %zu, %.3f s%s",
+                     est.trozos_cambiados, est.trozos, est.registros, est.filas_nuevas, est.filas_quitadas,
+                     est.segundos, est.completo ? " (escaneo completo)" : "");
+            continue;
+        }
+        if (c == 'u' || c == 'U') {
+            hora_local = !hora_local;
+            fechas_iniciar(hora_local);
+            continue;
+        }
+        if (c == 'e' || c == 'E') {
+            ver_contadores = !ver_contadores;
+            continue;
+        }
+        if (c == 'm' || c == 'M') {
+            mostrar_residencia(&vol);
+            continue;
+        }
+        if (vl.total == 0) continue;
+        size_t sel = fila_de_vista(&tabla, vista[vl.sel]);
+        // datos de la entrada elegida: el $DATA principal o el flujo alternativo
+        long sel_off = tabla.data_off[sel];
+        size_t sel_len = tabla.data_len[sel];
+        const unsigned char *sel_res = tabla_residente(&tabla, sel);
+        uint64_t sel_tam = tabla.tamano[sel];
+        const Extent *sel_ext = tabla.tramos + tabla.tramo_ini[sel];
+        int sel_n = (int)tabla.tramo_n[sel];
+        int sel_comp = tabla.compresion[sel];
+        char sel_nombre[600];
+        snprintf(sel_nombre, sizeof(sel_nombre), "%s", tabla_nombre(&tabla, sel));
+        if (vista[vl.sel] & VISTA_FLUJO) {
+            size_t f = vista[vl.sel] & ~VISTA_FLUJO;
+            sel_off = tabla.flujo_off[f];
+            sel_len = tabla.flujo_len[f];
+            sel_res = flujo_residente(&tabla, f);
+            sel_tam = tabla.flujo_tamano[f];
+            sel_ext = tabla.flujo_tramos + tabla.flujo_tramo_ini[f];
+            sel_n = (int)tabla.flujo_tramo_n[f];
+            sel_comp = tabla.flujo_compresion[f];
+            snprintf(sel_nombre, sizeof(sel_nombre), "%s_%s", tabla_nombre(&tabla, sel), flujo_nombre(&tabla, f));
+        }
+        switch (c) {
+            case 'g':
+            case 'G':
+                vista_ir_a(&vl);
                 break;
             case 10: // ENTER
-                if (entry_data_offset[sel] >= 0) {
+                if (sel_comp && sel_n > 0) {
+                    ver_comprimido(&vol, sel_ext, sel_n, sel_tam, sel_comp);
+                } else if (sel_n > 0) {
+                    ver_tramos(&vol, sel_ext, sel_n, sel_tam);
+                } else if (sel_res) {
+                    ver_residente(sel_res, sel_len, sel_off);
+                } else if (sel_off >= 0) {
                     // llamar al visor hex con map y offset
-                    size_t view_len = entry_data_len[sel];
-                    if (view_len == 0) view_len = 0; // 0 -> hasta el final (hex viewer lo interpreta)
-                    hex_viewer_from_map(map, mapped_file_size, (off_t)entry_data_offset[sel], view_len);
+                    hex_viewer_from_map(map, mapped_file_size, (off_t)sel_off, sel_len);
                 } else {
                     mvprintw(LINES - 2, 0, "No se pudo determinar offset de datos para este archivo (posiblemente contenido residente en MFT o atributo inexistente). Presiona cualquier tecla...");
                     getch();
                 }
                 break;
+            case 'r':
+            case 'R': // bytes crudos de la imagen desde el primer tramo, sin seguir el runlist
+                if (sel_off >= 0) {
+                    hex_viewer_from_map(map, mapped_file_size, (off_t)sel_off, sel_len);
+                } else {
+                    mvprintw(LINES - 2, 0, "No se pudo determinar offset de datos para este archivo. Presiona cualquier tecla...");
+                    getch();
+                }
+                break;
             case 'd':
-            case 'D': // Descargar el archivo seleccionado
-                if (entry_data_offset[sel] >= 0 && entry_data_len[sel] > 0) {
-                        // Llamamos a nuestra nueva función con los datos del archivo seleccionado
-                    descargar_archivo(map, (off_t)entry_data_offset[sel], entry_data_len[sel], entry_name[sel]);
-                        // La pantalla se redibujará automáticamente al continuar el bucle
+            case 'D': // Descargar el archivo (o flujo) seleccionado
+                if (sel_comp && sel_n > 0) {
+                    descargar_comprimido(&vol, sel_ext, sel_n, sel_tam, sel_comp, sel_nombre);
+                } else if (sel_n > 0) {
+                    // no residente: todo el runlist, no solo el primer tramo
+                    descargar_tramos(&vol, sel_ext, sel_n, sel_tam, sel_nombre);
+                } else if (sel_res && sel_len > 0) {
+                    // residente: la copia con los fixups, no los bytes del mapa
+                    descargar_archivo((unsigned char *)sel_res, 0, sel_len, sel_nombre);
+                } else if (sel_off >= 0 && sel_len > 0) {
+                    descargar_archivo(map, (off_t)sel_off, sel_len, sel_nombre);
                 } else {
                     mvprintw(LINES - 2, 0, "No se puede descargar: offset o tamaño de datos no disponible. Presiona una tecla...");
                     getch();
@@ -474,25 +1010,493 @@ void recorrer_mft(unsigned char *map, unsigned int lba_inicio){
 
     } while (c != 'q' && c != 'Q');
 
+    free(vista);
+    tabla_liberar(&tabla);
+    cerrar_volumen(&vol);
+
     mvprintw(LINES - 1, 0, "Presione cualquier tecla para volver...");
     refresh();
     getch();
 }
 
 
+// Carving: busca archivos por sus firmas en la particion, tengan o no entrada en el MFT.
+// Con solo_libres se miran solo los clusters que $Bitmap marca como libres.
+void tallar_particion(unsigned char *map, int index, int solo_libres) {
+    unsigned char *p_entry = get_partition_entry_ptr(map, index);
+    uint64_t inicio = (uint64_t)*(unsigned int *)&p_entry[PART_START_LBA_OFFSET] * 512;
+    uint64_t largo = (uint64_t)*(unsigned int *)&p_entry[PART_NUM_SECTORS_OFFSET] * 512;
+    if (inicio >= (uint64_t)mapped_file_size) {
+        mvprintw(12, 0, "La particion queda fuera de la imagen. Presiona una tecla...");
+        getch();
+        return;
+    }
+    if (inicio + largo > (uint64_t)mapped_file_size) largo = mapped_file_size - inicio;
+
+    // en NTFS los archivos empiezan en un cluster; si no, se mira cada sector
+    VolumenNtfs vol;
+    BitmapNtfs bm = { 0 };
+    uint32_t alineacion = 512;
+    if (abrir_volumen(map, mapped_file_size, (unsigned int)(inicio / 512), &vol) == 0) {
+        alineacion = vol.tam_cluster;
+        if (solo_libres && leer_bitmap(&vol, &bm) == 0) {
+            // no mirar mas alla del ultimo cluster que describe el bitmap
+            if (largo > bm.num_clusters * alineacion) largo = bm.num_clusters * alineacion;
+        }
+    }
+    cerrar_volumen(&vol);
+    if (solo_libres && !bm.bits) {
+        mvprintw(12, 0, "No se pudo leer $Bitmap: carving solo de clusters libres no disponible. Presiona una tecla...");
+        getch();
+        return;
+    }
+
+    clear();
+    mvprintw(0, 0, "--- Carving de la particion %d ---", index + 1);
+    mvprintw(2, 0, "Buscando JPEG, PNG, PDF, ZIP/Office y SQLite cada %u bytes en %.1f MB%s...", alineacion, largo / 1e6,
+             solo_libres ? " (solo clusters libres)" : "");
+    refresh();
+
+    ResultadoTallado res;
+    int error = tallar(map, inicio, largo, alineacion, bm.bits, &res);
+    liberar_bitmap(&bm);
+    if (error != 0) {
+        mvprintw(3, 0, "Sin memoria para el carving. Presiona una tecla...");
+        getch();
+        return;
+    }
+
+    VistaLista vl = { res.n, 0, 0, 1 };
+    int c;
+    do {
+        vl.rows = (LINES > 4) ? (size_t)(LINES - 4) : 1;
+        vista_ajustar(&vl);
+        erase();
+        mvprintw(0, 0, "--- Carving particion %d%s --- %zu hallazgos | %.1f MB en %.2f s (%.0f MB/s, %d hilos)",
+                 index + 1, solo_libres ? " (libres)" : "", res.n, res.bytes / 1e6, res.segundos,
+                 res.segundos > 0 ? res.bytes / 1e6 / res.segundos : 0.0, res.hilos);
+        mvprintw(1, 0, "%6s | %-14s | %12s | %-15s | %s", "#", "Offset", "Tamano", "Tipo", "Fin");
+        for (size_t i = 0; i < vl.rows && vl.top + i < vl.total; i++) {
+            const Hallazgo *h = &res.v[vl.top + i];
+            char col_tipo[15 * 4 + 1];
+            ajustar_ancho(nombre_tipo(h->tipo), 15, col_tipo, sizeof(col_tipo));
+            if (vl.top + i == vl.sel) attron(A_REVERSE);
+            mvprintw(2 + (int)i, 0, "%6zu | 0x%-12llx | %12llu | %s | %s", vl.top + i,
+                     (unsigned long long)h->offset, (unsigned long long)h->largo, col_tipo,
+                     h->completo ? "pie encontrado" : "sin pie (cortado al maximo)");
+            if (vl.top + i == vl.sel) attroff(A_REVERSE);
+        }
+        mvprintw(LINES - 1, 0, "q=volver  flechas/PGUP/PGDN/HOME/END=mover  g=ir a fila  ENTER=abrir hex  d/D=descargar");
+        clrtoeol();
+        refresh();
+
+        c = getch();
+        if (vista_tecla(&vl, c) || vl.total == 0) continue;
+        const Hallazgo *h = &res.v[vl.sel];
+        char nombre[64];
+        switch (c) {
+            case 'g':
+            case 'G':
+                vista_ir_a(&vl);
+                break;
+            case 10: // ENTER
+                hex_viewer_from_map(map, mapped_file_size, (off_t)h->offset, (size_t)h->largo);
+                break;
+            case 'd':
+            case 'D':
+                snprintf(nombre, sizeof(nombre), "tallado_%llx.%s", (unsigned long long)h->offset,
+                         extension_tallado(h->tipo));
+                descargar_archivo(map, (off_t)h->offset, (size_t)h->largo, nombre);
+                break;
+            default:
+                break;
+        }
+    } while (c != 'q' && c != 'Q');
+
+    liberar_tallado(&res);
+}
+
+
+// Lo que se pide exportar sin pantalla; NULL = no se escribe
+typedef struct {
+    const char *csv;        // tabla completa
+    const char *linea;      // linea de tiempo CSV ordenada
+    const char *body;       // bodyfile para mactime
+    const char *usn;        // registros de $UsnJrnl:$J
+    int con_hashes;
+    size_t presupuesto;     // memoria para ordenar la linea de tiempo
+} SalidasExportar;
+
+// "-" = salida estandar
+static FILE *abrir_salida(const char *ruta) {
+    if (strcmp(ruta, "-") == 0) return stdout;
+    FILE *out = fopen(ruta, "w");
+    if (!out) perror(ruta);
+    return out;
+}
+
+static int cerrar_salida(FILE *out, const char *ruta, int res) {
+    if (out != stdout) res |= fclose(out) != 0 ? -1 : 0;
+    else res |= fflush(out) != 0 ? -1 : 0;
+    if (res != 0) fprintf(stderr, "Error al escribir %s\n", ruta);
+    return res;
+}
+
+// Sin pantalla: escanea el MFT de la particion (0..3, -1 = la primera que no este vacia) y
+// escribe las salidas pedidas, con hashes si se piden
+static int exportar_particion(unsigned char *map, int particion, const SalidasExportar *sal) {
+    if (particion < 0) {
+        for (int i = 0; i < 4 && particion < 0; i++) {
+            if (*(unsigned int *)&get_partition_entry_ptr(map, i)[PART_NUM_SECTORS_OFFSET] != 0) particion = i;
+        }
+        if (particion < 0) {
+            fprintf(stderr, "La tabla de particiones esta vacia\n");
+            return -1;
+        }
+    }
+    const unsigned char *p_entry = get_partition_entry_ptr(map, particion);
+    if (*(unsigned int *)&p_entry[PART_NUM_SECTORS_OFFSET] == 0) {
+        fprintf(stderr, "Particion %d esta VACIA\n", particion + 1);
+        return -1;
+    }
+    MarcaFase m;
+    fase_empezar(&m);
+    VolumenNtfs vol;
+    if (abrir_volumen(map, mapped_file_size, *(unsigned int *)&p_entry[PART_START_LBA_OFFSET], &vol) != 0) {
+        fprintf(stderr, "La particion %d no parece NTFS\n", particion + 1);
+        cerrar_volumen(&vol);
+        return -1;
+    }
+    BitmapNtfs bm;
+    int hay_bitmap = leer_bitmap(&vol, &bm) == 0;
+    fase_terminar(&m, FASE_VOLUMEN);
+    TablaMft tabla;
+    anotar_frio(&vol, 0);
+    fase_empezar(&m);
+    int res = escanear_mft(&vol, hay_bitmap ? &bm : NULL, &tabla);
+    fase_terminar(&m, FASE_ESCANEO);
+    anotar_frio(&vol, 1);
+    if (hay_bitmap) liberar_bitmap(&bm);
+    if (res != 0) {
+        fprintf(stderr, "Sin memoria para la tabla del MFT\n");
+    } else if (sal->con_hashes) {
+        EstadisticaHash est;
+        fase_empezar(&m);
+        res = calcular_hashes(&vol, &tabla, &est);
+        fase_terminar(&m, FASE_HASHES);
+        if (res != 0) {
+            fprintf(stderr, "Sin memoria para calcular los hashes\n");
+        } else {
+            contar_bytes(est.bytes);
+            fprintf(stderr, "Hashes: %zu archivos, %.1f MB en %.2f s (%.1f MB/s, %d hilos)\n",
+                    est.archivos, est.bytes / 1e6, est.segundos,
+                    est.segundos > 0 ? est.bytes / 1e6 / est.segundos : 0.0, est.hilos);
+        }
+    }
+    fechas_iniciar(0); // siempre UTC
+    // las cuatro salidas cuentan juntas como exportar
+    fase_empezar(&m);
+    FILE *out;
+    if (res == 0 && sal->csv) {
+        if (!(out = abrir_salida(sal->csv))) res = -1;
+        else if ((res = cerrar_salida(out, sal->csv, exportar_csv(&tabla, out))) == 0)
+            fprintf(stderr, "%zu entradas exportadas a %s\n", tabla.n, sal->csv);
+    }
+    if (res == 0 && sal->linea) {
+        EstadisticaLinea est;
+        if (!(out = abrir_salida(sal->linea))) {
+            res = -1;
+        } else {
+            int r = exportar_linea_tiempo(&tabla, out, sal->presupuesto, &est);
+            if (r == -1) fprintf(stderr, "Sin memoria para la linea de tiempo\n");
+            if ((res = cerrar_salida(out, sal->linea, r)) == 0)
+                fprintf(stderr, "Linea de tiempo: %llu fechas en %llu lineas, %zu tandas, %.2f s -> %s\n",
+                        (unsigned long long)est.eventos, (unsigned long long)est.lineas, est.tandas,
+                        est.segundos, sal->linea);
+        }
+    }
+    if (res == 0 && sal->body) {
+        if (!(out = abrir_salida(sal->body))) res = -1;
+        else if ((res = cerrar_salida(out, sal->body, exportar_bodyfile(&tabla, out))) == 0)
+            fprintf(stderr, "bodyfile de %zu entradas en %s\n", tabla.n, sal->body);
+    }
+    if (res == 0 && sal->usn) {
+        long flujo = buscar_usn_jrnl(&tabla);
+        EstadisticaUsn est;
+        if (flujo < 0) {
+            fprintf(stderr, "No se encontro $Extend\\$UsnJrnl:$J (journal desactivado?)\n");
+            res = -1;
+        } else if (tabla.flujo_compresion[flujo]) {
+            fprintf(stderr, "$UsnJrnl:$J esta comprimido; no se interpreta\n");
+            res = -1;
+        } else if (!(out = abrir_salida(sal->usn))) {
+            res = -1;
+        } else {
+            int r = exportar_usn(&vol, &tabla, (size_t)flujo, out, &est);
+            if (r == -1) fprintf(stderr, "Sin memoria para leer el journal\n");
+            contar_bytes(est.bytes_datos);
+            if ((res = cerrar_salida(out, sal->usn, r)) == 0)
+                fprintf(stderr, "$UsnJrnl: %llu registros (%llu V3) en %.1f MB leidos, %.1f MB dispersos sin leer, "
+                        "%llu posiciones invalidas, %.2f s (%.0f MB/s) -> %s\n",
+                        (unsigned long long)est.registros, (unsigned long long)est.v3, est.bytes_datos / 1e6,
+                        est.bytes_dispersos / 1e6, (unsigned long long)est.invalidos, est.segundos,
+                        est.segundos > 0 ? est.bytes_datos / 1e6 / est.segundos : 0.0, sal->usn);
+        }
+    }
+    fase_terminar(&m, FASE_EXPORTAR);
+    tabla_liberar(&tabla);
+    cerrar_volumen(&vol);
+    return res;
+}
+
+// Bytes de la particion (0..3) dentro de la imagen, recortados al tamano del archivo;
+// particion -1 = la imagen entera. Devuelve 0 o -1 si esta vacia o fuera de la imagen.
+static int rango_particion(unsigned char *map, int particion, uint64_t *inicio, uint64_t *largo) {
+    if (particion < 0) {
+        *inicio = 0;
+        *largo = (uint64_t)mapped_file_size;
+        return 0;
+    }
+    const unsigned char *p_entry = get_partition_entry_ptr(map, particion);
+    uint64_t lba = *(unsigned int *)&p_entry[PART_START_LBA_OFFSET];
+    uint64_t sectores = *(unsigned int *)&p_entry[PART_NUM_SECTORS_OFFSET];
+    if (sectores == 0 || lba * 512 >= (uint64_t)mapped_file_size) return -1;
+    *inicio = lba * 512;
+    *largo = sectores * 512;
+    if (*largo > (uint64_t)mapped_file_size - *inicio) *largo = (uint64_t)mapped_file_size - *inicio;
+    return 0;
+}
+
+typedef struct {
+    double inicio;
+    int ultimo;     // ultimo porcentaje mostrado
+    int pantalla;   // 1 = linea de estado de ncurses, 0 = stderr
+} AvanceHash;
+
+static double segundos_ahora(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void mostrar_avance(void *ctx, uint64_t hecho, uint64_t total) {
+    AvanceHash *a = ctx;
+    int pct = total ? (int)(hecho * 100 / total) : 100;
+    if (pct == a->ultimo) return;
+    a->ultimo = pct;
+    double t = segundos_ahora() - a->inicio;
+    double mbs = t > 0 ? hecho / 1e6 / t : 0.0;
+    if (a->pantalla) {
+        mvprintw(LINES - 1, 0, "Hasheando: %3d%%  %.0f de %.0f MB  (%.0f MB/s)", pct, hecho / 1e6, total / 1e6, mbs);
+        clrtoeol();
+        refresh();
+    } else {
+        fprintf(stderr, "\rHasheando: %3d%%  %.0f de %.0f MB  (%.0f MB/s)", pct, hecho / 1e6, total / 1e6, mbs);
+        if (hecho == total) fputc('\n', stderr);
+    }
+}
+
+// Menu de particiones: hash lineal de la particion (o de la imagen) con el avance abajo
+static void hashear_particion(unsigned char *map, int particion) {
+    uint64_t inicio, largo;
+    clear();
+    if (rango_particion(map, particion, &inicio, &largo) != 0) {
+        mvprintw(2, 0, "Particion %d esta VACIA o fuera de la imagen. Presiona cualquier tecla...", particion + 1);
+        getch();
+        return;
+    }
+    if (particion < 0) mvprintw(2, 0, "--- Hash de la imagen entera (%llu bytes) ---", (unsigned long long)largo);
+    else mvprintw(2, 0, "--- Hash de la particion %d (%llu bytes desde el byte %llu) ---", particion + 1,
+                  (unsigned long long)largo, (unsigned long long)inicio);
+    refresh();
+    AvanceHash av = { segundos_ahora(), -1, 1 };
+    HashImagen h;
+    MarcaFase m;
+    fase_empezar(&m);
+    int r = hashear_imagen(map, inicio, largo, TROZO_IMAGEN, 0, &h, mostrar_avance, &av);
+    fase_terminar(&m, FASE_HASH_IMAGEN);
+    if (r != 0) {
+        mvprintw(4, 0, "Sin memoria para hashear. Presiona cualquier tecla...");
+        getch();
+        return;
+    }
+    contar_bytes(largo);
+    char md5[2 * LARGO_MD5 + 1], sha256[2 * LARGO_SHA256 + 1];
+    hash_a_hex(h.md5, LARGO_MD5, md5);
+    hash_a_hex(h.sha256, LARGO_SHA256, sha256);
+    mvprintw(4, 0, "MD5:     %s", md5);
+    mvprintw(5, 0, "SHA-256: %s", sha256);
+    mvprintw(7, 0, "%.2f s (%.0f MB/s, %d hilos)", h.segundos, h.segundos > 0 ? largo / 1e6 / h.segundos : 0.0, h.hilos);
+    mvprintw(LINES - 1, 0, "Presiona cualquier tecla para volver...");
+    clrtoeol();
+    liberar_hash_imagen(&h);
+    getch();
+}
+
+// Sin pantalla: hash lineal (y por trozos si hace falta el arbol o el mapa) a la salida estandar
+static int hashear_sin_pantalla(unsigned char *map, int particion, uint32_t tam_trozo, int con_arbol,
+                                const char *salida_mapa) {
+    uint64_t inicio, largo;
+    if (rango_particion(map, particion, &inicio, &largo) != 0) {
+        fprintf(stderr, "Particion %d esta VACIA o fuera de la imagen\n", particion + 1);
+        return -1;
+    }
+    AvanceHash av = { segundos_ahora(), -1, 0 };
+    HashImagen h;
+    MarcaFase m;
+    fase_empezar(&m);
+    int r = hashear_imagen(map, inicio, largo, tam_trozo, con_arbol || salida_mapa, &h, mostrar_avance, &av);
+    fase_terminar(&m, FASE_HASH_IMAGEN);
+    if (r != 0) {
+        fprintf(stderr, "Sin memoria para hashear\n");
+        return -1;
+    }
+    contar_bytes(largo);
+    char hex[2 * LARGO_SHA256 + 1];
+    hash_a_hex(h.md5, LARGO_MD5, hex);
+    printf("md5     %s\n", hex);
+    hash_a_hex(h.sha256, LARGO_SHA256, hex);
+    printf("sha256  %s\n", hex);
+    if (con_arbol) {
+        hash_a_hex(h.arbol, LARGO_SHA256, hex);
+        printf("arbol   %s  (SHA-256 de los SHA-256 de %zu trozos de %u bytes)\n", hex, h.n_trozos, h.tam_trozo);
+    }
+    fprintf(stderr, "%llu bytes en %.2f s (%.0f MB/s, %d hilos)\n", (unsigned long long)largo, h.segundos,
+            h.segundos > 0 ? largo / 1e6 / h.segundos : 0.0, h.hilos);
+    int res = 0;
+    if (salida_mapa) {
+        FILE *out = fopen(salida_mapa, "w");
+        if (!out) {
+            perror(salida_mapa);
+            res = -1;
+        } else {
+            res = guardar_mapa_hashes(&h, out);
+            if (fclose(out) != 0) res = -1;
+            if (res != 0) fprintf(stderr, "Error al escribir %s\n", salida_mapa);
+        }
+    }
+    liberar_hash_imagen(&h);
+    return res;
+}
+
+#define MAX_MALOS_MOSTRADOS 64
+
+// Sin pantalla: vuelve a hashear los trozos del mapa dentro de [desde, hasta) y lista los que cambiaron
+static int verificar_sin_pantalla(unsigned char *map, const char *entrada_mapa, uint64_t desde, uint64_t hasta) {
+    FILE *in = fopen(entrada_mapa, "r");
+    if (!in) {
+        perror(entrada_mapa);
+        return -1;
+    }
+    HashImagen mapa;
+    int r = cargar_mapa_hashes(in, &mapa);
+    fclose(in);
+    if (r != 0) {
+        fprintf(stderr, r == -2 ? "Sin memoria para el mapa\n" : "%s no es un mapa de hashes valido\n", entrada_mapa);
+        return -1;
+    }
+    AvanceHash av = { segundos_ahora(), -1, 0 };
+    size_t malos[MAX_MALOS_MOSTRADOS], revisados;
+    MarcaFase m;
+    fase_empezar(&m);
+    long n = verificar_mapa((unsigned char *)map, (uint64_t)mapped_file_size, &mapa, desde, hasta, malos,
+                            MAX_MALOS_MOSTRADOS, &revisados, mostrar_avance, &av);
+    fase_terminar(&m, FASE_HASH_IMAGEN);
+    contar_bytes((uint64_t)revisados * mapa.tam_trozo);
+    for (long i = 0; i < n && i < MAX_MALOS_MOSTRADOS; i++) {
+        uint64_t off = mapa.inicio + (uint64_t)malos[i] * mapa.tam_trozo;
+        printf("distinto: trozo %zu (bytes %llu-%llu)\n", malos[i], (unsigned long long)off,
+               (unsigned long long)(off + mapa.tam_trozo < mapa.inicio + mapa.largo ? off + mapa.tam_trozo
+                                                                                    : mapa.inicio + mapa.largo));
+    }
+    if (n > MAX_MALOS_MOSTRADOS) printf("... y %ld trozos distintos mas\n", n - MAX_MALOS_MOSTRADOS);
+    printf("%zu trozos revisados, %ld distintos: %s\n", revisados, n, n == 0 ? "VERIFICADO" : "NO COINCIDE");
+    liberar_hash_imagen(&mapa);
+    return n == 0 ? 0 : -1;
+}
 
 int main(int argc, char const *argv[])
 {
     int particion_seleccionada = 1;
-    if(argc != 2){
-        printf("se usa %s \n", argv[0]);
+    const char *salida_mapa = NULL, *entrada_mapa = NULL;
+    SalidasExportar sal = { NULL, NULL, NULL, NULL, 0, PRESUPUESTO_LINEA };
+    int particion_csv = -1, hash_imagen = 0, con_arbol = 0, estadisticas = 0, opt, uso = 0;
+    uint64_t tam_trozo = TROZO_IMAGEN, desde = 0, hasta = UINT64_MAX, presupuesto;
+    const char *fin;
+    while ((opt = getopt(argc, (char *const *)argv, "e:t:b:u:M:p:HiTm:c:V:r:S")) != -1) {
+        switch (opt) {
+            case 'e': sal.csv = optarg; break;
+            case 't': sal.linea = optarg; break;
+            case 'b': sal.body = optarg; break;
+            case 'u': sal.usn = optarg; break;
+            case 'M':
+                uso |= parsear_tamano(optarg, &fin, &presupuesto) != 0 || *fin || presupuesto == 0;
+                sal.presupuesto = (size_t)presupuesto;
+                break;
+            case 'p': particion_csv = atoi(optarg) - 1; uso |= particion_csv < 0 || particion_csv > 3; break;
+            case 'H': sal.con_hashes = 1; break;
+            case 'i': hash_imagen = 1; break;
+            case 'T': con_arbol = 1; break;
+            case 'm': salida_mapa = optarg; break;
+            case 'c':
+                uso |= parsear_tamano(optarg, &fin, &tam_trozo) != 0 || *fin || tam_trozo == 0 || tam_trozo > (1u << 30);
+                break;
+            case 'V': entrada_mapa = optarg; break;
+            case 'S': estadisticas = 1; break;
+            case 'r': // desde-hasta, cualquiera de los dos puede faltar
+                if (*optarg != '-') uso |= parsear_tamano(optarg, &fin, &desde) != 0;
+                else fin = optarg;
+                if (*fin++ != '-') uso = 1;
+                else if (*fin) uso |= parsear_tamano(fin, &fin, &hasta) != 0 || *fin;
+                break;
+            default: uso = 1; break; // opcion desconocida: mostrar el uso
+        }
+    }
+    if(uso || optind != argc - 1){
+        printf("se usa %s [-e tabla.csv] [-t linea.csv [-M memoria]] [-b bodyfile] [-u usn.csv] [-p particion 1-4] [-H] [-S] imagen\n"
+               "       %s -i [-p particion] [-T] [-m mapa.txt] [-c tam_trozo] [-S] imagen\n"
+               "       %s -V mapa.txt [-r desde-hasta] [-S] imagen\n"
+               "  -S  al terminar, tiempo y fallos de pagina por fase y contadores del escaneo (stderr)\n",
+               argv[0], argv[0], argv[0]);
         return (-1);
     }
-    char *map = mapFile((char *)argv[1]);
+    // extensiones propias (opcional): lineas "extension Nombre del tipo"
+    int linea_error = 0;
+    int res_tipos = cargar_tipos_config("tipos.conf", &linea_error);
+    if (res_tipos == -2) {
+        fprintf(stderr, "tipos.conf: linea %d no valida (se espera \"extension Nombre del tipo\")\n", linea_error);
+        return -1;
+    } else if (res_tipos == -3) {
+        fprintf(stderr, "tipos.conf: demasiados tipos o extensiones\n");
+        return -1;
+    }
+    char *map = mapFile((char *)argv[optind]);
     if (map == NULL) {
         return -1; // Error al mapear el archivo
     }
+    if (entrada_mapa || hash_imagen || sal.csv || sal.linea || sal.body || sal.usn) {
+        // sin -S las marcas de fase no cuestan nada
+        contadores.activos = estadisticas;
+        int res = entrada_mapa ? verificar_sin_pantalla((unsigned char *)map, entrada_mapa, desde, hasta)
+                : hash_imagen ? hashear_sin_pantalla((unsigned char *)map, particion_csv, (uint32_t)tam_trozo,
+                                                     con_arbol, salida_mapa)
+                : exportar_particion((unsigned char *)map, particion_csv, &sal);
+        if (estadisticas) {
+            contadores_imprimir(stderr);
+            if (imagen.ewf) {
+                EstadisticaEwf est;
+                ewf_estadisticas(imagen.ewf, &est);
+                fprintf(stderr, "E01: %llu fallos de pagina atendidos, %llu chunks descomprimidos, %llu desde la cache, "
+                        "%llu adelantados, %llu ilegibles\n", (unsigned long long)est.fallos,
+                        (unsigned long long)est.inflados, (unsigned long long)est.aciertos,
+                        (unsigned long long)est.adelantados, (unsigned long long)est.ilegibles);
+            }
+        }
+        return res == 0 ? 0 : 1;
+    }
+    contadores.activos = 1; // para el panel 'e' de la lista del MFT
     int c;
+    setlocale(LC_ALL, ""); // nombres UTF-8 en pantalla (requiere ncursesw)
     initscr();
     raw();
     noecho(); /* No muestres el caracter leido */
@@ -507,6 +1511,24 @@ int main(int argc, char const *argv[])
             case KEY_DOWN:
                 particion_seleccionada = (particion_seleccionada < 3) ? particion_seleccionada + 1 : 0;
                 break;
+            case 'h':
+                if (*(unsigned int *)&get_partition_entry_ptr((unsigned char *)map, particion_seleccionada)[PART_NUM_SECTORS_OFFSET] == 0) {
+                    mvprintw(12, 0, "Particion %d esta VACIA.", particion_seleccionada + 1);
+                } else {
+                    hashear_particion((unsigned char *)map, particion_seleccionada);
+                }
+                break;
+            case 'H':
+                hashear_particion((unsigned char *)map, -1);
+                break;
+            case 't':
+            case 'T': // 'T': solo los clusters libres
+                if (*(unsigned int *)&get_partition_entry_ptr((unsigned char *)map, particion_seleccionada)[PART_NUM_SECTORS_OFFSET] == 0) {
+                    mvprintw(12, 0, "Particion %d esta VACIA.", particion_seleccionada + 1);
+                } else {
+                    tallar_particion((unsigned char *)map, particion_seleccionada, c == 'T');
+                }
+                break;
             case 10: // Enter
                 const unsigned char *p_entry = get_partition_entry_ptr((unsigned char *)map, particion_seleccionada);
                 if(*(unsigned int *)&p_entry[PART_NUM_SECTORS_OFFSET] == 0) {
@@ -526,4 +1548,4 @@ int main(int argc, char const *argv[])
     endwin(); /* Termina ncurses */
     return 0;
 
-}
\ No newline at end of file
+}
\ No newline at end of file
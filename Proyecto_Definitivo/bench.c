@@ -0,0 +1,430 @@
+// bench.c
+//
+// Mide los caminos calientes sobre una imagen (normalmente una de generarImagen.c) y reporta
+// mediana y percentiles de cada uno. Se compila y se corre con "make bench"; a mano:
+//
+//     ./bench_pv [-r repeticiones] [-c commit] [-o resultados.csv] imagen
+//
+// Cada prueba corre una vez para calentar (cache de paginas, malloc) y despues 'repeticiones'
+// veces; el resumen va a stderr y una linea CSV por prueba se agrega a resultados.csv (o sale por
+// stdout), con el commit para comparar entre versiones.
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+#include "ntfsVolumen.h"
+#include "tablaMft.h"
+#include "bitmapNtfs.h"
+#include "runlist.h"
+#include "utf16.h"
+#include "extraer.h"
+#include "compresion.h"
+#include "tallado.h"
+#include "hexEditor.h"
+#include "imagen.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_REPETICIONES    101
+#define VUELTAS_PARTICIONES 2000             // aperturas por repeticion
+#define BYTES_HEX           (32u << 20)      // bytes formateados como lineas de dump
+#define BYTES_EXTRACCION    (256ull << 20)   // tope de bytes extraidos por repeticion
+#define BYTES_COMPRIMIDOS   (64ull << 20)
+
+typedef struct {
+    Imagen img;                     // la misma apertura que el visor (tambien imagenes partidas)
+    unsigned char *map;
+    long map_size;
+    unsigned int lba;               // primera particion NTFS
+    VolumenNtfs v;
+    BitmapNtfs bm;
+    TablaMft t;                     // escaneo hecho al preparar (para reescaneo y extraccion)
+
+    // runlists crudos de los $DATA no residentes, uno detras de otro
+    unsigned char *runs;
+    size_t runs_len;
+    uint32_t *run_off, *run_fin;
+    uint64_t *run_vcn;
+    size_t runs_n;
+
+    // nombres de $FILE_NAME en UTF-16 tal como estan en el disco
+    uint16_t *nombres;
+    uint32_t *nombre_off;
+    uint8_t *nombre_len;
+    size_t nombres_n, nombres_unidades;
+
+    FILE *sumidero;                 // salida de las extracciones (ver abrir_sumidero())
+    uint64_t sumidero_pos, sumidero_suma;
+} Banco;
+
+typedef struct {
+    const char *nombre;
+    const char *unidad;
+    double escala;                          // divisor de la cantidad por segundo
+    double (*correr)(Banco *b);             // devuelve la cantidad procesada (0 = no aplica)
+} Prueba;
+
+static double ahora_seg(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Salida que recorre cada byte escrito (como lo haria una copia) sin ir al disco: /dev/null no
+// lee el buffer y mediria solo el runlist. Acepta fseeko() para los huecos.
+static ssize_t sumidero_escribir(void *ctx, const char *buf, size_t n) {
+    Banco *b = ctx;
+    uint64_t s = b->sumidero_suma, w;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        memcpy(&w, buf + i, 8);
+        s ^= w;
+    }
+    for (; i < n; i++) s ^= (unsigned char)buf[i];
+    b->sumidero_suma = s;
+    b->sumidero_pos += n;
+    return (ssize_t)n;
+}
+
+static int sumidero_mover(void *ctx, off64_t *pos, int desde) {
+    Banco *b = ctx;
+    int64_t base = desde == SEEK_SET ? 0 : (int64_t)b->sumidero_pos;
+    if (base + *pos < 0) return -1;
+    b->sumidero_pos = (uint64_t)(base + *pos);
+    *pos = (off64_t)b->sumidero_pos;
+    return 0;
+}
+
+static FILE *abrir_sumidero(Banco *b) {
+    cookie_io_functions_t f = { NULL, sumidero_escribir, sumidero_mover, NULL };
+    return fopencookie(b, "w", f);
+}
+
+// --- pruebas ---
+
+// Tabla de particiones y boot sector + registro 0 de cada NTFS
+static double correr_particiones(Banco *b) {
+    uint64_t abiertas = 0;
+    for (int k = 0; k < VUELTAS_PARTICIONES; k++) {
+        for (int i = 0; i < 4; i++) {
+            const unsigned char *e = b->map + 0x1BE + i * 16;
+            unsigned int lba, sectores;
+            memcpy(&lba, e + 8, 4);
+            memcpy(&sectores, e + 12, 4);
+            if (sectores == 0 || (e[4] != 0x07 && e[4] != 0x17)) continue;
+            VolumenNtfs v;
+            if (abrir_volumen(b->map, b->map_size, lba, &v) != 0) continue;
+            cerrar_volumen(&v);
+            abiertas++;
+        }
+    }
+    return (double)abiertas;
+}
+
+static double correr_escaneo(Banco *b) {
+    TablaMft t;
+    if (escanear_mft(&b->v, &b->bm, &t) != 0) return 0;
+    tabla_liberar(&t);
+    return (double)b->v.num_registros;
+}
+
+// Sin cambios en la imagen: sumar todos los trozos y no reinterpretar ninguno
+static double correr_reescaneo(Banco *b) {
+    EstadisticaReescaneo est;
+    if (reescanear_mft(&b->v, &b->bm, &b->t, &est) != 0) return 0;
+    return (double)b->v.num_registros;
+}
+
+static double correr_runlist(Banco *b) {
+    Extent *ext = NULL;
+    int n = 0, cap = 0;
+    uint64_t tramos = 0;
+    for (size_t i = 0; i < b->runs_n; i++) {
+        n = 0;
+        int k = decodificar_runlist(b->runs + b->run_off[i], b->runs + b->run_fin[i], b->run_vcn[i], &ext, &n, &cap);
+        if (k > 0) tramos += (uint64_t)k;
+    }
+    free(ext);
+    return tramos ? (double)b->runs_n : 0;
+}
+
+static size_t leer_mapa(void *ctx, uint64_t off, unsigned char *buf, size_t n) {
+    Banco *b = ctx;
+    if (off >= (uint64_t)b->map_size) return 0;
+    if (n > (uint64_t)b->map_size - off) n = (size_t)((uint64_t)b->map_size - off);
+    memcpy(buf, b->map + off, n);
+    return n;
+}
+
+static double correr_hex(Banco *b) {
+    FuenteHex f = { leer_mapa, NULL, b, (uint64_t)b->map_size };
+    char linea[128];
+    long desde = (long)b->v.base, hasta = desde + BYTES_HEX;
+    if (hasta > b->map_size) hasta = b->map_size;
+    size_t total = 0;
+    for (long off = desde; off < hasta; off += 16) {
+        make_line(&f, off, linea, sizeof(linea));
+        total += (unsigned char)linea[9]; // que no se descarte
+    }
+    return total ? (double)((hasta - desde) / 16) : 0;
+}
+
+static double nombres_con(Banco *b, size_t (*convertir)(const uint16_t *, size_t, char *)) {
+    char out[UTF8_MAX_BYTES(255) + 1];
+    size_t bytes = 0;
+    for (size_t i = 0; i < b->nombres_n; i++) bytes += convertir(b->nombres + b->nombre_off[i], b->nombre_len[i], out);
+    return bytes ? (double)b->nombres_n : 0;
+}
+
+static double correr_nombres(Banco *b) {
+    return nombres_con(b, utf16le_a_utf8);
+}
+
+static double correr_nombres_escalar(Banco *b) {
+    return nombres_con(b, utf16le_a_utf8_escalar);
+}
+
+// Archivos en uso, en el orden de la tabla, hasta juntar el tope. Los huecos de los dispersos no
+// cuentan: no se leen.
+static double correr_extraccion(Banco *b) {
+    uint64_t bytes = 0, huecos;
+    for (size_t k = 0; k < b->t.n && bytes < BYTES_EXTRACCION; k++) {
+        if ((b->t.marcas[k] & MARCA_BORRADO) || b->t.compresion[k] || !b->t.tramo_n[k]) continue;
+        const Extent *ext = b->t.tramos + b->t.tramo_ini[k];
+        bytes += extraer_tramos(&b->v, ext, (int)b->t.tramo_n[k], b->t.tamano[k], b->sumidero, &huecos);
+        bytes -= huecos;
+    }
+    return (double)bytes;
+}
+
+static double correr_extraccion_lznt1(Banco *b) {
+    uint64_t bytes = 0, huecos;
+    for (size_t k = 0; k < b->t.n && bytes < BYTES_COMPRIMIDOS; k++) {
+        if ((b->t.marcas[k] & MARCA_BORRADO) || !b->t.compresion[k] || !b->t.tramo_n[k]) continue;
+        LectorComprimido l;
+        if (lector_abrir(&l, &b->v, b->t.tramos + b->t.tramo_ini[k], (int)b->t.tramo_n[k], b->t.tamano[k],
+                         b->t.compresion[k]) != 0) continue;
+        bytes += extraer_comprimido(&l, b->sumidero, &huecos);
+        bytes -= huecos;
+        lector_cerrar(&l);
+    }
+    return (double)bytes;
+}
+
+// Busqueda de firmas (carving) en toda la particion, un bloque por cluster
+static double correr_tallado(Banco *b) {
+    uint64_t inicio = (uint64_t)b->v.base, largo = b->v.num_clusters * b->v.tam_cluster;
+    if (inicio + largo > (uint64_t)b->map_size) largo = (uint64_t)b->map_size - inicio;
+    ResultadoTallado r;
+    if (tallar(b->map, inicio, largo, b->v.tam_cluster, NULL, &r) != 0) return 0;
+    liberar_tallado(&r);
+    return (double)largo;
+}
+
+static const Prueba pruebas[] = {
+    { "particiones",       "aperturas/s",  1,   correr_particiones },
+    { "escaneo_mft",       "Mregistros/s", 1e6, correr_escaneo },
+    { "reescaneo_mft",     "Mregistros/s", 1e6, correr_reescaneo },
+    { "runlist",           "Mrunlists/s",  1e6, correr_runlist },
+    { "lineas_hex",        "Mlineas/s",    1e6, correr_hex },
+    { "nombres_utf16",     "Mnombres/s",   1e6, correr_nombres },
+    { "nombres_escalar",   "Mnombres/s",   1e6, correr_nombres_escalar },
+    { "extraccion",        "MB/s",         1e6, correr_extraccion },
+    { "extraccion_lznt1",  "MB/s",         1e6, correr_extraccion_lznt1 },
+    { "tallado",           "GB/s",         1e9, correr_tallado },
+};
+
+// --- preparacion ---
+
+static int agregar_runlist(Banco *b, const unsigned char *run, size_t largo, uint64_t vcn, size_t *cap) {
+    if (b->runs_n == *cap) {
+        size_t c = *cap ? *cap * 2 : 4096;
+        uint32_t *o = realloc(b->run_off, c * sizeof(*o));
+        if (o) b->run_off = o;
+        uint32_t *f = realloc(b->run_fin, c * sizeof(*f));
+        if (f) b->run_fin = f;
+        uint64_t *v = realloc(b->run_vcn, c * sizeof(*v));
+        if (v) b->run_vcn = v;
+        unsigned char *r = realloc(b->runs, c * 64);
+        if (r) b->runs = r;
+        if (!o || !f || !v || !r) return -1;
+        *cap = c;
+    }
+    if (b->runs_len + largo > *cap * 64) return 0; // runlist enorme: no entra, se salta
+    memcpy(b->runs + b->runs_len, run, largo);
+    b->run_off[b->runs_n] = (uint32_t)b->runs_len;
+    b->run_fin[b->runs_n] = (uint32_t)(b->runs_len + largo);
+    b->run_vcn[b->runs_n++] = vcn;
+    b->runs_len += largo;
+    return 0;
+}
+
+static int agregar_nombre(Banco *b, const ATTR_FILENAME *fn, size_t *cap) {
+    if (b->nombres_n == *cap) {
+        size_t c = *cap ? *cap * 2 : 4096;
+        uint32_t *o = realloc(b->nombre_off, c * sizeof(*o));
+        if (o) b->nombre_off = o;
+        uint8_t *l = realloc(b->nombre_len, c);
+        if (l) b->nombre_len = l;
+        uint16_t *u = realloc(b->nombres, c * 64 * sizeof(uint16_t));
+        if (u) b->nombres = u;
+        if (!o || !l || !u) return -1;
+        *cap = c;
+    }
+    if (b->nombres_unidades + fn->chFileNameLength > *cap * 64) return 0;
+    memcpy(b->nombres + b->nombres_unidades, fn->wFilename, fn->chFileNameLength * 2u);
+    b->nombre_off[b->nombres_n] = (uint32_t)b->nombres_unidades;
+    b->nombre_len[b->nombres_n++] = fn->chFileNameLength;
+    b->nombres_unidades += fn->chFileNameLength;
+    return 0;
+}
+
+// Copia los runlists y los nombres de todos los registros, para medir solo la decodificacion
+static int juntar_crudos(Banco *b) {
+    unsigned char *reg = malloc(b->v.tam_registro);
+    size_t cap_runs = 0, cap_nombres = 0;
+    if (!reg) return -1;
+    for (uint64_t i = 0; i < b->v.num_registros; i++) {
+        if (leer_registro(&b->v, i, reg) != 0) continue;
+        for (NTFS_ATTRIBUTE *a = primer_atributo(reg, b->v.tam_registro); a; a = siguiente_atributo(reg, b->v.tam_registro, a)) {
+            int error = 0;
+            if (a->dwType == 0x80 && a->uchNonResFlag && a->Attr.NonResident.wDatarunOffset < a->dwFullLength) {
+                error = agregar_runlist(b, (unsigned char *)a + a->Attr.NonResident.wDatarunOffset,
+                                        a->dwFullLength - a->Attr.NonResident.wDatarunOffset,
+                                        a->Attr.NonResident.n64StartVCN, &cap_runs);
+            } else if (a->dwType == 0x30 && !a->uchNonResFlag) {
+                ATTR_FILENAME *fn = valor_residente(a, 66);
+                if (fn && 66u + fn->chFileNameLength * 2u <= a->Attr.Resident.dwLength) error = agregar_nombre(b, fn, &cap_nombres);
+            }
+            if (error) {
+                free(reg);
+                return -1;
+            }
+        }
+    }
+    free(reg);
+    return 0;
+}
+
+static int preparar(Banco *b, const char *ruta) {
+    if (abrir_imagen(ruta, &b->img) != 0) return -1;
+    b->map = b->img.map;
+    b->map_size = (long)b->img.tamano;
+    if (b->map_size < 512) {
+        fprintf(stderr, "%s: demasiado chica para tener una tabla de particiones\n", ruta);
+        return -1;
+    }
+    for (int i = 0; i < 4; i++) {
+        unsigned int lba;
+        memcpy(&lba, b->map + 0x1BE + i * 16 + 8, 4);
+        if (lba && abrir_volumen(b->map, b->map_size, lba, &b->v) == 0) {
+            b->lba = lba;
+            break;
+        }
+        if (i == 3) {
+            fprintf(stderr, "%s: no hay ninguna particion NTFS\n", ruta);
+            return -1;
+        }
+    }
+    if (leer_bitmap(&b->v, &b->bm) != 0) memset(&b->bm, 0, sizeof(b->bm));
+    if (escanear_mft(&b->v, b->bm.bits ? &b->bm : NULL, &b->t) != 0 || juntar_crudos(b) != 0) {
+        fprintf(stderr, "Sin memoria\n");
+        return -1;
+    }
+    b->sumidero = abrir_sumidero(b);
+    if (!b->sumidero) {
+        fprintf(stderr, "Sin memoria\n");
+        return -1;
+    }
+    return 0;
+}
+
+// --- resultados ---
+
+static int comparar_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Percentil por rango mas cercano sobre v ya ordenado
+static double percentil(const double *v, int n, double p) {
+    int k = (int)(p * n + 0.999999) - 1;
+    return v[k < 0 ? 0 : k >= n ? n - 1 : k];
+}
+
+int main(int argc, char **argv) {
+    int repeticiones = 7, opt, uso = 0;
+    const char *commit = "-", *salida = NULL;
+    while ((opt = getopt(argc, argv, "r:c:o:")) != -1) {
+        switch (opt) {
+            case 'r': repeticiones = atoi(optarg); break;
+            case 'c': commit = optarg; break;
+            case 'o': salida = optarg; break;
+            default: uso = 1; break; // opcion desconocida: mostrar el uso
+        }
+    }
+    if (uso || optind != argc - 1 || repeticiones < 1 || repeticiones > MAX_REPETICIONES) {
+        fprintf(stderr, "uso: %s [-r repeticiones 1-%d] [-c commit] [-o resultados.csv] imagen\n", argv[0],
+                MAX_REPETICIONES);
+        return 1;
+    }
+    const char *imagen = argv[optind];
+    Banco b = { 0 };
+    double t0 = ahora_seg();
+    if (preparar(&b, imagen) != 0) return 1;
+    fprintf(stderr, "%s: %llu registros, %zu filas, %zu runlists, %zu nombres (preparado en %.2f s), %d repeticiones\n",
+            imagen, (unsigned long long)b.v.num_registros, b.t.n, b.runs_n, b.nombres_n, ahora_seg() - t0,
+            repeticiones);
+
+    FILE *csv = stdout;
+    if (salida) {
+        csv = fopen(salida, "a");
+        if (!csv) {
+            perror(salida);
+            return 1;
+        }
+        if (ftello(csv) == 0) fprintf(csv, "commit,imagen,prueba,unidad,repeticiones,mediana,p10,p90,min,max\n");
+    }
+    const char *base = strrchr(imagen, '/') ? strrchr(imagen, '/') + 1 : imagen;
+
+    fprintf(stderr, "%-18s %12s %12s %12s  %s\n", "prueba", "mediana", "p10", "p90", "unidad");
+    for (size_t p = 0; p < sizeof(pruebas) / sizeof(*pruebas); p++) {
+        const Prueba *pr = &pruebas[p];
+        double v[MAX_REPETICIONES];
+        int n = 0;
+        if (pr->correr(&b) <= 0) { // calentamiento; 0 = la imagen no tiene con que medir
+            fprintf(stderr, "%-18s %12s\n", pr->nombre, "(no aplica)");
+            continue;
+        }
+        for (int r = 0; r < repeticiones; r++) {
+            double t = ahora_seg();
+            double cantidad = pr->correr(&b);
+            t = ahora_seg() - t;
+            if (t > 0) v[n++] = cantidad / t / pr->escala;
+        }
+        if (n == 0) continue;
+        qsort(v, n, sizeof(double), comparar_double);
+        double mediana = n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+        double p10 = percentil(v, n, 0.10), p90 = percentil(v, n, 0.90);
+        fprintf(stderr, "%-18s %12.3f %12.3f %12.3f  %s\n", pr->nombre, mediana, p10, p90, pr->unidad);
+        fprintf(csv, "%s,%s,%s,%s,%d,%.6g,%.6g,%.6g,%.6g,%.6g\n", commit, base, pr->nombre, pr->unidad, n, mediana, p10,
+                p90, v[0], v[n - 1]);
+    }
+
+    if (salida) fclose(csv);
+    fclose(b.sumidero);
+    tabla_liberar(&b.t);
+    liberar_bitmap(&b.bm);
+    cerrar_volumen(&b.v);
+    free(b.runs);
+    free(b.run_off);
+    free(b.run_fin);
+    free(b.run_vcn);
+    free(b.nombres);
+    free(b.nombre_off);
+    free(b.nombre_len);
+    cerrar_imagen(&b.img);
+    return 0;
+}
@@ -0,0 +1,197 @@
+// bitmapNtfs.c
+#include "bitmapNtfs.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define BITMAP_SIMD 1
+#endif
+
+#define REGISTRO_BITMAP 6
+
+void liberar_bitmap(BitmapNtfs *b) {
+    free(b->bits);
+    memset(b, 0, sizeof(*b));
+}
+
+int leer_bitmap(const VolumenNtfs *v, BitmapNtfs *b) {
+    memset(b, 0, sizeof(*b));
+    if (v->num_clusters == 0) return -1;
+    unsigned char *reg = malloc(v->tam_registro);
+    if (!reg) return -2;
+    if (leer_registro(v, REGISTRO_BITMAP, reg) != 0) {
+        free(reg);
+        return -1;
+    }
+
+    size_t bytes = (size_t)((v->num_clusters + 63) / 64 * 8);
+    b->bits = calloc(bytes, 1);
+    if (!b->bits) {
+        free(reg);
+        return -2;
+    }
+    b->num_clusters = v->num_clusters;
+
+    int leido = 0;
+    for (NTFS_ATTRIBUTE *attr = primer_atributo(reg, v->tam_registro); attr && !leido;
+         attr = siguiente_atributo(reg, v->tam_registro, attr)) {
+        if (attr->dwType != 0x80 || attr->uchNameLength != 0) continue;
+        if (attr->uchNonResFlag == 0) {
+            // volumen diminuto: el bitmap cabe en el registro
+            unsigned char *val = valor_residente(attr, 1);
+            if (!val) break;
+            size_t n = attr->Attr.Resident.dwLength < bytes ? attr->Attr.Resident.dwLength : bytes;
+            memcpy(b->bits, val, n);
+            leido = 1;
+            break;
+        }
+        Extent *ext = NULL;
+        int n = 0, cap = 0;
+        unsigned char *run = (unsigned char *)attr + attr->Attr.NonResident.wDatarunOffset;
+        if (decodificar_runlist(run, (unsigned char *)attr + attr->dwFullLength,
+                                attr->Attr.NonResident.n64StartVCN, &ext, &n, &cap) < 0) {
+            free(ext);
+            break;
+        }
+        // cada tramo se copia a su posicion (VCN); los huecos dispersos quedan en 0
+        for (int e = 0; e < n; e++) {
+            if (ext[e].lcn < 0) continue;
+            uint64_t dst = ext[e].vcn * v->tam_cluster;
+            if (dst >= bytes) continue;
+            uint64_t len = ext[e].len * v->tam_cluster;
+            if (len > bytes - dst) len = bytes - dst;
+            long long src = v->base + ext[e].lcn * (long long)v->tam_cluster;
+            if (src < 0 || src >= v->map_size) continue;
+            if (src + (long long)len > v->map_size) len = (uint64_t)(v->map_size - src);
+            memcpy(b->bits + dst, v->map + src, len);
+        }
+        free(ext);
+        leido = 1;
+    }
+    free(reg);
+    if (!leido) {
+        liberar_bitmap(b);
+        return -1;
+    }
+
+    // los bits despues del ultimo cluster no cuentan (NTFS los suele dejar en 1)
+    uint64_t resto = b->num_clusters & 63;
+    if (resto) {
+        uint64_t palabra;
+        memcpy(&palabra, b->bits + bytes - 8, 8);
+        palabra &= (1ULL << resto) - 1;
+        memcpy(b->bits + bytes - 8, &palabra, 8);
+    }
+    b->usados = contar_bits(b->bits, bytes);
+    return 0;
+}
+
+static uint64_t contar_bits_escalar(const uint8_t *p, size_t bytes) {
+    uint64_t total = 0;
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t w;
+        memcpy(&w, p + i, 8);
+        total += (uint64_t)__builtin_popcountll(w);
+    }
+    for (; i < bytes; i++) total += (uint64_t)__builtin_popcount(p[i]);
+    return total;
+}
+
+#ifdef BITMAP_SIMD
+__attribute__((target("popcnt")))
+static uint64_t contar_bits_popcnt(const uint8_t *p, size_t bytes) {
+    return contar_bits_escalar(p, bytes);
+}
+
+// Popcount de a 32 bytes con la tabla de nibbles en un registro (pshufb) y sad para sumar
+__attribute__((target("avx2")))
+static uint64_t contar_bits_avx2(const uint8_t *p, size_t bytes) {
+    const __m256i tabla = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    __m256i total = _mm256_setzero_si256();
+    size_t i = 0;
+    while (i + 32 <= bytes) {
+        // acumular bytes como mucho 31 vueltas antes de pasarlos a 64 bits (31 * 8 < 256)
+        __m256i parcial = _mm256_setzero_si256();
+        for (int k = 0; k < 31 && i + 32 <= bytes; k++, i += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+            __m256i bajo = _mm256_shuffle_epi8(tabla, _mm256_and_si256(v, nibble));
+            __m256i alto = _mm256_shuffle_epi8(tabla, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+            parcial = _mm256_add_epi8(parcial, _mm256_add_epi8(bajo, alto));
+        }
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(parcial, _mm256_setzero_si256()));
+    }
+    uint64_t s[4];
+    _mm256_storeu_si256((__m256i *)s, total);
+    return s[0] + s[1] + s[2] + s[3] + contar_bits_escalar(p + i, bytes - i);
+}
+
+typedef uint64_t (*FnContar)(const uint8_t *, size_t);
+
+static FnContar elegir_contar(void) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return contar_bits_avx2;
+    if (__builtin_cpu_supports("popcnt")) return contar_bits_popcnt;
+    return contar_bits_escalar;
+}
+#endif
+
+uint64_t contar_bits(const uint8_t *p, size_t bytes) {
+#ifdef BITMAP_SIMD
+    static FnContar contar = NULL;
+    if (!contar) contar = elegir_contar();
+    return contar(p, bytes);
+#else
+    return contar_bits_escalar(p, bytes);
+#endif
+}
+
+uint64_t contar_ocupados(const BitmapNtfs *b, uint64_t lcn, uint64_t n) {
+    if (lcn >= b->num_clusters) return n;
+    uint64_t fuera = 0;
+    if (n > b->num_clusters - lcn) {
+        fuera = n - (b->num_clusters - lcn);
+        n -= fuera;
+    }
+    uint64_t total = 0;
+    // bits sueltos hasta llegar a un byte entero, bytes enteros con contar_bits, y la cola
+    while (n > 0 && (lcn & 7)) {
+        total += b->bits[lcn >> 3] >> (lcn & 7) & 1;
+        lcn++;
+        n--;
+    }
+    total += contar_bits(b->bits + (lcn >> 3), (size_t)(n >> 3));
+    lcn += n & ~7ULL;
+    for (n &= 7; n > 0; n--, lcn++) total += b->bits[lcn >> 3] >> (lcn & 7) & 1;
+    return total + fuera;
+}
+
+// Busca el primer bit igual a 'valor' desde 'desde', de a 64 bits
+static int64_t siguiente_bit(const BitmapNtfs *b, uint64_t desde, int valor) {
+    if (desde >= b->num_clusters) return -1;
+    uint64_t palabras = (b->num_clusters + 63) / 64;
+    uint64_t i = desde / 64;
+    uint64_t w;
+    memcpy(&w, b->bits + i * 8, 8);
+    if (!valor) w = ~w;
+    w &= ~0ULL << (desde & 63); // descartar los bits antes de 'desde'
+    while (w == 0) {
+        if (++i == palabras) return -1;
+        memcpy(&w, b->bits + i * 8, 8);
+        if (!valor) w = ~w;
+    }
+    uint64_t lcn = i * 64 + (uint64_t)__builtin_ctzll(w);
+    return lcn < b->num_clusters ? (int64_t)lcn : -1;
+}
+
+int64_t siguiente_ocupado(const BitmapNtfs *b, uint64_t desde) {
+    return siguiente_bit(b, desde, 1);
+}
+
+int64_t siguiente_libre(const BitmapNtfs *b, uint64_t desde) {
+    return siguiente_bit(b, desde, 0);
+}
@@ -0,0 +1,43 @@
+#ifndef BITMAPNTFS_H
+#define BITMAPNTFS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "ntfsVolumen.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// $Bitmap (registro 6): un bit por cluster del volumen, 1 = ocupado
+typedef struct {
+    uint8_t *bits;          // con relleno hasta un multiplo de 8 bytes, los bits de mas en 0
+    uint64_t num_clusters;
+    uint64_t usados;
+} BitmapNtfs;
+
+// Lee $Bitmap siguiendo su runlist y cuenta los clusters usados. Devuelve 0, -1 si el
+// registro 6 no tiene un $DATA legible o -2 si falta memoria.
+int leer_bitmap(const VolumenNtfs *v, BitmapNtfs *b);
+void liberar_bitmap(BitmapNtfs *b);
+
+// Cuenta los bits en 1 de 'bytes' bytes (AVX2 si la CPU lo tiene)
+uint64_t contar_bits(const uint8_t *p, size_t bytes);
+
+static inline int cluster_ocupado(const BitmapNtfs *b, uint64_t lcn) {
+    return lcn < b->num_clusters && (b->bits[lcn >> 3] >> (lcn & 7) & 1);
+}
+
+// Clusters ocupados en [lcn, lcn + n); los que pasan del final cuentan como ocupados
+uint64_t contar_ocupados(const BitmapNtfs *b, uint64_t lcn, uint64_t n);
+
+// Primer cluster ocupado / libre en [desde, num_clusters), o -1 si no hay
+int64_t siguiente_ocupado(const BitmapNtfs *b, uint64_t desde);
+int64_t siguiente_libre(const BitmapNtfs *b, uint64_t desde);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,246 @@
+// compresion.c
+#include "compresion.h"
+#include "extraer.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define BLOQUE_LZNT1        4096
+#define MAX_HILOS_COMPRESION 16
+#define UNIDADES_POR_HILO    8   // unidades que descomprime cada hilo antes de escribir
+
+long lznt1_descomprimir(const unsigned char *in, size_t n_in, unsigned char *out, size_t n_out) {
+    const unsigned char *p = in, *fin = in + n_in;
+    size_t o = 0;
+    while (p + 2 <= fin && o < n_out) {
+        unsigned cab = p[0] | (p[1] << 8);
+        if (cab == 0) break; // fin de los datos
+        size_t largo = (cab & 0x0FFF) + 1; // bytes del bloque sin contar la cabecera
+        p += 2;
+        if (p + largo > fin) return -1;
+        const unsigned char *b = p, *bfin = p + largo;
+        p = bfin;
+        size_t inicio = o, tope = (n_out - o < BLOQUE_LZNT1) ? n_out : o + BLOQUE_LZNT1;
+
+        if (!(cab & 0x8000)) { // bloque guardado sin comprimir
+            size_t k = (largo < tope - o) ? largo : tope - o;
+            memcpy(out + o, b, k);
+            o += k;
+        } else {
+            while (b < bfin && o < tope) {
+                unsigned banderas = *b++;
+                for (int bit = 0; bit < 8 && b < bfin && o < tope; bit++, banderas >>= 1) {
+                    if (!(banderas & 1)) { // literal
+                        out[o++] = *b++;
+                        continue;
+                    }
+                    // referencia hacia atras: cuantos bits son distancia y cuantos largo
+                    // depende de cuanto se lleva escrito del bloque
+                    if (b + 2 > bfin) return -1;
+                    unsigned tok = b[0] | (b[1] << 8);
+                    b += 2;
+                    size_t pos = o - inicio;
+                    if (pos == 0) return -1;
+                    int bits_largo = 12;
+                    for (size_t q = pos - 1; q >= 0x10; q >>= 1) bits_largo--;
+                    size_t distancia = (tok >> bits_largo) + 1;
+                    size_t cuenta = (tok & ((1u << bits_largo) - 1)) + 3;
+                    if (distancia > pos) return -1;
+                    if (cuenta > tope - o) cuenta = tope - o;
+                    if (distancia >= cuenta) {
+                        memcpy(out + o, out + o - distancia, cuenta);
+                        o += cuenta;
+                    } else {
+                        // se solapa con lo que se esta escribiendo: byte a byte
+                        for (size_t k = 0; k < cuenta; k++, o++) out[o] = out[o - distancia];
+                    }
+                }
+            }
+        }
+        // un bloque que no es el ultimo cubre siempre 4 KB; lo que no escribio son ceros
+        if (o < tope && p + 2 <= fin && (p[0] | p[1]) != 0) {
+            memset(out + o, 0, tope - o);
+            o = tope;
+        }
+    }
+    return (long)o;
+}
+
+// Deja en 'dest' (bytes_unidad bytes) el contenido de la unidad 'u'. Devuelve 0, 1 si la unidad
+// es toda dispersa o -1 si esta corrupta o sale del mapa (en esos casos queda en ceros).
+static int descomprimir_unidad(const LectorComprimido *l, uint64_t u, unsigned char *dest, unsigned char *crudo) {
+    uint64_t v = u * l->clusters_unidad, fin = v + l->clusters_unidad;
+    uint64_t asignados = 0;
+    // junta en 'crudo' los clusters asignados del principio de la unidad
+    for (int e = buscar_tramo(l->ext, l->n, v); e >= 0 && e < l->n && v < fin && l->ext[e].vcn <= v; e++) {
+        const Extent *x = &l->ext[e];
+        if (x->lcn < 0) break; // disperso: ahi terminan los datos comprimidos
+        uint64_t hasta = (x->vcn + x->len < fin) ? x->vcn + x->len : fin;
+        long long off = l->base + (x->lcn + (long long)(v - x->vcn)) * l->tam_cluster;
+        size_t bytes = (size_t)(hasta - v) * l->tam_cluster;
+        if (off < 0 || off + (long long)bytes > l->map_size) {
+            memset(dest, 0, l->bytes_unidad);
+            return -1;
+        }
+        memcpy(crudo + asignados * l->tam_cluster, l->map + off, bytes);
+        asignados += hasta - v;
+        v = hasta;
+    }
+
+    if (asignados == 0) {
+        memset(dest, 0, l->bytes_unidad);
+        return 1;
+    }
+    if (asignados == l->clusters_unidad) { // no se pudo comprimir: esta tal cual
+        memcpy(dest, crudo, l->bytes_unidad);
+        return 0;
+    }
+    long n = lznt1_descomprimir(crudo, asignados * l->tam_cluster, dest, l->bytes_unidad);
+    if (n < 0) {
+        memset(dest, 0, l->bytes_unidad);
+        return -1;
+    }
+    memset(dest + n, 0, l->bytes_unidad - n);
+    return 0;
+}
+
+int lector_abrir(LectorComprimido *l, const VolumenNtfs *v, const Extent *ext, int n, uint64_t tamano,
+                 int log2_unidad) {
+    memset(l, 0, sizeof(*l));
+    if (log2_unidad <= 0 || log2_unidad > 8) log2_unidad = 4;
+    l->map = v->map;
+    l->map_size = v->map_size;
+    l->base = v->base;
+    l->tam_cluster = v->tam_cluster;
+    l->ext = ext;
+    l->n = n;
+    l->tamano = tamano;
+    l->clusters_unidad = 1u << log2_unidad;
+    l->bytes_unidad = (size_t)l->clusters_unidad * v->tam_cluster;
+    l->unidades = (tamano + l->bytes_unidad - 1) / l->bytes_unidad;
+    l->crudo = malloc(l->bytes_unidad);
+    if (!l->crudo) return -1;
+    for (int i = 0; i < UNIDADES_CACHE; i++) {
+        l->cache[i].datos = malloc(l->bytes_unidad);
+        if (!l->cache[i].datos) {
+            lector_cerrar(l);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void lector_cerrar(LectorComprimido *l) {
+    for (int i = 0; i < UNIDADES_CACHE; i++) free(l->cache[i].datos);
+    free(l->crudo);
+    memset(l, 0, sizeof(*l));
+}
+
+// Unidad 'u' descomprimida; si no esta en la cache reemplaza a la usada hace mas tiempo
+static const unsigned char *unidad_en_cache(LectorComprimido *l, uint64_t u) {
+    int victima = 0;
+    for (int i = 0; i < UNIDADES_CACHE; i++) {
+        if (l->cache[i].uso && l->cache[i].unidad == u) {
+            l->cache[i].uso = ++l->reloj;
+            return l->cache[i].datos;
+        }
+        if (l->cache[i].uso < l->cache[victima].uso) victima = i;
+    }
+    descomprimir_unidad(l, u, l->cache[victima].datos, l->crudo);
+    l->cache[victima].unidad = u;
+    l->cache[victima].uso = ++l->reloj;
+    return l->cache[victima].datos;
+}
+
+size_t lector_leer(LectorComprimido *l, uint64_t off, unsigned char *buf, size_t n) {
+    if (off >= l->tamano) return 0;
+    if (n > l->tamano - off) n = (size_t)(l->tamano - off);
+    size_t hecho = 0;
+    while (hecho < n) {
+        uint64_t u = (off + hecho) / l->bytes_unidad;
+        size_t dentro = (size_t)((off + hecho) % l->bytes_unidad);
+        size_t k = l->bytes_unidad - dentro;
+        if (k > n - hecho) k = n - hecho;
+        memcpy(buf + hecho, unidad_en_cache(l, u) + dentro, k);
+        hecho += k;
+    }
+    return n;
+}
+
+typedef struct {
+    const LectorComprimido *l;
+    uint64_t primera, cuantas;  // unidades de esta tanda
+    int h, nhilos;
+    unsigned char *salida;      // cuantas * bytes_unidad
+    uint8_t *vacia;             // 1 si la unidad no tiene clusters (se escribe como hueco)
+    unsigned char *crudo;
+} TrozoExtraccion;
+
+static void *descomprimir_trozo(void *arg) {
+    TrozoExtraccion *tr = arg;
+    // unidades intercaladas: el costo se reparte parejo aunque haya zonas sin comprimir
+    for (uint64_t i = tr->h; i < tr->cuantas; i += tr->nhilos) {
+        tr->vacia[i] = descomprimir_unidad(tr->l, tr->primera + i, tr->salida + i * tr->l->bytes_unidad, tr->crudo) == 1;
+    }
+    return NULL;
+}
+
+uint64_t extraer_comprimido(const LectorComprimido *l, FILE *out, uint64_t *huecos) {
+    long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    int nhilos = nucleos < 1 ? 1 : nucleos > MAX_HILOS_COMPRESION ? MAX_HILOS_COMPRESION : (int)nucleos;
+    uint64_t por_tanda = (uint64_t)nhilos * UNIDADES_POR_HILO;
+    unsigned char *salida = malloc(por_tanda * l->bytes_unidad);
+    unsigned char *crudos = malloc((size_t)nhilos * l->bytes_unidad);
+    uint8_t *vacia = malloc(por_tanda);
+    *huecos = 0;
+    if (!salida || !crudos || !vacia) {
+        free(salida);
+        free(crudos);
+        free(vacia);
+        return 0;
+    }
+
+    uint64_t escritos = 0;
+    int error = 0;
+    for (uint64_t u = 0; u < l->unidades && !error; u += por_tanda) {
+        uint64_t cuantas = (l->unidades - u < por_tanda) ? l->unidades - u : por_tanda;
+        TrozoExtraccion trozos[MAX_HILOS_COMPRESION];
+        pthread_t hilos[MAX_HILOS_COMPRESION];
+        int creados[MAX_HILOS_COMPRESION] = { 0 };
+        for (int h = 0; h < nhilos; h++) {
+            trozos[h] = (TrozoExtraccion){ l, u, cuantas, h, nhilos, salida, vacia,
+                                           crudos + (size_t)h * l->bytes_unidad };
+        }
+        for (int h = 1; h < nhilos; h++) {
+            creados[h] = pthread_create(&hilos[h], NULL, descomprimir_trozo, &trozos[h]) == 0;
+        }
+        descomprimir_trozo(&trozos[0]);
+        for (int h = 1; h < nhilos; h++) {
+            if (creados[h]) pthread_join(hilos[h], NULL);
+            else descomprimir_trozo(&trozos[h]);
+        }
+
+        // las unidades se escriben en orden (las vacias como hueco); la ultima se corta en el
+        // tamano real
+        for (uint64_t i = 0; i < cuantas && !error; i++) {
+            uint64_t bytes = l->bytes_unidad;
+            if (bytes > l->tamano - escritos) bytes = l->tamano - escritos;
+            if (vacia[i]) {
+                error = escribir_hueco(out, bytes) != 0;
+                *huecos += bytes;
+                escritos += error ? 0 : bytes;
+                continue;
+            }
+            size_t k = fwrite(salida + i * l->bytes_unidad, 1, (size_t)bytes, out);
+            escritos += k;
+            error = k != bytes;
+        }
+    }
+    if (!error && *huecos) cerrar_huecos(out, l->tamano);
+    free(salida);
+    free(crudos);
+    free(vacia);
+    return escritos;
+}
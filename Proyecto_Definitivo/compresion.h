@@ -0,0 +1,63 @@
+#ifndef COMPRESION_H
+#define COMPRESION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "ntfsVolumen.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UNIDADES_CACHE 8 // unidades descomprimidas que guarda el lector (LRU)
+
+// Descomprime un flujo LZNT1 (secuencia de bloques de hasta 4 KB con cabecera de 2 bytes)
+// en 'out'. Un bloque que da menos de 4 KB se completa con ceros, como hace NTFS.
+// Devuelve los bytes escritos en 'out' o -1 si los datos estan corruptos.
+long lznt1_descomprimir(const unsigned char *in, size_t n_in, unsigned char *out, size_t n_out);
+
+// Lectura de un atributo comprimido por unidades de compresion (normalmente 16 clusters):
+// una unidad con todos sus clusters asignados esta sin comprimir, una sin ninguno son ceros
+// y el resto es LZNT1 en los primeros clusters de la unidad.
+typedef struct {
+    const unsigned char *map;
+    long map_size;
+    long long base;
+    uint32_t tam_cluster;
+    const Extent *ext;
+    int n;
+    uint64_t tamano;            // tamano real del atributo
+    uint32_t clusters_unidad;
+    size_t bytes_unidad;
+    uint64_t unidades;
+
+    struct {
+        uint64_t unidad;
+        uint64_t uso;           // reloj del ultimo acceso, 0 = vacia
+        unsigned char *datos;
+    } cache[UNIDADES_CACHE];
+    uint64_t reloj;
+    unsigned char *crudo;       // clusters de la unidad antes de descomprimir
+} LectorComprimido;
+
+// 'log2_unidad' es wCompressionSize del atributo. Devuelve 0 o -1 si falta memoria.
+int lector_abrir(LectorComprimido *l, const VolumenNtfs *v, const Extent *ext, int n, uint64_t tamano,
+                 int log2_unidad);
+void lector_cerrar(LectorComprimido *l);
+
+// Copia hasta 'n' bytes desde el offset logico 'off'; devuelve cuantos copio (0 al final).
+// Una unidad ilegible se lee como ceros.
+size_t lector_leer(LectorComprimido *l, uint64_t off, unsigned char *buf, size_t n);
+
+// Escribe el atributo descomprimido en 'out' descomprimiendo las unidades en paralelo
+// (un hilo por nucleo); las unidades sin ningun cluster quedan como huecos y su tamano va a
+// *huecos. Devuelve los bytes escritos; menos que l->tamano si fallo la escritura.
+uint64_t extraer_comprimido(const LectorComprimido *l, FILE *out, uint64_t *huecos);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
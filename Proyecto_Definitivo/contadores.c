@@ -0,0 +1,91 @@
+#include "contadores.h"
+#include <time.h>
+#include <sys/resource.h>
+
+Contadores contadores;
+
+static const char *nombres_fase[NUM_FASES] = {
+    "volumen y $Bitmap", "escaneo del $MFT", "reescaneo", "contenido", "hashes", "hash de imagen",
+    "filtro y orden", "exportar", "extraer", "formato de filas", "pantalla",
+};
+
+static double ahora_seg(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void fase_empezar(MarcaFase *m) {
+    if (!contadores.activos) return;
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    m->menores = ru.ru_minflt;
+    m->mayores = ru.ru_majflt;
+    m->t = ahora_seg();
+}
+
+void fase_terminar(const MarcaFase *m, FaseMedida f) {
+    if (!contadores.activos) return;
+    double t = ahora_seg();
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    TiempoFase *tf = &contadores.fase[f];
+    tf->segundos += t - m->t;
+    tf->veces++;
+    tf->fallos_menores += ru.ru_minflt - m->menores;
+    tf->fallos_mayores += ru.ru_majflt - m->mayores;
+}
+
+int contadores_linea(int i, char *buf, size_t sz) {
+    if (i == 0) {
+        snprintf(buf, sz, "%-18s %8s %10s %14s %8s", "fase", "veces", "segundos", "fallos menores", "mayores");
+        return 1;
+    }
+    i--;
+    int medidas = 0;
+    for (int f = 0; f < NUM_FASES; f++) {
+        const TiempoFase *tf = &contadores.fase[f];
+        if (!tf->veces) continue;
+        if (medidas++ == i) {
+            snprintf(buf, sz, "%-18s %8llu %10.3f %14ld %8ld", nombres_fase[f], (unsigned long long)tf->veces,
+                     tf->segundos, tf->fallos_menores, tf->fallos_mayores);
+            return 1;
+        }
+    }
+    if (!medidas && i == 0) {
+        snprintf(buf, sz, "(nada medido todavia)");
+        return 1;
+    }
+    i -= medidas ? medidas : 1;
+    if (i == 0) {
+        snprintf(buf, sz, "$MFT: %llu registros leidos, %llu sin firma FILE, %llu con el fixup roto, "
+                 "%llu de extension, %llu descartados, %llu atributos",
+                 (unsigned long long)contadores.registros_leidos, (unsigned long long)contadores.sin_firma,
+                 (unsigned long long)contadores.fixups_rotos, (unsigned long long)contadores.extensiones,
+                 (unsigned long long)contadores.descartados, (unsigned long long)contadores.atributos);
+        return 1;
+    }
+    if (i == 1 && contadores.frio_medido) {
+        int n = snprintf(buf, sz, "Cache de paginas del $MFT: ");
+        if (contadores.frio_antes < 0 || contadores.frio_despues < 0)
+            snprintf(buf + n, sz - (size_t)n, "no se pudo medir (mincore)");
+        else
+            snprintf(buf + n, sz - (size_t)n, "%.1f%% fuera de la cache antes del ultimo escaneo, %.1f%% despues",
+                     contadores.frio_antes, contadores.frio_despues);
+        return 1;
+    }
+    if (contadores.frio_medido) i--;
+    if (i == 1) {
+        struct rusage ru;
+        getrusage(RUSAGE_SELF, &ru);
+        snprintf(buf, sz, "Bytes tocados: %.1f MB; el proceso lleva %ld fallos de pagina menores y %ld mayores",
+                 contadores.bytes / 1e6, ru.ru_minflt, ru.ru_majflt);
+        return 1;
+    }
+    return 0;
+}
+
+void contadores_imprimir(FILE *out) {
+    char linea[256];
+    for (int i = 0; contadores_linea(i, linea, sizeof(linea)); i++) fprintf(out, "%s\n", linea);
+}
@@ -0,0 +1,74 @@
+#ifndef CONTADORES_H
+#define CONTADORES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Donde se va el tiempo: tiempo de pared y fallos de pagina por fase y lo que hizo el escaneo
+// del $MFT. Con 'activos' en 0 (lo normal sin -S) las marcas no leen ni el reloj ni getrusage;
+// el escaneo cuenta en variables locales y suma una sola vez al final.
+typedef enum {
+    FASE_VOLUMEN,       // abrir el volumen y leer $Bitmap
+    FASE_ESCANEO,       // escanear_mft
+    FASE_REESCANEO,     // reescanear_mft
+    FASE_CONTENIDO,     // firmas del principio de cada archivo
+    FASE_HASHES,        // hashes por archivo
+    FASE_HASH_IMAGEN,   // hash de la imagen o verificacion del mapa
+    FASE_ORDEN,         // filtrar, ordenar e intercalar flujos
+    FASE_EXPORTAR,      // CSV, bodyfile, linea de tiempo, $UsnJrnl
+    FASE_EXTRAER,       // descargas
+    FASE_FORMATO,       // armar las filas de la lista (fechas, nombres, ajustar_ancho)
+    FASE_PANTALLA,      // refresh() de ncurses
+    NUM_FASES
+} FaseMedida;
+
+typedef struct {
+    double segundos;
+    uint64_t veces;
+    long fallos_menores, fallos_mayores;
+} TiempoFase;
+
+typedef struct {
+    int activos;
+    TiempoFase fase[NUM_FASES];
+    uint64_t registros_leidos;  // registros del $MFT que se intentaron interpretar
+    uint64_t sin_firma;         // sin "FILE" (libres o basura)
+    uint64_t fixups_rotos;      // escritura a medias: el numero de actualizacion no coincide
+    uint64_t extensiones;       // registros de extension (se funden con su base)
+    uint64_t descartados;       // validos pero sin fila: sin $FILE_NAME o borrados con runlist roto
+    uint64_t atributos;         // atributos recorridos
+    uint64_t bytes;             // bytes de la imagen tocados por las fases medidas
+    // % del $MFT fuera de la cache de paginas antes y despues del ultimo escaneo (-1 = mincore fallo)
+    int frio_medido;
+    double frio_antes, frio_despues;
+} Contadores;
+
+extern Contadores contadores;
+
+typedef struct {
+    double t;
+    long menores, mayores;
+} MarcaFase;
+
+void fase_empezar(MarcaFase *m);
+void fase_terminar(const MarcaFase *m, FaseMedida f);
+
+static inline void contar_bytes(uint64_t n) {
+    if (contadores.activos) contadores.bytes += n;
+}
+
+// Linea 'i' del informe (tabla de fases y totales) en buf. Devuelve 0 cuando no hay mas lineas.
+int contadores_linea(int i, char *buf, size_t sz);
+// Todas las lineas, para las corridas sin pantalla
+void contadores_imprimir(FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,380 @@
+#include "demanda.h"
+#include "imagen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/userfaultfd.h>
+
+#define VENTANA_DEMANDA (64u << 20) // bytes del mapa que quedan cargados; los mas viejos se sueltan
+#define ADELANTE        64          // bloques que se cargan por delante de una lectura secuencial
+#define MAX_FLUJOS      8           // lecturas secuenciales que se siguen a la vez
+#define MAX_HILOS       8
+
+#ifndef UFFD_USER_MODE_ONLY
+#define UFFD_USER_MODE_ONLY 1 // kernels viejos: se prueba igual y si falla no hay userfaultfd
+#endif
+
+enum { BLOQUE_VACIO, BLOQUE_MAPEADO };
+
+typedef struct {
+    uint64_t bloque;
+    unsigned char *buf;
+    int32_t ant, sig;   // lista LRU
+    int32_t cadena;     // siguiente en la misma cubeta
+    int uso;            // hilos copiando desde buf: no se puede reusar
+    int valido;
+} SlotCache;
+
+typedef struct {
+    uint64_t ultimo;    // ultimo bloque que fallo en este flujo
+    uint64_t fin;       // primer bloque que todavia no se pidio por adelantado
+    uint64_t edad;
+} Flujo;
+
+struct MapaDemanda {
+    unsigned char *map;
+    size_t largo;
+    uint32_t tam_bloque;
+    uint64_t n_bloques;
+    uint8_t *estado;        // BLOQUE_VACIO / BLOQUE_MAPEADO, bajo 'mutex'
+    LeerBloque leer;
+    void *ctx;
+
+    int uffd, tubo[2];
+    pthread_t atiende[MAX_HILOS], adelanta[MAX_HILOS];
+    int n_atiende, n_adelanta, salir;
+    pthread_mutex_t mutex;
+    pthread_cond_t hay_trabajo;
+
+    uint64_t *ventana;      // bloques mapeados en orden de carga (anillo)
+    size_t ventana_cap, ventana_ini, ventana_n;
+
+    SlotCache *slots;
+    size_t n_slots;
+    int32_t *cubeta;
+    size_t n_cubetas;       // potencia de 2
+    int32_t lru_primero, lru_ultimo; // primero = el mas reciente
+
+    Flujo flujos[MAX_FLUJOS];
+    uint64_t reloj;
+    uint64_t *cola;         // bloques pedidos por adelantado (anillo)
+    size_t cola_cap, cola_ini, cola_n;
+
+    EstadisticaDemanda est;
+};
+
+// --- cache LRU de bloques (todo bajo d->mutex) ---
+
+static size_t cubeta_de(const MapaDemanda *d, uint64_t b) {
+    return (size_t)((b * 0x9E3779B97F4A7C15ull) >> 20) & (d->n_cubetas - 1);
+}
+
+static void lru_sacar(MapaDemanda *d, int32_t s) {
+    SlotCache *x = &d->slots[s];
+    if (x->ant >= 0) d->slots[x->ant].sig = x->sig;
+    else d->lru_primero = x->sig;
+    if (x->sig >= 0) d->slots[x->sig].ant = x->ant;
+    else d->lru_ultimo = x->ant;
+    x->ant = x->sig = -1;
+}
+
+static void lru_al_frente(MapaDemanda *d, int32_t s) {
+    SlotCache *x = &d->slots[s];
+    x->ant = -1;
+    x->sig = d->lru_primero;
+    if (d->lru_primero >= 0) d->slots[d->lru_primero].ant = s;
+    d->lru_primero = s;
+    if (d->lru_ultimo < 0) d->lru_ultimo = s;
+}
+
+static int32_t cache_buscar(MapaDemanda *d, uint64_t b) {
+    if (!d->n_slots) return -1;
+    for (int32_t s = d->cubeta[cubeta_de(d, b)]; s >= 0; s = d->slots[s].cadena)
+        if (d->slots[s].valido && d->slots[s].bloque == b) return s;
+    return -1;
+}
+
+static void cache_quitar(MapaDemanda *d, int32_t s) {
+    int32_t *p = &d->cubeta[cubeta_de(d, d->slots[s].bloque)];
+    while (*p != s) p = &d->slots[*p].cadena;
+    *p = d->slots[s].cadena;
+    d->slots[s].valido = 0;
+}
+
+// Guarda una copia de buf como el bloque b, reusando el menos usado que nadie este copiando
+static void cache_guardar(MapaDemanda *d, uint64_t b, const unsigned char *buf) {
+    if (cache_buscar(d, b) >= 0) return;
+    int32_t s = d->lru_ultimo;
+    while (s >= 0 && d->slots[s].uso) s = d->slots[s].ant;
+    if (s < 0) return;
+    SlotCache *x = &d->slots[s];
+    if (!x->buf && !(x->buf = malloc(d->tam_bloque))) return;
+    if (x->valido) cache_quitar(d, s);
+    memcpy(x->buf, buf, d->tam_bloque);
+    x->bloque = b;
+    x->valido = 1;
+    size_t c = cubeta_de(d, b);
+    x->cadena = d->cubeta[c];
+    d->cubeta[c] = s;
+    lru_sacar(d, s);
+    lru_al_frente(d, s);
+}
+
+static size_t largo_bloque(const MapaDemanda *d, uint64_t b) {
+    uint64_t ini = b * d->tam_bloque;
+    return ini + d->tam_bloque < d->largo ? d->tam_bloque : d->largo - (size_t)ini;
+}
+
+// El bloque b quedo mapeado: entra en la ventana y, si esta llena, se suelta el mas viejo
+static void ventana_agregar(MapaDemanda *d, uint64_t b) {
+    d->estado[b] = BLOQUE_MAPEADO;
+    if (d->ventana_n == d->ventana_cap) {
+        uint64_t viejo = d->ventana[d->ventana_ini];
+        d->ventana_ini = (d->ventana_ini + 1) % d->ventana_cap;
+        d->ventana_n--;
+        // el proximo acceso vuelve a fallar y sale de la cache o se vuelve a leer
+        madvise(d->map + viejo * d->tam_bloque, largo_bloque(d, viejo), MADV_DONTNEED);
+        d->estado[viejo] = BLOQUE_VACIO;
+    }
+    d->ventana[(d->ventana_ini + d->ventana_n++) % d->ventana_cap] = b;
+}
+
+// Pone el bloque b en el mapa. buf es del hilo (tam_bloque bytes). anticipado = lo pidio la
+// lectura anticipada, no un fallo.
+static void cargar_bloque(MapaDemanda *d, uint64_t b, unsigned char *buf, int anticipado) {
+    unsigned char *dst = d->map + b * d->tam_bloque;
+    size_t largo = largo_bloque(d, b);
+    pthread_mutex_lock(&d->mutex);
+    if (!anticipado) d->est.fallos++;
+    if (d->estado[b] == BLOQUE_MAPEADO) {
+        pthread_mutex_unlock(&d->mutex);
+        // otro hilo lo cargo entre el fallo y ahora
+        struct uffdio_range r = { (unsigned long)dst, largo };
+        if (!anticipado) ioctl(d->uffd, UFFDIO_WAKE, &r);
+        return;
+    }
+    const unsigned char *src;
+    int32_t s = cache_buscar(d, b);
+    if (s >= 0) {
+        d->slots[s].uso++;
+        lru_sacar(d, s);
+        lru_al_frente(d, s);
+        if (!anticipado) d->est.aciertos++;
+        src = d->slots[s].buf;
+        pthread_mutex_unlock(&d->mutex);
+    } else {
+        pthread_mutex_unlock(&d->mutex);
+        int guardar = 0;
+        int ok = d->leer(d->ctx, b, buf, &guardar) == 0;
+        pthread_mutex_lock(&d->mutex);
+        if (!ok) d->est.ilegibles++;
+        else if (guardar) {
+            d->est.rehechos++;
+            cache_guardar(d, b, buf);
+        }
+        pthread_mutex_unlock(&d->mutex);
+        src = buf;
+    }
+
+    struct uffdio_copy cp = { (unsigned long)dst, (unsigned long)src, largo, 0, 0 };
+    int copiado = ioctl(d->uffd, UFFDIO_COPY, &cp) == 0;
+    int existia = !copiado && errno == EEXIST;
+
+    pthread_mutex_lock(&d->mutex);
+    if (s >= 0) d->slots[s].uso--;
+    if (copiado) {
+        ventana_agregar(d, b);
+        if (anticipado) d->est.adelantados++;
+    }
+    pthread_mutex_unlock(&d->mutex);
+    if (existia && !anticipado) {
+        struct uffdio_range r = { (unsigned long)dst, largo };
+        ioctl(d->uffd, UFFDIO_WAKE, &r);
+    }
+}
+
+// Un fallo en el bloque b: si sigue a uno anterior (o cae en lo ya pedido por adelantado) se
+// piden los siguientes ADELANTE bloques. Bajo d->mutex.
+static void seguir_flujo(MapaDemanda *d, uint64_t b) {
+    Flujo *f = NULL, *viejo = &d->flujos[0];
+    for (int i = 0; i < MAX_FLUJOS; i++) {
+        Flujo *x = &d->flujos[i];
+        if (x->edad && b > x->ultimo && b <= (x->fin > x->ultimo + 1 ? x->fin : x->ultimo + 1)) {
+            f = x;
+            break;
+        }
+        if (x->edad < viejo->edad) viejo = x;
+    }
+    if (!f) {
+        // primer fallo de una lectura que puede ser secuencial: todavia no se adelanta nada
+        *viejo = (Flujo){ b, b + 1, ++d->reloj };
+        return;
+    }
+    f->ultimo = b;
+    f->edad = ++d->reloj;
+    uint64_t desde = f->fin > b + 1 ? f->fin : b + 1, hasta = b + 1 + ADELANTE;
+    if (hasta > d->n_bloques) hasta = d->n_bloques;
+    for (uint64_t x = desde; x < hasta && d->cola_n < d->cola_cap; x++) {
+        d->cola[(d->cola_ini + d->cola_n++) % d->cola_cap] = x;
+    }
+    if (hasta > f->fin) f->fin = hasta;
+    pthread_cond_broadcast(&d->hay_trabajo);
+}
+
+static void *atender_fallos(void *arg) {
+    MapaDemanda *d = arg;
+    unsigned char *buf = malloc(d->tam_bloque);
+    if (!buf) return NULL;
+    struct pollfd pf[2] = { { d->uffd, POLLIN, 0 }, { d->tubo[0], POLLIN, 0 } };
+    for (;;) {
+        if (poll(pf, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (pf[1].revents) break;
+        struct uffd_msg msg;
+        ssize_t r = read(d->uffd, &msg, sizeof(msg));
+        if (r != (ssize_t)sizeof(msg)) continue; // otro hilo se lo llevo (EAGAIN)
+        if (msg.event != UFFD_EVENT_PAGEFAULT) continue;
+        uint64_t b = ((unsigned char *)(uintptr_t)msg.arg.pagefault.address - d->map) / d->tam_bloque;
+        if (b >= d->n_bloques) continue;
+        pthread_mutex_lock(&d->mutex);
+        seguir_flujo(d, b);
+        pthread_mutex_unlock(&d->mutex);
+        cargar_bloque(d, b, buf, 0);
+    }
+    free(buf);
+    return NULL;
+}
+
+static void *adelantar(void *arg) {
+    MapaDemanda *d = arg;
+    unsigned char *buf = malloc(d->tam_bloque);
+    if (!buf) return NULL;
+    pthread_mutex_lock(&d->mutex);
+    for (;;) {
+        while (!d->salir && d->cola_n == 0) pthread_cond_wait(&d->hay_trabajo, &d->mutex);
+        if (d->salir) break;
+        uint64_t b = d->cola[d->cola_ini];
+        d->cola_ini = (d->cola_ini + 1) % d->cola_cap;
+        d->cola_n--;
+        if (d->estado[b] == BLOQUE_MAPEADO) continue;
+        pthread_mutex_unlock(&d->mutex);
+        cargar_bloque(d, b, buf, 1);
+        pthread_mutex_lock(&d->mutex);
+    }
+    pthread_mutex_unlock(&d->mutex);
+    free(buf);
+    return NULL;
+}
+
+int demanda_abrir(MapaDemanda **dd, unsigned char *map, size_t largo, uint32_t tam_bloque, LeerBloque leer,
+                  void *ctx, size_t cache) {
+    *dd = NULL;
+    size_t pag = (size_t)sysconf(_SC_PAGESIZE);
+    if (!tam_bloque || tam_bloque % pag != 0 || !largo) return -1;
+    // primero con los fallos del kernel (root, o vm.unprivileged_userfaultfd = 1)
+    int solo_usuario = 0;
+    int uffd = (int)syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK);
+    if (uffd < 0) {
+        uffd = (int)syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY);
+        solo_usuario = 1;
+    }
+    if (uffd < 0) return -1;
+    struct uffdio_api api = { .api = UFFD_API };
+    struct uffdio_register reg = { .range = { (unsigned long)map, largo }, .mode = UFFDIO_REGISTER_MODE_MISSING };
+    if (ioctl(uffd, UFFDIO_API, &api) != 0 || ioctl(uffd, UFFDIO_REGISTER, &reg) != 0) {
+        close(uffd);
+        return -1;
+    }
+
+    MapaDemanda *d = calloc(1, sizeof(MapaDemanda));
+    if (!d) {
+        close(uffd);
+        return -2;
+    }
+    d->uffd = uffd;
+    d->tubo[0] = d->tubo[1] = -1;
+    pthread_mutex_init(&d->mutex, NULL);
+    pthread_cond_init(&d->hay_trabajo, NULL);
+    *dd = d;
+    d->map = map;
+    d->largo = largo;
+    d->tam_bloque = tam_bloque;
+    d->n_bloques = (largo + tam_bloque - 1) / tam_bloque;
+    d->leer = leer;
+    d->ctx = ctx;
+    d->ventana_cap = VENTANA_DEMANDA / tam_bloque ? VENTANA_DEMANDA / tam_bloque : 1;
+    d->n_slots = cache / tam_bloque;
+    for (d->n_cubetas = 1; d->n_cubetas < 2 * d->n_slots; d->n_cubetas <<= 1) {}
+    d->cola_cap = (size_t)ADELANTE * MAX_FLUJOS * 2;
+    d->estado = calloc(d->n_bloques, 1);
+    d->ventana = malloc(d->ventana_cap * sizeof(uint64_t));
+    d->slots = calloc(d->n_slots ? d->n_slots : 1, sizeof(SlotCache));
+    d->cubeta = malloc(d->n_cubetas * sizeof(int32_t));
+    d->cola = malloc(d->cola_cap * sizeof(uint64_t));
+    if (!d->estado || !d->ventana || !d->slots || !d->cubeta || !d->cola || pipe(d->tubo) != 0) {
+        demanda_cerrar(d);
+        *dd = NULL;
+        return -2;
+    }
+    for (size_t c = 0; c < d->n_cubetas; c++) d->cubeta[c] = -1;
+    // todos los slots empiezan vacios en la lista LRU
+    d->lru_primero = d->lru_ultimo = -1;
+    for (size_t s = 0; s < d->n_slots; s++) {
+        d->slots[s].cadena = -1;
+        lru_al_frente(d, (int32_t)s);
+    }
+
+    long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    int nhilos = nucleos < 1 ? 1 : nucleos > MAX_HILOS ? MAX_HILOS : (int)nucleos;
+    for (int h = 0; h < nhilos; h++) {
+        if (pthread_create(&d->atiende[d->n_atiende], NULL, atender_fallos, d) == 0) d->n_atiende++;
+        if (pthread_create(&d->adelanta[d->n_adelanta], NULL, adelantar, d) == 0) d->n_adelanta++;
+    }
+    if (!d->n_atiende) {
+        demanda_cerrar(d);
+        *dd = NULL;
+        return -2;
+    }
+    mapa_solo_usuario = solo_usuario;
+    return 0;
+}
+
+void demanda_cerrar(MapaDemanda *d) {
+    if (!d) return;
+    pthread_mutex_lock(&d->mutex);
+    d->salir = 1;
+    pthread_cond_broadcast(&d->hay_trabajo);
+    pthread_mutex_unlock(&d->mutex);
+    if (d->tubo[1] >= 0 && write(d->tubo[1], "x", 1) < 0) perror("userfaultfd");
+    for (int h = 0; h < d->n_atiende; h++) pthread_join(d->atiende[h], NULL);
+    for (int h = 0; h < d->n_adelanta; h++) pthread_join(d->adelanta[h], NULL);
+    close(d->uffd);
+    if (d->tubo[0] >= 0) close(d->tubo[0]);
+    if (d->tubo[1] >= 0) close(d->tubo[1]);
+    for (size_t s = 0; d->slots && s < d->n_slots; s++) free(d->slots[s].buf);
+    free(d->estado);
+    free(d->ventana);
+    free(d->slots);
+    free(d->cubeta);
+    free(d->cola);
+    pthread_mutex_destroy(&d->mutex);
+    pthread_cond_destroy(&d->hay_trabajo);
+    free(d);
+    mapa_solo_usuario = 0;
+}
+
+void demanda_estadisticas(MapaDemanda *d, EstadisticaDemanda *est) {
+    pthread_mutex_lock(&d->mutex);
+    *est = d->est;
+    pthread_mutex_unlock(&d->mutex);
+}
@@ -0,0 +1,46 @@
+#ifndef DEMANDA_H
+#define DEMANDA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Mapa anonimo de solo lectura que se llena bajo demanda con userfaultfd, de a bloques: el primer
+// acceso a un bloque lo pide a leer() y lo copia en su lugar. Del mapa solo quedan cargados los
+// ultimos VENTANA_DEMANDA bytes (los mas viejos se sueltan con MADV_DONTNEED y el proximo acceso
+// los vuelve a pedir), asi que la memoria no crece con la imagen. Los bloques caros de rehacer
+// (chunks de una E01) quedan ademas en una cache LRU. Las lecturas secuenciales se detectan y los
+// bloques siguientes se piden por adelantado desde varios hilos.
+typedef struct MapaDemanda MapaDemanda;
+
+typedef struct {
+    uint64_t fallos;        // fallos de pagina atendidos
+    uint64_t rehechos;      // bloques que leer() tuvo que armar y pidio guardar en la cache
+    uint64_t aciertos;      // fallos resueltos desde la cache, sin llamar a leer()
+    uint64_t adelantados;   // bloques cargados por la lectura anticipada antes de que se pidieran
+    uint64_t ilegibles;     // bloques que leer() no pudo armar: quedan en ceros
+} EstadisticaDemanda;
+
+// Deja el bloque b en buf (tam_bloque bytes, con ceros despues del final). Devuelve 0 o -1 si no
+// se pudo (buf en ceros). *guardar = 1 si vale la pena guardar una copia en la cache. Se llama
+// desde varios hilos a la vez.
+typedef int (*LeerBloque)(void *ctx, uint64_t b, unsigned char *buf, int *guardar);
+
+// Registra [map, map + largo), ya mapeado anonimo y PROT_READ, y arranca los hilos. tam_bloque
+// tiene que ser multiplo de la pagina; cache = bytes de la cache LRU (0 = sin cache). Se pide
+// atender tambien los fallos que toma el kernel; si solo se permiten los de modo usuario queda
+// mapa_solo_usuario = 1 (imagen.h). Devuelve 0, -1 si no hay userfaultfd o -2 sin memoria.
+int demanda_abrir(MapaDemanda **d, unsigned char *map, size_t largo, uint32_t tam_bloque, LeerBloque leer,
+                  void *ctx, size_t cache);
+// Detiene los hilos; el mapa queda para el que lo creo
+void demanda_cerrar(MapaDemanda *d);
+void demanda_estadisticas(MapaDemanda *d, EstadisticaDemanda *est);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
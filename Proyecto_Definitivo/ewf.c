@@ -0,0 +1,399 @@
+#include "ewf.h"
+#include "demanda.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <zlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CACHE_EWF     (256u << 20)  // chunks ya descomprimidos (LRU)
+#define MAX_HILOS_EWF 8
+#define MAX_ARCHIVOS  (26 * 26 * 22 + 99) // .E01 - .E99 y .EAA - .ZZZ
+
+#define FIRMA_EWF "EVF\x09\x0d\x0a\xff\x00"
+#define LARGO_DESCRIPTOR 76
+
+// Donde esta cada chunk en los archivos de la E01
+typedef struct {
+    uint64_t off;       // en su archivo
+    uint32_t largo;     // bytes guardados (sin comprimir: el chunk y un adler32)
+    uint16_t arch;
+    uint8_t comprimido;
+} ChunkEwf;
+
+struct Ewf {
+    int n_arch;
+    unsigned char **arch_map;
+    uint64_t *arch_tam;
+    char **arch_ruta;
+
+    ChunkEwf *chunk;
+    uint64_t n_chunks;
+    uint32_t tam_chunk;
+    unsigned char *map;
+    uint64_t tamano;
+    size_t reservado;
+    unsigned char md5[16];
+    int con_md5;
+
+    MapaDemanda *demanda;   // NULL si se descomprimio todo al abrir
+    uint64_t ilegibles;     // al descomprimir todo
+};
+
+static uint32_t leer32(const unsigned char *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t leer64(const unsigned char *p) {
+    return (uint64_t)leer32(p) | (uint64_t)leer32(p + 4) << 32;
+}
+
+int es_ewf(const char *ruta) {
+    unsigned char firma[8];
+    int fd = open(ruta, O_RDONLY);
+    if (fd < 0) return 0;
+    int es = read(fd, firma, sizeof(firma)) == (ssize_t)sizeof(firma) && memcmp(firma, FIRMA_EWF, 8) == 0;
+    close(fd);
+    return es;
+}
+
+// Nombre del segmento n (1 = el primero): .E01 - .E99, despues .EAA, .EAB... respetando mayusculas
+static void nombre_segmento(const char *primero, size_t base, int n, char *out, size_t sz) {
+    int minus = islower((unsigned char)primero[base]);
+    char ext[4];
+    if (n <= 99) {
+        snprintf(ext, sizeof(ext), "%c%02d", primero[base], n);
+    } else {
+        int k = n - 100;
+        ext[0] = (char)(primero[base] + k / (26 * 26));
+        ext[1] = (char)((minus ? 'a' : 'A') + (k / 26) % 26);
+        ext[2] = (char)((minus ? 'a' : 'A') + k % 26);
+        ext[3] = '\0';
+    }
+    snprintf(out, sz, "%.*s%s", (int)base, primero, ext);
+}
+
+static int agregar_chunk(Ewf *e, uint64_t *cap, uint64_t off, uint32_t largo, int arch, int comprimido) {
+    if (e->n_chunks == *cap) {
+        uint64_t nuevo = *cap ? *cap * 2 : 4096;
+        ChunkEwf *c = realloc(e->chunk, nuevo * sizeof(ChunkEwf));
+        if (!c) return -1;
+        e->chunk = c;
+        *cap = nuevo;
+    }
+    e->chunk[e->n_chunks++] = (ChunkEwf){ off, largo, (uint16_t)arch, (uint8_t)comprimido };
+    return 0;
+}
+
+// Seccion "table": cabecera de 24 bytes y una entrada de 4 bytes por chunk (bit 31 = comprimido,
+// el resto = offset desde la base). El ultimo chunk termina donde terminan los datos de "sectors".
+static int leer_tabla(Ewf *e, int a, uint64_t sec_off, uint64_t sec_tam, uint64_t fin_datos, uint64_t *cap) {
+    const unsigned char *m = e->arch_map[a];
+    uint64_t tam = e->arch_tam[a], p = sec_off + LARGO_DESCRIPTOR;
+    if (p + 24 > tam) return -1;
+    uint32_t n = leer32(m + p);
+    uint64_t base = leer64(m + p + 8);
+    if (adler32(1, m + p, 20) != leer32(m + p + 20)) return -1;
+    p += 24;
+    if (p + (uint64_t)n * 4 > tam) return -1;
+    // sin "sectors" (formatos viejos) los datos van dentro de la propia tabla
+    if (fin_datos <= sec_off) fin_datos = sec_off + sec_tam;
+    uint64_t anterior = 0, desborde = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t ent = leer32(m + p + (uint64_t)i * 4);
+        uint64_t ini = base + (ent & 0x7fffffffu) + desborde;
+        // segmentos de mas de 2 GB de EnCase viejos: el offset de 31 bits da la vuelta
+        if (i && ini < anterior) {
+            desborde += 0x80000000u;
+            ini += 0x80000000u;
+        }
+        uint64_t fin;
+        if (i + 1 < n) {
+            uint32_t sig = leer32(m + p + (uint64_t)(i + 1) * 4);
+            fin = base + (sig & 0x7fffffffu) + desborde;
+            if (fin < ini) fin += 0x80000000u;
+        } else {
+            fin = fin_datos;
+        }
+        if (fin > tam) fin = tam;
+        uint32_t largo = fin > ini && fin - ini < UINT32_MAX ? (uint32_t)(fin - ini) : 0;
+        if (agregar_chunk(e, cap, ini, largo, a, (ent & 0x80000000u) != 0) != 0) return -2;
+        anterior = ini;
+    }
+    return 0;
+}
+
+// Recorre las secciones de un archivo: cada una empieza con un descriptor de 76 bytes (tipo,
+// offset de la siguiente, tamano, adler32) y "next" o "done" cierran el archivo
+static int leer_secciones(Ewf *e, int a, uint64_t *sectores, uint32_t *bytes_sector, uint32_t *sect_chunk,
+                          uint64_t *cap) {
+    const unsigned char *m = e->arch_map[a];
+    uint64_t tam = e->arch_tam[a], off = 13, fin_sectores = 0;
+    if (tam < 13 || memcmp(m, FIRMA_EWF, 8) != 0) {
+        fprintf(stderr, "%s: no es un segmento EWF\n", e->arch_ruta[a]);
+        return -1;
+    }
+    if ((m[9] | m[10] << 8) != a + 1)
+        fprintf(stderr, "%s: dice ser el segmento %d\n", e->arch_ruta[a], m[9] | m[10] << 8);
+    while (off + LARGO_DESCRIPTOR <= tam) {
+        const unsigned char *d = m + off;
+        if (adler32(1, d, 72) != leer32(d + 72)) {
+            fprintf(stderr, "%s: seccion danada en el byte %llu\n", e->arch_ruta[a], (unsigned long long)off);
+            return -1;
+        }
+        char tipo[17];
+        memcpy(tipo, d, 16);
+        tipo[16] = '\0';
+        uint64_t siguiente = leer64(d + 16), largo = leer64(d + 24);
+        if ((strcmp(tipo, "volume") == 0 || strcmp(tipo, "disk") == 0 || strcmp(tipo, "data") == 0) &&
+            !*bytes_sector && off + LARGO_DESCRIPTOR + 24 <= tam) {
+            const unsigned char *v = d + LARGO_DESCRIPTOR;
+            *sect_chunk = leer32(v + 8);
+            *bytes_sector = leer32(v + 12);
+            *sectores = leer64(v + 16);
+        } else if (strcmp(tipo, "sectors") == 0) {
+            fin_sectores = off + largo;
+        } else if (strcmp(tipo, "table") == 0) {
+            int r = leer_tabla(e, a, off, largo, fin_sectores, cap);
+            if (r != 0) {
+                fprintf(stderr, r == -2 ? "Sin memoria para la tabla de chunks\n" : "%s: tabla de chunks danada\n",
+                        e->arch_ruta[a]);
+                return -1;
+            }
+        } else if (strcmp(tipo, "hash") == 0 && off + LARGO_DESCRIPTOR + 16 <= tam) {
+            memcpy(e->md5, d + LARGO_DESCRIPTOR, 16);
+            e->con_md5 = 1;
+        }
+        if (strcmp(tipo, "next") == 0 || strcmp(tipo, "done") == 0 || siguiente <= off) break;
+        off = siguiente;
+    }
+    return 0;
+}
+
+static int abrir_archivos(Ewf *e, const char *ruta) {
+    size_t largo = strlen(ruta);
+    const char *punto = strrchr(ruta, '.');
+    // sin extension .Exx solo se abre ese archivo
+    size_t base = punto && strlen(punto) == 4 ? (size_t)(punto + 1 - ruta) : largo;
+    char *nombre = malloc(largo + 8);
+    e->arch_map = calloc(MAX_ARCHIVOS, sizeof(unsigned char *));
+    e->arch_tam = calloc(MAX_ARCHIVOS, sizeof(uint64_t));
+    e->arch_ruta = calloc(MAX_ARCHIVOS, sizeof(char *));
+    if (!nombre || !e->arch_map || !e->arch_tam || !e->arch_ruta) {
+        free(nombre);
+        fprintf(stderr, "Sin memoria\n");
+        return -1;
+    }
+    for (int n = 1; n <= MAX_ARCHIVOS; n++) {
+        if (n == 1) strcpy(nombre, ruta);
+        else if (base == largo) break;
+        else nombre_segmento(ruta, base, n, nombre, largo + 8);
+        int fd = open(nombre, O_RDONLY);
+        if (fd < 0) {
+            if (n == 1) perror(nombre);
+            break;
+        }
+        struct stat st;
+        void *m = fstat(fd, &st) == 0 && st.st_size > 0
+                      ? mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+        close(fd);
+        if (m == MAP_FAILED) {
+            perror(nombre);
+            free(nombre);
+            return -1;
+        }
+        e->arch_map[e->n_arch] = m;
+        e->arch_tam[e->n_arch] = (uint64_t)st.st_size;
+        e->arch_ruta[e->n_arch++] = strdup(nombre);
+    }
+    free(nombre);
+    return e->n_arch ? 0 : -1;
+}
+
+// Deja el chunk c descomprimido en buf (tam_chunk bytes, con ceros al final si es corto).
+// Devuelve 0 o -1 si no se pudo: buf queda en ceros.
+static int descomprimir_chunk(const Ewf *e, uint64_t c, unsigned char *buf) {
+    const ChunkEwf *ch = &e->chunk[c];
+    const unsigned char *src = e->arch_map[ch->arch] + ch->off;
+    uLongf largo = e->tam_chunk;
+    int ok;
+    if (!ch->largo) {
+        ok = 0;
+        largo = 0;
+    } else if (ch->comprimido) {
+        ok = uncompress(buf, &largo, src, ch->largo) == Z_OK;
+        if (!ok) largo = 0;
+    } else {
+        largo = ch->largo < e->tam_chunk ? ch->largo : e->tam_chunk;
+        memcpy(buf, src, largo);
+        ok = 1;
+    }
+    if (largo < e->tam_chunk) memset(buf + largo, 0, e->tam_chunk - largo);
+    return ok ? 0 : -1;
+}
+
+// Para el mapa bajo demanda: los chunks que no venian comprimidos ya estan en la cache de
+// paginas del archivo, no vale la pena guardarlos
+static int leer_chunk(void *ctx, uint64_t c, unsigned char *buf, int *guardar) {
+    Ewf *e = ctx;
+    *guardar = e->chunk[c].comprimido;
+    return descomprimir_chunk(e, c, buf);
+}
+
+typedef struct {
+    Ewf *e;
+    int h, nhilos;
+    uint64_t ilegibles;
+} HiloTodo;
+
+static void *descomprimir_intercalados(void *arg) {
+    HiloTodo *t = arg;
+    Ewf *e = t->e;
+    unsigned char *buf = malloc(e->tam_chunk);
+    for (uint64_t c = (uint64_t)t->h; buf && c < e->n_chunks; c += (uint64_t)t->nhilos) {
+        t->ilegibles += descomprimir_chunk(e, c, buf) != 0;
+        uint64_t ini = c * e->tam_chunk;
+        memcpy(e->map + ini, buf, ini + e->tam_chunk < e->tamano ? e->tam_chunk : (size_t)(e->tamano - ini));
+    }
+    free(buf);
+    return NULL;
+}
+
+// Sin userfaultfd: todo el disco descomprimido en memoria, un hilo por nucleo
+static int descomprimir_todo(Ewf *e) {
+    fprintf(stderr, "Sin userfaultfd (o con chunks de %u bytes, menos que una pagina): se descomprimen %.1f MB al abrir\n",
+            e->tam_chunk, e->tamano / 1e6);
+    if (mprotect(e->map, e->reservado, PROT_READ | PROT_WRITE) != 0) return -1;
+    long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    int nhilos = nucleos < 1 ? 1 : nucleos > MAX_HILOS_EWF ? MAX_HILOS_EWF : (int)nucleos;
+    HiloTodo ht[MAX_HILOS_EWF];
+    pthread_t hilos[MAX_HILOS_EWF];
+    int creados[MAX_HILOS_EWF] = { 0 };
+    for (int h = 0; h < nhilos; h++) ht[h] = (HiloTodo){ e, h, nhilos, 0 };
+    for (int h = 1; h < nhilos; h++) creados[h] = pthread_create(&hilos[h], NULL, descomprimir_intercalados, &ht[h]) == 0;
+    descomprimir_intercalados(&ht[0]);
+    for (int h = 1; h < nhilos; h++) {
+        if (creados[h]) pthread_join(hilos[h], NULL);
+        else descomprimir_intercalados(&ht[h]);
+    }
+    for (int h = 0; h < nhilos; h++) e->ilegibles += ht[h].ilegibles;
+    return mprotect(e->map, e->reservado, PROT_READ);
+}
+
+int ewf_abrir(const char *ruta, Imagen *img) {
+    memset(img, 0, sizeof(*img));
+    Ewf *e = calloc(1, sizeof(Ewf));
+    if (!e) return -1;
+    img->ewf = e;
+    if (abrir_archivos(e, ruta) != 0) {
+        cerrar_imagen(img);
+        return -1;
+    }
+
+    // la tabla de chunks de cada archivo; la geometria sale de "volume" (o "disk"/"data")
+    uint64_t sectores = 0, cap = 0;
+    uint32_t bytes_sector = 0, sect_chunk = 0;
+    img->seg = calloc((size_t)e->n_arch, sizeof(SegmentoImagen));
+    if (!img->seg) {
+        cerrar_imagen(img);
+        return -1;
+    }
+    for (int a = 0; a < e->n_arch; a++) {
+        uint64_t antes = e->n_chunks;
+        if (leer_secciones(e, a, &sectores, &bytes_sector, &sect_chunk, &cap) != 0) {
+            cerrar_imagen(img);
+            return -1;
+        }
+        img->seg[a] = (SegmentoImagen){ strdup(e->arch_ruta[a]), antes, e->n_chunks - antes, NULL }; // en chunks por ahora
+        img->n_seg++;
+    }
+    if (!bytes_sector || !sect_chunk || (uint64_t)bytes_sector * sect_chunk > (64u << 20) || !e->n_chunks) {
+        fprintf(stderr, "%s: la E01 no tiene seccion \"volume\" o tabla de chunks validas\n", ruta);
+        cerrar_imagen(img);
+        return -1;
+    }
+    e->tam_chunk = bytes_sector * sect_chunk;
+    e->tamano = sectores ? sectores * bytes_sector : e->n_chunks * e->tam_chunk;
+    if ((e->tamano + e->tam_chunk - 1) / e->tam_chunk > e->n_chunks) {
+        fprintf(stderr, "%s: faltan chunks (%llu de %llu); el resto se ve en ceros\n", ruta,
+                (unsigned long long)e->n_chunks,
+                (unsigned long long)((e->tamano + e->tam_chunk - 1) / e->tam_chunk));
+        while ((e->tamano + e->tam_chunk - 1) / e->tam_chunk > e->n_chunks)
+            if (agregar_chunk(e, &cap, 0, 0, 0, 0) != 0) {
+                cerrar_imagen(img);
+                return -1;
+            }
+    }
+    e->n_chunks = (e->tamano + e->tam_chunk - 1) / e->tam_chunk;
+    for (int a = 0; a < img->n_seg; a++) {
+        SegmentoImagen *s = &img->seg[a];
+        uint64_t ini = s->inicio * e->tam_chunk, fin = (s->inicio + s->largo) * e->tam_chunk;
+        s->inicio = ini < e->tamano ? ini : e->tamano;
+        s->largo = (fin < e->tamano ? fin : e->tamano) - s->inicio;
+    }
+    img->demanda_desde = img->n_seg;
+
+    size_t pag = (size_t)sysconf(_SC_PAGESIZE);
+    e->reservado = (size_t)((e->tamano + pag - 1) / pag * pag);
+    e->map = mmap(NULL, e->reservado, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (e->map == MAP_FAILED) {
+        e->map = NULL;
+        perror("Error reservando el espacio de la imagen");
+        cerrar_imagen(img);
+        return -1;
+    }
+    img->map = e->map;
+    img->tamano = e->tamano;
+    img->reservado = e->reservado;
+    int r = demanda_abrir(&e->demanda, e->map, e->reservado, e->tam_chunk, leer_chunk, e, CACHE_EWF);
+    if (r == -2 || (r == -1 && descomprimir_todo(e) != 0)) {
+        fprintf(stderr, "Sin memoria para abrir la E01\n");
+        cerrar_imagen(img);
+        return -1;
+    }
+    return 0;
+}
+
+void ewf_cerrar(Ewf *e) {
+    if (!e) return;
+    demanda_cerrar(e->demanda);
+    for (int a = 0; a < e->n_arch; a++) {
+        munmap(e->arch_map[a], (size_t)e->arch_tam[a]);
+        free(e->arch_ruta[a]);
+    }
+    free(e->arch_map);
+    free(e->arch_tam);
+    free(e->arch_ruta);
+    free(e->chunk);
+    free(e);
+}
+
+void ewf_estadisticas(Ewf *e, EstadisticaEwf *est) {
+    EstadisticaDemanda d = { 0 };
+    if (e->demanda) demanda_estadisticas(e->demanda, &d);
+    *est = (EstadisticaEwf){ d.fallos, d.rehechos, d.aciertos, d.adelantados, d.ilegibles + e->ilegibles };
+}
+
+int ewf_md5(const Ewf *e, unsigned char md5[16]) {
+    if (!e->con_md5) return -1;
+    memcpy(md5, e->md5, 16);
+    return 0;
+}
+
+void ewf_ubicar(const Ewf *e, uint64_t off, char *buf, size_t n) {
+    uint64_t c = off / e->tam_chunk;
+    if (c >= e->n_chunks) {
+        snprintf(buf, n, "fuera de la imagen");
+        return;
+    }
+    const ChunkEwf *ch = &e->chunk[c];
+    const char *nombre = strrchr(e->arch_ruta[ch->arch], '/');
+    snprintf(buf, n, "%s chunk %llu + 0x%llx, %s", nombre ? nombre + 1 : e->arch_ruta[ch->arch],
+             (unsigned long long)c, (unsigned long long)(off % e->tam_chunk),
+             !ch->largo ? "sin datos" : ch->comprimido ? "comprimido" : "sin comprimir");
+}
@@ -0,0 +1,46 @@
+#ifndef EWF_H
+#define EWF_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "imagen.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Ewf Ewf;
+
+typedef struct {
+    uint64_t fallos;        // fallos de pagina atendidos
+    uint64_t inflados;      // chunks descomprimidos con zlib
+    uint64_t aciertos;      // fallos resueltos desde la cache de chunks, sin descomprimir
+    uint64_t adelantados;   // chunks cargados por la lectura anticipada antes de que se pidieran
+    uint64_t ilegibles;     // chunks que no se pudieron leer: quedan en ceros
+} EstadisticaEwf;
+
+// 1 si el archivo empieza con la firma de EWF ("EVF\x09\x0d\x0a\xff\x00")
+int es_ewf(const char *ruta);
+
+// Abre una imagen EnCase (.E01 y los segmentos .E02..., .EAA...) como un mapa contiguo del disco
+// adquirido. El mapa se llena bajo demanda (demanda.h) de a un chunk: el primer acceso lo
+// descomprime (zlib) y lo copia en su lugar, los descomprimidos quedan en una cache LRU y las
+// lecturas secuenciales descomprimen los siguientes por adelantado en paralelo. Sin userfaultfd
+// se descomprime todo al abrir. Deja en img->seg un segmento por archivo con los bytes del disco
+// que guarda. Devuelve 0 o -1 con el error en stderr.
+int ewf_abrir(const char *ruta, Imagen *img);
+// Detiene el llenado bajo demanda y libera lo de la EWF; el mapa lo desmapea cerrar_imagen()
+void ewf_cerrar(Ewf *e);
+
+void ewf_estadisticas(Ewf *e, EstadisticaEwf *est);
+// MD5 del disco guardado en la seccion "hash" al adquirir; 0 si lo hay, -1 si no
+int ewf_md5(const Ewf *e, unsigned char md5[16]);
+// Archivo y chunk donde esta el byte 'off' del disco, para el visor hex
+void ewf_ubicar(const Ewf *e, uint64_t off, char *buf, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
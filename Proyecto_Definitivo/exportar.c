@@ -0,0 +1,47 @@
+// exportar.c
+#include "exportar.h"
+#include "hashes.h"
+#include "fechas.h"
+#include "tiposArchivo.h"
+
+void escribir_campo_csv(FILE *out, const char *s) {
+    fputc('"', out);
+    for (; *s; s++) {
+        if (*s == '"') fputc('"', out);
+        fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+int exportar_csv(const TablaMft *t, FILE *out) {
+    IndiceRegistros ix;
+    if (indice_registros(t, &ix) != 0) return -1;
+    char ruta[4096];
+    fprintf(out, "registro,nombre,ruta,tamano,creado,modificado,cambiado,accedido,atributos,directorio,borrado,tipo,"
+                 "md5,sha1,sha256\n");
+    for (size_t i = 0; i < t->n; i++) {
+        // las cuatro fechas de $STANDARD_INFORMATION; las de $FILE_NAME van en la linea de tiempo
+        uint64_t fechas[4] = { t->creado[i], t->modificado[i], t->cambiado[i], t->accedido[i] };
+        char texto[4][FECHA_LARGO_PREC + 1];
+        for (int f = 0; f < 4; f++) filetime_to_str_prec(fechas[f], 7, texto[f], sizeof(texto[f]));
+        fprintf(out, "%u,", t->registro[i]);
+        escribir_campo_csv(out, tabla_nombre(t, i));
+        fputc(',', out);
+        ruta_completa(t, &ix, i, ruta, sizeof(ruta));
+        escribir_campo_csv(out, ruta);
+        fprintf(out, ",%llu,%s,%s,%s,%s,0x%08x,%u,%u,", (unsigned long long)t->tamano[i], texto[0], texto[1],
+                texto[2], texto[3], t->atributos[i], t->es_dir[i], (t->marcas[i] & MARCA_BORRADO) != 0);
+        escribir_campo_csv(out, nombre_tipo(t->tipo[i]));
+        if (t->hashes && (t->marcas[i] & MARCA_HASH)) {
+            char md5[2 * LARGO_MD5 + 1], sha1[2 * LARGO_SHA1 + 1], sha256[2 * LARGO_SHA256 + 1];
+            hash_a_hex(hash_md5(t, i), LARGO_MD5, md5);
+            hash_a_hex(hash_sha1(t, i), LARGO_SHA1, sha1);
+            hash_a_hex(hash_sha256(t, i), LARGO_SHA256, sha256);
+            fprintf(out, ",%s,%s,%s\n", md5, sha1, sha256);
+        } else {
+            fputs(",,,\n", out);
+        }
+    }
+    liberar_indice_registros(&ix);
+    return ferror(out) ? -1 : 0;
+}
@@ -0,0 +1,25 @@
+#ifndef EXPORTAR_H
+#define EXPORTAR_H
+
+#include <stdio.h>
+
+#include "tablaMft.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Escribe la tabla como CSV (una fila por entrada del MFT, con cabecera): registro, nombre,
+// ruta completa, tamano, las 4 fechas de $STANDARD_INFORMATION en UTC con precision de 100 ns,
+// atributos, directorio, borrado, tipo y, si la tabla ya tiene hashes (MARCA_HASH),
+// MD5/SHA-1/SHA-256 en hexadecimal; si no, esas columnas van vacias. Devuelve 0 o -1 si falta memoria o fallo la escritura.
+int exportar_csv(const TablaMft *t, FILE *out);
+
+// Campo de texto entre comillas dobles, con las comillas de adentro duplicadas (RFC 4180)
+void escribir_campo_csv(FILE *out, const char *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,111 @@
+// extraer.c
+#define _FILE_OFFSET_BITS 64
+#include "extraer.h"
+#include "imagen.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+int escribir_hueco(FILE *out, uint64_t bytes) {
+    if (bytes == 0) return 0;
+    if (fseeko(out, (off_t)bytes, SEEK_CUR) == 0) return 0;
+    static const unsigned char ceros[65536];
+    while (bytes > 0) {
+        size_t trozo = bytes < sizeof(ceros) ? (size_t)bytes : sizeof(ceros);
+        if (fwrite(ceros, 1, trozo, out) != trozo) return -1;
+        bytes -= trozo;
+    }
+    return 0;
+}
+
+size_t escribir_mapa(const unsigned char *p, size_t n, FILE *out) {
+    if (!mapa_solo_usuario) return fwrite(p, 1, n, out);
+    unsigned char buf[65536];
+    size_t hecho = 0;
+    while (hecho < n) {
+        size_t trozo = n - hecho < sizeof(buf) ? n - hecho : sizeof(buf);
+        memcpy(buf, p + hecho, trozo); // el fallo de pagina lo toma el programa y la E01 lo llena
+        size_t k = fwrite(buf, 1, trozo, out);
+        hecho += k;
+        if (k != trozo) break;
+    }
+    return hecho;
+}
+
+void cerrar_huecos(FILE *out, uint64_t tamano) {
+    // un fseeko sin escritura despues no agranda el archivo: el ultimo hueco se fija aca
+    if (fflush(out) != 0) return;
+    if (ftruncate(fileno(out), (off_t)tamano) != 0) {
+        // no es un archivo comun; los huecos ya se escribieron como ceros
+    }
+}
+
+uint64_t extraer_tramos(const VolumenNtfs *v, const Extent *ext, int n, uint64_t tamano, FILE *out,
+                        uint64_t *huecos) {
+    uint64_t escritos = 0;
+    *huecos = 0;
+    for (int e = 0; e < n && escritos < tamano; e++) {
+        uint64_t bytes = ext[e].len * v->tam_cluster;
+        if (bytes > tamano - escritos) bytes = tamano - escritos;
+        if (ext[e].lcn < 0) {
+            if (escribir_hueco(out, bytes) != 0) break;
+            escritos += bytes;
+            *huecos += bytes;
+            continue;
+        }
+        long long off = v->base + ext[e].lcn * (long long)v->tam_cluster;
+        if (off < 0 || off + (long long)bytes > v->map_size) break; // el tramo sale de la imagen
+        size_t hecho = escribir_mapa(v->map + off, (size_t)bytes, out);
+        escritos += hecho;
+        if (hecho != bytes) break;
+    }
+    if (escritos == tamano && *huecos) cerrar_huecos(out, tamano);
+    return escritos;
+}
+
+void tramos_abrir(LectorTramos *l, const VolumenNtfs *v, const Extent *ext, int n, uint64_t tamano) {
+    l->v = v;
+    l->ext = ext;
+    l->n = n;
+    l->tamano = tamano;
+    l->ultimo = 0;
+}
+
+// Tramo que contiene el VCN: primero el ultimo usado y su siguiente, si no busqueda binaria
+static int tramo_de(LectorTramos *l, uint64_t vcn) {
+    for (int i = l->ultimo; i < l->n && i <= l->ultimo + 1; i++) {
+        if (vcn >= l->ext[i].vcn && vcn < l->ext[i].vcn + l->ext[i].len) return l->ultimo = i;
+    }
+    int i = buscar_tramo(l->ext, l->n, vcn);
+    if (i >= 0) l->ultimo = i;
+    return i;
+}
+
+long long tramos_fisico(LectorTramos *l, uint64_t off) {
+    if (off >= l->tamano) return -1;
+    uint64_t vcn = off / l->v->tam_cluster;
+    int i = tramo_de(l, vcn);
+    if (i < 0 || l->ext[i].lcn < 0) return -1;
+    return l->v->base + (long long)(l->ext[i].lcn + (vcn - l->ext[i].vcn)) * l->v->tam_cluster
+           + (long long)(off % l->v->tam_cluster);
+}
+
+size_t tramos_leer(LectorTramos *l, uint64_t off, unsigned char *buf, size_t n) {
+    if (off >= l->tamano) return 0;
+    if (n > l->tamano - off) n = (size_t)(l->tamano - off);
+    size_t hecho = 0;
+    while (hecho < n) {
+        uint64_t pos = off + hecho;
+        uint64_t vcn = pos / l->v->tam_cluster;
+        int i = tramo_de(l, vcn);
+        // hasta el final del tramo (o del cluster si no hay tramo)
+        uint64_t fin_tramo = (i >= 0 ? l->ext[i].vcn + l->ext[i].len : vcn + 1) * l->v->tam_cluster;
+        size_t k = (fin_tramo - pos < n - hecho) ? (size_t)(fin_tramo - pos) : n - hecho;
+        long long fis = tramos_fisico(l, pos);
+        if (fis < 0 || fis + (long long)k > l->v->map_size) memset(buf + hecho, 0, k);
+        else memcpy(buf + hecho, l->v->map + fis, k);
+        hecho += k;
+    }
+    return n;
+}
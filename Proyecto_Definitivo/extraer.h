@@ -0,0 +1,56 @@
+#ifndef EXTRAER_H
+#define EXTRAER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ntfsVolumen.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Avanza 'bytes' en la salida sin escribirlos, asi el archivo queda disperso (el sistema de
+// archivos no reserva bloques para el hueco). Si la salida no admite fseeko (un pipe) escribe
+// ceros. Devuelve 0 o -1 si fallo.
+int escribir_hueco(FILE *out, uint64_t bytes);
+
+// fwrite de 'n' bytes del mapa de la imagen. Con mapa_solo_usuario el kernel no puede leer las
+// partes del mapa que todavia no se cargaron: se copian de a pedazos a un buffer desde el programa.
+// Devuelve los bytes escritos.
+size_t escribir_mapa(const unsigned char *p, size_t n, FILE *out);
+
+// Deja el archivo en 'tamano' bytes aunque termine en un hueco (ftruncate)
+void cerrar_huecos(FILE *out, uint64_t tamano);
+
+// Escribe los primeros 'tamano' bytes de un atributo no residente siguiendo su runlist; los
+// tramos dispersos (lcn < 0) quedan como huecos. Devuelve los bytes logicos escritos (menos que
+// 'tamano' si un tramo sale de la imagen o fallo la escritura) y en *huecos cuantos fueron hueco.
+uint64_t extraer_tramos(const VolumenNtfs *v, const Extent *ext, int n, uint64_t tamano, FILE *out,
+                        uint64_t *huecos);
+
+// Lectura por offset logico de un atributo no residente: los tramos se ven como un solo
+// espacio de direcciones (VCN -> LCN por busqueda binaria, con el ultimo tramo usado como
+// atajo para que leer lineas seguidas no dependa del numero de tramos)
+typedef struct {
+    const VolumenNtfs *v;
+    const Extent *ext;
+    int n;
+    uint64_t tamano;
+    int ultimo;             // indice del ultimo tramo usado
+} LectorTramos;
+
+void tramos_abrir(LectorTramos *l, const VolumenNtfs *v, const Extent *ext, int n, uint64_t tamano);
+
+// Copia hasta 'n' bytes desde 'off'; los tramos dispersos o fuera de la imagen se leen como ceros.
+// Devuelve cuantos copio (0 al final).
+size_t tramos_leer(LectorTramos *l, uint64_t off, unsigned char *buf, size_t n);
+
+// Offset absoluto en el mapa del byte logico 'off', -1 si es disperso o no esta en el runlist
+long long tramos_fisico(LectorTramos *l, uint64_t off);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,161 @@
+// fechas.c
+#include "fechas.h"
+
+#include <string.h>
+#include <time.h>
+
+#define FILETIME_UNIX     116444736000000000LL // diferencia entre 1601 y 1970 en unidades de 100ns
+#define FILETIME_POR_SEG  10000000LL
+
+// Tramos de tiempo (segundos Unix, [desde, hasta)) con el mismo desfase local: cada horario de
+// verano o de invierno visto. Se llena a medida que aparecen fechas de otros periodos.
+typedef struct {
+    int64_t desde, hasta;
+    long desfase;
+} PeriodoLocal;
+
+#define MAX_PERIODOS  256
+#define DIAS_BUSQUEDA 370 // hasta donde se busca el borde de un periodo a cada lado
+
+static int usar_hora_local = 0;
+static PeriodoLocal periodos[MAX_PERIODOS];
+static int n_periodos = 0;
+static int ultimo_periodo = 0;
+
+static long desfase_en(int64_t t) {
+    time_t tt = (time_t)t;
+    struct tm tm;
+    return localtime_r(&tt, &tm) ? tm.tm_gmtoff : 0;
+}
+
+// Ultimo segundo con el mismo desfase que t yendo hacia sentido (+1/-1): avanza de a un dia
+// hasta que el desfase cambia y despues busca el segundo exacto por biseccion
+static int64_t borde_periodo(int64_t t, long desfase, int sentido) {
+    int64_t bueno = t, malo = t;
+    int dia;
+    for (dia = 1; dia <= DIAS_BUSQUEDA; dia++) {
+        malo = t + sentido * (int64_t)dia * 86400;
+        if (desfase_en(malo) != desfase) break;
+        bueno = malo;
+    }
+    if (dia > DIAS_BUSQUEDA) return bueno;
+    while (bueno - malo > 1 || malo - bueno > 1) {
+        int64_t medio = bueno + (malo - bueno) / 2;
+        if (desfase_en(medio) == desfase) bueno = medio;
+        else malo = medio;
+    }
+    return bueno;
+}
+
+static long desfase_local(int64_t seg) {
+    if (!usar_hora_local) return 0;
+    if (n_periodos > 0) {
+        const PeriodoLocal *u = &periodos[ultimo_periodo];
+        if (seg >= u->desde && seg < u->hasta) return u->desfase;
+        for (int i = 0; i < n_periodos; i++)
+            if (seg >= periodos[i].desde && seg < periodos[i].hasta) {
+                ultimo_periodo = i;
+                return periodos[i].desfase;
+            }
+    }
+    if (n_periodos == MAX_PERIODOS) n_periodos = 0;
+    PeriodoLocal *p = &periodos[n_periodos];
+    p->desfase = desfase_en(seg);
+    p->desde = borde_periodo(seg, p->desfase, -1);
+    p->hasta = borde_periodo(seg, p->desfase, 1) + 1;
+    ultimo_periodo = n_periodos++;
+    return p->desfase;
+}
+
+void fechas_iniciar(int usar_local) {
+    usar_hora_local = usar_local;
+    n_periodos = 0;
+    ultimo_periodo = 0;
+}
+
+// Dias desde 1970-01-01 a fecha civil (algoritmo de Howard Hinnant, sin tablas ni bucles)
+static void civil_desde_dias(int64_t z, int64_t *y, unsigned *m, unsigned *d) {
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = (unsigned)(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    *d = doy - (153 * mp + 2) / 5 + 1;
+    *m = mp < 10 ? mp + 3 : mp - 9;
+    *y = (int64_t)yoe + era * 400 + (*m <= 2);
+}
+
+static char *dos_digitos(char *p, unsigned v) {
+    p[0] = (char)('0' + v / 10);
+    p[1] = (char)('0' + v % 10);
+    return p + 2;
+}
+
+void filetime_to_str_prec(uint64_t ft, int decimales, char *out, size_t out_sz) {
+    if (out_sz == 0) return;
+    if (ft == 0) {
+        strncpy(out, "(sin fecha)", out_sz);
+        out[out_sz - 1] = '\0';
+        return;
+    }
+    if (decimales < 0) decimales = 0;
+    if (decimales > 7) decimales = 7;
+
+    // FILETIME es sin signo hasta el ano 60056: division con piso para fechas previas a 1970
+    int64_t t = (int64_t)(ft - (uint64_t)FILETIME_UNIX);
+    int64_t seg = t / FILETIME_POR_SEG;
+    int64_t frac = t % FILETIME_POR_SEG;
+    if (frac < 0) {
+        frac += FILETIME_POR_SEG;
+        seg--;
+    }
+    seg += desfase_local(seg);
+    int64_t dias = seg / 86400;
+    int64_t resto = seg % 86400;
+    if (resto < 0) {
+        resto += 86400;
+        dias--;
+    }
+
+    int64_t y;
+    unsigned m, d;
+    civil_desde_dias(dias, &y, &m, &d);
+
+    char buf[FECHA_LARGO_PREC + 8];
+    char *p = buf;
+    if (y < 0 || y > 9999) {
+        strncpy(out, "(fecha invalida)", out_sz);
+        out[out_sz - 1] = '\0';
+        return;
+    }
+    p = dos_digitos(p, (unsigned)(y / 100));
+    p = dos_digitos(p, (unsigned)(y % 100));
+    *p++ = '-';
+    p = dos_digitos(p, m);
+    *p++ = '-';
+    p = dos_digitos(p, d);
+    *p++ = ' ';
+    p = dos_digitos(p, (unsigned)(resto / 3600));
+    *p++ = ':';
+    p = dos_digitos(p, (unsigned)(resto / 60 % 60));
+    *p++ = ':';
+    p = dos_digitos(p, (unsigned)(resto % 60));
+    if (decimales > 0) {
+        *p++ = '.';
+        unsigned f = (unsigned)frac;
+        char digitos[7];
+        for (int i = 6; i >= 0; i--) {
+            digitos[i] = (char)('0' + f % 10);
+            f /= 10;
+        }
+        memcpy(p, digitos, decimales);
+        p += decimales;
+    }
+    *p = '\0';
+
+    size_t largo = (size_t)(p - buf);
+    if (largo >= out_sz) largo = out_sz - 1;
+    memcpy(out, buf, largo);
+    out[largo] = '\0';
+}
@@ -0,0 +1,32 @@
+#ifndef FECHAS_H
+#define FECHAS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Largo de "AAAA-MM-DD HH:MM:SS" y de "AAAA-MM-DD HH:MM:SS.fffffff" sin el '\0'
+#define FECHA_LARGO      19
+#define FECHA_LARGO_PREC 27
+
+// usar_local = 0 deja todo en UTC. Con hora local el desfase se guarda por periodo (horario de
+// verano/invierno de cada ano, con sus bordes exactos) para no llamar a localtime_r por cada
+// fecha. La cache no es segura entre hilos: la hora local solo se usa desde la interfaz.
+void fechas_iniciar(int usar_local);
+
+// FILETIME (100 ns desde 1601) a texto. decimales = 0..7 digitos de fraccion de segundo.
+// Un FILETIME 0 se muestra como "(sin fecha)". No usa localtime_r ni strftime.
+void filetime_to_str_prec(uint64_t ft, int decimales, char *out, size_t out_sz);
+
+static inline void filetime_to_str(uint64_t ft, char *out, size_t out_sz) {
+    filetime_to_str_prec(ft, 0, out, out_sz);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,237 @@
+// firmas.c
+#define _GNU_SOURCE // memmem
+#include "firmas.h"
+#include "compresion.h"
+#include "ordenMft.h"
+#include "tiposArchivo.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#define B(t) (1ULL << (t))
+
+// Tipos por extension que nunca se marcan: no dicen nada del contenido
+#define COMPAT_SIEMPRE (B(TIPO_DATOS) | B(TIPO_TEMPORAL) | B(TIPO_DISCO_VIRTUAL))
+
+typedef struct {
+    uint16_t offset;
+    uint8_t largo;
+    unsigned char bytes[16];
+    uint8_t tipo;
+    uint64_t compatibles;
+} Firma;
+
+// Ordenadas de la mas larga a la mas corta dentro de lo posible, la primera que coincide gana
+static const Firma firmas[] = {
+    { 0, 16, "SQLite format 3\0", TIPO_BASE_DATOS, B(TIPO_BASE_DATOS) | B(TIPO_SISTEMA) | B(TIPO_CONFIG) },
+    { 0, 8, "\x89PNG\r\n\x1a\n", TIPO_PNG, B(TIPO_PNG) | B(TIPO_IMAGEN) },
+    { 0, 8, "\xd0\xcf\x11\xe0\xa1\xb1\x1a\xe1", TIPO_DOCUMENTO,
+      B(TIPO_WORD) | B(TIPO_EXCEL) | B(TIPO_PRESENTACION) | B(TIPO_DOCUMENTO) | B(TIPO_CORREO) |
+      B(TIPO_EJECUTABLE) | B(TIPO_SISTEMA) | B(TIPO_IMAGEN) | B(TIPO_BASE_DATOS) },
+    { 0, 8, "ElfFile\0", TIPO_SISTEMA, B(TIPO_SISTEMA) | B(TIPO_LOG) },
+    { 0, 8, "vhdxfile", TIPO_DISCO_VIRTUAL, B(TIPO_DISCO_VIRTUAL) },
+    { 0, 8, "conectix", TIPO_DISCO_VIRTUAL, B(TIPO_DISCO_VIRTUAL) },
+    { 0, 8, "EVF\x09\x0d\x0a\xff\x00", TIPO_DISCO_VIRTUAL, B(TIPO_DISCO_VIRTUAL) },
+    { 0, 8, "L\0\0\0\x01\x14\x02\0", TIPO_ACCESO_DIRECTO, B(TIPO_ACCESO_DIRECTO) },
+    { 0, 6, "7z\xbc\xaf\x27\x1c", TIPO_COMPRIMIDO, B(TIPO_COMPRIMIDO) },
+    { 0, 6, "Rar!\x1a\x07", TIPO_COMPRIMIDO, B(TIPO_COMPRIMIDO) },
+    { 0, 6, "\xfd" "7zXZ\0", TIPO_COMPRIMIDO, B(TIPO_COMPRIMIDO) },
+    { 0, 6, "GIF87a", TIPO_IMAGEN, B(TIPO_IMAGEN) },
+    { 0, 6, "GIF89a", TIPO_IMAGEN, B(TIPO_IMAGEN) },
+    { 0, 5, "%PDF-", TIPO_PDF, B(TIPO_PDF) | B(TIPO_IMAGEN) },
+    { 0, 5, "{\\rtf", TIPO_DOCUMENTO, B(TIPO_DOCUMENTO) | B(TIPO_WORD) },
+    { 0, 5, "<?xml", TIPO_DATOS, B(TIPO_DATOS) | B(TIPO_HTML) | B(TIPO_CONFIG) | B(TIPO_IMAGEN) |
+      B(TIPO_TEXTO) | B(TIPO_CODIGO) | B(TIPO_SISTEMA) | B(TIPO_ARCHIVO) },
+    { 0, 4, "\x7f" "ELF", TIPO_EJECUTABLE, B(TIPO_EJECUTABLE) | B(TIPO_SISTEMA) | B(TIPO_ARCHIVO) },
+    { 0, 4, "PK\x03\x04", TIPO_COMPRIMIDO, 0 }, // se refina mirando los nombres internos
+    { 0, 4, "PK\x05\x06", TIPO_COMPRIMIDO, B(TIPO_COMPRIMIDO) },
+    { 0, 4, "regf", TIPO_SISTEMA, B(TIPO_SISTEMA) | B(TIPO_ARCHIVO) },
+    { 0, 4, "!BDN", TIPO_CORREO, B(TIPO_CORREO) },
+    { 0, 4, "KDMV", TIPO_DISCO_VIRTUAL, B(TIPO_DISCO_VIRTUAL) },
+    { 0, 4, "OggS", TIPO_AUDIO, B(TIPO_AUDIO) | B(TIPO_VIDEO) },
+    { 0, 4, "fLaC", TIPO_AUDIO, B(TIPO_AUDIO) },
+    { 0, 4, "\x1a\x45\xdf\xa3", TIPO_VIDEO, B(TIPO_VIDEO) | B(TIPO_AUDIO) },
+    { 0, 4, "wOFF", TIPO_FUENTE, B(TIPO_FUENTE) },
+    { 0, 4, "wOF2", TIPO_FUENTE, B(TIPO_FUENTE) },
+    { 0, 4, "OTTO", TIPO_FUENTE, B(TIPO_FUENTE) },
+    { 0, 4, "II*\0", TIPO_IMAGEN, B(TIPO_IMAGEN) },
+    { 0, 4, "MM\0*", TIPO_IMAGEN, B(TIPO_IMAGEN) },
+    { 0, 4, "8BPS", TIPO_IMAGEN, B(TIPO_IMAGEN) },
+    { 4, 4, "ftyp", TIPO_VIDEO, B(TIPO_VIDEO) | B(TIPO_AUDIO) | B(TIPO_IMAGEN) },
+    { 0, 3, "\xff\xd8\xff", TIPO_JPEG, B(TIPO_JPEG) | B(TIPO_IMAGEN) },
+    { 0, 3, "ID3", TIPO_AUDIO, B(TIPO_AUDIO) },
+    { 0, 3, "\x1f\x8b\x08", TIPO_COMPRIMIDO, B(TIPO_COMPRIMIDO) | B(TIPO_DISCO_VIRTUAL) },
+    { 0, 3, "BZh", TIPO_COMPRIMIDO, B(TIPO_COMPRIMIDO) },
+    { 0, 2, "MZ", TIPO_EJECUTABLE, B(TIPO_EJECUTABLE) | B(TIPO_SISTEMA) | B(TIPO_FUENTE) |
+      B(TIPO_COMPRIMIDO) | B(TIPO_SCRIPT) },
+};
+
+#define NUM_FIRMAS (sizeof(firmas) / sizeof(firmas[0]))
+
+static int contiene(const unsigned char *buf, size_t n, const char *s) {
+    return memmem(buf, n, s, strlen(s)) != NULL;
+}
+
+// Texto plano: sin bytes de control salvo espacios; UTF-8 o Latin-1 pasan
+static int parece_texto(const unsigned char *buf, size_t n) {
+    if (n == 0) return 0;
+    if (n >= 2 && ((buf[0] == 0xff && buf[1] == 0xfe) || (buf[0] == 0xfe && buf[1] == 0xff))) return 1; // BOM UTF-16
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = buf[i];
+        if (c < 0x20 && c != '\t' && c != '\n' && c != '\r' && c != '\f' && c != 0x1b) return 0;
+        if (c == 0x7f) return 0;
+    }
+    return 1;
+}
+
+uint8_t detectar_contenido(const unsigned char *buf, size_t n, uint64_t *compatibles) {
+    uint64_t compat = 0;
+    uint8_t tipo = TIPO_ARCHIVO;
+
+    for (size_t f = 0; f < NUM_FIRMAS; f++) {
+        const Firma *fi = &firmas[f];
+        if (n < (size_t)fi->offset + fi->largo || memcmp(buf + fi->offset, fi->bytes, fi->largo) != 0) continue;
+        tipo = fi->tipo;
+        compat = fi->compatibles;
+        if (memcmp(fi->bytes, "PK\x03\x04", 4) == 0) {
+            // ZIP: OOXML, OpenDocument y Java/Android se reconocen por las entradas
+            if (contiene(buf, n, "word/")) tipo = TIPO_WORD;
+            else if (contiene(buf, n, "xl/")) tipo = TIPO_EXCEL;
+            else if (contiene(buf, n, "ppt/")) tipo = TIPO_PRESENTACION;
+            else if (contiene(buf, n, "mimetypeapplication/vnd.oasis")) tipo = TIPO_DOCUMENTO;
+            else if (contiene(buf, n, "mimetypeapplication/epub")) tipo = TIPO_DOCUMENTO;
+            else if (contiene(buf, n, "META-INF/") || contiene(buf, n, "AndroidManifest")) tipo = TIPO_EJECUTABLE;
+            compat = B(TIPO_COMPRIMIDO) | B(tipo);
+            if (tipo == TIPO_COMPRIMIDO) {
+                // el principio no alcanzo para decidir
+                compat |= B(TIPO_WORD) | B(TIPO_EXCEL) | B(TIPO_PRESENTACION) | B(TIPO_DOCUMENTO) |
+                          B(TIPO_EJECUTABLE) | B(TIPO_FUENTE);
+            }
+        } else if (tipo == TIPO_EJECUTABLE && fi->largo == 2) {
+            // MZ solo cuenta si e_lfanew apunta a una cabecera PE
+            uint32_t pe = n >= 0x40 ? (uint32_t)buf[0x3c] | (uint32_t)buf[0x3d] << 8 |
+                                      (uint32_t)buf[0x3e] << 16 | (uint32_t)buf[0x3f] << 24 : 0;
+            if (n < 0x40 || (uint64_t)pe + 4 > n || memcmp(buf + pe, "PE\0\0", 4) != 0) {
+                tipo = TIPO_ARCHIVO;
+                compat = 0;
+                continue;
+            }
+        }
+        break;
+    }
+
+    if (tipo == TIPO_ARCHIVO && parece_texto(buf, n)) {
+        tipo = TIPO_TEXTO;
+        // texto es compatible con todo lo que suele ser texto, y con no tener extension
+        compat = B(TIPO_TEXTO) | B(TIPO_HTML) | B(TIPO_CODIGO) | B(TIPO_SCRIPT) | B(TIPO_CONFIG) |
+                 B(TIPO_DATOS) | B(TIPO_LOG) | B(TIPO_CORREO) | B(TIPO_CERTIFICADO) |
+                 B(TIPO_ACCESO_DIRECTO) | B(TIPO_DOCUMENTO) | B(TIPO_SISTEMA) | B(TIPO_IMAGEN) |
+                 B(TIPO_ARCHIVO);
+    }
+
+    if (compatibles) *compatibles = compat | COMPAT_SIEMPRE;
+    return tipo;
+}
+
+static double ahora_seg(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#define PREFETCH_ADELANTE 32 // archivos que se piden al kernel antes de leerlos
+
+// Principio descomprimido de un $DATA comprimido (LZNT1): el primer tramo en el mapa son los
+// datos comprimidos. Devuelve los bytes leidos o -1 si falta memoria.
+static long leer_comprimido(const VolumenNtfs *v, const TablaMft *t, size_t i, unsigned char *buf, size_t n) {
+    LectorComprimido l;
+    if (lector_abrir(&l, v, t->tramos + t->tramo_ini[i], (int)t->tramo_n[i], t->tamano[i], t->compresion[i]) != 0)
+        return -1;
+    size_t hecho = 0, k;
+    while (hecho < n && (k = lector_leer(&l, hecho, buf + hecho, n - hecho)) > 0) hecho += k;
+    lector_cerrar(&l);
+    return (long)hecho;
+}
+
+int analizar_contenido(const VolumenNtfs *v, TablaMft *t, EstadisticaContenido *est) {
+    memset(est, 0, sizeof(*est));
+    double inicio = ahora_seg();
+
+    // solo los archivos con datos, ordenados por offset fisico (el orden de los LCN)
+    uint64_t *claves = malloc((t->n ? t->n : 1) * sizeof(uint64_t));
+    uint32_t *orden = malloc((t->n ? t->n : 1) * sizeof(uint32_t));
+    if (!claves || !orden) {
+        free(claves);
+        free(orden);
+        return -1;
+    }
+    size_t m = 0;
+    for (size_t i = 0; i < t->n; i++) {
+        t->contenido[i] = TIPO_ARCHIVO;
+        t->marcas[i] &= (uint8_t)~MARCA_DISCORDANTE;
+        if (t->es_dir[i] || t->tamano[i] == 0) continue;
+        int comprimido = t->compresion[i] && t->tramo_n[i];
+        if (!comprimido && (t->data_len[i] == 0 || (t->data_off[i] < 0 && !tabla_residente(t, i)))) continue;
+        claves[m] = t->data_off[i] >= 0 ? (uint64_t)t->data_off[i] : UINT64_MAX;
+        orden[m++] = (uint32_t)i;
+    }
+    if (radix_ordenar(claves, orden, m) != 0) {
+        free(claves);
+        free(orden);
+        return -1;
+    }
+
+    long pagina = sysconf(_SC_PAGESIZE);
+    unsigned char buf[BYTES_ANALISIS];
+    int error = 0;
+    for (size_t j = 0; j < m; j++) {
+        if (j + PREFETCH_ADELANTE < m && claves[j + PREFETCH_ADELANTE] != UINT64_MAX) {
+            long off = (long)claves[j + PREFETCH_ADELANTE];
+            long ini = off & ~(pagina - 1);
+            long fin = off + BYTES_ANALISIS < v->map_size ? off + BYTES_ANALISIS : v->map_size;
+            madvise((void *)(v->map + ini), (size_t)(fin - ini), MADV_WILLNEED);
+        }
+
+        uint32_t i = orden[j];
+        size_t n = t->tamano[i] < BYTES_ANALISIS ? (size_t)t->tamano[i] : BYTES_ANALISIS;
+        const unsigned char *datos;
+        if (t->compresion[i] && t->tramo_n[i]) {
+            long leidos = leer_comprimido(v, t, i, buf, n);
+            if (leidos < 0) {
+                error = 1;
+                break;
+            }
+            n = (size_t)leidos;
+            datos = buf;
+        } else {
+            // residente: la copia del registro con los fixups aplicados
+            datos = tabla_residente(t, i);
+            if (n > t->data_len[i]) n = t->data_len[i];
+            if (!datos) {
+                if (t->data_off[i] + (long)n > v->map_size) n = (size_t)(v->map_size - t->data_off[i]);
+                datos = v->map + t->data_off[i];
+            }
+        }
+
+        uint64_t compat;
+        uint8_t tipo = detectar_contenido(datos, n, &compat);
+        t->contenido[i] = tipo;
+        est->archivos++;
+        est->bytes += n;
+        if (tipo == TIPO_ARCHIVO) continue;
+        est->reconocidos++;
+        // los tipos definidos en tipos.conf no se sabe que contienen
+        if (t->tipo[i] < NUM_TIPOS && !(compat & B(t->tipo[i]))) {
+            t->marcas[i] |= MARCA_DISCORDANTE;
+            est->discordantes++;
+        }
+    }
+
+    free(claves);
+    free(orden);
+    est->segundos = ahora_seg() - inicio;
+    return error ? -1 : 0;
+}
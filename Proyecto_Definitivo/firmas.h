@@ -0,0 +1,38 @@
+#ifndef FIRMAS_H
+#define FIRMAS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "tablaMft.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BYTES_ANALISIS 4096 // cuanto se lee del principio de cada archivo
+
+typedef struct {
+    size_t archivos;        // archivos con datos que se leyeron
+    size_t reconocidos;     // con una firma conocida
+    size_t discordantes;    // la extension no cuadra con el contenido
+    uint64_t bytes;
+    double segundos;
+} EstadisticaContenido;
+
+// Clasifica el principio de un archivo por sus bytes magicos. Devuelve el tipo (TIPO_ARCHIVO si
+// no se reconoce) y, si compatibles no es NULL, la mascara (1 << TipoArchivo) de los tipos por
+// extension que no se consideran discordantes con ese contenido.
+uint8_t detectar_contenido(const unsigned char *buf, size_t n, uint64_t *compatibles);
+
+// Lee los primeros BYTES_ANALISIS de cada archivo de la tabla (primer tramo de $DATA, la copia
+// residente o, si esta comprimido, su primera unidad descomprimida), llena t->contenido y marca
+// MARCA_DISCORDANTE. Las lecturas van ordenadas por offset fisico para recorrer el disco de
+// corrido. Devuelve 0 o -1 si falta memoria.
+int analizar_contenido(const VolumenNtfs *v, TablaMft *t, EstadisticaContenido *est);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
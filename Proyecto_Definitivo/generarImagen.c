@@ -0,0 +1,1010 @@
+// generarImagen.c
+//
+// Genera una imagen cruda (MBR + una particion NTFS) sintetica para medir como escalan el
+// escaneo y la extraccion con volumenes grandes o raros. Todo sale de un generador
+// pseudoaleatorio con semilla, asi que la misma linea de comandos da siempre los mismos bytes.
+// Trae $MFT fragmentado (con tramos fuera de orden), un arbol de directorios con una rama muy
+// profunda, flujos alternativos, archivos comprimidos (LZNT1), dispersos, fragmentados y partidos
+// en registros de extension, borrados (algunos con el runlist fuera del volumen o el directorio
+// padre ya reusado) y registros con el fixup roto. No escribe indices de directorio, $LogFile ni
+// $UpCase reales: solo lo que lee este programa.
+//
+//     gcc -O2 generarImagen.c -o generar_imagen
+//     ./generar_imagen [-n registros] [-s semilla] [-f tramos_mft] [-p profundidad] [-z] salida.img
+//
+// La salida es un archivo disperso: los huecos entre tramos y, con -z, el contenido de los
+// archivos no ocupan disco (se leen como ceros).
+#define _FILE_OFFSET_BITS 64
+#include "ntfs.h"
+#include "runlist.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define BYTES_SECTOR     512
+#define SECTORES_CLUSTER 8
+#define TAM_CLUSTER      (BYTES_SECTOR * SECTORES_CLUSTER)
+#define TAM_REGISTRO     1024
+#define LBA_PARTICION    2048
+#define BASE_PARTICION   ((long long)LBA_PARTICION * BYTES_SECTOR)
+#define PRIMER_USUARIO   16      // los registros 0-15 son del sistema
+#define LOTE_REGISTROS   4096    // registros que se juntan antes de escribirlos
+#define MAX_TRAMOS_MFT   48      // el runlist de $MFT tiene que entrar en el registro 0
+#define UNIDAD_COMPRESION 16     // clusters (wCompressionSize = 4)
+#define FILETIME_2015    130645440000000000ULL
+#define FILETIME_DIA     864000000000ULL
+
+// Porcentajes (sobre 1000) de cada clase de registro de usuario
+#define POR_MIL_DIRECTORIO  60
+#define POR_MIL_BORRADO     80
+#define POR_MIL_ROTO         1   // fixup que no coincide: leer_registro() lo rechaza
+#define POR_MIL_COMPRIMIDO  10
+#define POR_MIL_DISPERSO     5
+#define POR_MIL_EXTENSION   15
+#define POR_MIL_FRAGMENTADO 30
+#define POR_MIL_FLUJO       50
+
+typedef struct {
+    int fd;
+    int sin_contenido;
+    uint64_t semilla;
+    uint64_t semilla_datos, datos;  // contenido: aparte, para que -z no cambie los metadatos
+
+    // $MFT: tramos en orden de VCN; 'zonas' son los mismos ordenados por LCN para saltarlos
+    Extent mft[MAX_TRAMOS_MFT], zonas[MAX_TRAMOS_MFT];
+    int mft_n;
+    uint64_t registros;
+
+    uint64_t cursor;            // proximo cluster libre para datos
+    int zona;                   // primera zona que puede estar delante del cursor
+    uint8_t *bitmap;            // $Bitmap que se va armando
+    uint64_t bitmap_clusters;   // clusters que cubre 'bitmap' (crece)
+
+    unsigned char *lote;        // LOTE_REGISTROS registros desde 'lote_ini'
+    uint64_t lote_ini;
+    unsigned char sistema[PRIMER_USUARIO][TAM_REGISTRO];
+
+    uint32_t *dirs;             // directorios vivos ya creados (para elegir padre)
+    uint16_t *dirs_sec;
+    size_t dirs_n, dirs_cap;
+    uint32_t dir_borrado;       // ultimo directorio borrado (padre de otros borrados)
+
+    unsigned char *buf;         // contenido de un archivo antes de escribirlo
+    size_t buf_cap;
+
+    struct {
+        uint64_t archivos, directorios, borrados, runlist_fuera, rotos, comprimidos, dispersos,
+                 extensiones, fragmentados, flujos, de_borrado, huerfanos, bytes_datos;
+    } cuenta;
+} Generador;
+
+// splitmix64: rapido, de 64 bits y el mismo en todas las plataformas
+static uint64_t splitmix(uint64_t *estado) {
+    uint64_t z = (*estado += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static uint64_t azar(Generador *g) {
+    return splitmix(&g->semilla);
+}
+
+static uint64_t azar_hasta(Generador *g, uint64_t n) {
+    return n ? azar(g) % n : 0;
+}
+
+static int por_mil(Generador *g, int p) {
+    return (int)azar_hasta(g, 1000) < p;
+}
+
+static int escribir_en(Generador *g, long long off, const void *p, size_t n) {
+    const unsigned char *b = p;
+    while (n > 0) {
+        ssize_t k = pwrite(g->fd, b, n, off);
+        if (k <= 0) return -1;
+        b += k;
+        off += k;
+        n -= (size_t)k;
+    }
+    return 0;
+}
+
+// --- $Bitmap y reserva de clusters ---
+
+static int marcar_clusters(Generador *g, uint64_t lcn, uint64_t n) {
+    if (lcn + n > g->bitmap_clusters) {
+        uint64_t nuevo = g->bitmap_clusters ? g->bitmap_clusters : 1 << 20;
+        while (nuevo < lcn + n) nuevo *= 2;
+        uint8_t *b = realloc(g->bitmap, nuevo / 8);
+        if (!b) return -1;
+        memset(b + g->bitmap_clusters / 8, 0, (nuevo - g->bitmap_clusters) / 8);
+        g->bitmap = b;
+        g->bitmap_clusters = nuevo;
+    }
+    for (uint64_t c = lcn; c < lcn + n; c++) g->bitmap[c >> 3] |= (uint8_t)(1u << (c & 7));
+    return 0;
+}
+
+// 'n' clusters seguidos desde el cursor, saltando los tramos de $MFT
+static uint64_t reservar_clusters(Generador *g, uint64_t n) {
+    for (;;) {
+        while (g->zona < g->mft_n && (uint64_t)g->zonas[g->zona].lcn + g->zonas[g->zona].len <= g->cursor) g->zona++;
+        if (g->zona == g->mft_n || g->cursor + n <= (uint64_t)g->zonas[g->zona].lcn) break;
+        g->cursor = (uint64_t)g->zonas[g->zona].lcn + g->zonas[g->zona].len;
+    }
+    uint64_t lcn = g->cursor;
+    g->cursor += n;
+    return lcn;
+}
+
+// --- registros ---
+
+typedef struct {
+    unsigned char *r;
+    uint32_t pos;           // donde va el proximo atributo
+    uint16_t id;
+} Registro;
+
+static void registro_iniciar(Registro *x, unsigned char *buf, uint64_t num, uint16_t secuencia, uint16_t flags,
+                             uint64_t base_ref) {
+    memset(buf, 0, TAM_REGISTRO);
+    struct NTFS_MFT_FILE *h = (struct NTFS_MFT_FILE *)buf;
+    memcpy(h->szSignature, "FILE", 4);
+    h->wFixupOffset = 0x30;
+    h->wFixupSize = TAM_REGISTRO / 512 + 1;
+    h->n64LogSeqNumber = 0;
+    h->wSequence = secuencia;
+    h->wHardLinks = 1;
+    h->wAttribOffset = 0x38;
+    h->wFlags = flags;
+    h->dwAllLength = TAM_REGISTRO;
+    h->n64BaseMftRec = base_ref;
+    h->dwMFTRecNumber = (DWORD)num;
+    x->r = buf;
+    x->pos = 0x38;
+    x->id = 0;
+}
+
+// Espacio para un atributo de 'largo' bytes (ya alineado a 8); NULL si no entra
+static NTFS_ATTRIBUTE *registro_atributo(Registro *x, uint32_t tipo, uint32_t largo) {
+    if (x->pos + largo + 8 > TAM_REGISTRO - 8) return NULL;
+    NTFS_ATTRIBUTE *a = (NTFS_ATTRIBUTE *)(x->r + x->pos);
+    a->dwType = tipo;
+    a->dwFullLength = largo;
+    a->wID = x->id++;
+    x->pos += largo;
+    return a;
+}
+
+static void attr_nombre(NTFS_ATTRIBUTE *a, uint16_t off, const uint16_t *nombre, int nlen) {
+    a->uchNameLength = (BYTE)nlen;
+    a->wNameOffset = off;
+    if (nlen) memcpy((unsigned char *)a + off, nombre, nlen * 2u);
+}
+
+static int attr_residente(Registro *x, uint32_t tipo, const uint16_t *nombre, int nlen, const void *valor,
+                          uint32_t largo) {
+    uint32_t off = (24 + nlen * 2u + 7) & ~7u;
+    NTFS_ATTRIBUTE *a = registro_atributo(x, tipo, (off + largo + 7) & ~7u);
+    if (!a) return -1;
+    attr_nombre(a, 24, nombre, nlen);
+    a->Attr.Resident.dwLength = largo;
+    a->Attr.Resident.wAttrOffset = (WORD)off;
+    if (largo) memcpy((unsigned char *)a + off, valor, largo);
+    return 0;
+}
+
+// Runlist de 'ext' (lcn < 0 = disperso); devuelve los bytes escritos
+static uint32_t codificar_runlist(const Extent *ext, int n, unsigned char *out) {
+    uint32_t p = 0;
+    int64_t previo = 0;
+    for (int i = 0; i < n; i++) {
+        int bl = 1, bo = 0;
+        while (bl < 8 && (ext[i].len >> (8 * bl))) bl++;
+        int64_t d = 0;
+        if (ext[i].lcn >= 0) {
+            d = ext[i].lcn - previo;
+            previo = ext[i].lcn;
+            bo = 1;
+            while (bo < 8 && !(d >= -(1LL << (8 * bo - 1)) && d < (1LL << (8 * bo - 1)))) bo++;
+        }
+        out[p++] = (unsigned char)(bl | (bo << 4));
+        for (int b = 0; b < bl; b++) out[p++] = (unsigned char)(ext[i].len >> (8 * b));
+        for (int b = 0; b < bo; b++) out[p++] = (unsigned char)((uint64_t)d >> (8 * b));
+    }
+    out[p++] = 0;
+    return p;
+}
+
+#define ATTR_COMPRIMIDO 0x0001
+#define ATTR_DISPERSO   0x8000
+
+static int attr_no_residente(Registro *x, uint32_t tipo, const uint16_t *nombre, int nlen, const Extent *ext, int n,
+                             uint64_t tam_real, uint16_t flags) {
+    unsigned char runs[16 * 64 + 1];
+    uint32_t lr = codificar_runlist(ext, n, runs);
+    uint32_t cab = (flags & ATTR_COMPRIMIDO) ? 72 : 64; // los comprimidos llevan el tamano comprimido
+    uint32_t off = (cab + nlen * 2u + 7) & ~7u;
+    NTFS_ATTRIBUTE *a = registro_atributo(x, tipo, (off + lr + 7) & ~7u);
+    if (!a) return -1;
+    uint64_t vcn = ext[0].vcn, clusters = 0, asignados = 0;
+    for (int i = 0; i < n; i++) {
+        clusters += ext[i].len;
+        if (ext[i].lcn >= 0) asignados += ext[i].len;
+    }
+    a->uchNonResFlag = 1;
+    a->wFlags = flags;
+    attr_nombre(a, (WORD)cab, nombre, nlen);
+    a->Attr.NonResident.n64StartVCN = vcn;
+    a->Attr.NonResident.n64EndVCN = vcn + clusters - 1;
+    a->Attr.NonResident.wDatarunOffset = (WORD)off;
+    a->Attr.NonResident.wCompressionSize = (flags & ATTR_COMPRIMIDO) ? 4 : 0;
+    if (vcn == 0) { // los tamanos solo van en el primer segmento
+        a->Attr.NonResident.n64AllocSize = clusters * TAM_CLUSTER;
+        a->Attr.NonResident.n64RealSize = tam_real;
+        a->Attr.NonResident.n64StreamSize = tam_real;
+        if (flags & ATTR_COMPRIMIDO) {
+            uint64_t comprimido = asignados * TAM_CLUSTER;
+            memcpy((unsigned char *)a + 64, &comprimido, 8);
+        }
+    }
+    memcpy((unsigned char *)a + off, runs, lr);
+    return 0;
+}
+
+// Fin de atributos, largo usado y update sequence array (al reves que aplicar_fixups())
+static void registro_cerrar(Registro *x, int romper_fixup) {
+    struct NTFS_MFT_FILE *h = (struct NTFS_MFT_FILE *)x->r;
+    memset(x->r + x->pos, 0xFF, 4);
+    h->dwRecLength = x->pos + 8;
+    h->wNextAttrID = x->id;
+    uint16_t usn = (uint16_t)(1 + (h->dwMFTRecNumber & 0x7FFF));
+    memcpy(x->r + h->wFixupOffset, &usn, 2);
+    for (uint32_t s = 1; s < h->wFixupSize; s++) {
+        unsigned char *fin = x->r + s * 512 - 2;
+        memcpy(x->r + h->wFixupOffset + s * 2, fin, 2);
+        memcpy(fin, &usn, 2);
+    }
+    if (romper_fixup) x->r[2 * 512 - 2] ^= 0x5A; // como un sector que no llego a escribirse
+}
+
+// Offset en la imagen del registro 'num' segun los tramos de $MFT
+static long long offset_registro_mft(const Generador *g, uint64_t num, uint64_t *contiguos) {
+    uint64_t vcn = num * TAM_REGISTRO / TAM_CLUSTER;
+    for (int i = 0; i < g->mft_n; i++) {
+        if (vcn < g->mft[i].vcn || vcn >= g->mft[i].vcn + g->mft[i].len) continue;
+        uint64_t fin = (g->mft[i].vcn + g->mft[i].len) * TAM_CLUSTER / TAM_REGISTRO;
+        *contiguos = fin - num;
+        return BASE_PARTICION + (long long)(g->mft[i].lcn + (vcn - g->mft[i].vcn)) * TAM_CLUSTER
+               + (long long)(num * TAM_REGISTRO % TAM_CLUSTER);
+    }
+    return -1;
+}
+
+static int escribir_lote(Generador *g) {
+    uint64_t hecho = 0, n = g->registros - g->lote_ini;
+    if (n > LOTE_REGISTROS) n = LOTE_REGISTROS;
+    while (hecho < n) {
+        uint64_t contiguos;
+        long long off = offset_registro_mft(g, g->lote_ini + hecho, &contiguos);
+        if (off < 0) return -1;
+        if (contiguos > n - hecho) contiguos = n - hecho;
+        if (escribir_en(g, off, g->lote + hecho * TAM_REGISTRO, contiguos * TAM_REGISTRO) != 0) return -1;
+        hecho += contiguos;
+    }
+    g->lote_ini += LOTE_REGISTROS;
+    memset(g->lote, 0, (size_t)LOTE_REGISTROS * TAM_REGISTRO); // los que no se usen quedan libres
+    return 0;
+}
+
+// Lugar del registro 'num' en el lote (los de usuario se piden en orden)
+static unsigned char *registro_buf(Generador *g, uint64_t num) {
+    if (num < PRIMER_USUARIO) return g->sistema[num];
+    while (num >= g->lote_ini + LOTE_REGISTROS) {
+        if (escribir_lote(g) != 0) return NULL;
+    }
+    return g->lote + (num - g->lote_ini) * TAM_REGISTRO;
+}
+
+// --- atributos de un archivo ---
+
+static int attr_standard(Registro *x, uint64_t t, uint32_t atributos) {
+    unsigned char v[48] = { 0 };
+    ATTR_STANDARD *s = (ATTR_STANDARD *)v;
+    s->n64Create = t;
+    s->n64Modify = t + 7 * 10000000ULL;
+    s->n64Modfil = t + 13 * 10000000ULL;
+    s->n64Access = t + 3 * FILETIME_DIA;
+    s->dwFATAttributes = atributos;
+    return attr_residente(x, 0x10, NULL, 0, v, sizeof(v));
+}
+
+static int attr_file_name(Registro *x, uint64_t padre_ref, const uint16_t *nombre, int nlen, uint64_t tam,
+                          int es_dir, uint64_t t) {
+    unsigned char v[sizeof(ATTR_FILENAME)] = { 0 };
+    ATTR_FILENAME *f = (ATTR_FILENAME *)v;
+    f->dwMftParentDir = padre_ref;
+    f->n64Create = f->n64Modify = f->n64Modfil = f->n64Access = t;
+    f->n64Allocated = (tam + TAM_CLUSTER - 1) / TAM_CLUSTER * TAM_CLUSTER;
+    f->n64RealSize = tam;
+    f->dwFlags = es_dir ? 0x10000000 : 0x20;
+    f->chFileNameLength = (BYTE)nlen;
+    f->chFileNameType = 1; // Win32
+    memcpy(v + 66, nombre, nlen * 2u);
+    return attr_residente(x, 0x30, NULL, 0, v, 66 + nlen * 2u);
+}
+
+// Entrada de $ATTRIBUTE_LIST: en que registro (y desde que VCN) esta cada atributo
+static uint32_t entrada_lista(unsigned char *p, uint32_t tipo, uint64_t vcn, uint64_t ref, uint16_t id) {
+    memset(p, 0, 32);
+    memcpy(p, &tipo, 4);
+    uint16_t largo = 32;
+    memcpy(p + 4, &largo, 2);
+    p[7] = 26;
+    memcpy(p + 8, &vcn, 8);
+    memcpy(p + 16, &ref, 8);
+    memcpy(p + 24, &id, 2);
+    return 32;
+}
+
+// Nombre UTF-8 (solo plano basico) a UTF-16; devuelve las unidades
+static int a_utf16(const char *s, uint16_t *out, int max) {
+    const unsigned char *p = (const unsigned char *)s;
+    int n = 0;
+    while (*p && n < max) {
+        if (*p < 0x80) out[n++] = *p++;
+        else if ((*p & 0xE0) == 0xC0) {
+            out[n++] = (uint16_t)(((p[0] & 0x1F) << 6) | (p[1] & 0x3F));
+            p += 2;
+        } else {
+            out[n++] = (uint16_t)(((p[0] & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F));
+            p += 3;
+        }
+    }
+    return n;
+}
+
+static const char *palabras[] = {
+    "informe", "foto", "factura", "copia", "datos", "nota", "año", "canción", "presupuesto", "contrato",
+    "日本", "résumé", "backup", "IMG", "scan", "Документ", "tarea", "video", "clave", "registro"
+};
+static const char *extensiones[] = {
+    "txt", "pdf", "jpg", "png", "exe", "docx", "zip", "log", "dll", "csv", "mp3", "html", "", "dat"
+};
+
+static int nombre_archivo(Generador *g, uint64_t num, int es_dir, uint16_t *nombre, const char **ext) {
+    char s[600];
+    const char *w = palabras[azar_hasta(g, sizeof(palabras) / sizeof(*palabras))];
+    *ext = extensiones[azar_hasta(g, sizeof(extensiones) / sizeof(*extensiones))];
+    if (es_dir) {
+        snprintf(s, sizeof(s), "%s_%llu", w, (unsigned long long)num);
+        *ext = "";
+    } else if (por_mil(g, 5)) {
+        // nombre largo, sin pasar de ~200 unidades para que el registro siga teniendo lugar
+        int k = snprintf(s, sizeof(s), "%llu_", (unsigned long long)num);
+        while (k < 180) k += snprintf(s + k, sizeof(s) - k, "%s", w);
+        snprintf(s + k, sizeof(s) - k, ".%s", **ext ? *ext : "bin");
+    } else {
+        snprintf(s, sizeof(s), "%s%llu%s%s", w, (unsigned long long)num, **ext ? "." : "", *ext);
+    }
+    return a_utf16(s, nombre, 255);
+}
+
+// --- contenido ---
+
+static unsigned char *buf_reservar(Generador *g, size_t n) {
+    if (n > g->buf_cap) {
+        unsigned char *b = realloc(g->buf, n);
+        if (!b) return NULL;
+        g->buf = b;
+        g->buf_cap = n;
+    }
+    return g->buf;
+}
+
+// Texto (se comprime bien) o bytes pseudoaleatorios, con la firma que corresponde a la
+// extension; uno de cada 40 lleva la de otra (discordante). Solo usa g->datos.
+static void llenar_contenido(Generador *g, unsigned char *b, size_t n, const char *ext, int texto) {
+    if (texto) {
+        size_t k = 0;
+        while (k < n) {
+            char linea[96];
+            uint64_t r = splitmix(&g->datos);
+            int l = snprintf(linea, sizeof(linea), "%s %llu %s\r\n", palabras[r % 20],
+                             (unsigned long long)(r >> 8) % 100000, palabras[(r >> 40) % 20]);
+            size_t c = (size_t)l < n - k ? (size_t)l : n - k;
+            memcpy(b + k, linea, c);
+            k += c;
+        }
+    } else {
+        for (size_t k = 0; k < n; k += 8) {
+            uint64_t r = splitmix(&g->datos);
+            memcpy(b + k, &r, n - k < 8 ? n - k : 8);
+        }
+    }
+    // con el pie que corresponde, para que el carving encuentre el final como en un archivo real
+    static const struct { const char *ext; const char *firma; size_t n; const char *pie; size_t m; } firmas[] = {
+        { "pdf", "%PDF-1.5\n", 9, "\n%%EOF\n", 7 },
+        { "jpg", "\xFF\xD8\xFF\xE0\x00\x10JFIF\x00\x01\x01\x00\x00\x01\x00\x01\x00\x00\xFF\xDA", 22, "\xFF\xD9", 2 },
+        { "png", "\x89PNG\r\n\x1a\n", 8, "", 0 },
+        { "exe", "MZ\x90\0", 4, "", 0 }, { "dll", "MZ\x90\0", 4, "", 0 },
+        { "zip", "PK\x03\x04", 4, "PK\x05\x06\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", 22 },
+        { "docx", "PK\x03\x04", 4, "PK\x05\x06\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", 22 },
+        { "mp3", "ID3\x03", 4, "", 0 }
+    };
+    int nf = sizeof(firmas) / sizeof(*firmas), elegida = -1;
+    for (int i = 0; i < nf; i++) {
+        if (strcmp(firmas[i].ext, ext) == 0) elegida = i;
+    }
+    if (elegida >= 0 && splitmix(&g->datos) % 40 == 0) elegida = (elegida + 3) % nf;
+    if (elegida < 0 || n < firmas[elegida].n + firmas[elegida].m) return;
+    memcpy(b, firmas[elegida].firma, firmas[elegida].n);
+    memcpy(b + n - firmas[elegida].m, firmas[elegida].pie, firmas[elegida].m);
+}
+
+static int escribir_clusters(Generador *g, uint64_t lcn, const unsigned char *b, size_t n) {
+    g->cuenta.bytes_datos += n;
+    if (g->sin_contenido) return 0;
+    return escribir_en(g, BASE_PARTICION + (long long)lcn * TAM_CLUSTER, b, n);
+}
+
+// --- LZNT1 ---
+
+// Comprime un bloque de hasta 4 KB; devuelve los bytes (sin la cabecera) o 0 si no achica.
+// Cuantos bits son distancia depende de la posicion, igual que en lznt1_descomprimir().
+static size_t lznt1_bloque(const unsigned char *in, size_t n, unsigned char *out) {
+    int16_t ultimo[4096];
+    memset(ultimo, 0xFF, sizeof(ultimo));
+    size_t o = 0, i = 0;
+    while (i < n) {
+        size_t pos_banderas = o++;
+        unsigned banderas = 0;
+        for (int bit = 0; bit < 8 && i < n; bit++) {
+            int bits_largo = 12;
+            for (size_t q = i ? i - 1 : 0; q >= 0x10; q >>= 1) bits_largo--;
+            size_t max_largo = ((size_t)1 << bits_largo) + 2, max_dist = (size_t)1 << (16 - bits_largo);
+            size_t largo = 0, dist = 0;
+            if (i + 3 <= n) {
+                unsigned h = ((in[i] << 8) ^ (in[i + 1] << 4) ^ in[i + 2]) & 4095;
+                int cand = ultimo[h];
+                ultimo[h] = (int16_t)i;
+                if (cand >= 0 && i - (size_t)cand <= max_dist) {
+                    while (largo < max_largo && i + largo < n && in[cand + largo] == in[i + largo]) largo++;
+                    dist = i - (size_t)cand;
+                }
+            }
+            if (largo >= 3) {
+                uint16_t tok = (uint16_t)(((dist - 1) << bits_largo) | (largo - 3));
+                out[o++] = (unsigned char)tok;
+                out[o++] = (unsigned char)(tok >> 8);
+                banderas |= 1u << bit;
+                i += largo;
+            } else {
+                out[o++] = in[i++];
+            }
+            if (o >= n) return 0;
+        }
+        out[pos_banderas] = (unsigned char)banderas;
+    }
+    return o;
+}
+
+// Una unidad de compresion; devuelve los bytes comprimidos en 'out' o 0 si conviene guardarla tal cual
+static size_t lznt1_unidad(const unsigned char *in, size_t n, unsigned char *out) {
+    size_t o = 0;
+    unsigned char tmp[4096 + 512];
+    for (size_t b = 0; b < n; b += 4096) {
+        size_t len = n - b < 4096 ? n - b : 4096;
+        size_t c = lznt1_bloque(in + b, len, tmp);
+        uint16_t cab;
+        if (c) {
+            cab = (uint16_t)(0xB000 | (c - 1));
+        } else { // bloque sin comprimir: siempre 4 KB
+            memset(tmp, 0, 4096);
+            memcpy(tmp, in + b, len);
+            c = 4096;
+            cab = 0x3000 | 4095;
+        }
+        out[o++] = (unsigned char)cab;
+        out[o++] = (unsigned char)(cab >> 8);
+        memcpy(out + o, tmp, c);
+        o += c;
+    }
+    out[o++] = 0; // fin de los datos
+    out[o++] = 0;
+    return o + TAM_CLUSTER <= (size_t)UNIDAD_COMPRESION * TAM_CLUSTER ? o : 0;
+}
+
+// --- archivos ---
+
+typedef struct {
+    Extent ext[24];
+    int n;
+    uint64_t tamano;
+    uint16_t flags;         // ATTR_COMPRIMIDO / ATTR_DISPERSO
+    uint32_t atributos;     // FAT para $STANDARD_INFORMATION
+    int residente;
+    uint32_t largo_residente;
+} Datos;
+
+static void agregar_tramo(Datos *d, int64_t lcn, uint64_t len) {
+    uint64_t vcn = d->n ? d->ext[d->n - 1].vcn + d->ext[d->n - 1].len : 0;
+    if (d->n && lcn < 0 && d->ext[d->n - 1].lcn < 0) { // dispersos seguidos van juntos
+        d->ext[d->n - 1].len += len;
+        return;
+    }
+    d->ext[d->n++] = (Extent){ vcn, lcn, len };
+}
+
+static int datos_simples(Generador *g, Datos *d, uint64_t tam, const char *ext, int fragmentado, int marcar) {
+    uint64_t clusters = (tam + TAM_CLUSTER - 1) / TAM_CLUSTER;
+    unsigned char *b = buf_reservar(g, clusters * TAM_CLUSTER);
+    if (!b) return -1;
+    if (!g->sin_contenido) {
+        llenar_contenido(g, b, tam, ext, strcmp(ext, "txt") == 0 || strcmp(ext, "log") == 0 || strcmp(ext, "csv") == 0);
+        memset(b + tam, 0, clusters * TAM_CLUSTER - tam);
+    }
+    int piezas = fragmentado && clusters >= 4 ? 2 + (int)azar_hasta(g, clusters < 16 ? 2 : 6) : 1;
+    uint64_t hecho = 0;
+    for (int p = 0; p < piezas; p++) {
+        uint64_t len = p == piezas - 1 ? clusters - hecho : 1 + azar_hasta(g, (clusters - hecho) - (piezas - p - 1));
+        if (fragmentado) g->cursor += 1 + azar_hasta(g, 8); // hueco libre entre pedazos
+        uint64_t lcn = reservar_clusters(g, len);
+        if ((marcar && marcar_clusters(g, lcn, len) != 0) ||
+            escribir_clusters(g, lcn, b + hecho * TAM_CLUSTER, len * TAM_CLUSTER) != 0) return -1;
+        agregar_tramo(d, (int64_t)lcn, len);
+        hecho += len;
+    }
+    d->tamano = tam;
+    return 0;
+}
+
+static int datos_comprimidos(Generador *g, Datos *d, uint64_t tam, int marcar) {
+    uint64_t bytes_unidad = (uint64_t)UNIDAD_COMPRESION * TAM_CLUSTER;
+    uint64_t unidades = (tam + bytes_unidad - 1) / bytes_unidad;
+    unsigned char *b = buf_reservar(g, 2 * bytes_unidad + 4096);
+    if (!b) return -1;
+    unsigned char *comp = b + bytes_unidad;
+    for (uint64_t u = 0; u < unidades; u++) {
+        size_t n = (size_t)(tam - u * bytes_unidad < bytes_unidad ? tam - u * bytes_unidad : bytes_unidad);
+        int r = (int)azar_hasta(g, 10);
+        if (r == 0) { // unidad de ceros: no ocupa nada
+            agregar_tramo(d, -1, UNIDAD_COMPRESION);
+            continue;
+        }
+        llenar_contenido(g, b, n, "txt", r > 1); // r == 1: binaria, no se puede comprimir
+        memset(b + n, 0, bytes_unidad - n);
+        size_t c = r > 1 ? lznt1_unidad(b, n, comp) : 0;
+        const unsigned char *escribir = c ? comp : b;
+        uint64_t clusters = c ? (c + TAM_CLUSTER - 1) / TAM_CLUSTER : UNIDAD_COMPRESION;
+        if (c) memset(comp + c, 0, clusters * TAM_CLUSTER - c);
+        uint64_t lcn = reservar_clusters(g, clusters);
+        if ((marcar && marcar_clusters(g, lcn, clusters) != 0) ||
+            escribir_clusters(g, lcn, escribir, clusters * TAM_CLUSTER) != 0) return -1;
+        agregar_tramo(d, (int64_t)lcn, clusters);
+        if (clusters < UNIDAD_COMPRESION) agregar_tramo(d, -1, UNIDAD_COMPRESION - clusters);
+    }
+    d->tamano = tam;
+    d->flags = ATTR_COMPRIMIDO;
+    d->atributos |= 0x800;
+    return 0;
+}
+
+// Disco virtual: unos pocos tramos con datos entre huecos grandes
+static int datos_dispersos(Generador *g, Datos *d, int marcar) {
+    int piezas = 1 + (int)azar_hasta(g, 3);
+    unsigned char *b = buf_reservar(g, 8 * TAM_CLUSTER);
+    if (!b) return -1;
+    for (int p = 0; p < piezas; p++) {
+        agregar_tramo(d, -1, 16 + azar_hasta(g, 512));
+        uint64_t len = 1 + azar_hasta(g, 8);
+        if (!g->sin_contenido) llenar_contenido(g, b, len * TAM_CLUSTER, "dat", 0);
+        uint64_t lcn = reservar_clusters(g, len);
+        if ((marcar && marcar_clusters(g, lcn, len) != 0) || escribir_clusters(g, lcn, b, len * TAM_CLUSTER) != 0) return -1;
+        agregar_tramo(d, (int64_t)lcn, len);
+    }
+    agregar_tramo(d, -1, 1 + azar_hasta(g, 256));
+    const Extent *u = &d->ext[d->n - 1];
+    d->tamano = (u->vcn + u->len) * TAM_CLUSTER - azar_hasta(g, TAM_CLUSTER);
+    d->flags = ATTR_DISPERSO;
+    d->atributos |= 0x200;
+    return 0;
+}
+
+static void agregar_directorio(Generador *g, uint32_t num, uint16_t sec) {
+    if (g->dirs_n == g->dirs_cap) {
+        size_t cap = g->dirs_cap ? g->dirs_cap * 2 : 1024;
+        uint32_t *d = realloc(g->dirs, cap * sizeof(uint32_t));
+        uint16_t *s = realloc(g->dirs_sec, cap * sizeof(uint16_t));
+        if (d) g->dirs = d;
+        if (s) g->dirs_sec = s;
+        if (!d || !s) return; // sin memoria: simplemente no se usa como padre
+        g->dirs_cap = cap;
+    }
+    g->dirs[g->dirs_n] = num;
+    g->dirs_sec[g->dirs_n++] = sec;
+}
+
+static uint64_t referencia(uint64_t num, uint16_t sec) {
+    return num | ((uint64_t)sec << 48);
+}
+
+// Genera el registro 'num' (y 'num + 1' si usa uno de extension); devuelve cuantos uso
+static int generar_registro(Generador *g, uint64_t num, int profundidad) {
+    unsigned char *r = registro_buf(g, num);
+    if (!r) return -1;
+    g->datos = g->semilla_datos ^ (num * 0xD1B54A32D192ED03ULL); // el contenido de cada registro es independiente
+    int cadena = num < PRIMER_USUARIO + (uint64_t)profundidad; // la rama profunda, uno dentro del otro
+    int es_dir = cadena || por_mil(g, POR_MIL_DIRECTORIO);
+    int borrado = !cadena && por_mil(g, POR_MIL_BORRADO);
+    int roto = !cadena && por_mil(g, POR_MIL_ROTO);
+    uint16_t sec = borrado ? 2 : 1; // al borrar sube la secuencia
+    uint64_t t = FILETIME_2015 + azar_hasta(g, 3650) * FILETIME_DIA + azar_hasta(g, FILETIME_DIA);
+
+    // padre: el anterior de la rama, o cualquier directorio ya creado; algunos borrados
+    // cuelgan del ultimo directorio borrado, con la secuencia de antes de borrarlo o con una
+    // que ya no tiene (el registro se reuso: quedan huerfanos)
+    uint64_t padre = 5;
+    uint16_t padre_sec = 5;
+    if (cadena && num > PRIMER_USUARIO) {
+        padre = num - 1;
+        padre_sec = 1;
+    } else if (!cadena && borrado && g->dir_borrado && por_mil(g, 300)) {
+        padre = g->dir_borrado;
+        padre_sec = por_mil(g, 500) ? 1 : 7;
+        g->cuenta.de_borrado += padre_sec == 1;
+        g->cuenta.huerfanos += padre_sec != 1;
+    } else if (!cadena && g->dirs_n && !por_mil(g, 50)) {
+        size_t k = azar_hasta(g, g->dirs_n);
+        padre = g->dirs[k];
+        padre_sec = g->dirs_sec[k];
+    }
+
+    uint16_t nombre[255];
+    const char *ext;
+    int nlen = nombre_archivo(g, num, es_dir, nombre, &ext);
+    Registro x;
+    registro_iniciar(&x, r, num, sec, (uint16_t)((borrado ? 0 : 1) | (es_dir ? 2 : 0)), 0);
+
+    if (es_dir) {
+        if (attr_standard(&x, t, 0x10) || attr_file_name(&x, referencia(padre, padre_sec), nombre, nlen, 0, 1, t)) return -1;
+        registro_cerrar(&x, roto);
+        if (borrado) g->dir_borrado = (uint32_t)num;
+        else if (!roto) agregar_directorio(g, (uint32_t)num, sec);
+        g->cuenta.directorios++;
+        g->cuenta.borrados += borrado;
+        g->cuenta.rotos += roto;
+        return 1;
+    }
+
+    // los borrados no marcan sus clusters (salvo los que ya se volvieron a usar)
+    int marcar = !borrado || por_mil(g, 300);
+    Datos d = { .atributos = 0x20 };
+    int extension = num + 1 < g->registros && por_mil(g, POR_MIL_EXTENSION);
+    int r_clase = (int)azar_hasta(g, 1000);
+    if (r_clase < POR_MIL_COMPRIMIDO) {
+        if (datos_comprimidos(g, &d, 4096 + azar_hasta(g, 256 * 1024), marcar)) return -1;
+        g->cuenta.comprimidos++;
+        extension = 0;
+    } else if (r_clase < POR_MIL_COMPRIMIDO + POR_MIL_DISPERSO) {
+        if (datos_dispersos(g, &d, marcar)) return -1;
+        g->cuenta.dispersos++;
+        extension = 0;
+    } else {
+        // tamano: la mitad entra en el registro, el resto crece exponencialmente
+        uint64_t tam = azar_hasta(g, 2) ? azar_hasta(g, 700) : 701 + azar_hasta(g, 1ULL << (9 + azar_hasta(g, 8)));
+        if (extension && tam < 2 * TAM_CLUSTER) tam = 2 * TAM_CLUSTER + azar_hasta(g, 64 * 1024);
+        if (tam <= 700) {
+            d.residente = 1;
+            d.largo_residente = (uint32_t)tam;
+            d.tamano = tam;
+            extension = 0;
+        } else {
+            int frag = !extension && por_mil(g, POR_MIL_FRAGMENTADO);
+            if (datos_simples(g, &d, tam, ext, frag, marcar)) return -1;
+            g->cuenta.fragmentados += frag && d.n > 1;
+        }
+    }
+    if (borrado && d.n && por_mil(g, 100)) { // runlist que ya no tiene sentido: sale del volumen
+        for (int i = 0; i < d.n; i++) {
+            if (d.ext[i].lcn >= 0) d.ext[i].lcn += 1LL << 40;
+        }
+        g->cuenta.runlist_fuera++;
+    }
+
+    if (attr_standard(&x, t, d.atributos)) return -1;
+    if (extension) {
+        // $DATA partido: el primer tramo en el base y el resto en el registro num + 1; a veces
+        // el $FILE_NAME tambien va en la extension (el base no tiene nombre propio)
+        uint64_t ref_base = referencia(num, sec), ref_ext = referencia(num + 1, sec);
+        int nombre_afuera = por_mil(g, 500);
+        Datos primero = d, resto = d;
+        uint64_t corte = 1 + azar_hasta(g, d.ext[d.n - 1].vcn + d.ext[d.n - 1].len - 1);
+        primero.n = resto.n = 0;
+        for (int i = 0; i < d.n; i++) {
+            Extent e = d.ext[i];
+            if (e.vcn < corte) {
+                uint64_t len = e.vcn + e.len <= corte ? e.len : corte - e.vcn;
+                primero.ext[primero.n++] = (Extent){ e.vcn, e.lcn, len };
+                if (len == e.len) continue;
+                e = (Extent){ e.vcn + len, e.lcn + (int64_t)len, e.len - len };
+            }
+            resto.ext[resto.n++] = e;
+        }
+        unsigned char lista[4 * 32];
+        uint32_t ll = entrada_lista(lista, 0x10, 0, ref_base, 0);
+        ll += entrada_lista(lista + ll, 0x30, 0, nombre_afuera ? ref_ext : ref_base, nombre_afuera ? 0 : 2);
+        ll += entrada_lista(lista + ll, 0x80, 0, ref_base, nombre_afuera ? 2 : 3);
+        ll += entrada_lista(lista + ll, 0x80, corte, ref_ext, nombre_afuera ? 1 : 0);
+        if (attr_residente(&x, 0x20, NULL, 0, lista, ll) ||
+            (!nombre_afuera && attr_file_name(&x, referencia(padre, padre_sec), nombre, nlen, d.tamano, 0, t)) ||
+            attr_no_residente(&x, 0x80, NULL, 0, primero.ext, primero.n, d.tamano, d.flags)) return -1;
+        registro_cerrar(&x, roto);
+
+        unsigned char *r2 = registro_buf(g, num + 1);
+        if (!r2) return -1;
+        Registro y;
+        registro_iniciar(&y, r2, num + 1, sec, borrado ? 0 : 1, ref_base);
+        if ((nombre_afuera && attr_file_name(&y, referencia(padre, padre_sec), nombre, nlen, d.tamano, 0, t)) ||
+            attr_no_residente(&y, 0x80, NULL, 0, resto.ext, resto.n, d.tamano, d.flags)) return -1;
+        registro_cerrar(&y, 0);
+        g->cuenta.archivos++;
+        g->cuenta.extensiones++;
+        g->cuenta.borrados += borrado;
+        g->cuenta.rotos += roto;
+        return 2;
+    }
+
+    if (attr_file_name(&x, referencia(padre, padre_sec), nombre, nlen, d.tamano, 0, t)) return -1;
+    if (d.residente && x.pos + 24 + ((d.largo_residente + 7) & ~7u) + 16 > TAM_REGISTRO - 8) {
+        // con un nombre largo no entra en el registro: va afuera, como haria NTFS
+        if (datos_simples(g, &d, d.tamano, ext, 0, marcar)) return -1;
+        d.residente = 0;
+    }
+    if (d.residente) {
+        unsigned char *b = buf_reservar(g, d.largo_residente + 1);
+        if (!b) return -1;
+        llenar_contenido(g, b, d.largo_residente, ext, 1);
+        if (attr_residente(&x, 0x80, NULL, 0, b, d.largo_residente)) return -1;
+    } else if (attr_no_residente(&x, 0x80, NULL, 0, d.ext, d.n, d.tamano, d.flags)) {
+        return -1;
+    }
+    if (por_mil(g, POR_MIL_FLUJO)) {
+        // Zone.Identifier residente, o un flujo escondido fuera del registro
+        static const char zona[] = "[ZoneTransfer]\r\nZoneId=3\r\n";
+        uint16_t nf[32];
+        // (si ya no hay lugar en el registro el archivo queda sin flujo)
+        int puesto;
+        if (azar_hasta(g, 4)) {
+            int n = a_utf16("Zone.Identifier", nf, 32);
+            puesto = attr_residente(&x, 0x80, nf, n, zona, sizeof(zona) - 1) == 0;
+        } else {
+            int n = a_utf16("oculto", nf, 32);
+            Datos f = { 0 };
+            if (datos_simples(g, &f, 1 + azar_hasta(g, 64 * 1024), "dat", 0, marcar)) return -1;
+            puesto = attr_no_residente(&x, 0x80, nf, n, f.ext, f.n, f.tamano, 0) == 0;
+        }
+        g->cuenta.flujos += puesto;
+    }
+    registro_cerrar(&x, roto);
+    g->cuenta.archivos++;
+    g->cuenta.borrados += borrado;
+    g->cuenta.rotos += roto;
+    return 1;
+}
+
+// --- registros del sistema, $Bitmap, boot sector y MBR ---
+
+static int registro_sistema(Generador *g, uint64_t num, const char *nombre, int es_dir, const Extent *ext, int n,
+                            uint64_t tam) {
+    Registro x;
+    uint16_t nom[32];
+    int nlen = a_utf16(nombre, nom, 32);
+    uint64_t t = FILETIME_2015;
+    registro_iniciar(&x, g->sistema[num], num, (uint16_t)(num ? num : 1), es_dir ? 3 : 1, 0);
+    if (attr_standard(&x, t, es_dir ? 0x16 : 0x06) ||
+        attr_file_name(&x, referencia(5, 5), nom, nlen, tam, es_dir, t)) return -1;
+    if (!es_dir) {
+        if (n ? attr_no_residente(&x, 0x80, NULL, 0, ext, n, tam, 0) : attr_residente(&x, 0x80, NULL, 0, NULL, 0)) return -1;
+    }
+    registro_cerrar(&x, 0);
+    return 0;
+}
+
+static int cerrar_volumen_generado(Generador *g, uint64_t *total_clusters) {
+    // $MFTMirr, $LogFile y $Boot ocupan clusters como en un volumen real
+    uint64_t espejo = reservar_clusters(g, 1), log = reservar_clusters(g, 64);
+    if (marcar_clusters(g, 0, PRIMER_USUARIO) || marcar_clusters(g, espejo, 1) || marcar_clusters(g, log, 64)) return -1;
+    for (int i = 0; i < g->mft_n; i++) {
+        if (marcar_clusters(g, (uint64_t)g->mft[i].lcn, g->mft[i].len)) return -1;
+    }
+
+    // el $Bitmap va al final y se cubre a si mismo
+    uint64_t fin = g->cursor;
+    for (int i = 0; i < g->mft_n; i++) {
+        if ((uint64_t)g->mft[i].lcn + g->mft[i].len > fin) fin = (uint64_t)g->mft[i].lcn + g->mft[i].len;
+    }
+    g->cursor = fin;
+    uint64_t bm_clusters = 1, total;
+    for (;;) {
+        total = fin + bm_clusters + 16;
+        uint64_t necesarios = ((total + 7) / 8 + TAM_CLUSTER - 1) / TAM_CLUSTER;
+        if (necesarios <= bm_clusters) break;
+        bm_clusters = necesarios;
+    }
+    uint64_t bm_lcn = reservar_clusters(g, bm_clusters);
+    if (marcar_clusters(g, bm_lcn, bm_clusters) || marcar_clusters(g, total, 0)) return -1;
+    uint64_t bm_bytes = (total + 7) / 8;
+    if (escribir_en(g, BASE_PARTICION + (long long)bm_lcn * TAM_CLUSTER, g->bitmap, bm_bytes) != 0) return -1;
+
+    Extent e_mirr = { 0, (int64_t)espejo, 1 }, e_log = { 0, (int64_t)log, 64 }, e_boot = { 0, 0, 2 };
+    Extent e_bm = { 0, (int64_t)bm_lcn, bm_clusters };
+    if (registro_sistema(g, 0, "$MFT", 0, g->mft, g->mft_n, g->registros * TAM_REGISTRO) ||
+        registro_sistema(g, 1, "$MFTMirr", 0, &e_mirr, 1, 4 * TAM_REGISTRO) ||
+        registro_sistema(g, 2, "$LogFile", 0, &e_log, 1, 64 * TAM_CLUSTER) ||
+        registro_sistema(g, 3, "$Volume", 0, NULL, 0, 0) ||
+        registro_sistema(g, 4, "$AttrDef", 0, NULL, 0, 0) ||
+        registro_sistema(g, 5, ".", 1, NULL, 0, 0) ||
+        registro_sistema(g, 6, "$Bitmap", 0, &e_bm, 1, bm_bytes) ||
+        registro_sistema(g, 7, "$Boot", 0, &e_boot, 1, 2 * TAM_CLUSTER) ||
+        registro_sistema(g, 8, "$BadClus", 0, NULL, 0, 0) ||
+        registro_sistema(g, 9, "$Secure", 0, NULL, 0, 0) ||
+        registro_sistema(g, 10, "$UpCase", 0, NULL, 0, 0) ||
+        registro_sistema(g, 11, "$Extend", 1, NULL, 0, 0)) return -1;
+    for (uint64_t i = 0; i < PRIMER_USUARIO; i++) {
+        uint64_t contiguos;
+        long long off = offset_registro_mft(g, i, &contiguos);
+        if (off < 0 || escribir_en(g, off, g->sistema[i], TAM_REGISTRO) != 0) return -1;
+    }
+    if (escribir_en(g, BASE_PARTICION + (long long)espejo * TAM_CLUSTER, g->sistema, 4 * TAM_REGISTRO) != 0) return -1;
+
+    // boot sector (y su copia en el ultimo sector) y la tabla de particiones
+    unsigned char bs[BYTES_SECTOR] = { 0xEB, 0x52, 0x90 };
+    uint16_t bps = BYTES_SECTOR;
+    uint64_t sectores = total * SECTORES_CLUSTER, mft_lcn = (uint64_t)g->mft[0].lcn, serie = azar(g);
+    memcpy(bs + 0x03, "NTFS    ", 8);
+    memcpy(bs + 0x0B, &bps, 2);
+    bs[0x0D] = SECTORES_CLUSTER;
+    bs[0x15] = 0xF8;
+    memcpy(bs + 0x28, &sectores, 8);
+    memcpy(bs + 0x30, &mft_lcn, 8);
+    memcpy(bs + 0x38, &espejo, 8);
+    bs[0x40] = 0xF6; // 2^10 = 1024 bytes por registro
+    bs[0x44] = 0x01;
+    memcpy(bs + 0x48, &serie, 8);
+    bs[0x1FE] = 0x55;
+    bs[0x1FF] = 0xAA;
+    if (escribir_en(g, BASE_PARTICION, bs, sizeof(bs)) != 0 ||
+        escribir_en(g, BASE_PARTICION + (long long)sectores * BYTES_SECTOR, bs, sizeof(bs)) != 0) return -1;
+
+    unsigned char mbr[512] = { 0 };
+    uint32_t lba = LBA_PARTICION, n_sect = (uint32_t)(sectores + 1 > 0xFFFFFFFFu ? 0xFFFFFFFFu : sectores + 1);
+    mbr[0x1BE] = 0x80;
+    mbr[0x1BE + 4] = 0x07; // NTFS
+    memcpy(mbr + 0x1BE + 8, &lba, 4);
+    memcpy(mbr + 0x1BE + 12, &n_sect, 4);
+    mbr[0x1FE] = 0x55;
+    mbr[0x1FF] = 0xAA;
+    if (escribir_en(g, 0, mbr, sizeof(mbr)) != 0) return -1;
+    if (ftruncate(g->fd, BASE_PARTICION + (long long)(sectores + 1) * BYTES_SECTOR) != 0) return -1;
+    *total_clusters = total;
+    return 0;
+}
+
+// Reparte el $MFT en 'n' tramos separados por zonas de datos; los que no son el primero
+// quedan en orden fisico mezclado (el runlist tiene saltos hacia atras)
+static void planear_mft(Generador *g, int n) {
+    uint64_t clusters = (g->registros * TAM_REGISTRO + TAM_CLUSTER - 1) / TAM_CLUSTER;
+    if ((uint64_t)n > clusters / 4) n = clusters / 4 ? (int)(clusters / 4) : 1;
+    uint64_t por_tramo = clusters / n, hueco = por_tramo < 64 ? 64 : por_tramo;
+    int lugar[MAX_TRAMOS_MFT];
+    for (int i = 0; i < n; i++) lugar[i] = i;
+    for (int i = n - 1; i > 1; i--) {
+        int j = 1 + (int)azar_hasta(g, i);
+        int x = lugar[i];
+        lugar[i] = lugar[j];
+        lugar[j] = x;
+    }
+    uint64_t vcn = 0;
+    for (int i = 0; i < n; i++) {
+        uint64_t len = i == n - 1 ? clusters - vcn : por_tramo;
+        g->mft[i] = (Extent){ vcn, (int64_t)(PRIMER_USUARIO + (uint64_t)lugar[i] * (por_tramo + hueco)), len };
+        vcn += len;
+    }
+    g->mft_n = n;
+    memcpy(g->zonas, g->mft, n * sizeof(Extent));
+    for (int i = 1; i < n; i++) { // por LCN, para reservar_clusters()
+        Extent e = g->zonas[i];
+        int j = i;
+        for (; j > 0 && g->zonas[j - 1].lcn > e.lcn; j--) g->zonas[j] = g->zonas[j - 1];
+        g->zonas[j] = e;
+    }
+    g->cursor = PRIMER_USUARIO;
+}
+
+int main(int argc, char **argv) {
+    Generador g = { 0 };
+    uint64_t semilla = 1, registros = 100000;
+    int tramos = 8, profundidad = 200, opt, uso = 0;
+    while ((opt = getopt(argc, argv, "n:s:f:p:z")) != -1) {
+        switch (opt) {
+            case 'n': registros = strtoull(optarg, NULL, 0); break;
+            case 's': semilla = strtoull(optarg, NULL, 0); break;
+            case 'f': tramos = atoi(optarg); break;
+            case 'p': profundidad = atoi(optarg); break;
+            case 'z': g.sin_contenido = 1; break;
+            default: uso = 1; break; // opcion desconocida: mostrar el uso
+        }
+    }
+    if (uso || optind != argc - 1 || registros < PRIMER_USUARIO + 1 || tramos < 1 || tramos > MAX_TRAMOS_MFT ||
+        profundidad < 0) {
+        fprintf(stderr, "uso: %s [-n registros] [-s semilla] [-f tramos_mft 1-%d] [-p profundidad] [-z] salida.img\n",
+                argv[0], MAX_TRAMOS_MFT);
+        fprintf(stderr, "  -z: no escribe el contenido de los archivos (quedan huecos que se leen como ceros)\n");
+        return 1;
+    }
+    g.semilla = g.semilla_datos = semilla;
+    g.registros = registros;
+    g.fd = open(argv[optind], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (g.fd < 0) {
+        perror(argv[optind]);
+        return 1;
+    }
+    g.lote = calloc(LOTE_REGISTROS, TAM_REGISTRO);
+    if (!g.lote) {
+        fprintf(stderr, "Sin memoria\n");
+        return 1;
+    }
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    planear_mft(&g, tramos);
+    g.lote_ini = 0;
+
+    int error = 0;
+    for (uint64_t i = PRIMER_USUARIO; i < registros && !error;) {
+        int n = generar_registro(&g, i, profundidad);
+        if (n < 0) error = 1;
+        else i += (uint64_t)n;
+        if ((i & 0xFFFFF) < (uint64_t)n && isatty(2)) {
+            fprintf(stderr, "\r%llu de %llu registros", (unsigned long long)i, (unsigned long long)registros);
+        }
+    }
+    uint64_t total = 0;
+    if (!error) error = escribir_lote(&g) != 0;
+    if (!error) error = cerrar_volumen_generado(&g, &total) != 0;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (isatty(2)) fprintf(stderr, "\r");
+    if (error) {
+        perror("Error generando la imagen");
+        close(g.fd);
+        return 1;
+    }
+    close(g.fd);
+    fprintf(stderr, "%s: %llu registros (semilla %llu), $MFT en %d tramos, %llu clusters de %d bytes (%.1f MB)\n",
+            argv[optind], (unsigned long long)registros, (unsigned long long)semilla, g.mft_n,
+            (unsigned long long)total, TAM_CLUSTER, total * (double)TAM_CLUSTER / 1e6);
+    fprintf(stderr, "  %llu archivos, %llu directorios (rama de %d niveles), %llu borrados (%llu con el runlist fuera "
+            "del volumen, %llu de un directorio borrado, %llu huerfanos), %llu registros con el fixup roto\n",
+            (unsigned long long)g.cuenta.archivos, (unsigned long long)g.cuenta.directorios, profundidad,
+            (unsigned long long)g.cuenta.borrados, (unsigned long long)g.cuenta.runlist_fuera,
+            (unsigned long long)g.cuenta.de_borrado, (unsigned long long)g.cuenta.huerfanos,
+            (unsigned long long)g.cuenta.rotos);
+    fprintf(stderr, "  %llu comprimidos, %llu dispersos, %llu con registro de extension, %llu fragmentados, "
+            "%llu con flujos alternativos; %.1f MB de datos%s en %.2f s\n",
+            (unsigned long long)g.cuenta.comprimidos, (unsigned long long)g.cuenta.dispersos,
+            (unsigned long long)g.cuenta.extensiones, (unsigned long long)g.cuenta.fragmentados,
+            (unsigned long long)g.cuenta.flujos, g.cuenta.bytes_datos / 1e6, g.sin_contenido ? " (sin escribir)" : "",
+            (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9);
+    free(g.lote);
+    free(g.bitmap);
+    free(g.dirs);
+    free(g.dirs_sec);
+    free(g.buf);
+    return 0;
+}
@@ -0,0 +1,315 @@
+// hashImagen.c
+#include "hashImagen.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <openssl/evp.h>
+
+#define MAX_HILOS_IMAGEN 16
+#define PORCION_IMAGEN   65536 // porcion que pasa por MD5 y SHA-256 seguidos mientras esta en cache
+#define TAM_PAGINA       4096
+
+static double ahora_seg(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int hilos_disponibles(void) {
+    long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    return nucleos < 1 ? 1 : nucleos > MAX_HILOS_IMAGEN ? MAX_HILOS_IMAGEN : (int)nucleos;
+}
+
+static uint64_t largo_trozo(const HashImagen *h, size_t k) {
+    uint64_t off = (uint64_t)k * h->tam_trozo;
+    return (h->largo - off < h->tam_trozo) ? h->largo - off : h->tam_trozo;
+}
+
+// Los hilos auxiliares toman trozos en orden, pero como mucho 'ventana' por delante del hash
+// lineal: si no, en imagenes mas grandes que la RAM las paginas que cargan se descartarian
+// antes de que llegue el hilo lineal
+typedef struct {
+    const unsigned char *map;
+    HashImagen *h;
+    size_t siguiente;       // proximo trozo para un hilo auxiliar
+    size_t lineal;          // trozos que ya paso el hash lineal
+    size_t ventana;
+    pthread_mutex_t mu;
+    pthread_cond_t cv;
+} Adelanto;
+
+static void *adelantar_trozos(void *arg) {
+    Adelanto *a = arg;
+    HashImagen *h = a->h;
+    for (;;) {
+        pthread_mutex_lock(&a->mu);
+        while (a->siguiente < h->n_trozos && a->siguiente >= a->lineal + a->ventana)
+            pthread_cond_wait(&a->cv, &a->mu);
+        if (a->siguiente >= h->n_trozos) {
+            pthread_mutex_unlock(&a->mu);
+            break;
+        }
+        size_t k = a->siguiente++;
+        pthread_mutex_unlock(&a->mu);
+
+        const unsigned char *p = a->map + h->inicio + (uint64_t)k * h->tam_trozo;
+        uint64_t n = largo_trozo(h, k);
+        if (h->con_trozos) {
+            EVP_Digest(p, (size_t)n, h->trozos + k * LARGO_SHA256, NULL, EVP_sha256(), NULL);
+        } else {
+            // solo traer las paginas: un byte de cada una
+            volatile unsigned char suma = 0;
+            for (uint64_t o = 0; o < n; o += TAM_PAGINA) suma += p[o];
+            (void)suma;
+        }
+    }
+    return NULL;
+}
+
+int hashear_imagen(const unsigned char *map, uint64_t inicio, uint64_t largo, uint32_t tam_trozo,
+                   int con_trozos, HashImagen *h, ProgresoHash progreso, void *ctx) {
+    memset(h, 0, sizeof(*h));
+    double t0 = ahora_seg();
+    if (tam_trozo == 0) tam_trozo = TROZO_IMAGEN;
+    h->inicio = inicio;
+    h->largo = largo;
+    h->tam_trozo = tam_trozo;
+    h->n_trozos = (size_t)((largo + tam_trozo - 1) / tam_trozo);
+    h->con_trozos = con_trozos;
+    if (con_trozos) {
+        h->trozos = malloc((h->n_trozos ? h->n_trozos : 1) * LARGO_SHA256);
+        if (!h->trozos) return -1;
+    }
+    EVP_MD_CTX *md5 = EVP_MD_CTX_new(), *sha256 = EVP_MD_CTX_new(), *trozo = EVP_MD_CTX_new();
+    if (!md5 || !sha256 || !trozo) {
+        EVP_MD_CTX_free(md5);
+        EVP_MD_CTX_free(sha256);
+        EVP_MD_CTX_free(trozo);
+        liberar_hash_imagen(h);
+        return -1;
+    }
+    EVP_DigestInit_ex(md5, EVP_md5(), NULL);
+    EVP_DigestInit_ex(sha256, EVP_sha256(), NULL);
+
+    // este hilo hace el hash lineal; el resto, los hashes por trozo (o solo adelantar la lectura)
+    int nhilos = hilos_disponibles();
+    Adelanto a = { map, h, 0, 0, (size_t)nhilos * 2, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER };
+    pthread_t hilos[MAX_HILOS_IMAGEN];
+    int auxiliares = 0;
+    for (int i = 1; i < nhilos; i++) {
+        if (pthread_create(&hilos[auxiliares], NULL, adelantar_trozos, &a) == 0) auxiliares++;
+    }
+    h->hilos = auxiliares + 1;
+
+    for (size_t k = 0; k < h->n_trozos; k++) {
+        const unsigned char *p = map + inicio + (uint64_t)k * tam_trozo;
+        uint64_t n = largo_trozo(h, k);
+        // sin hilos auxiliares el hash del trozo tambien se hace aca, en la misma pasada
+        int propio = con_trozos && auxiliares == 0;
+        if (propio) EVP_DigestInit_ex(trozo, EVP_sha256(), NULL);
+        for (uint64_t o = 0; o < n; o += PORCION_IMAGEN) {
+            size_t m = (n - o < PORCION_IMAGEN) ? (size_t)(n - o) : PORCION_IMAGEN;
+            EVP_DigestUpdate(md5, p + o, m);
+            EVP_DigestUpdate(sha256, p + o, m);
+            if (propio) EVP_DigestUpdate(trozo, p + o, m);
+        }
+        if (propio) EVP_DigestFinal_ex(trozo, h->trozos + k * LARGO_SHA256, NULL);
+
+        pthread_mutex_lock(&a.mu);
+        a.lineal = k + 1;
+        pthread_cond_broadcast(&a.cv);
+        pthread_mutex_unlock(&a.mu);
+        if (progreso) progreso(ctx, (uint64_t)k * tam_trozo + n, largo);
+    }
+    // sin hashes por trozo ya no hay nada que adelantar; con ellos se espera a que terminen
+    if (!con_trozos) {
+        pthread_mutex_lock(&a.mu);
+        a.siguiente = h->n_trozos;
+        pthread_cond_broadcast(&a.cv);
+        pthread_mutex_unlock(&a.mu);
+    }
+    for (int i = 0; i < auxiliares; i++) pthread_join(hilos[i], NULL);
+
+    EVP_DigestFinal_ex(md5, h->md5, NULL);
+    EVP_DigestFinal_ex(sha256, h->sha256, NULL);
+    if (con_trozos) EVP_Digest(h->trozos, h->n_trozos * LARGO_SHA256, h->arbol, NULL, EVP_sha256(), NULL);
+    EVP_MD_CTX_free(md5);
+    EVP_MD_CTX_free(sha256);
+    EVP_MD_CTX_free(trozo);
+    pthread_mutex_destroy(&a.mu);
+    pthread_cond_destroy(&a.cv);
+    h->segundos = ahora_seg() - t0;
+    return 0;
+}
+
+void liberar_hash_imagen(HashImagen *h) {
+    free(h->trozos);
+    h->trozos = NULL;
+    h->con_trozos = 0;
+}
+
+int guardar_mapa_hashes(const HashImagen *h, FILE *out) {
+    char hex[2 * LARGO_SHA256 + 1];
+    fprintf(out, "# mapa de hashes por trozo: inicio %llu largo %llu trozo %u trozos %zu\n",
+            (unsigned long long)h->inicio, (unsigned long long)h->largo, h->tam_trozo, h->n_trozos);
+    hash_a_hex(h->md5, LARGO_MD5, hex);
+    fprintf(out, "# md5 %s\n", hex);
+    hash_a_hex(h->sha256, LARGO_SHA256, hex);
+    fprintf(out, "# sha256 %s\n", hex);
+    if (h->con_trozos) {
+        hash_a_hex(h->arbol, LARGO_SHA256, hex);
+        fprintf(out, "# arbol %s\n", hex);
+        for (size_t k = 0; k < h->n_trozos; k++) {
+            hash_a_hex(h->trozos + k * LARGO_SHA256, LARGO_SHA256, hex);
+            fprintf(out, "%llu %llu %s\n", (unsigned long long)(h->inicio + (uint64_t)k * h->tam_trozo),
+                    (unsigned long long)largo_trozo(h, k), hex);
+        }
+    }
+    return ferror(out) ? -1 : 0;
+}
+
+static int hex_a_bytes(const char *s, unsigned char *out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        int v = 0;
+        for (int j = 0; j < 2; j++) {
+            char c = s[2 * i + j];
+            int d = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                  : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+            if (d < 0) return -1;
+            v = v * 16 + d;
+        }
+        out[i] = (unsigned char)v;
+    }
+    return s[2 * n] == '\0' ? 0 : -1;
+}
+
+int cargar_mapa_hashes(FILE *in, HashImagen *h) {
+    memset(h, 0, sizeof(*h));
+    char linea[256], hex[2 * LARGO_SHA256 + 2];
+    unsigned long long inicio, largo;
+    unsigned tam;
+    size_t n;
+    if (!fgets(linea, sizeof(linea), in) ||
+        sscanf(linea, "# mapa de hashes por trozo: inicio %llu largo %llu trozo %u trozos %zu",
+               &inicio, &largo, &tam, &n) != 4 || tam == 0 || n != (largo + tam - 1) / tam)
+        return -1;
+    h->inicio = inicio;
+    h->largo = largo;
+    h->tam_trozo = tam;
+    h->n_trozos = n;
+    h->trozos = malloc((n ? n : 1) * LARGO_SHA256);
+    if (!h->trozos) return -2;
+    h->con_trozos = 1;
+    size_t k = 0;
+    while (fgets(linea, sizeof(linea), in)) {
+        unsigned long long off, len;
+        if (sscanf(linea, "# md5 %33s", hex) == 1) {
+            if (hex_a_bytes(hex, h->md5, LARGO_MD5) != 0) break;
+        } else if (sscanf(linea, "# sha256 %65s", hex) == 1) {
+            if (hex_a_bytes(hex, h->sha256, LARGO_SHA256) != 0) break;
+        } else if (sscanf(linea, "# arbol %65s", hex) == 1) {
+            if (hex_a_bytes(hex, h->arbol, LARGO_SHA256) != 0) break;
+        } else if (linea[0] == '#') {
+            continue;
+        } else if (sscanf(linea, "%llu %llu %65s", &off, &len, hex) == 3) {
+            // los trozos tienen que venir todos y en orden
+            if (k >= n || off != inicio + (uint64_t)k * tam || len != largo_trozo(h, k) ||
+                hex_a_bytes(hex, h->trozos + k * LARGO_SHA256, LARGO_SHA256) != 0)
+                break;
+            k++;
+        } else {
+            break;
+        }
+    }
+    if (k != n || ferror(in) || !feof(in)) {
+        liberar_hash_imagen(h);
+        return -1;
+    }
+    return 0;
+}
+
+typedef struct {
+    const unsigned char *map;
+    uint64_t map_size;
+    const HashImagen *mapa;
+    size_t k_fin;
+    size_t *siguiente;      // compartido, atomico
+    uint64_t *hecho;        // bytes revisados, compartido
+    pthread_mutex_t *mu;    // protege malos/n_malos
+    size_t *malos, max_malos;
+    long *n_malos;
+    ProgresoHash progreso;  // solo el hilo 0 lo llama
+    void *ctx;
+    uint64_t total;
+} TrabajoVerificar;
+
+static void *verificar_trozos(void *arg) {
+    TrabajoVerificar *tr = arg;
+    const HashImagen *m = tr->mapa;
+    for (;;) {
+        size_t k = __atomic_fetch_add(tr->siguiente, 1, __ATOMIC_RELAXED);
+        if (k >= tr->k_fin) break;
+        uint64_t off = m->inicio + (uint64_t)k * m->tam_trozo, n = largo_trozo(m, k);
+        unsigned char dig[LARGO_SHA256];
+        int bien = off + n <= tr->map_size &&
+                   EVP_Digest(tr->map + off, (size_t)n, dig, NULL, EVP_sha256(), NULL) == 1 &&
+                   memcmp(dig, m->trozos + k * LARGO_SHA256, LARGO_SHA256) == 0;
+        if (!bien) {
+            pthread_mutex_lock(tr->mu);
+            if ((size_t)*tr->n_malos < tr->max_malos) tr->malos[*tr->n_malos] = k;
+            (*tr->n_malos)++;
+            pthread_mutex_unlock(tr->mu);
+        }
+        uint64_t h = __atomic_add_fetch(tr->hecho, n, __ATOMIC_RELAXED);
+        if (tr->progreso) tr->progreso(tr->ctx, h, tr->total);
+    }
+    return NULL;
+}
+
+static int comparar_size(const void *a, const void *b) {
+    size_t x = *(const size_t *)a, y = *(const size_t *)b;
+    return (x > y) - (x < y);
+}
+
+long verificar_mapa(const unsigned char *map, uint64_t map_size, const HashImagen *mapa, uint64_t desde,
+                    uint64_t hasta, size_t *malos, size_t max_malos, size_t *revisados,
+                    ProgresoHash progreso, void *ctx) {
+    // trozos que tocan [desde, hasta)
+    uint64_t fin_mapa = mapa->inicio + mapa->largo;
+    if (desde < mapa->inicio) desde = mapa->inicio;
+    if (hasta > fin_mapa) hasta = fin_mapa;
+    *revisados = 0;
+    if (!mapa->con_trozos || desde >= hasta) return 0;
+    size_t k_ini = (size_t)((desde - mapa->inicio) / mapa->tam_trozo);
+    size_t k_fin = (size_t)((hasta - mapa->inicio + mapa->tam_trozo - 1) / mapa->tam_trozo);
+    uint64_t total = 0;
+    for (size_t k = k_ini; k < k_fin; k++) total += largo_trozo(mapa, k);
+
+    int nhilos = hilos_disponibles();
+    size_t siguiente = k_ini;
+    uint64_t hecho = 0;
+    long n_malos = 0;
+    pthread_mutex_t mu = PTHREAD_MUTEX_INITIALIZER;
+    TrabajoVerificar trabajos[MAX_HILOS_IMAGEN];
+    pthread_t hilos[MAX_HILOS_IMAGEN];
+    int creados[MAX_HILOS_IMAGEN] = { 0 };
+    for (int i = 0; i < nhilos; i++) {
+        trabajos[i] = (TrabajoVerificar){ map, map_size, mapa, k_fin, &siguiente, &hecho, &mu, malos, max_malos,
+                                          &n_malos, i == 0 ? progreso : NULL, ctx, total };
+    }
+    for (int i = 1; i < nhilos; i++) {
+        creados[i] = pthread_create(&hilos[i], NULL, verificar_trozos, &trabajos[i]) == 0;
+    }
+    verificar_trozos(&trabajos[0]);
+    for (int i = 1; i < nhilos; i++) {
+        if (creados[i]) pthread_join(hilos[i], NULL);
+    }
+    pthread_mutex_destroy(&mu);
+    size_t guardados = (size_t)n_malos < max_malos ? (size_t)n_malos : max_malos;
+    qsort(malos, guardados, sizeof(size_t), comparar_size);
+    *revisados = k_fin - k_ini;
+    return n_malos;
+}
@@ -0,0 +1,60 @@
+#ifndef HASHIMAGEN_H
+#define HASHIMAGEN_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "hashes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TROZO_IMAGEN (64u << 20) // tamano de trozo por defecto del mapa de hashes
+
+// Hash de un rango de la imagen (la imagen entera o una particion). md5/sha256 son los de todo el
+// rango leido de corrido, los mismos que da md5sum/sha256sum. Si se pidieron, 'trozos' tiene el
+// SHA-256 de cada trozo de tam_trozo bytes (el ultimo puede ser mas corto) y 'arbol' es el
+// SHA-256 de todos esos hashes concatenados en orden.
+typedef struct {
+    uint64_t inicio, largo;     // bytes de la imagen
+    uint32_t tam_trozo;
+    size_t n_trozos;
+    unsigned char md5[LARGO_MD5];
+    unsigned char sha256[LARGO_SHA256];
+    int con_trozos;
+    unsigned char arbol[LARGO_SHA256];
+    unsigned char *trozos;      // n_trozos * LARGO_SHA256, NULL sin con_trozos
+    double segundos;
+    int hilos;
+} HashImagen;
+
+// Avance: bytes hechos de 'total'. Se llama desde el hilo que llamo a la funcion.
+typedef void (*ProgresoHash)(void *ctx, uint64_t hecho, uint64_t total);
+
+// Hashea map[inicio .. inicio + largo). Un hilo calcula MD5 y SHA-256 lineales y los demas
+// (uno por nucleo) van por delante hasheando cada trozo por separado, con lo que ademas dejan
+// las paginas cargadas. con_trozos = 0 no guarda hashes por trozo: los otros hilos solo adelantan
+// la lectura. Devuelve 0 o -1 si falta memoria.
+int hashear_imagen(const unsigned char *map, uint64_t inicio, uint64_t largo, uint32_t tam_trozo,
+                   int con_trozos, HashImagen *h, ProgresoHash progreso, void *ctx);
+void liberar_hash_imagen(HashImagen *h);
+
+// Mapa de hashes por trozo en texto: cabecera "# ..." y una linea "offset largo sha256" por trozo
+int guardar_mapa_hashes(const HashImagen *h, FILE *out);
+// Devuelve 0, -1 si el archivo no es un mapa valido o -2 si falta memoria
+int cargar_mapa_hashes(FILE *in, HashImagen *h);
+
+// Vuelve a hashear (en paralelo) solo los trozos del mapa que tocan [desde, hasta) y deja en
+// 'malos' (hasta max_malos) los numeros de los que no coinciden. Un trozo fuera de la imagen
+// cuenta como malo. Devuelve cuantos no coinciden o -1 si falta memoria; *revisados = trozos leidos.
+long verificar_mapa(const unsigned char *map, uint64_t map_size, const HashImagen *mapa, uint64_t desde,
+                    uint64_t hasta, size_t *malos, size_t max_malos, size_t *revisados,
+                    ProgresoHash progreso, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,205 @@
+// hashes.c
+#include "hashes.h"
+#include "compresion.h"
+#include "ordenMft.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <openssl/evp.h>
+
+#define MAX_HILOS_HASH 16
+#define TROZO_HASH     65536 // cada trozo pasa por los tres algoritmos mientras sigue en cache
+
+static double ahora_seg(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef struct {
+    EVP_MD_CTX *md5, *sha1, *sha256;
+} Digestos;
+
+static void digestos_actualizar(Digestos *d, const unsigned char *p, size_t n) {
+    while (n > 0) {
+        size_t k = n < TROZO_HASH ? n : TROZO_HASH;
+        EVP_DigestUpdate(d->md5, p, k);
+        EVP_DigestUpdate(d->sha1, p, k);
+        EVP_DigestUpdate(d->sha256, p, k);
+        p += k;
+        n -= k;
+    }
+}
+
+static void digestos_ceros(Digestos *d, uint64_t n) {
+    static const unsigned char ceros[TROZO_HASH];
+    while (n > 0) {
+        size_t k = n < TROZO_HASH ? (size_t)n : TROZO_HASH;
+        digestos_actualizar(d, ceros, k);
+        n -= k;
+    }
+}
+
+// Pasa el contenido de la fila i por los tres digestos. Devuelve los bytes leidos o -1 si
+// los datos no se pueden leer (fuera de la imagen, sin memoria, residente sin offset).
+static long long hashear_fila(const VolumenNtfs *v, const TablaMft *t, size_t i, Digestos *d) {
+    uint64_t tamano = t->tamano[i];
+    const Extent *ext = t->tramos + t->tramo_ini[i];
+    int n = (int)t->tramo_n[i];
+
+    if (t->compresion[i] && n > 0) {
+        LectorComprimido l;
+        if (lector_abrir(&l, v, ext, n, tamano, t->compresion[i]) != 0) return -1;
+        unsigned char *buf = malloc(l.bytes_unidad);
+        if (!buf) {
+            lector_cerrar(&l);
+            return -1;
+        }
+        uint64_t hecho = 0;
+        size_t k;
+        while ((k = lector_leer(&l, hecho, buf, l.bytes_unidad)) > 0) {
+            digestos_actualizar(d, buf, k);
+            hecho += k;
+        }
+        free(buf);
+        lector_cerrar(&l);
+        return (long long)hecho;
+    }
+
+    if (n > 0) {
+        // los tramos se leen directo del mapa, sin copiar
+        uint64_t hecho = 0;
+        for (int e = 0; e < n && hecho < tamano; e++) {
+            uint64_t bytes = ext[e].len * v->tam_cluster;
+            if (bytes > tamano - hecho) bytes = tamano - hecho;
+            if (ext[e].lcn < 0) {
+                digestos_ceros(d, bytes);
+            } else {
+                long long off = v->base + ext[e].lcn * (long long)v->tam_cluster;
+                if (off < 0 || off + (long long)bytes > v->map_size) return -1;
+                digestos_actualizar(d, v->map + off, (size_t)bytes);
+            }
+            hecho += bytes;
+        }
+        // un runlist mas corto que el tamano (no deberia pasar) se completa con ceros
+        if (hecho < tamano) digestos_ceros(d, tamano - hecho);
+        return (long long)tamano;
+    }
+
+    // residente: de la copia del registro con los fixups aplicados, no del mapa
+    if (tamano == 0) return 0;
+    const unsigned char *valor = tabla_residente(t, i);
+    if (!valor) return -1;
+    size_t len = t->data_len[i] < tamano ? t->data_len[i] : (size_t)tamano;
+    digestos_actualizar(d, valor, len);
+    return (long long)len;
+}
+
+typedef struct {
+    const VolumenNtfs *v;
+    TablaMft *t;
+    const uint32_t *orden;
+    size_t m;
+    size_t *siguiente;      // proximo archivo a repartir (compartido)
+    size_t archivos;
+    uint64_t bytes;
+    int error;
+} TrabajoHash;
+
+static void *hashear_trozo(void *arg) {
+    TrabajoHash *tr = arg;
+    Digestos d = { EVP_MD_CTX_new(), EVP_MD_CTX_new(), EVP_MD_CTX_new() };
+    if (!d.md5 || !d.sha1 || !d.sha256) {
+        tr->error = 1;
+    } else {
+        for (;;) {
+            // reparto dinamico: los tamanos de archivo son muy distintos
+            size_t j = __atomic_fetch_add(tr->siguiente, 1, __ATOMIC_RELAXED);
+            if (j >= tr->m) break;
+            size_t i = tr->orden[j];
+            EVP_DigestInit_ex(d.md5, EVP_md5(), NULL);
+            EVP_DigestInit_ex(d.sha1, EVP_sha1(), NULL);
+            EVP_DigestInit_ex(d.sha256, EVP_sha256(), NULL);
+            long long leidos = hashear_fila(tr->v, tr->t, i, &d);
+            if (leidos < 0) continue;
+            unsigned char *h = tr->t->hashes + i * LARGO_HASHES;
+            EVP_DigestFinal_ex(d.md5, h, NULL);
+            EVP_DigestFinal_ex(d.sha1, h + LARGO_MD5, NULL);
+            EVP_DigestFinal_ex(d.sha256, h + LARGO_MD5 + LARGO_SHA1, NULL);
+            // cada hilo escribe solo las filas que tomo; la marca es un byte por fila
+            tr->t->marcas[i] |= MARCA_HASH;
+            tr->archivos++;
+            tr->bytes += (uint64_t)leidos;
+        }
+    }
+    EVP_MD_CTX_free(d.md5);
+    EVP_MD_CTX_free(d.sha1);
+    EVP_MD_CTX_free(d.sha256);
+    return NULL;
+}
+
+int calcular_hashes(const VolumenNtfs *v, TablaMft *t, EstadisticaHash *est) {
+    memset(est, 0, sizeof(*est));
+    double inicio = ahora_seg();
+    if (!t->hashes) {
+        t->hashes = malloc((t->n ? t->n : 1) * LARGO_HASHES);
+        if (!t->hashes) return -1;
+    }
+
+    // en orden de posicion fisica (primer tramo) para leer el disco de corrido
+    uint64_t *claves = malloc((t->n ? t->n : 1) * sizeof(uint64_t));
+    uint32_t *orden = malloc((t->n ? t->n : 1) * sizeof(uint32_t));
+    if (!claves || !orden) {
+        free(claves);
+        free(orden);
+        return -1;
+    }
+    size_t m = 0;
+    for (size_t i = 0; i < t->n; i++) {
+        t->marcas[i] &= (uint8_t)~MARCA_HASH;
+        if (t->es_dir[i]) continue;
+        claves[m] = t->data_off[i] >= 0 ? (uint64_t)t->data_off[i] : UINT64_MAX;
+        orden[m++] = (uint32_t)i;
+    }
+    if (radix_ordenar(claves, orden, m) != 0) {
+        free(claves);
+        free(orden);
+        return -1;
+    }
+    free(claves);
+
+    long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    int nhilos = nucleos < 1 ? 1 : nucleos > MAX_HILOS_HASH ? MAX_HILOS_HASH : (int)nucleos;
+    size_t siguiente = 0;
+    TrabajoHash trabajos[MAX_HILOS_HASH];
+    pthread_t hilos[MAX_HILOS_HASH];
+    int creados[MAX_HILOS_HASH] = { 0 };
+    for (int h = 0; h < nhilos; h++) trabajos[h] = (TrabajoHash){ v, t, orden, m, &siguiente, 0, 0, 0 };
+    for (int h = 1; h < nhilos; h++) {
+        creados[h] = pthread_create(&hilos[h], NULL, hashear_trozo, &trabajos[h]) == 0;
+    }
+    hashear_trozo(&trabajos[0]);
+    int error = 0;
+    for (int h = 0; h < nhilos; h++) {
+        if (h > 0 && creados[h]) pthread_join(hilos[h], NULL);
+        est->archivos += trabajos[h].archivos;
+        est->bytes += trabajos[h].bytes;
+        error |= trabajos[h].error;
+    }
+    free(orden);
+    est->hilos = nhilos;
+    est->segundos = ahora_seg() - inicio;
+    return error ? -1 : 0;
+}
+
+void hash_a_hex(const unsigned char *h, size_t n, char *out) {
+    static const char dig[] = "0123456789abcdef";
+    for (size_t i = 0; i < n; i++) {
+        out[2 * i] = dig[h[i] >> 4];
+        out[2 * i + 1] = dig[h[i] & 15];
+    }
+    out[2 * n] = '\0';
+}
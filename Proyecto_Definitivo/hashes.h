@@ -0,0 +1,50 @@
+#ifndef HASHES_H
+#define HASHES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "ntfsVolumen.h"
+#include "tablaMft.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LARGO_MD5    16
+#define LARGO_SHA1   20
+#define LARGO_SHA256 32
+#define LARGO_HASHES (LARGO_MD5 + LARGO_SHA1 + LARGO_SHA256)
+
+// Hashes de la fila i en t->hashes (validos si tiene MARCA_HASH)
+static inline const unsigned char *hash_md5(const TablaMft *t, size_t i) {
+    return t->hashes + i * LARGO_HASHES;
+}
+static inline const unsigned char *hash_sha1(const TablaMft *t, size_t i) {
+    return t->hashes + i * LARGO_HASHES + LARGO_MD5;
+}
+static inline const unsigned char *hash_sha256(const TablaMft *t, size_t i) {
+    return t->hashes + i * LARGO_HASHES + LARGO_MD5 + LARGO_SHA1;
+}
+
+typedef struct {
+    size_t archivos;
+    uint64_t bytes;
+    double segundos;
+    int hilos;
+} EstadisticaHash;
+
+// MD5, SHA-1 y SHA-256 del contenido de cada archivo (no directorios) en una sola lectura:
+// cada trozo leido pasa por los tres. Sigue el runlist completo, descomprime LZNT1 y cuenta los
+// tramos dispersos como ceros. Los archivos se reparten entre un hilo por nucleo en orden de
+// posicion en el disco. Devuelve 0 o -1 si falta memoria.
+int calcular_hashes(const VolumenNtfs *v, TablaMft *t, EstadisticaHash *est);
+
+// 'n' bytes en hexadecimal minuscula; 'out' debe tener 2 * n + 1 bytes
+void hash_a_hex(const unsigned char *h, size_t n, char *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <sys/types.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -10,6 +11,27 @@ extern "C" {
 
 void hex_viewer_from_map(unsigned char *map, long map_size, off_t start_offset, size_t view_length);
 
+// Origen de los bytes del visor cuando no son un rango contiguo del mapa (p. ej. un archivo
+// comprimido): leer() copia hasta n bytes desde el offset 'off' y devuelve cuantos copio.
+// Si fisico no es NULL la barra de estado muestra tambien el offset en la imagen (-1 = disperso).
+typedef struct {
+    size_t (*leer)(void *ctx, uint64_t off, unsigned char *buf, size_t n);
+    long long (*fisico)(void *ctx, uint64_t off);
+    void *ctx;
+    uint64_t tamano;
+} FuenteHex;
+
+// Si no es NULL, la barra de estado agrega donde cae el offset de la imagen (p. ej. en que
+// segmento de una imagen partida)
+extern void (*hex_ubicar)(uint64_t off, char *buf, size_t n);
+
+// Igual que hex_viewer_from_map() pero sobre una fuente: empieza en 'inicio' y no baja de 'fin'
+void hex_viewer_fuente(const FuenteHex *f, uint64_t inicio, uint64_t fin);
+
+// Linea de dump que muestra el visor para 'abs_offset': offset, 16 bytes en hex y en ASCII, '\n'.
+// 'out' necesita al menos 80 bytes.
+void make_line(const FuenteHex *f, long abs_offset, char *out, size_t outsz);
+
 #ifdef __cplusplus
 }
 #endif
@@ -9,14 +9,19 @@
 #include <stdint.h>
 #include <inttypes.h>
 
+void (*hex_ubicar)(uint64_t off, char *buf, size_t n);
+
 #ifndef MIN
 #define MIN(a,b) ((a) < (b) ? (a) : (b))
 #endif
 
-// Crea una linea de dump (offset en hex, 16 bytes hex, ascii)
-static void make_line_from_map(unsigned char *map, long map_size, long abs_offset, char *out, size_t outsz) {
+// Crea una linea de dump (offset en hex, 16 bytes hex, ascii) leyendo de la fuente
+void make_line(const FuenteHex *f, long abs_offset, char *out, size_t outsz) {
+    unsigned char bytes[16];
+    size_t n = 0;
     // abs_offset puede estar fuera de rango: manejamos truncado
-    if (abs_offset < 0 || abs_offset >= map_size) {
+    if (abs_offset >= 0 && (uint64_t)abs_offset < f->tamano) n = f->leer(f->ctx, (uint64_t)abs_offset, bytes, 16);
+    if (n == 0) {
         snprintf(out, outsz, "%08lx  -- fuera de rango --\n", (unsigned long)abs_offset);
         return;
     }
@@ -25,10 +30,9 @@ static void make_line_from_map(unsigned char *map, long map_size, long abs_offse
     printed += snprintf(out + printed, outsz - printed, "%08lx ", (unsigned long)abs_offset);
 
     // imprime 16 bytes en hex (si hay menos, rellena)
-    for (int i = 0; i < 16; i++) {
-        long p = abs_offset + i;
-        if (p < map_size) {
-            printed += snprintf(out + printed, outsz - printed, "%02x ", map[p]);
+    for (size_t i = 0; i < 16; i++) {
+        if (i < n) {
+            printed += snprintf(out + printed, outsz - printed, "%02x ", bytes[i]);
         } else {
             printed += snprintf(out + printed, outsz - printed, "   ");
         }
@@ -36,10 +40,9 @@ static void make_line_from_map(unsigned char *map, long map_size, long abs_offse
 
     printed += snprintf(out + printed, outsz - printed, " ");
 
-    for (int i = 0; i < 16; i++) {
-        long p = abs_offset + i;
-        if (p < map_size) {
-            unsigned char c = map[p];
+    for (size_t i = 0; i < 16; i++) {
+        if (i < n) {
+            unsigned char c = bytes[i];
             out[printed++] = (isprint(c) ? c : '.');
         } else {
             out[printed++] = ' ';
@@ -49,6 +52,33 @@ static void make_line_from_map(unsigned char *map, long map_size, long abs_offse
     out[printed] = '\0';
 }
 
+// Redibuja las lineas visibles a partir de top_offset
+static void redraw(const FuenteHex *f, long top_offset, long end_offset, int screen_lines) {
+    char linebuf[256];
+    for (int i = 0; i < screen_lines; i++) {
+        long line_off = top_offset + i * 16;
+        if (line_off >= end_offset) {
+            move(i, 0); clrtoeol();
+        } else {
+            make_line(f, line_off, linebuf, sizeof(linebuf));
+            mvaddstr(i,0,linebuf);
+        }
+    }
+}
+
+typedef struct {
+    unsigned char *map;
+    long map_size;
+} FuenteMapa;
+
+static size_t leer_mapa(void *ctx, uint64_t off, unsigned char *buf, size_t n) {
+    const FuenteMapa *m = ctx;
+    if (off >= (uint64_t)m->map_size) return 0;
+    if (n > (uint64_t)m->map_size - off) n = (size_t)((uint64_t)m->map_size - off);
+    memcpy(buf, m->map + off, n);
+    return n;
+}
+
 // vista hex navegable: asume ncurses ya inicializado.
 void hex_viewer_from_map(unsigned char *map, long map_size, off_t start_offset, size_t view_length) {
     if (!map) return;
@@ -64,6 +94,16 @@ void hex_viewer_from_map(unsigned char *map, long map_size, off_t start_offset,
         if (end_offset > map_size) end_offset = map_size;
     }
 
+    FuenteMapa m = { map, map_size };
+    FuenteHex f = { leer_mapa, NULL, &m, (uint64_t)map_size };
+    hex_viewer_fuente(&f, (uint64_t)offset, (uint64_t)end_offset);
+}
+
+void hex_viewer_fuente(const FuenteHex *f, uint64_t inicio, uint64_t fin) {
+    long offset = (long)inicio;
+    long end_offset = (long)fin;
+    long limite = (long)f->tamano; // hasta donde se puede ir con 'g'
+
     int screen_lines = LINES - 3; // reservamos 2 líneas para info/status
     if (screen_lines < 5) screen_lines = 5;
 
@@ -73,17 +113,7 @@ void hex_viewer_from_map(unsigned char *map, long map_size, off_t start_offset,
 
     // Dibujar inicial
     clear();
-    char linebuf[256];
-    for (int i = 0; i < screen_lines; i++) {
-        long line_off = top_offset + i * 16;
-        if (line_off >= end_offset) {
-            move(i, 0);
-            clrtoeol();
-        } else {
-            make_line_from_map(map, map_size, line_off, linebuf, sizeof(linebuf));
-            mvaddstr(i, 0, linebuf);
-        }
-    }
+    redraw(f, top_offset, end_offset, screen_lines);
 
     // Posicionar cursor visual
     int cursor_x = 9 + (cur_col * 3); // 8 hex chars + space -> 9 offset
@@ -97,7 +127,23 @@ void hex_viewer_from_map(unsigned char *map, long map_size, off_t start_offset,
     // loop de interacción
     while (1) {
         // barra de estado inferior
-        mvprintw(LINES - 2, 0, "Offset: 0x%08lx  (%ld)  Top: 0x%08lx  End: 0x%08lx  q=salir, ENTER=mostrar offset", (unsigned long)(top_offset + cur_line*16 + cur_col), (long)(top_offset + cur_line*16 + cur_col), (unsigned long)top_offset, (unsigned long)end_offset);
+        long cur = top_offset + cur_line*16 + cur_col;
+        long long en_imagen = f->leer == leer_mapa ? cur : -1; // offset en la imagen, si se sabe
+        if (f->fisico) {
+            // vista logica de un archivo: offset dentro del archivo y donde cae en la imagen
+            long long fis = en_imagen = f->fisico(f->ctx, (uint64_t)cur);
+            if (fis >= 0)
+                mvprintw(LINES - 2, 0, "Logico: 0x%08lx  (%ld)  Fisico: 0x%010llx  End: 0x%08lx  q=salir, ENTER=mostrar offset", (unsigned long)cur, cur, (unsigned long long)fis, (unsigned long)end_offset);
+            else
+                mvprintw(LINES - 2, 0, "Logico: 0x%08lx  (%ld)  Fisico: (disperso)  End: 0x%08lx  q=salir, ENTER=mostrar offset", (unsigned long)cur, cur, (unsigned long)end_offset);
+        } else {
+            mvprintw(LINES - 2, 0, "Offset: 0x%08lx  (%ld)  Top: 0x%08lx  End: 0x%08lx  q=salir, ENTER=mostrar offset", (unsigned long)cur, cur, (unsigned long)top_offset, (unsigned long)end_offset);
+        }
+        if (hex_ubicar && en_imagen >= 0) {
+            char donde[128];
+            hex_ubicar((uint64_t)en_imagen, donde, sizeof(donde));
+            printw("  [%s]", donde);
+        }
         clrtoeol();
         refresh();
 
@@ -113,16 +159,7 @@ void hex_viewer_from_map(unsigned char *map, long map_size, off_t start_offset,
                     else {
                         top_offset -= 16;
                         if (top_offset < 0) top_offset = 0;
-                        // redraw
-                        for (int i = 0; i < screen_lines; i++) {
-                            long line_off = top_offset + i * 16;
-                            if (line_off >= end_offset) {
-                                move(i, 0); clrtoeol();
-                            } else {
-                                make_line_from_map(map, map_size, line_off, linebuf, sizeof(linebuf));
-                                mvaddstr(i,0,linebuf);
-                            }
-                        }
+                        redraw(f, top_offset, end_offset, screen_lines);
                     }
                     cur_col = 15;
                 }
@@ -142,16 +179,7 @@ void hex_viewer_from_map(unsigned char *map, long map_size, off_t start_offset,
                                 // nothing
                             }
                         }
-                        // redraw
-                        for (int i = 0; i < screen_lines; i++) {
-                            long line_off = top_offset + i * 16;
-                            if (line_off >= end_offset) {
-                                move(i, 0); clrtoeol();
-                            } else {
-                                make_line_from_map(map, map_size, line_off, linebuf, sizeof(linebuf));
-                                mvaddstr(i,0,linebuf);
-                            }
-                        }
+                        redraw(f, top_offset, end_offset, screen_lines);
                     }
                     cur_col = 0;
                 }
@@ -161,16 +189,7 @@ void hex_viewer_from_map(unsigned char *map, long map_size, off_t start_offset,
             else {
                 if (top_offset >= 16) {
                     top_offset -= 16;
-                    // redraw
-                    for (int i = 0; i < screen_lines; i++) {
-                        long line_off = top_offset + i * 16;
-                        if (line_off >= end_offset) {
-                            move(i, 0); clrtoeol();
-                        } else {
-                            make_line_from_map(map, map_size, line_off, linebuf, sizeof(linebuf));
-                            mvaddstr(i,0,linebuf);
-                        }
-                    }
+                    redraw(f, top_offset, end_offset, screen_lines);
                 }
             }
         } else if (ch == KEY_DOWN) {
@@ -180,16 +199,7 @@ void hex_viewer_from_map(unsigned char *map, long map_size, off_t start_offset,
                 // scroll down
                 if (top_offset + screen_lines*16 < end_offset) {
                     top_offset += 16;
-                    // redraw
-                    for (int i = 0; i < screen_lines; i++) {
-                        long line_off = top_offset + i * 16;
-                        if (line_off >= end_offset) {
-                            move(i, 0); clrtoeol();
-                        } else {
-                            make_line_from_map(map, map_size, line_off, linebuf, sizeof(linebuf));
-                            mvaddstr(i,0,linebuf);
-                        }
-                    }
+                    redraw(f, top_offset, end_offset, screen_lines);
                 }
             }
         } else if (ch == 10 || ch == KEY_ENTER) {
@@ -209,20 +219,11 @@ void hex_viewer_from_map(unsigned char *map, long map_size, off_t start_offset,
             noecho();
             long newoff = strtol(input, NULL, 0);
             if (newoff < 0) newoff = 0;
-            if (newoff >= map_size) newoff = map_size - 1;
+            if (newoff >= limite) newoff = limite - 1;
             top_offset = newoff - (newoff % 16);
             cur_line = 0;
             cur_col = newoff % 16;
-            // redraw
-            for (int i = 0; i < screen_lines; i++) {
-                long line_off = top_offset + i * 16;
-                if (line_off >= end_offset) {
-                    move(i, 0); clrtoeol();
-                } else {
-                    make_line_from_map(map, map_size, line_off, linebuf, sizeof(linebuf));
-                    mvaddstr(i,0,linebuf);
-                }
-            }
+            redraw(f, top_offset, end_offset, screen_lines);
         }
 
         // actualizar cursor visual
@@ -0,0 +1,240 @@
+#include "imagen.h"
+#include "ewf.h"
+#include "demanda.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define MAX_SEGMENTOS  100000
+#define BLOQUE_DEMANDA (256u << 10) // de a cuanto se llena lo que no se pudo mapear en su lugar
+#define MAX_COPIA      (1ull << 30) // sin userfaultfd se copia a memoria solo hasta esto
+
+int mapa_solo_usuario = 0;
+
+// Cifras del sufijo numerico de una imagen partida (".001" -> 3), 0 si no es el primer segmento
+static int cifras_primer_segmento(const char *ruta) {
+    const char *punto = strrchr(ruta, '.');
+    if (!punto || strchr(punto, '/')) return 0;
+    int cifras = 0;
+    for (const char *p = punto + 1; *p; p++, cifras++)
+        if (!isdigit((unsigned char)*p)) return 0;
+    if (cifras < 2 || cifras > 6) return 0;
+    long n = strtol(punto + 1, NULL, 10);
+    return n == 0 || n == 1 ? cifras : 0;
+}
+
+static int agregar_segmento(Imagen *img, int *cap, const char *ruta, uint64_t largo) {
+    if (img->n_seg == *cap) {
+        int nuevo = *cap ? *cap * 2 : 16;
+        SegmentoImagen *s = realloc(img->seg, (size_t)nuevo * sizeof(SegmentoImagen));
+        if (!s) return -1;
+        img->seg = s;
+        *cap = nuevo;
+    }
+    char *copia = strdup(ruta);
+    if (!copia) return -1;
+    img->seg[img->n_seg++] = (SegmentoImagen){ copia, img->tamano, largo, NULL };
+    img->tamano += largo;
+    return 0;
+}
+
+// Lista los segmentos y sus tamanos sin mapear nada todavia
+static int listar_segmentos(const char *ruta, Imagen *img) {
+    int cap = 0, cifras = cifras_primer_segmento(ruta);
+    struct stat st;
+    if (stat(ruta, &st) != 0) {
+        perror(ruta);
+        return -1;
+    }
+    if (agregar_segmento(img, &cap, ruta, (uint64_t)st.st_size) != 0) return -1;
+    if (!cifras) return 0;
+
+    size_t base = strlen(ruta) - (size_t)cifras;
+    char *otra = malloc(base + 16);
+    if (!otra) return -1;
+    long n = strtol(ruta + base, NULL, 10);
+    while (img->n_seg < MAX_SEGMENTOS) {
+        snprintf(otra, base + 16, "%.*s%0*ld", (int)base, ruta, cifras, ++n);
+        if (stat(otra, &st) != 0) break; // el primero que falta cierra la imagen
+        if (agregar_segmento(img, &cap, otra, (uint64_t)st.st_size) != 0) {
+            free(otra);
+            return -1;
+        }
+    }
+    free(otra);
+    return 0;
+}
+
+// Copia a buf [off, off + n) de la imagen desde los segmentos mapeados aparte; lo que pasa del
+// final queda en ceros
+static void copiar_de_segmentos(const Imagen *img, uint64_t off, unsigned char *buf, size_t n) {
+    uint64_t off_seg;
+    int s = imagen_segmento(img, off, &off_seg);
+    size_t hecho = 0;
+    while (s >= 0 && s < img->n_seg && hecho < n) {
+        const SegmentoImagen *sg = &img->seg[s++];
+        size_t k = sg->largo - off_seg < n - hecho ? (size_t)(sg->largo - off_seg) : n - hecho;
+        if (k) memcpy(buf + hecho, sg->map + off_seg, k);
+        hecho += k;
+        off_seg = 0;
+    }
+    if (hecho < n) memset(buf + hecho, 0, n - hecho);
+}
+
+static int leer_bloque(void *ctx, uint64_t b, unsigned char *buf, int *guardar) {
+    const Imagen *img = ctx;
+    *guardar = 0; // ya esta en la cache de paginas de los segmentos
+    copiar_de_segmentos(img, img->demanda_off + b * BLOQUE_DEMANDA, buf, BLOQUE_DEMANDA);
+    return 0;
+}
+
+// Desde 'desde' (el borde de pagina anterior al primer segmento que no cae en uno) el mapa pasa a
+// ser memoria anonima. Los segmentos que tocan esa parte se mapean aparte y se copian de a
+// bloques la primera vez que se lee cada uno; sin userfaultfd se copia todo ahora.
+static int llenar_resto(Imagen *img, const char *ruta, int primero, uint64_t desde) {
+    size_t largo = img->reservado - (size_t)desde;
+    unsigned char *m = mmap(img->map + desde, largo, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED,
+                            -1, 0);
+    if (m == MAP_FAILED) {
+        perror("Error reservando memoria para la imagen");
+        return -1;
+    }
+    for (int i = primero; i < img->n_seg; i++) {
+        SegmentoImagen *s = &img->seg[i];
+        if (s->largo == 0) continue;
+        int fd = open(s->ruta, O_RDONLY);
+        if (fd < 0) {
+            perror(s->ruta);
+            return -1;
+        }
+        void *sm = mmap(NULL, (size_t)s->largo, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (sm == MAP_FAILED) {
+            perror(s->ruta);
+            return -1;
+        }
+        s->map = sm;
+    }
+    img->demanda_off = desde;
+    int r = demanda_abrir(&img->demanda, m, largo, BLOQUE_DEMANDA, leer_bloque, img, 0);
+    if (r == 0) return 0;
+    if (r == -2) {
+        fprintf(stderr, "Sin memoria para abrir la imagen\n");
+        return -1;
+    }
+    if (largo > MAX_COPIA) {
+        fprintf(stderr, "%s: el segmento %d no termina en un borde de pagina y sin userfaultfd habria que copiar "
+                "%.1f GB a memoria; juntar los segmentos en un solo archivo (cat) o habilitar "
+                "vm.unprivileged_userfaultfd\n", ruta, img->demanda_desde, largo / 1e9);
+        return -1;
+    }
+    fprintf(stderr, "%s: el segmento %d no termina en un borde de pagina; sin userfaultfd %.1f MB se copian a memoria\n",
+            ruta, img->demanda_desde, largo / 1e6);
+    if (mprotect(m, largo, PROT_READ | PROT_WRITE) != 0) {
+        perror("mprotect");
+        return -1;
+    }
+    copiar_de_segmentos(img, desde, m, (size_t)(img->tamano - desde));
+    mprotect(m, largo, PROT_READ);
+    return 0;
+}
+
+int abrir_imagen(const char *ruta, Imagen *img) {
+    if (es_ewf(ruta)) return ewf_abrir(ruta, img);
+    memset(img, 0, sizeof(*img));
+    if (listar_segmentos(ruta, img) != 0 || img->tamano == 0) {
+        if (img->tamano == 0 && img->n_seg) fprintf(stderr, "%s: la imagen esta vacia\n", ruta);
+        cerrar_imagen(img);
+        return -1;
+    }
+    size_t pag = (size_t)sysconf(_SC_PAGESIZE);
+    img->reservado = (size_t)((img->tamano + pag - 1) / pag * pag);
+    // solo se reservan las direcciones; cada segmento se mapea encima
+    img->map = mmap(NULL, img->reservado, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (img->map == MAP_FAILED) {
+        img->map = NULL;
+        perror("Error reservando el espacio de la imagen");
+        cerrar_imagen(img);
+        return -1;
+    }
+    img->demanda_desde = img->n_seg;
+    for (int i = 0; i < img->n_seg; i++) {
+        SegmentoImagen *s = &img->seg[i];
+        if (s->largo == 0) continue;
+        if (s->inicio % pag != 0) {
+            // el anterior no termino en un borde de pagina: de aca en adelante se llena bajo demanda
+            img->demanda_desde = i;
+            break;
+        }
+        int fd = open(s->ruta, O_RDONLY);
+        if (fd < 0) {
+            perror(s->ruta);
+            cerrar_imagen(img);
+            return -1;
+        }
+        void *m = mmap(img->map + s->inicio, (size_t)s->largo, PROT_READ, MAP_SHARED | MAP_FIXED, fd, 0);
+        close(fd);
+        if (m == MAP_FAILED) {
+            perror(s->ruta);
+            cerrar_imagen(img);
+            return -1;
+        }
+    }
+    if (img->demanda_desde < img->n_seg) {
+        uint64_t desde = img->seg[img->demanda_desde].inicio / pag * pag;
+        // la pagina compartida con el segmento anterior tambien se pisa: ese pedazo se relee
+        int primero = img->demanda_desde;
+        while (primero > 0 && img->seg[primero - 1].inicio + img->seg[primero - 1].largo > desde) primero--;
+        if (llenar_resto(img, ruta, primero, desde) != 0) {
+            cerrar_imagen(img);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void cerrar_imagen(Imagen *img) {
+    // antes de desmapear: sus hilos llenan el mapa
+    ewf_cerrar(img->ewf);
+    demanda_cerrar(img->demanda);
+    if (img->map) munmap(img->map, img->reservado);
+    for (int i = 0; i < img->n_seg; i++) {
+        if (img->seg[i].map) munmap(img->seg[i].map, (size_t)img->seg[i].largo);
+        free(img->seg[i].ruta);
+    }
+    free(img->seg);
+    memset(img, 0, sizeof(*img));
+}
+
+int imagen_segmento(const Imagen *img, uint64_t off, uint64_t *off_seg) {
+    if (off >= img->tamano) return -1;
+    // el ultimo segmento que empieza en o antes de 'off'; los vacios se saltan solos
+    int lo = 0, hi = img->n_seg - 1;
+    while (lo < hi) {
+        int mid = lo + (hi - lo + 1) / 2;
+        if (img->seg[mid].inicio <= off) lo = mid;
+        else hi = mid - 1;
+    }
+    *off_seg = off - img->seg[lo].inicio;
+    return lo;
+}
+
+void imagen_ubicar(const Imagen *img, uint64_t off, char *buf, size_t n) {
+    if (img->ewf) {
+        ewf_ubicar(img->ewf, off, buf, n);
+        return;
+    }
+    uint64_t off_seg;
+    int s = imagen_segmento(img, off, &off_seg);
+    if (s >= 0) {
+        const char *nombre = strrchr(img->seg[s].ruta, '/');
+        snprintf(buf, n, "%s + 0x%llx", nombre ? nombre + 1 : img->seg[s].ruta, (unsigned long long)off_seg);
+    } else {
+        snprintf(buf, n, "fuera de la imagen");
+    }
+}
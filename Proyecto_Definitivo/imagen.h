@@ -0,0 +1,61 @@
+#ifndef IMAGEN_H
+#define IMAGEN_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Un archivo de la imagen: la imagen entera o uno de los segmentos de una imagen partida
+typedef struct {
+    char *ruta;
+    uint64_t inicio;    // offset del segmento dentro de la imagen
+    uint64_t largo;
+    unsigned char *map; // mapeado aparte si cae en la parte que se llena bajo demanda; si no NULL
+} SegmentoImagen;
+
+// Imagen en crudo vista como un solo mapa contiguo. Una adquisicion partida (imagen.001,
+// imagen.002, ...) se abre reservando el espacio de direcciones de todo el disco y mapeando cada
+// segmento en su lugar con MAP_FIXED, asi que lo que cruza de un segmento al siguiente se lee
+// directo del mapa sin copiar. Si un segmento que no es el ultimo no mide un multiplo de la
+// pagina, los siguientes ya no caen en un borde de pagina: desde ahi el mapa es memoria anonima
+// que se llena bajo demanda (demanda.h) copiando de los segmentos mapeados aparte. La Imagen
+// abierta no se copia: los hilos que llenan el mapa usan su direccion.
+typedef struct {
+    unsigned char *map;
+    uint64_t tamano;
+    size_t reservado;           // bytes reservados (tamano redondeado a pagina), para munmap
+    SegmentoImagen *seg;
+    int n_seg;
+    int demanda_desde;          // primer segmento que no se pudo mapear en su lugar; n_seg si ninguno
+    uint64_t demanda_off;       // offset (borde de pagina) donde empieza la parte bajo demanda
+    struct MapaDemanda *demanda;
+    struct Ewf *ewf;            // no NULL si es una E01: el mapa se llena bajo demanda
+} Imagen;
+
+// 1 mientras parte de la imagen abierta se llene con userfaultfd limitado a modo usuario: los
+// fallos de pagina que toma el kernel no se atienden, asi que un write(2) directo desde una parte
+// no cargada del mapa falla con EFAULT. Lo que se escribe desde el mapa pasa por escribir_mapa()
+// (extraer.h).
+extern int mapa_solo_usuario;
+
+// Abre 'ruta'. Si es una EWF (E01) la abre con ewf_abrir(). Si termina en .000 o .001 junta los
+// segmentos siguientes (.002, .003... con el mismo numero de cifras) hasta el primero que falte.
+// Sin userfaultfd lo que no se puede mapear en su lugar se copia a memoria si no pasa de 1 GB; si
+// no, la imagen no se abre. Devuelve 0 o -1 con el error en stderr.
+int abrir_imagen(const char *ruta, Imagen *img);
+void cerrar_imagen(Imagen *img);
+
+// Segmento en el que cae el byte 'off' de la imagen (busqueda binaria) y su offset dentro de el;
+// -1 si esta fuera de la imagen
+int imagen_segmento(const Imagen *img, uint64_t off, uint64_t *off_seg);
+// Donde esta el byte 'off' en los archivos de la imagen, en texto (segmento y offset, o el chunk de la E01)
+void imagen_ubicar(const Imagen *img, uint64_t off, char *buf, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
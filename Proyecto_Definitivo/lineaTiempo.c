@@ -0,0 +1,298 @@
+// lineaTiempo.c
+#define _FILE_OFFSET_BITS 64 // tandas de mas de 2 GB en el temporal
+#include "lineaTiempo.h"
+#include "exportar.h"
+#include "fechas.h"
+#include "ordenMft.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+
+#define EVENTOS_ESCRITURA  4096
+#define EVENTOS_BLOQUE_MIN 1024 // lectura minima de cada tanda al mezclar
+#define LARGO_RUTA         4096
+
+// Un evento es una fecha de una fila: ref = fila * 8 + cual (0..3 de $STANDARD_INFORMATION en
+// orden m, a, c, b; 4..7 las mismas de $FILE_NAME). Ordenar por (tiempo, ref) deja juntas las
+// fechas iguales de un mismo registro.
+typedef struct {
+    uint64_t tiempo;
+    uint32_t ref;
+    uint32_t reservado;
+} Evento;
+
+static double ahora_seg(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t fecha_evento(const TablaMft *t, size_t k, int cual) {
+    switch (cual) {
+        case 0: return t->modificado[k];
+        case 1: return t->accedido[k];
+        case 2: return t->cambiado[k];
+        case 3: return t->creado[k];
+        case 4: return t->fn_fechas[k].modificado;
+        case 5: return t->fn_fechas[k].accedido;
+        case 6: return t->fn_fechas[k].cambiado;
+        default: return t->fn_fechas[k].creado;
+    }
+}
+
+// Junta los eventos consecutivos de la misma fecha, fila y atributo en una linea "macb"
+typedef struct {
+    const TablaMft *t;
+    const IndiceRegistros *ix;
+    FILE *out;
+    int hay;                // hay una linea pendiente
+    uint64_t tiempo;
+    uint32_t fila;
+    int fuente;             // 0 = $STANDARD_INFORMATION, 1 = $FILE_NAME
+    int macb;               // bits 0..3 = m, a, c, b
+    uint64_t lineas;
+    char ruta[LARGO_RUTA];
+} Escritor;
+
+static void escribir_linea(Escritor *e) {
+    const TablaMft *t = e->t;
+    char fecha[FECHA_LARGO_PREC + 1], macb[5] = "....";
+    filetime_to_str_prec(e->tiempo, 7, fecha, sizeof(fecha));
+    for (int b = 0; b < 4; b++) {
+        if (e->macb & (1 << b)) macb[b] = "macb"[b];
+    }
+    ruta_completa(t, e->ix, e->fila, e->ruta, sizeof(e->ruta));
+    fprintf(e->out, "%s,%s,%s,%u,%llu,%u,", fecha, macb, e->fuente ? "FN" : "SI", t->registro[e->fila],
+            (unsigned long long)t->tamano[e->fila], (t->marcas[e->fila] & MARCA_BORRADO) != 0);
+    escribir_campo_csv(e->out, e->ruta);
+    fputc('\n', e->out);
+    e->lineas++;
+}
+
+static void emitir(Escritor *e, uint64_t tiempo, uint32_t ref) {
+    uint32_t fila = ref >> 3;
+    int cual = ref & 7, fuente = cual >> 2;
+    if (e->hay && e->tiempo == tiempo && e->fila == fila && e->fuente == fuente) {
+        e->macb |= 1 << (cual & 3);
+        return;
+    }
+    if (e->hay) escribir_linea(e);
+    e->hay = 1;
+    e->tiempo = tiempo;
+    e->fila = fila;
+    e->fuente = fuente;
+    e->macb = 1 << (cual & 3);
+}
+
+// Escribe una tanda ya ordenada al final del temporal
+static int volcar_tanda(FILE *tmp, const uint64_t *claves, const uint32_t *refs, size_t n, Evento *buf) {
+    for (size_t i = 0; i < n; i += EVENTOS_ESCRITURA) {
+        size_t m = (n - i < EVENTOS_ESCRITURA) ? n - i : EVENTOS_ESCRITURA;
+        for (size_t j = 0; j < m; j++) buf[j] = (Evento){ claves[i + j], refs[i + j], 0 };
+        if (fwrite(buf, sizeof(Evento), m, tmp) != m) return -1;
+    }
+    return 0;
+}
+
+typedef struct {
+    off_t inicio;           // en eventos dentro del temporal
+    uint64_t n, leidos;     // leidos = ya pasados a 'buf'
+    Evento *buf;
+    size_t buf_n, pos;
+} Tanda;
+
+// Anota una tanda de n eventos a continuacion de la anterior en el temporal
+static int nueva_tanda(Tanda **tandas, size_t *nt, size_t *cap, uint64_t n) {
+    if (*nt == *cap) {
+        size_t nuevo = *cap ? *cap * 2 : 16;
+        Tanda *x = realloc(*tandas, nuevo * sizeof(Tanda));
+        if (!x) return -1;
+        *tandas = x;
+        *cap = nuevo;
+    }
+    off_t inicio = *nt ? (*tandas)[*nt - 1].inicio + (off_t)(*tandas)[*nt - 1].n : 0;
+    (*tandas)[(*nt)++] = (Tanda){ inicio, n, 0, NULL, 0, 0 };
+    return 0;
+}
+
+static int recargar(FILE *tmp, Tanda *d, size_t bloque) {
+    size_t m = (d->n - d->leidos < bloque) ? (size_t)(d->n - d->leidos) : bloque;
+    if (fseeko(tmp, (d->inicio + (off_t)d->leidos) * (off_t)sizeof(Evento), SEEK_SET) != 0 ||
+        fread(d->buf, sizeof(Evento), m, tmp) != m) return -1;
+    d->leidos += m;
+    d->buf_n = m;
+    d->pos = 0;
+    return 0;
+}
+
+static int evento_menor(const Evento *a, const Evento *b) {
+    return a->tiempo < b->tiempo || (a->tiempo == b->tiempo && a->ref < b->ref);
+}
+
+// Mezcla de k vias con un monticulo de las tandas por su evento actual
+static int mezclar_tandas(FILE *tmp, Tanda *tandas, size_t nt, size_t bloque, Escritor *e) {
+    size_t *heap = malloc(nt * sizeof(size_t)), hn = 0;
+    if (!heap) return -1;
+    for (size_t i = 0; i < nt; i++) {
+        tandas[i].buf = malloc(bloque * sizeof(Evento));
+        if (!tandas[i].buf || recargar(tmp, &tandas[i], bloque) != 0) {
+            free(heap);
+            return -1;
+        }
+    }
+#define ACTUAL(i) (&tandas[heap[i]].buf[tandas[heap[i]].pos])
+    for (size_t i = 0; i < nt; i++) {
+        // insertar y subir
+        size_t c = hn++;
+        heap[c] = i;
+        while (c > 0 && evento_menor(ACTUAL(c), ACTUAL((c - 1) / 2))) {
+            size_t p = (c - 1) / 2, x = heap[c];
+            heap[c] = heap[p];
+            heap[p] = x;
+            c = p;
+        }
+    }
+    int error = 0;
+    while (hn > 0 && !error) {
+        Tanda *d = &tandas[heap[0]];
+        emitir(e, d->buf[d->pos].tiempo, d->buf[d->pos].ref);
+        if (++d->pos == d->buf_n) {
+            if (d->leidos < d->n) error = recargar(tmp, d, bloque) != 0;
+            else heap[0] = heap[--hn]; // tanda agotada
+        }
+        // bajar la raiz
+        size_t c = 0;
+        for (;;) {
+            size_t m = c, l = 2 * c + 1, r = l + 1;
+            if (l < hn && evento_menor(ACTUAL(l), ACTUAL(m))) m = l;
+            if (r < hn && evento_menor(ACTUAL(r), ACTUAL(m))) m = r;
+            if (m == c) break;
+            size_t x = heap[c];
+            heap[c] = heap[m];
+            heap[m] = x;
+            c = m;
+        }
+    }
+#undef ACTUAL
+    free(heap);
+    return error ? -1 : 0;
+}
+
+int exportar_linea_tiempo(const TablaMft *t, FILE *out, size_t presupuesto, EstadisticaLinea *est) {
+    memset(est, 0, sizeof(*est));
+    double inicio = ahora_seg();
+    IndiceRegistros ix;
+    if (indice_registros(t, &ix) != 0) return -1;
+
+    // cada evento en memoria ocupa clave + ref y otro tanto de auxiliar del radix sort
+    size_t cap = presupuesto / (2 * (sizeof(uint64_t) + sizeof(uint32_t)));
+    if (cap < 65536) cap = 65536;
+    uint64_t total = 0;
+    for (size_t k = 0; k < t->n; k++) {
+        for (int j = 0; j < 8; j++) total += fecha_evento(t, k, j) != 0;
+    }
+    if (cap > total) cap = total ? (size_t)total : 1;
+    uint64_t *claves = malloc(cap * sizeof(uint64_t));
+    uint32_t *refs = malloc(cap * sizeof(uint32_t));
+    Evento *buf = malloc(EVENTOS_ESCRITURA * sizeof(Evento));
+    FILE *tmp = NULL;
+    Tanda *tandas = NULL;
+    size_t nt = 0, nt_cap = 0, n = 0;
+    int res = 0;
+    if (!claves || !refs || !buf) res = -1;
+
+    fprintf(out, "fecha,macb,fuente,registro,tamano,borrado,ruta\n");
+    Escritor *e = malloc(sizeof(Escritor));
+    if (!e) res = -1;
+    else *e = (Escritor){ .t = t, .ix = &ix, .out = out };
+
+    // generar en orden de fila: dentro de una tanda el radix (estable) deja los empates por ref
+    for (size_t k = 0; k < t->n && res == 0; k++) {
+        for (int j = 0; j < 8 && res == 0; j++) {
+            uint64_t f = fecha_evento(t, k, j);
+            if (f == 0) continue;
+            if (n == cap) {
+                // tanda llena: ordenarla y pasarla al temporal
+                if (!tmp && !(tmp = tmpfile())) {
+                    res = -2;
+                    break;
+                }
+                if (radix_ordenar(claves, refs, n) != 0 || nueva_tanda(&tandas, &nt, &nt_cap, n) != 0) {
+                    res = -1;
+                    break;
+                }
+                if (volcar_tanda(tmp, claves, refs, n, buf) != 0) {
+                    res = -2;
+                    break;
+                }
+                n = 0;
+            }
+            claves[n] = f;
+            refs[n++] = (uint32_t)(k * 8 + j);
+            est->eventos++;
+        }
+    }
+
+    if (res == 0 && radix_ordenar(claves, refs, n) != 0) res = -1;
+    if (res == 0 && nt == 0) {
+        // entro todo en memoria: directo a la salida
+        for (size_t i = 0; i < n; i++) emitir(e, claves[i], refs[i]);
+        est->tandas = n ? 1 : 0;
+    } else if (res == 0) {
+        // la ultima tanda tambien al temporal y mezclar todas con la memoria que queda libre
+        if (n && nueva_tanda(&tandas, &nt, &nt_cap, n) != 0) res = -1;
+        else if (n && volcar_tanda(tmp, claves, refs, n, buf) != 0) res = -2;
+        free(claves);
+        free(refs);
+        claves = NULL;
+        refs = NULL;
+        est->tandas = nt;
+        size_t bloque = presupuesto / (nt * sizeof(Evento));
+        if (bloque < EVENTOS_BLOQUE_MIN) bloque = EVENTOS_BLOQUE_MIN;
+        if (res == 0 && (fflush(tmp) != 0 || mezclar_tandas(tmp, tandas, nt, bloque, e) != 0)) res = -2;
+    }
+    if (res == 0 && e->hay) escribir_linea(e);
+    if (res == 0 && ferror(out)) res = -2;
+    if (e) est->lineas = e->lineas;
+
+    for (size_t i = 0; i < nt; i++) free(tandas[i].buf);
+    free(tandas);
+    if (tmp) fclose(tmp);
+    free(e);
+    free(buf);
+    free(claves);
+    free(refs);
+    liberar_indice_registros(&ix);
+    est->segundos = ahora_seg() - inicio;
+    return res;
+}
+
+// FILETIME a segundos Unix (0 se queda en 0)
+static long long segundos_unix(uint64_t ft) {
+    return ft ? (long long)(ft / 10000000ULL) - 11644473600LL : 0;
+}
+
+int exportar_bodyfile(const TablaMft *t, FILE *out) {
+    IndiceRegistros ix;
+    if (indice_registros(t, &ix) != 0) return -1;
+    char ruta[LARGO_RUTA];
+    // MD5|nombre|inodo|modo|UID|GID|tamano|atime|mtime|ctime|crtime
+    for (size_t k = 0; k < t->n; k++) {
+        ruta_completa(t, &ix, k, ruta, sizeof(ruta));
+        const char *modo = t->es_dir[k] ? "d/drwxrwxrwx" : "r/rrwxrwxrwx";
+        const char *borrado = (t->marcas[k] & MARCA_BORRADO) ? " (deleted)" : "";
+        fprintf(out, "0|%s%s|%u|%s|0|0|%llu|%lld|%lld|%lld|%lld\n", ruta, borrado, t->registro[k], modo,
+                (unsigned long long)t->tamano[k], segundos_unix(t->accedido[k]), segundos_unix(t->modificado[k]),
+                segundos_unix(t->cambiado[k]), segundos_unix(t->creado[k]));
+        const FechasNtfs *f = &t->fn_fechas[k];
+        if (f->creado | f->modificado | f->cambiado | f->accedido) {
+            fprintf(out, "0|%s ($FILE_NAME)%s|%u|%s|0|0|%llu|%lld|%lld|%lld|%lld\n", ruta, borrado, t->registro[k], modo,
+                    (unsigned long long)t->tamano[k], segundos_unix(f->accedido), segundos_unix(f->modificado),
+                    segundos_unix(f->cambiado), segundos_unix(f->creado));
+        }
+    }
+    liberar_indice_registros(&ix);
+    return ferror(out) ? -1 : 0;
+}
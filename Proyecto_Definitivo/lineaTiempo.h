@@ -0,0 +1,40 @@
+#ifndef LINEATIEMPO_H
+#define LINEATIEMPO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "tablaMft.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PRESUPUESTO_LINEA ((size_t)256 << 20) // memoria por defecto para ordenar los eventos
+
+typedef struct {
+    uint64_t eventos;       // fechas distintas de 0 que se ordenaron
+    uint64_t lineas;        // lineas escritas (eventos juntados por macb)
+    size_t tandas;          // tramos ordenados en memoria; mas de 1 = se uso el archivo temporal
+    double segundos;
+} EstadisticaLinea;
+
+// Linea de tiempo en CSV ordenada por fecha con las 8 fechas de cada registro (4 de
+// $STANDARD_INFORMATION y 4 de $FILE_NAME) y la ruta completa. Las fechas iguales de un mismo
+// registro y atributo van en una sola linea con su "macb" (modificado, acceso, cambio del
+// registro, creado), como mactime. Los eventos se ordenan en tandas que entran en 'presupuesto'
+// bytes, las tandas van a un archivo temporal (tmpfile) y al final se mezclan leyendo de a un
+// bloque de cada una. Devuelve 0, -1 si falta memoria o -2 si fallo la escritura.
+int exportar_linea_tiempo(const TablaMft *t, FILE *out, size_t presupuesto, EstadisticaLinea *est);
+
+// Formato bodyfile de Sleuth Kit (entrada de mactime): una linea con las fechas de
+// $STANDARD_INFORMATION y otra con las de $FILE_NAME por registro, en segundos Unix; el
+// orden lo hace mactime. Devuelve 0 o -1 si falta memoria o fallo la escritura.
+int exportar_bodyfile(const TablaMft *t, FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
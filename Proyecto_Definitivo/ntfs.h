@@ -1,3 +1,6 @@
+#ifndef NTFS_H
+#define NTFS_H
+
 typedef unsigned char BYTE;
 typedef unsigned short int WORD;
 typedef unsigned int DWORD;
@@ -91,3 +94,5 @@ typedef struct
 
 }ATTR_FILENAME;
 //////////////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,157 @@
+// ntfsVolumen.c
+#include "ntfsVolumen.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NTFS_FIXUP_STRIDE 512 // los fixups se aplican cada 512 bytes sin importar el sector
+
+int aplicar_fixups(unsigned char *reg, uint32_t tam) {
+    struct NTFS_MFT_FILE *f = (struct NTFS_MFT_FILE *)reg;
+    uint32_t off = f->wFixupOffset;
+    uint32_t n = f->wFixupSize; // incluye la palabra del patron
+    if (n < 2 || off + n * 2 > tam || (n - 1) * NTFS_FIXUP_STRIDE > tam) return -1;
+
+    uint16_t patron;
+    memcpy(&patron, reg + off, 2);
+    for (uint32_t i = 1; i < n; i++) {
+        unsigned char *fin_sector = reg + i * NTFS_FIXUP_STRIDE - 2;
+        uint16_t actual;
+        memcpy(&actual, fin_sector, 2);
+        if (actual != patron) return -2;
+        memcpy(fin_sector, reg + off + i * 2, 2);
+    }
+    return 0;
+}
+
+NTFS_ATTRIBUTE *primer_atributo(unsigned char *reg, uint32_t tam) {
+    struct NTFS_MFT_FILE *f = (struct NTFS_MFT_FILE *)reg;
+    if (f->wAttribOffset < sizeof(struct NTFS_MFT_FILE) - 4 || f->wAttribOffset + 4u > tam) return NULL;
+    NTFS_ATTRIBUTE *attr = (NTFS_ATTRIBUTE *)(reg + f->wAttribOffset);
+    uint32_t fin = f->dwRecLength < tam ? f->dwRecLength : tam;
+    if (attr->dwType == 0xFFFFFFFF) return NULL;
+    if (f->wAttribOffset + 16u > fin || attr->dwFullLength < 16 ||
+        f->wAttribOffset + attr->dwFullLength > fin) return NULL;
+    return attr;
+}
+
+NTFS_ATTRIBUTE *siguiente_atributo(unsigned char *reg, uint32_t tam, NTFS_ATTRIBUTE *attr) {
+    struct NTFS_MFT_FILE *f = (struct NTFS_MFT_FILE *)reg;
+    uint32_t fin = f->dwRecLength < tam ? f->dwRecLength : tam;
+    size_t pos = (unsigned char *)attr - reg + attr->dwFullLength;
+    if (pos + 4 > fin) return NULL;
+    NTFS_ATTRIBUTE *sig = (NTFS_ATTRIBUTE *)(reg + pos);
+    if (sig->dwType == 0xFFFFFFFF) return NULL;
+    if (pos + 16 > fin || sig->dwFullLength < 16 || pos + sig->dwFullLength > fin) return NULL;
+    return sig;
+}
+
+void *valor_residente(NTFS_ATTRIBUTE *attr, uint32_t minimo) {
+    if (attr->uchNonResFlag != 0) return NULL;
+    uint32_t off = attr->Attr.Resident.wAttrOffset;
+    uint32_t len = attr->Attr.Resident.dwLength;
+    if (len < minimo || off + (uint64_t)len > attr->dwFullLength) return NULL;
+    return (unsigned char *)attr + off;
+}
+
+// Tramo de $MFT que contiene el VCN, NULL si no esta
+static const Extent *tramo_mft(const VolumenNtfs *v, uint64_t vcn) {
+    int i = buscar_tramo(v->mft_ext, v->mft_n, vcn);
+    return i < 0 ? NULL : &v->mft_ext[i];
+}
+
+long long offset_registro(const VolumenNtfs *v, uint64_t num) {
+    if (num >= v->num_registros) return -1;
+    uint64_t byte = num * v->tam_registro;
+    const Extent *e = tramo_mft(v, byte / v->tam_cluster);
+    if (!e || e->lcn < 0) return -1;
+    long long off = v->base + (long long)(e->lcn + (byte / v->tam_cluster - e->vcn)) * v->tam_cluster
+                    + (long long)(byte % v->tam_cluster);
+    if (off < 0 || off + v->tam_registro > v->map_size) return -1;
+    return off;
+}
+
+int leer_registro(const VolumenNtfs *v, uint64_t num, unsigned char *buf) {
+    if (v->tam_registro <= v->tam_cluster) {
+        long long off = offset_registro(v, num);
+        if (off < 0) return -1;
+        memcpy(buf, v->map + off, v->tam_registro);
+    } else {
+        // registro mayor que el cluster: puede cruzar tramos, se copia cluster a cluster
+        uint64_t byte = num * v->tam_registro;
+        if (num >= v->num_registros) return -1;
+        for (uint32_t hecho = 0; hecho < v->tam_registro; hecho += v->tam_cluster) {
+            uint64_t vcn = (byte + hecho) / v->tam_cluster;
+            const Extent *e = tramo_mft(v, vcn);
+            if (!e || e->lcn < 0) return -1;
+            long long off = v->base + (long long)(e->lcn + (vcn - e->vcn)) * v->tam_cluster;
+            if (off < 0 || off + v->tam_cluster > v->map_size) return -1;
+            memcpy(buf + hecho, v->map + off, v->tam_cluster);
+        }
+    }
+    if (memcmp(buf, "FILE", 4) != 0) return -1;
+    return aplicar_fixups(buf, v->tam_registro) == 0 ? 0 : -2;
+}
+
+int abrir_volumen(unsigned char *map, long map_size, unsigned int lba_inicio, VolumenNtfs *v) {
+    memset(v, 0, sizeof(*v));
+    v->map = map;
+    v->map_size = map_size;
+    v->lba_inicio = lba_inicio;
+    v->base = (long long)lba_inicio * 512;
+    if (v->base + 512 > map_size) return -1;
+
+    unsigned char *boot_sector = map + v->base;
+    if (memcmp(&boot_sector[0x03], "NTFS    ", 8) != 0) return -1;
+
+    v->bytes_por_sector = *(unsigned short *)&boot_sector[0x0B];
+    v->sectores_por_cluster = boot_sector[0x0D];
+    v->tam_cluster = v->bytes_por_sector * v->sectores_por_cluster;
+    v->mft_cluster = *(LONGLONG *)&boot_sector[0x30];
+    if (v->tam_cluster == 0 || (v->tam_cluster & (v->tam_cluster - 1)) != 0) return -1;
+    v->num_clusters = *(uint64_t *)&boot_sector[0x28] / v->sectores_por_cluster; // 0x28: sectores totales
+
+    // 0x40: clusters por registro, si es negativo el tamano es 2^(-n) bytes
+    signed char cpr = (signed char)boot_sector[0x40];
+    v->tam_registro = (cpr < 0) ? (1u << (-cpr)) : (uint32_t)cpr * v->tam_cluster;
+    if (v->tam_registro < 512 || v->tam_registro > 65536) return -1;
+
+    // Registro 0 ($MFT) en su posicion fija; de su $DATA sale el runlist del resto
+    long long off0 = v->base + (long long)v->mft_cluster * v->tam_cluster;
+    if (off0 < 0 || off0 + v->tam_registro > map_size) return -1;
+    unsigned char *reg = malloc(v->tam_registro);
+    if (!reg) return -1;
+    memcpy(reg, map + off0, v->tam_registro);
+    if (memcmp(reg, "FILE", 4) != 0 || aplicar_fixups(reg, v->tam_registro) != 0) {
+        free(reg);
+        return -1;
+    }
+
+    for (NTFS_ATTRIBUTE *attr = primer_atributo(reg, v->tam_registro); attr;
+         attr = siguiente_atributo(reg, v->tam_registro, attr)) {
+        if (attr->dwType != 0x80 || attr->uchNonResFlag == 0 || attr->uchNameLength != 0) continue;
+        unsigned char *run = (unsigned char *)attr + attr->Attr.NonResident.wDatarunOffset;
+        if (decodificar_runlist(run, (unsigned char *)attr + attr->dwFullLength,
+                                attr->Attr.NonResident.n64StartVCN,
+                                &v->mft_ext, &v->mft_n, &v->mft_cap) < 0) break;
+        v->num_registros = attr->Attr.NonResident.n64RealSize / v->tam_registro;
+    }
+    free(reg);
+
+    if (v->mft_n == 0) {
+        // sin runlist legible: asumimos $MFT contiguo hasta el final de la imagen
+        Extent e = { 0, (int64_t)v->mft_cluster, (uint64_t)(map_size - off0) / v->tam_cluster };
+        v->mft_ext = malloc(sizeof(Extent));
+        if (!v->mft_ext) return -1;
+        v->mft_ext[0] = e;
+        v->mft_n = v->mft_cap = 1;
+        v->num_registros = (uint64_t)(map_size - off0) / v->tam_registro;
+    }
+    return 0;
+}
+
+void cerrar_volumen(VolumenNtfs *v) {
+    free(v->mft_ext);
+    v->mft_ext = NULL;
+    v->mft_n = v->mft_cap = 0;
+}
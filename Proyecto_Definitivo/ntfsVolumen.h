@@ -0,0 +1,57 @@
+#ifndef NTFSVOLUMEN_H
+#define NTFSVOLUMEN_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "ntfs.h"
+#include "runlist.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Geometria de un volumen NTFS dentro del mapa y runlist del propio $MFT
+typedef struct {
+    unsigned char *map;
+    long map_size;
+    unsigned int lba_inicio;
+    long long base;                 // offset en bytes del inicio de la particion
+    uint32_t bytes_por_sector;
+    uint32_t sectores_por_cluster;
+    uint32_t tam_cluster;
+    uint32_t tam_registro;          // normalmente 1024
+    uint64_t num_clusters;          // clusters del volumen segun el boot sector
+    uint64_t mft_cluster;
+    uint64_t num_registros;         // registros que caben en $MFT:$DATA
+    Extent *mft_ext;                // $MFT puede estar fragmentado
+    int mft_n, mft_cap;
+} VolumenNtfs;
+
+// Lee el boot sector y el registro 0 ($MFT). Devuelve 0 o -1 si no es un NTFS valido.
+int abrir_volumen(unsigned char *map, long map_size, unsigned int lba_inicio, VolumenNtfs *v);
+void cerrar_volumen(VolumenNtfs *v);
+
+// Offset absoluto (dentro del mapa) del registro 'num', o -1 si queda fuera
+long long offset_registro(const VolumenNtfs *v, uint64_t num);
+
+// Copia el registro 'num' en buf (tam_registro bytes) y aplica los fixups.
+// Devuelve 0, -1 si no hay registro "FILE" valido, -2 si un fixup no coincide (sector roto).
+int leer_registro(const VolumenNtfs *v, uint64_t num, unsigned char *buf);
+
+// Aplica el update sequence array sobre un registro ya copiado en memoria
+int aplicar_fixups(unsigned char *reg, uint32_t tam);
+
+// Recorrido de atributos: primer_atributo() y siguiente_atributo() devuelven NULL
+// al llegar a 0xFFFFFFFF o si la cabecera del atributo es inconsistente.
+NTFS_ATTRIBUTE *primer_atributo(unsigned char *reg, uint32_t tam);
+NTFS_ATTRIBUTE *siguiente_atributo(unsigned char *reg, uint32_t tam, NTFS_ATTRIBUTE *attr);
+
+// Valor de un atributo residente si cabe dentro del atributo y mide al menos 'minimo', si no NULL
+void *valor_residente(NTFS_ATTRIBUTE *attr, uint32_t minimo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,320 @@
+// ordenMft.c
+#include "ordenMft.h"
+#include "tiposArchivo.h"
+
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#define RADIX_BITS      11 // 6 pasadas para 64 bits
+#define RADIX_CUBETAS   (1 << RADIX_BITS)
+#define UMBRAL_PARALELO (1 << 16) // por debajo no vale la pena crear hilos
+#define MAX_HILOS       16
+
+typedef struct {
+    const uint64_t *k_in;
+    const uint32_t *i_in;
+    uint64_t *k_out;
+    uint32_t *i_out;
+    size_t ini, fin;
+    int shift;
+    size_t hist[RADIX_CUBETAS]; // despues de contar pasa a ser la posicion de escritura
+} TrozoRadix;
+
+static void *contar_trozo(void *arg) {
+    TrozoRadix *tr = arg;
+    memset(tr->hist, 0, sizeof(tr->hist));
+    for (size_t i = tr->ini; i < tr->fin; i++) {
+        tr->hist[(tr->k_in[i] >> tr->shift) & (RADIX_CUBETAS - 1)]++;
+    }
+    return NULL;
+}
+
+static void *dispersar_trozo(void *arg) {
+    TrozoRadix *tr = arg;
+    for (size_t i = tr->ini; i < tr->fin; i++) {
+        size_t pos = tr->hist[(tr->k_in[i] >> tr->shift) & (RADIX_CUBETAS - 1)]++;
+        tr->k_out[pos] = tr->k_in[i];
+        tr->i_out[pos] = tr->i_in[i];
+    }
+    return NULL;
+}
+
+// Ejecuta fn sobre cada trozo, en hilos si hay mas de uno
+static void en_paralelo(void *(*fn)(void *), TrozoRadix *trozos, int nhilos) {
+    pthread_t hilos[MAX_HILOS];
+    int creados = 0;
+    for (int h = 1; h < nhilos; h++) {
+        if (pthread_create(&hilos[h], NULL, fn, &trozos[h]) != 0) break;
+        creados = h;
+    }
+    fn(&trozos[0]);
+    for (int h = 1; h <= creados; h++) pthread_join(hilos[h], NULL);
+    for (int h = creados + 1; h < nhilos; h++) fn(&trozos[h]); // si no se pudo crear el hilo
+}
+
+int radix_ordenar(uint64_t *claves, uint32_t *idx, size_t n) {
+    if (n < 2) return 0;
+    uint64_t *k_tmp = malloc(n * sizeof(uint64_t));
+    uint32_t *i_tmp = malloc(n * sizeof(uint32_t));
+    if (!k_tmp || !i_tmp) {
+        free(k_tmp);
+        free(i_tmp);
+        return -1;
+    }
+
+    int nhilos = 1;
+    if (n >= UMBRAL_PARALELO) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        nhilos = (cpus < 1) ? 1 : (cpus > MAX_HILOS ? MAX_HILOS : (int)cpus);
+    }
+    TrozoRadix trozos[MAX_HILOS];
+
+    // bits que cambian entre claves: las pasadas sobre digitos constantes no hacen falta
+    uint64_t distintos = 0;
+    for (size_t i = 1; i < n; i++) distintos |= claves[i] ^ claves[0];
+
+    uint64_t *k_in = claves, *k_out = k_tmp;
+    uint32_t *i_in = idx, *i_out = i_tmp;
+    for (int shift = 0; shift < 64; shift += RADIX_BITS) {
+        if (((distintos >> shift) & (RADIX_CUBETAS - 1)) == 0) continue;
+        for (int h = 0; h < nhilos; h++) {
+            trozos[h].k_in = k_in;
+            trozos[h].i_in = i_in;
+            trozos[h].k_out = k_out;
+            trozos[h].i_out = i_out;
+            trozos[h].ini = n * h / nhilos;
+            trozos[h].fin = n * (h + 1) / nhilos;
+            trozos[h].shift = shift;
+        }
+        en_paralelo(contar_trozo, trozos, nhilos);
+
+        // posicion de inicio de cada (cubeta, hilo): cubetas en orden y dentro de ellas hilos en orden
+        size_t pos = 0;
+        for (int b = 0; b < RADIX_CUBETAS; b++) {
+            for (int h = 0; h < nhilos; h++) {
+                size_t c = trozos[h].hist[b];
+                trozos[h].hist[b] = pos;
+                pos += c;
+            }
+        }
+        en_paralelo(dispersar_trozo, trozos, nhilos);
+
+        uint64_t *kt = k_in; k_in = k_out; k_out = kt;
+        uint32_t *it = i_in; i_in = i_out; i_out = it;
+    }
+
+    if (k_in != claves) {
+        memcpy(claves, k_in, n * sizeof(uint64_t));
+        memcpy(idx, i_in, n * sizeof(uint32_t));
+    }
+    free(k_tmp);
+    free(i_tmp);
+    return 0;
+}
+
+// Los grupos que empatan en los 8 bytes del nivel actual se vuelven a ordenar con los
+// 8 bytes siguientes del nombre (radix por tramos); los grupos chicos van por insercion.
+static int refinar_nombres(const TablaMft *t, uint32_t *vista, uint64_t *k, size_t n, size_t nivel, int desc) {
+    size_t salto = 8 * (nivel + 1);
+    for (size_t i = 0; i < n;) {
+        size_t j = i + 1;
+        while (j < n && k[j] == k[i]) j++;
+        size_t m = j - i;
+        // si el ultimo byte de la clave es 0 el nombre ya termino: el grupo es igual
+        uint64_t clave = desc ? ~k[i] : k[i];
+        if (m > 1 && (clave & 0xFF) != 0) {
+            if (m <= 16) {
+                // insercion: estable y sin llamadas extra para grupos de pocos nombres
+                for (size_t x = i + 1; x < j; x++) {
+                    uint32_t r = vista[x];
+                    const char *nom = tabla_nombre(t, r) + salto;
+                    size_t y = x;
+                    while (y > i) {
+                        int cmp = strcasecmp(tabla_nombre(t, vista[y - 1]) + salto, nom);
+                        if (desc ? cmp >= 0 : cmp <= 0) break;
+                        vista[y] = vista[y - 1];
+                        y--;
+                    }
+                    vista[y] = r;
+                }
+            } else {
+                for (size_t x = i; x < j; x++) {
+                    uint64_t v = clave_nombre(tabla_nombre(t, vista[x]) + salto);
+                    k[x] = desc ? ~v : v;
+                }
+                if (radix_ordenar(k + i, vista + i, m) != 0 ||
+                    refinar_nombres(t, vista + i, k + i, m, nivel + 1, desc) != 0) return -1;
+            }
+        }
+        i = j;
+    }
+    return 0;
+}
+
+// Orden alfabetico de los nombres de tipo, para que ordenar por tipo sea legible
+static void rango_tipos(uint8_t *rango) {
+    int orden[MAX_TIPOS], total = tipos_total();
+    for (int i = 0; i < total; i++) orden[i] = i;
+    for (int i = 1; i < total; i++) {
+        for (int j = i; j > 0 && strcasecmp(nombre_tipo(orden[j - 1]), nombre_tipo(orden[j])) > 0; j--) {
+            int x = orden[j]; orden[j] = orden[j - 1]; orden[j - 1] = x;
+        }
+    }
+    for (int i = 0; i < total; i++) rango[orden[i]] = (uint8_t)i;
+}
+
+int ordenar_vista(const TablaMft *t, uint32_t *vista, size_t n, const ClaveOrden *claves, int nclaves) {
+    uint64_t *k = malloc((n ? n : 1) * sizeof(uint64_t));
+    if (!k) return -1;
+    uint8_t rango[MAX_TIPOS];
+    rango_tipos(rango);
+
+    // LSD: como el radix es estable, ordenar de la ultima clave a la primera da el orden multiple
+    for (int c = nclaves - 1; c >= 0; c--) {
+        for (size_t i = 0; i < n; i++) {
+            uint32_t r = vista[i];
+            uint64_t v;
+            switch (claves[c].campo) {
+                case CAMPO_NOMBRE:     v = t->clave_nom[r]; break;
+                case CAMPO_TAMANO:     v = t->tamano[r]; break;
+                case CAMPO_CREADO:     v = t->creado[r]; break;
+                case CAMPO_MODIFICADO: v = t->modificado[r]; break;
+                case CAMPO_TIPO:       v = rango[t->tipo[r] < tipos_total() ? t->tipo[r] : 0]; break;
+                default:               v = t->registro[r]; break;
+            }
+            k[i] = claves[c].descendente ? ~v : v;
+        }
+        if (radix_ordenar(k, vista, n) != 0 ||
+            (claves[c].campo == CAMPO_NOMBRE && refinar_nombres(t, vista, k, n, 0, claves[c].descendente) != 0)) {
+            free(k);
+            return -1;
+        }
+    }
+    free(k);
+    return 0;
+}
+
+size_t filtrar_tabla(const TablaMft *t, const FiltroMft *f, uint32_t *vista) {
+    size_t m = 0;
+    for (size_t i = 0; i < t->n; i++) {
+        if (f->tipos && !(f->tipos & (1ULL << t->tipo[i]))) continue;
+        if (t->tamano[i] < f->tam_min) continue;
+        if (f->tam_max && t->tamano[i] > f->tam_max) continue;
+        if ((t->atributos[i] & f->attr_si) != f->attr_si) continue;
+        if (t->atributos[i] & f->attr_no) continue;
+        if ((t->marcas[i] & f->marcas) != f->marcas) continue;
+        if (t->marcas[i] & f->marcas_no) continue;
+        vista[m++] = (uint32_t)i;
+    }
+    return m;
+}
+
+static const char letras_campo[] = "rntcmy"; // mismo orden que CampoOrden
+
+int parsear_orden(const char *s, ClaveOrden *claves) {
+    int n = 0;
+    for (; *s; s++) {
+        if (*s == ' ' || *s == ',') continue;
+        const char *p = strchr(letras_campo, tolower((unsigned char)*s));
+        if (!p || n == MAX_CLAVES_ORDEN) return -1;
+        claves[n].campo = (CampoOrden)(p - letras_campo);
+        claves[n].descendente = isupper((unsigned char)*s) != 0;
+        n++;
+    }
+    return n;
+}
+
+void describir_orden(const ClaveOrden *claves, int nclaves, char *out, size_t outsz) {
+    static const char *nombres[] = { "registro", "nombre", "tamano", "creado", "modificado", "tipo" };
+    size_t used = 0;
+    out[0] = '\0';
+    for (int i = 0; i < nclaves && used < outsz; i++) {
+        used += snprintf(out + used, outsz - used, "%s%s%s", i ? "," : "",
+                         nombres[claves[i].campo], claves[i].descendente ? "(desc)" : "");
+    }
+}
+
+int parsear_tamano(const char *s, const char **fin, uint64_t *out) {
+    char *e;
+    unsigned long long v = strtoull(s, &e, 10);
+    if (e == s) return -1;
+    switch (toupper((unsigned char)*e)) {
+        case 'K': v <<= 10; e++; break;
+        case 'M': v <<= 20; e++; break;
+        case 'G': v <<= 30; e++; break;
+    }
+    *out = v;
+    *fin = e;
+    return 0;
+}
+
+// Letras de atributo: R=solo lectura H=oculto S=sistema A=archive C=comprimido E=cifrado
+static uint32_t bit_atributo(char c) {
+    switch (toupper((unsigned char)c)) {
+        case 'R': return 0x01;
+        case 'H': return 0x02;
+        case 'S': return 0x04;
+        case 'A': return 0x20;
+        case 'C': return 0x800;
+        case 'E': return 0x4000;
+    }
+    return 0;
+}
+
+int parsear_filtro(const char *s, FiltroMft *f) {
+    memset(f, 0, sizeof(*f));
+    char copia[256];
+    strncpy(copia, s, sizeof(copia) - 1);
+    copia[sizeof(copia) - 1] = '\0';
+
+    for (char *tok = strtok(copia, " "); tok; tok = strtok(NULL, " ")) {
+        if (strncasecmp(tok, "tipo=", 5) == 0) {
+            // cada nombre acepta prefijos: "imagen" incluye JPEG y PNG
+            char *guarda;
+            for (char *nom = strtok_r(tok + 5, ",", &guarda); nom; nom = strtok_r(NULL, ",", &guarda)) {
+                uint64_t antes = f->tipos;
+                for (int ti = 0; ti < tipos_total(); ti++) {
+                    if (strncasecmp(nombre_tipo(ti), nom, strlen(nom)) == 0) f->tipos |= 1ULL << ti;
+                }
+                if (f->tipos == antes) return -1;
+            }
+        } else if (strcasecmp(tok, "discordantes") == 0) {
+            f->marcas |= MARCA_DISCORDANTE;
+        } else if (strcasecmp(tok, "borrados") == 0) {
+            f->marcas |= MARCA_BORRADO;
+        } else if (strcasecmp(tok, "vivos") == 0) {
+            f->marcas_no |= MARCA_BORRADO;
+        } else if (strcasecmp(tok, "flujos") == 0) {
+            f->marcas |= MARCA_FLUJOS;
+        } else if (strncasecmp(tok, "tam=", 4) == 0) {
+            // "min-max", "min-" o "-max"
+            const char *p = tok + 4;
+            if (*p != '-' && parsear_tamano(p, &p, &f->tam_min) != 0) return -1;
+            if (*p == '-') {
+                p++;
+                if (*p && parsear_tamano(p, &p, &f->tam_max) != 0) return -1;
+            }
+            if (*p) return -1;
+        } else if (strncasecmp(tok, "attr=", 5) == 0) {
+            int quitar = 0;
+            for (const char *p = tok + 5; *p; p++) {
+                if (*p == '+') quitar = 0;
+                else if (*p == '-') quitar = 1;
+                else {
+                    uint32_t bit = bit_atributo(*p);
+                    if (!bit) return -1;
+                    if (quitar) f->attr_no |= bit;
+                    else f->attr_si |= bit;
+                }
+            }
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,68 @@
+#ifndef ORDENMFT_H
+#define ORDENMFT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "tablaMft.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    CAMPO_REGISTRO,
+    CAMPO_NOMBRE,
+    CAMPO_TAMANO,
+    CAMPO_CREADO,
+    CAMPO_MODIFICADO,
+    CAMPO_TIPO
+} CampoOrden;
+
+typedef struct {
+    CampoOrden campo;
+    int descendente;
+} ClaveOrden;
+
+#define MAX_CLAVES_ORDEN 4
+
+// Filtro de la lista; los campos en 0 no filtran
+typedef struct {
+    uint64_t tipos;     // mascara de bits (1 << TipoArchivo) permitidos
+    uint64_t tam_min;
+    uint64_t tam_max;
+    uint32_t attr_si;   // atributos FAT que deben estar
+    uint32_t attr_no;   // atributos FAT que no deben estar
+    uint8_t marcas;     // MARCA_* que deben estar
+    uint8_t marcas_no;  // MARCA_* que no deben estar
+} FiltroMft;
+
+// Llena 'vista' con los indices de las filas que pasan el filtro y devuelve cuantas son
+size_t filtrar_tabla(const TablaMft *t, const FiltroMft *f, uint32_t *vista);
+
+// Ordena la vista por varias claves (la primera es la principal). Cada clave se
+// convierte en un entero de 64 bits y se ordena con radix sort estable.
+// Devuelve 0 o -1 si falta memoria.
+int ordenar_vista(const TablaMft *t, uint32_t *vista, size_t n, const ClaveOrden *claves, int nclaves);
+
+// Radix sort LSD estable de pares (clave, indice); usa varios hilos si n es grande
+int radix_ordenar(uint64_t *claves, uint32_t *idx, size_t n);
+
+// "Tn" -> tamano descendente y luego nombre ascendente (mayuscula = descendente).
+// Letras: r=registro n=nombre t=tamano c=creado m=modificado y=tipo. Devuelve nclaves o -1.
+int parsear_orden(const char *s, ClaveOrden *claves);
+
+// "tipo=pdf,imagen tam=1K-20M attr=+H-S discordantes borrados flujos" (o vivos). Devuelve 0 o -1 si no se entiende.
+int parsear_filtro(const char *s, FiltroMft *f);
+
+// "20M" -> 20971520 (sufijos K, M, G); *fin queda despues del numero. Devuelve 0 o -1.
+int parsear_tamano(const char *s, const char **fin, uint64_t *out);
+
+// Textos cortos para la cabecera de la lista
+void describir_orden(const ClaveOrden *claves, int nclaves, char *out, size_t outsz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
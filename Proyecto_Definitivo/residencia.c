@@ -0,0 +1,100 @@
+#include "residencia.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define BLOQUE_PAGINAS (1u << 16) // mincore de a 256 MB con paginas de 4 KB
+
+int medir_residencia(const unsigned char *map, uint64_t map_size, const RangoImagen *rangos, int n,
+                     char *barra, int ancho, Residencia *r) {
+    uint64_t pag = (uint64_t)sysconf(_SC_PAGESIZE);
+    memset(r, 0, sizeof(*r));
+    // primero el total de paginas, para repartirlas entre las celdas
+    uint64_t total = 0;
+    for (int i = 0; i < n; i++) {
+        if (rangos[i].off >= map_size || rangos[i].largo == 0) continue;
+        uint64_t fin = rangos[i].off + rangos[i].largo < map_size ? rangos[i].off + rangos[i].largo : map_size;
+        total += (fin + pag - 1) / pag - rangos[i].off / pag;
+    }
+    unsigned char *vec = malloc(BLOQUE_PAGINAS);
+    uint64_t *celda_total = NULL, *celda_cache = NULL;
+    if (barra && ancho > 0) {
+        celda_total = calloc((size_t)ancho, sizeof(uint64_t));
+        celda_cache = calloc((size_t)ancho, sizeof(uint64_t));
+    }
+    if (!vec || (barra && ancho > 0 && (!celda_total || !celda_cache))) {
+        free(vec);
+        free(celda_total);
+        free(celda_cache);
+        return -2;
+    }
+
+    int res = 0;
+    uint64_t g = 0; // pagina dentro de todos los rangos concatenados
+    for (int i = 0; i < n && res == 0; i++) {
+        if (rangos[i].off >= map_size || rangos[i].largo == 0) continue;
+        uint64_t fin = rangos[i].off + rangos[i].largo < map_size ? rangos[i].off + rangos[i].largo : map_size;
+        uint64_t p = rangos[i].off / pag, p_fin = (fin + pag - 1) / pag;
+        while (p < p_fin) {
+            uint64_t k = p_fin - p < BLOQUE_PAGINAS ? p_fin - p : BLOQUE_PAGINAS;
+            // el mapa viene de mmap: esta alineado a pagina
+            if (mincore((void *)(map + p * pag), (size_t)(k * pag), vec) != 0) {
+                res = -1;
+                break;
+            }
+            for (uint64_t j = 0; j < k; j++, g++) {
+                int esta = vec[j] & 1;
+                r->en_cache += (uint64_t)esta;
+                if (celda_total) {
+                    size_t c = (size_t)(g * (uint64_t)ancho / total);
+                    celda_total[c]++;
+                    celda_cache[c] += (uint64_t)esta;
+                }
+            }
+            p += k;
+        }
+    }
+    r->paginas = g;
+
+    if (barra && ancho > 0) {
+        char anterior = ' ';
+        for (int c = 0; c < ancho; c++) {
+            // con menos paginas que celdas algunas quedan vacias: repiten la de la izquierda
+            if (celda_total[c] == 0) barra[c] = anterior;
+            else if (celda_cache[c] == celda_total[c]) barra[c] = '#';
+            else if (2 * celda_cache[c] > celda_total[c]) barra[c] = '+';
+            else if (celda_cache[c]) barra[c] = '.';
+            else barra[c] = ' ';
+            anterior = barra[c];
+        }
+    }
+    free(vec);
+    free(celda_total);
+    free(celda_cache);
+    return res;
+}
+
+RangoImagen *rangos_mft(const VolumenNtfs *v, int *n) {
+    RangoImagen *rangos = malloc((v->mft_n ? (size_t)v->mft_n : 1) * sizeof(RangoImagen));
+    if (!rangos) return NULL;
+    *n = 0;
+    for (int i = 0; i < v->mft_n; i++) {
+        if (v->mft_ext[i].lcn < 0) continue;
+        rangos[*n].off = (uint64_t)v->base + (uint64_t)v->mft_ext[i].lcn * v->tam_cluster;
+        rangos[*n].largo = v->mft_ext[i].len * v->tam_cluster;
+        (*n)++;
+    }
+    return rangos;
+}
+
+double frio_mft(const VolumenNtfs *v) {
+    int n;
+    RangoImagen *rangos = rangos_mft(v, &n);
+    if (!rangos) return -1;
+    Residencia r;
+    int res = medir_residencia(v->map, (uint64_t)v->map_size, rangos, n, NULL, 0, &r);
+    free(rangos);
+    if (res != 0 || r.paginas == 0) return -1;
+    return 100.0 * (double)(r.paginas - r.en_cache) / (double)r.paginas;
+}
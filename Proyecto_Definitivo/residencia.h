@@ -0,0 +1,39 @@
+#ifndef RESIDENCIA_H
+#define RESIDENCIA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "ntfsVolumen.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bytes de la imagen, relativos al principio del mapa
+typedef struct {
+    uint64_t off, largo;
+} RangoImagen;
+
+typedef struct {
+    uint64_t paginas, en_cache;
+} Residencia;
+
+// Cuantas paginas de los rangos estan en la cache de paginas del sistema, segun mincore() sobre el
+// mapa de la imagen (lo que se pase del mapa no cuenta). Si barra no es NULL resume ademas los
+// rangos, uno detras de otro, en 'ancho' celdas: '#' todo en cache, '+' mas de la mitad, '.' algo,
+// ' ' nada (sin terminar en '\0'). Devuelve 0, -1 si mincore falla o -2 si falta memoria.
+int medir_residencia(const unsigned char *map, uint64_t map_size, const RangoImagen *rangos, int n,
+                     char *barra, int ancho, Residencia *r);
+
+// Tramos no dispersos del $MFT como rangos de la imagen, en orden de VCN; NULL si falta memoria
+RangoImagen *rangos_mft(const VolumenNtfs *v, int *n);
+
+// Porcentaje del $MFT que no esta en cache (lo que costaria leer del disco); -1 si no se pudo medir
+double frio_mft(const VolumenNtfs *v);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
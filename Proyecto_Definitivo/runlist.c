@@ -0,0 +1,66 @@
+// runlist.c
+#include "runlist.h"
+
+#include <stdlib.h>
+
+int decodificar_runlist(const unsigned char *run, const unsigned char *fin, uint64_t vcn_inicial,
+                        Extent **ext, int *n, int *cap) {
+    int agregados = 0;
+    uint64_t vcn = vcn_inicial;
+    long long prev_lcn = 0;
+
+    while (run < fin && *run != 0) {
+        unsigned char header = *run++;
+        int len_len = header & 0x0F;
+        int off_len = (header >> 4) & 0x0F;
+        if (len_len == 0 || len_len > 8 || off_len > 8 || run + len_len + off_len > fin) return -1;
+
+        // leer length (clusters)
+        uint64_t cluster_count = 0;
+        for (int k = 0; k < len_len; k++) {
+            cluster_count |= ((uint64_t)*run++) << (8 * k);
+        }
+
+        // leer offset (LCN) relativo al tramo anterior, con signo. off_len == 0 -> disperso
+        long long lcn = -1;
+        if (off_len > 0) {
+            uint64_t tmp = 0;
+            for (int k = 0; k < off_len; k++) {
+                tmp |= ((uint64_t)*run++) << (8 * k);
+            }
+            // sign extend
+            if (off_len < 8 && (tmp & (1ULL << (off_len * 8 - 1)))) {
+                tmp |= (~0ULL) << (off_len * 8);
+            }
+            prev_lcn += (long long)tmp;
+            if (prev_lcn < 0) return -1;
+            lcn = prev_lcn;
+        }
+
+        if (*n == *cap) {
+            int nuevo = *cap ? *cap * 2 : 8;
+            Extent *p = realloc(*ext, nuevo * sizeof(Extent));
+            if (!p) return -1;
+            *ext = p;
+            *cap = nuevo;
+        }
+        (*ext)[*n].vcn = vcn;
+        (*ext)[*n].lcn = lcn;
+        (*ext)[*n].len = cluster_count;
+        (*n)++;
+        agregados++;
+        vcn += cluster_count;
+    }
+    return agregados;
+}
+
+int buscar_tramo(const Extent *ext, int n, uint64_t vcn) {
+    int lo = 0, hi = n - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (vcn < ext[mid].vcn) hi = mid - 1;
+        else if (vcn >= ext[mid].vcn + ext[mid].len) lo = mid + 1;
+        else return mid;
+    }
+    return -1;
+}
@@ -0,0 +1,32 @@
+#ifndef RUNLIST_H
+#define RUNLIST_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Un tramo (extent) de un atributo no residente: VCN -> LCN
+typedef struct {
+    uint64_t vcn;   // primer cluster virtual del tramo
+    int64_t  lcn;   // primer cluster logico, -1 si el tramo es disperso (sparse)
+    uint64_t len;   // longitud en clusters
+} Extent;
+
+// Decodifica el runlist que empieza en 'run' (sin pasar de 'fin') y agrega los
+// tramos al arreglo dinamico *ext (n/cap se actualizan, se usa realloc).
+// Devuelve el numero de tramos agregados o -1 si el runlist esta corrupto.
+int decodificar_runlist(const unsigned char *run, const unsigned char *fin, uint64_t vcn_inicial,
+                        Extent **ext, int *n, int *cap);
+
+// Indice del tramo que contiene 'vcn' en un runlist ordenado por VCN (busqueda binaria),
+// o -1 si el VCN no esta cubierto
+int buscar_tramo(const Extent *ext, int n, uint64_t vcn);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1196 @@
+// tablaMft.c
+#define _GNU_SOURCE // qsort_r
+#include "tablaMft.h"
+#include "tiposArchivo.h"
+#include "utf16.h"
+#include "hashes.h"
+#include "contadores.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define REFERENCIA_REGISTRO(r) ((r) & 0xFFFFFFFFFFFFULL) // los 16 bits altos son la secuencia
+#define MAX_HILOS_SUMA 16
+
+static int crecer_columna(void **col, size_t elem, size_t cap) {
+    void *p = realloc(*col, elem * cap);
+    if (!p) return -1;
+    *col = p;
+    return 0;
+}
+
+static int tabla_reservar(TablaMft *t, size_t cap) {
+    if (crecer_columna((void **)&t->registro, sizeof(*t->registro), cap) ||
+        crecer_columna((void **)&t->nombre_off, sizeof(*t->nombre_off), cap) ||
+        crecer_columna((void **)&t->clave_nom, sizeof(*t->clave_nom), cap) ||
+        crecer_columna((void **)&t->tamano, sizeof(*t->tamano), cap) ||
+        crecer_columna((void **)&t->atributos, sizeof(*t->atributos), cap) ||
+        crecer_columna((void **)&t->creado, sizeof(*t->creado), cap) ||
+        crecer_columna((void **)&t->modificado, sizeof(*t->modificado), cap) ||
+        crecer_columna((void **)&t->cambiado, sizeof(*t->cambiado), cap) ||
+        crecer_columna((void **)&t->accedido, sizeof(*t->accedido), cap) ||
+        crecer_columna((void **)&t->fn_fechas, sizeof(*t->fn_fechas), cap) ||
+        crecer_columna((void **)&t->padre, sizeof(*t->padre), cap) ||
+        crecer_columna((void **)&t->padre_sec, sizeof(*t->padre_sec), cap) ||
+        crecer_columna((void **)&t->secuencia, sizeof(*t->secuencia), cap) ||
+        crecer_columna((void **)&t->es_dir, sizeof(*t->es_dir), cap) ||
+        crecer_columna((void **)&t->tipo, sizeof(*t->tipo), cap) ||
+        crecer_columna((void **)&t->contenido, sizeof(*t->contenido), cap) ||
+        crecer_columna((void **)&t->marcas, sizeof(*t->marcas), cap) ||
+        crecer_columna((void **)&t->recuperable, sizeof(*t->recuperable), cap) ||
+        crecer_columna((void **)&t->data_off, sizeof(*t->data_off), cap) ||
+        crecer_columna((void **)&t->data_len, sizeof(*t->data_len), cap) ||
+        crecer_columna((void **)&t->data_res, sizeof(*t->data_res), cap) ||
+        crecer_columna((void **)&t->tramo_ini, sizeof(*t->tramo_ini), cap) ||
+        crecer_columna((void **)&t->tramo_n, sizeof(*t->tramo_n), cap) ||
+        crecer_columna((void **)&t->compresion, sizeof(*t->compresion), cap) ||
+        crecer_columna((void **)&t->flujo_ini, sizeof(*t->flujo_ini), cap) ||
+        crecer_columna((void **)&t->flujo_cnt, sizeof(*t->flujo_cnt), cap)) return -1;
+    t->cap = cap;
+    return 0;
+}
+
+static int flujos_reservar(TablaMft *t, size_t cap) {
+    if (crecer_columna((void **)&t->flujo_fila, sizeof(*t->flujo_fila), cap) ||
+        crecer_columna((void **)&t->flujo_nombre_off, sizeof(*t->flujo_nombre_off), cap) ||
+        crecer_columna((void **)&t->flujo_tamano, sizeof(*t->flujo_tamano), cap) ||
+        crecer_columna((void **)&t->flujo_off, sizeof(*t->flujo_off), cap) ||
+        crecer_columna((void **)&t->flujo_len, sizeof(*t->flujo_len), cap) ||
+        crecer_columna((void **)&t->flujo_res, sizeof(*t->flujo_res), cap) ||
+        crecer_columna((void **)&t->flujo_tramo_ini, sizeof(*t->flujo_tramo_ini), cap) ||
+        crecer_columna((void **)&t->flujo_tramo_n, sizeof(*t->flujo_tramo_n), cap) ||
+        crecer_columna((void **)&t->flujo_compresion, sizeof(*t->flujo_compresion), cap)) return -1;
+    t->flujos_cap = cap;
+    return 0;
+}
+
+// Copia 'cnt' tramos al final de un arreglo dinamico de tramos
+static int agregar_tramos(Extent **ext, int *n, int *cap, const Extent *src, int cnt) {
+    if (cnt == 0) return 0;
+    if (*n + cnt > *cap) {
+        int nuevo = *cap ? *cap * 2 : 1024;
+        while (nuevo < *n + cnt) nuevo *= 2;
+        Extent *p = realloc(*ext, nuevo * sizeof(Extent));
+        if (!p) return -1;
+        *ext = p;
+        *cap = nuevo;
+    }
+    memcpy(*ext + *n, src, cnt * sizeof(Extent));
+    *n += cnt;
+    return 0;
+}
+
+// Reserva 'len' bytes en la arena de nombres y devuelve su offset
+static long arena_reservar(TablaMft *t, size_t len) {
+    if (t->nombres_len + len > t->nombres_cap) {
+        size_t nuevo = t->nombres_cap ? t->nombres_cap * 2 : 1 << 16;
+        while (nuevo < t->nombres_len + len) nuevo *= 2;
+        char *p = realloc(t->nombres, nuevo);
+        if (!p) return -1;
+        t->nombres = p;
+        t->nombres_cap = nuevo;
+    }
+    long off = (long)t->nombres_len;
+    t->nombres_len += len;
+    return off;
+}
+
+// Copia el valor de un atributo residente en la arena de residentes; devuelve su offset o
+// SIN_RESIDENTE si falta memoria o la arena ya no entra en 32 bits
+static uint32_t residente_guardar(TablaMft *t, const unsigned char *valor, size_t len) {
+    if (t->residentes_len + len > UINT32_MAX) return SIN_RESIDENTE;
+    if (t->residentes_len + len > t->residentes_cap) {
+        size_t nuevo = t->residentes_cap ? t->residentes_cap * 2 : 1 << 16;
+        while (nuevo < t->residentes_len + len) nuevo *= 2;
+        unsigned char *p = realloc(t->residentes, nuevo);
+        if (!p) return SIN_RESIDENTE;
+        t->residentes = p;
+        t->residentes_cap = nuevo;
+    }
+    uint32_t off = (uint32_t)t->residentes_len;
+    if (len) memcpy(t->residentes + off, valor, len);
+    t->residentes_len += len;
+    return off;
+}
+
+// Valor de un atributo residente y su largo recortado al atributo, NULL si no es residente
+static const unsigned char *valor_datos(const NTFS_ATTRIBUTE *attr, size_t *len) {
+    if (attr->uchNonResFlag != 0 || attr->Attr.Resident.wAttrOffset > attr->dwFullLength) return NULL;
+    size_t max = attr->dwFullLength - attr->Attr.Resident.wAttrOffset;
+    *len = attr->Attr.Resident.dwLength < max ? attr->Attr.Resident.dwLength : max;
+    return (const unsigned char *)attr + attr->Attr.Resident.wAttrOffset;
+}
+
+void tabla_liberar(TablaMft *t) {
+    free(t->registro);
+    free(t->nombre_off);
+    free(t->clave_nom);
+    free(t->tamano);
+    free(t->atributos);
+    free(t->creado);
+    free(t->modificado);
+    free(t->cambiado);
+    free(t->accedido);
+    free(t->fn_fechas);
+    free(t->padre);
+    free(t->padre_sec);
+    free(t->secuencia);
+    free(t->es_dir);
+    free(t->tipo);
+    free(t->contenido);
+    free(t->marcas);
+    free(t->recuperable);
+    free(t->data_off);
+    free(t->data_len);
+    free(t->data_res);
+    free(t->tramo_ini);
+    free(t->tramo_n);
+    free(t->compresion);
+    free(t->flujo_ini);
+    free(t->flujo_cnt);
+    free(t->tramos);
+    free(t->flujo_fila);
+    free(t->flujo_nombre_off);
+    free(t->flujo_tamano);
+    free(t->flujo_off);
+    free(t->flujo_len);
+    free(t->flujo_res);
+    free(t->flujo_tramo_ini);
+    free(t->flujo_tramo_n);
+    free(t->flujo_compresion);
+    free(t->flujo_tramos);
+    free(t->hashes);
+    free(t->nombres);
+    free(t->residentes);
+    free(t->suma_trozo);
+    free(t->ext_registro);
+    free(t->ext_base);
+    memset(t, 0, sizeof(*t));
+}
+
+// Un runlist de un registro borrado solo se cree si todos sus tramos caen dentro del volumen
+static int tramos_validos(const VolumenNtfs *v, const Extent *ext, int n) {
+    for (int e = 0; e < n; e++) {
+        if (ext[e].lcn < 0) continue;
+        if (ext[e].len == 0) return 0;
+        if (v->num_clusters && (uint64_t)ext[e].lcn + ext[e].len > v->num_clusters) return 0;
+    }
+    return 1;
+}
+
+// Lo que aportan los registros de extension (n64BaseMftRec != 0) a su registro base:
+// tramos de $DATA y, si estan ahi, el primer segmento de $DATA o el $FILE_NAME
+typedef struct {
+    Extent *ext;            // tramos de todos los registros de extension, en orden de escaneo
+    int n, cap;
+    uint64_t *base;         // registro base de cada tramo (paralelo a ext)
+    uint8_t *borrado;
+    size_t base_cap;
+} TramosPendientes;
+
+typedef struct {
+    uint64_t base;
+    uint8_t borrado;
+    uint8_t tiene_tam, tiene_nombre, es_dir;
+    uint8_t compresion;
+    uint64_t tamano;        // de $DATA con VCN inicial 0
+    uint32_t nombre_off;    // ya convertido en la arena
+    FechasNtfs fn_fechas;   // con el nombre: fechas y padre de ese $FILE_NAME
+    uint64_t padre;
+} InfoPendiente;
+
+typedef struct {
+    InfoPendiente *v;
+    size_t n, cap;
+} InfosPendientes;
+
+// Durante el escaneo cada segmento de un flujo con nombre es una entrada de las columnas
+// flujo_*; estos datos (paralelos a ellas) sirven para agruparlos al final por archivo
+typedef struct {
+    uint64_t *dueno;        // registro base del archivo
+    uint64_t *vcn;          // primer VCN del segmento
+    uint8_t *borrado;
+    size_t cap;
+} FlujosPendientes;
+
+static int pendientes_marcar(TramosPendientes *p, int desde, uint64_t base, uint8_t borrado) {
+    if ((size_t)p->cap > p->base_cap) {
+        uint64_t *b = realloc(p->base, p->cap * sizeof(uint64_t));
+        if (!b) return -1;
+        p->base = b;
+        uint8_t *x = realloc(p->borrado, p->cap);
+        if (!x) return -1;
+        p->borrado = x;
+        p->base_cap = p->cap;
+    }
+    for (int e = desde; e < p->n; e++) {
+        p->base[e] = base;
+        p->borrado[e] = borrado;
+    }
+    return 0;
+}
+
+static InfoPendiente *info_agregar(InfosPendientes *p, uint64_t base, uint8_t borrado) {
+    if (p->n == p->cap) {
+        size_t nuevo = p->cap ? p->cap * 2 : 64;
+        InfoPendiente *x = realloc(p->v, nuevo * sizeof(InfoPendiente));
+        if (!x) return NULL;
+        p->v = x;
+        p->cap = nuevo;
+    }
+    InfoPendiente *i = &p->v[p->n++];
+    memset(i, 0, sizeof(*i));
+    i->base = base;
+    i->borrado = borrado;
+    return i;
+}
+
+// Convierte un nombre UTF-16LE en la arena y devuelve el offset, o -1 si falta memoria
+static long guardar_nombre(TablaMft *t, const uint16_t *nombre16, int len) {
+    // se reserva el peor caso y se convierte directo en la arena; lo que sobra se devuelve
+    long off = arena_reservar(t, UTF8_MAX_BYTES(len) + 1);
+    if (off < 0) return -1;
+    char *nombre = t->nombres + off;
+    size_t bytes = utf16le_a_utf8(nombre16, len, nombre);
+    nombre[bytes] = '\0';
+    t->nombres_len = off + bytes + 1;
+    return off;
+}
+
+static void poner_nombre(TablaMft *t, size_t k, uint32_t off) {
+    t->nombre_off[k] = off;
+    t->clave_nom[k] = clave_nombre(t->nombres + off);
+    t->tipo[k] = t->es_dir[k] ? TIPO_DIRECTORIO : determinar_tipo_archivo(t->nombres + off);
+}
+
+// Offset en el mapa del primer tramo (VCN 0) de un runlist, -1 si no esta en el mapa
+static long offset_primer_tramo(const VolumenNtfs *v, const Extent *e, int n, size_t *len) {
+    if (n == 0 || e->vcn != 0 || e->lcn < 0) return -1;
+    long long off = v->base + e->lcn * (long long)v->tam_cluster;
+    if (off < 0 || off >= v->map_size) return -1;
+    *len = (size_t)e->len * v->tam_cluster;
+    return (long)off;
+}
+
+static void poner_datos_desde_tramos(const VolumenNtfs *v, TablaMft *t, size_t k) {
+    // sin $DATA residente ni primer tramo en el registro base: el primer tramo de la lista completa
+    if (t->data_off[k] >= 0 || t->data_res[k] != SIN_RESIDENTE) return;
+    size_t len;
+    long off = offset_primer_tramo(v, &t->tramos[t->tramo_ini[k]], (int)t->tramo_n[k], &len);
+    if (off < 0) return;
+    t->data_off[k] = off;
+    t->data_len[k] = len;
+}
+
+static int comparar_pendientes(const void *a, const void *b, void *ctx) {
+    const TramosPendientes *p = ctx;
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    if (p->base[x] != p->base[y]) return p->base[x] < p->base[y] ? -1 : 1;
+    if (p->ext[x].vcn != p->ext[y].vcn) return p->ext[x].vcn < p->ext[y].vcn ? -1 : 1;
+    return 0;
+}
+
+// Padre y fechas de $FILE_NAME de la fila k
+static void poner_padre(TablaMft *t, size_t k, uint64_t padre, const FechasNtfs *f) {
+    uint64_t reg = REFERENCIA_REGISTRO(padre);
+    t->padre[k] = reg < SIN_PADRE ? (uint32_t)reg : SIN_PADRE;
+    t->padre_sec[k] = (uint16_t)(padre >> 48);
+    t->fn_fechas[k] = *f;
+}
+
+static FechasNtfs fechas_nombre(const ATTR_FILENAME *fn) {
+    return (FechasNtfs){ fn->n64Create, fn->n64Modify, fn->n64Modfil, fn->n64Access };
+}
+
+static int comparar_infos(const void *a, const void *b) {
+    const InfoPendiente *x = a, *y = b;
+    return (x->base > y->base) - (x->base < y->base);
+}
+
+// Junta lo que dejaron los registros de extension con su registro base. Las filas estan en
+// orden de registro, asi que basta ordenar lo pendiente por (base, VCN) y recorrer ambas listas
+// una vez, mezclando los tramos de cada fila por VCN en una arena nueva.
+static int fusionar_extensiones(const VolumenNtfs *v, TablaMft *t, TramosPendientes *p, InfosPendientes *inf) {
+    if (p->n == 0 && inf->n == 0) return 0;
+
+    uint32_t *orden = malloc((p->n ? p->n : 1) * sizeof(uint32_t));
+    Extent *nuevos = malloc(((size_t)t->tramos_n + p->n + 1) * sizeof(Extent));
+    if (!orden || !nuevos) {
+        free(orden);
+        free(nuevos);
+        return -1;
+    }
+    for (int e = 0; e < p->n; e++) orden[e] = (uint32_t)e;
+    qsort_r(orden, p->n, sizeof(uint32_t), comparar_pendientes, p);
+    qsort(inf->v, inf->n, sizeof(InfoPendiente), comparar_infos);
+
+    size_t j = 0, ii = 0;
+    int m = 0;
+    for (size_t k = 0; k < t->n; k++) {
+        uint64_t reg = t->registro[k];
+        uint8_t borrado = (t->marcas[k] & MARCA_BORRADO) != 0;
+        // un registro de extension borrado solo cuenta para un base borrado (y al reves)
+        const Extent *propios = t->tramos + t->tramo_ini[k];
+        uint32_t a = 0, na = t->tramo_n[k];
+        t->tramo_ini[k] = (uint32_t)m;
+        while (j < (size_t)p->n && p->base[orden[j]] < reg) j++;
+        for (;;) {
+            while (j < (size_t)p->n && p->base[orden[j]] == reg && p->borrado[orden[j]] != borrado) j++;
+            int hay_pend = j < (size_t)p->n && p->base[orden[j]] == reg;
+            if (a < na && (!hay_pend || propios[a].vcn <= p->ext[orden[j]].vcn)) nuevos[m++] = propios[a++];
+            else if (hay_pend) nuevos[m++] = p->ext[orden[j++]];
+            else break;
+        }
+        t->tramo_n[k] = (uint32_t)m - t->tramo_ini[k];
+
+        while (ii < inf->n && inf->v[ii].base < reg) ii++;
+        for (; ii < inf->n && inf->v[ii].base == reg; ii++) {
+            const InfoPendiente *x = &inf->v[ii];
+            if (x->borrado != borrado) continue;
+            if (x->tiene_tam) t->tamano[k] = x->tamano;
+            if (x->compresion) t->compresion[k] = x->compresion;
+            if (x->tiene_nombre && t->nombres[t->nombre_off[k]] == '\0') {
+                t->es_dir[k] = x->es_dir;
+                poner_nombre(t, k, x->nombre_off);
+                poner_padre(t, k, x->padre, &x->fn_fechas);
+            }
+        }
+        poner_datos_desde_tramos(v, t, k);
+    }
+
+    free(orden);
+    free(t->tramos);
+    t->tramos = nuevos;
+    t->tramos_n = t->tramos_cap = m;
+    return 0;
+}
+
+static int comparar_flujos(const void *a, const void *b, void *ctx) {
+    const TablaMft *t = ((const void **)ctx)[0];
+    const FlujosPendientes *fp = ((const void **)ctx)[1];
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    if (fp->dueno[x] != fp->dueno[y]) return fp->dueno[x] < fp->dueno[y] ? -1 : 1;
+    int c = strcmp(t->nombres + t->flujo_nombre_off[x], t->nombres + t->flujo_nombre_off[y]);
+    if (c) return c;
+    if (fp->vcn[x] != fp->vcn[y]) return fp->vcn[x] < fp->vcn[y] ? -1 : 1;
+    return 0;
+}
+
+// Las columnas flujo_* de 'g' (con 'm' flujos) reemplazan a las de 't'
+static void reemplazar_flujos(TablaMft *t, TablaMft *g, size_t m) {
+    TablaMft viejo = { 0 };
+    viejo.flujo_fila = t->flujo_fila;
+    viejo.flujo_nombre_off = t->flujo_nombre_off;
+    viejo.flujo_tamano = t->flujo_tamano;
+    viejo.flujo_off = t->flujo_off;
+    viejo.flujo_len = t->flujo_len;
+    viejo.flujo_res = t->flujo_res;
+    viejo.flujo_tramo_ini = t->flujo_tramo_ini;
+    viejo.flujo_tramo_n = t->flujo_tramo_n;
+    viejo.flujo_compresion = t->flujo_compresion;
+    viejo.flujo_tramos = t->flujo_tramos;
+    t->flujo_fila = g->flujo_fila;
+    t->flujo_nombre_off = g->flujo_nombre_off;
+    t->flujo_tamano = g->flujo_tamano;
+    t->flujo_off = g->flujo_off;
+    t->flujo_len = g->flujo_len;
+    t->flujo_res = g->flujo_res;
+    t->flujo_tramo_ini = g->flujo_tramo_ini;
+    t->flujo_tramo_n = g->flujo_tramo_n;
+    t->flujo_compresion = g->flujo_compresion;
+    t->flujo_tramos = g->flujo_tramos;
+    t->flujo_tramos_n = g->flujo_tramos_n;
+    t->flujo_tramos_cap = g->flujo_tramos_cap;
+    t->flujos_n = m;
+    t->flujos_cap = g->flujos_cap;
+    tabla_liberar(&viejo);
+}
+
+// Deja los flujos agrupados por fila (en el orden de las filas y por nombre) y une los
+// segmentos de un mismo flujo repartido entre el registro base y sus extensiones
+static int agrupar_flujos(const VolumenNtfs *v, TablaMft *t, FlujosPendientes *fp) {
+    size_t n = t->flujos_n;
+    for (size_t k = 0; k < t->n; k++) t->flujo_ini[k] = t->flujo_cnt[k] = 0;
+    if (n == 0) return 0;
+
+    TablaMft g = { 0 }; // solo se usan las columnas flujo_*
+    uint32_t *orden = malloc(n * sizeof(uint32_t));
+    if (!orden || flujos_reservar(&g, n) != 0) {
+        free(orden);
+        tabla_liberar(&g);
+        return -1;
+    }
+    for (size_t f = 0; f < n; f++) orden[f] = (uint32_t)f;
+    const void *ctx[2] = { t, fp };
+    qsort_r(orden, n, sizeof(uint32_t), comparar_flujos, ctx);
+
+    size_t j = 0, m = 0;
+    int error = 0;
+    for (size_t k = 0; k < t->n && !error; k++) {
+        uint64_t reg = t->registro[k];
+        uint8_t borrado = (t->marcas[k] & MARCA_BORRADO) != 0;
+        t->flujo_ini[k] = (uint32_t)m;
+        while (j < n && fp->dueno[orden[j]] < reg) j++;
+        for (; j < n && fp->dueno[orden[j]] == reg; j++) {
+            uint32_t f = orden[j];
+            if (fp->borrado[f] != borrado) continue;
+            const Extent *ext = t->flujo_tramos + t->flujo_tramo_ini[f];
+            int cnt = (int)t->flujo_tramo_n[f];
+            // continuacion (VCN > 0) del flujo anterior con el mismo nombre
+            if (fp->vcn[f] > 0 && m > t->flujo_ini[k] &&
+                strcmp(t->nombres + g.flujo_nombre_off[m - 1], t->nombres + t->flujo_nombre_off[f]) == 0) {
+                if (agregar_tramos(&g.flujo_tramos, &g.flujo_tramos_n, &g.flujo_tramos_cap, ext, cnt) != 0) error = 1;
+                g.flujo_tramo_n[m - 1] += (uint32_t)cnt;
+                continue;
+            }
+            g.flujo_fila[m] = (uint32_t)k;
+            g.flujo_nombre_off[m] = t->flujo_nombre_off[f];
+            g.flujo_tamano[m] = t->flujo_tamano[f];
+            g.flujo_off[m] = t->flujo_off[f];
+            g.flujo_len[m] = t->flujo_len[f];
+            g.flujo_res[m] = t->flujo_res[f];
+            g.flujo_compresion[m] = t->flujo_compresion[f];
+            g.flujo_tramo_ini[m] = (uint32_t)g.flujo_tramos_n;
+            g.flujo_tramo_n[m] = (uint32_t)cnt;
+            if (agregar_tramos(&g.flujo_tramos, &g.flujo_tramos_n, &g.flujo_tramos_cap, ext, cnt) != 0) error = 1;
+            m++;
+        }
+        t->flujo_cnt[k] = (uint16_t)(m - t->flujo_ini[k]);
+        if (t->flujo_cnt[k]) t->marcas[k] |= MARCA_FLUJOS;
+    }
+    free(orden);
+
+    // el offset de un flujo que solo tenia el primer tramo en una extension
+    for (size_t f = 0; f < m && !error; f++) {
+        if (g.flujo_off[f] >= 0) continue;
+        g.flujo_off[f] = offset_primer_tramo(v, g.flujo_tramos + g.flujo_tramo_ini[f], (int)g.flujo_tramo_n[f],
+                                             &g.flujo_len[f]);
+    }
+
+    reemplazar_flujos(t, &g, m);
+    return error ? -1 : 0;
+}
+
+// wCompressionSize de un $DATA no residente comprimido (flag 0x0001), 0 si no lo esta
+static uint8_t compresion_atributo(const NTFS_ATTRIBUTE *attr) {
+    if (attr->uchNonResFlag == 0 || !(attr->wFlags & 0x0001)) return 0;
+    return (uint8_t)attr->Attr.NonResident.wCompressionSize;
+}
+
+// Agrega un segmento de flujo con nombre; devuelve su indice o -1 si falta memoria
+static long flujo_agregar(TablaMft *t, FlujosPendientes *fp, const NTFS_ATTRIBUTE *attr,
+                          uint64_t dueno, uint8_t borrado) {
+    if (t->flujos_n == t->flujos_cap) {
+        size_t cap = t->flujos_cap ? t->flujos_cap * 2 : 256;
+        if (flujos_reservar(t, cap) != 0 ||
+            crecer_columna((void **)&fp->dueno, sizeof(*fp->dueno), cap) ||
+            crecer_columna((void **)&fp->vcn, sizeof(*fp->vcn), cap) ||
+            crecer_columna((void **)&fp->borrado, sizeof(*fp->borrado), cap)) return -1;
+        fp->cap = cap;
+    }
+    // el nombre del atributo (UTF-16LE) no esta alineado a 2 dentro del registro
+    uint16_t nombre16[255];
+    memcpy(nombre16, (const unsigned char *)attr + attr->wNameOffset, attr->uchNameLength * 2u);
+    long off = guardar_nombre(t, nombre16, attr->uchNameLength);
+    if (off < 0) return -1;
+    size_t f = t->flujos_n++;
+    t->flujo_fila[f] = 0;
+    t->flujo_nombre_off[f] = (uint32_t)off;
+    t->flujo_tamano[f] = 0;
+    t->flujo_off[f] = -1;
+    t->flujo_len[f] = 0;
+    t->flujo_res[f] = SIN_RESIDENTE;
+    t->flujo_tramo_ini[f] = (uint32_t)t->flujo_tramos_n;
+    t->flujo_tramo_n[f] = 0;
+    t->flujo_compresion[f] = compresion_atributo(attr);
+    fp->dueno[f] = dueno;
+    fp->vcn[f] = attr->uchNonResFlag ? (uint64_t)attr->Attr.NonResident.n64StartVCN : 0;
+    fp->borrado[f] = borrado;
+    return (long)f;
+}
+
+// Anota que el registro 'ext' es una extension de 'base' (para saber que releer al reescanear)
+static int extension_agregar(TablaMft *t, uint64_t ext, uint64_t base) {
+    if (ext >= SIN_PADRE || base >= SIN_PADRE) return 0;
+    if (t->ext_n == t->ext_cap) {
+        size_t cap = t->ext_cap ? t->ext_cap * 2 : 256;
+        if (crecer_columna((void **)&t->ext_registro, sizeof(*t->ext_registro), cap) ||
+            crecer_columna((void **)&t->ext_base, sizeof(*t->ext_base), cap)) return -1;
+        t->ext_cap = cap;
+    }
+    t->ext_registro[t->ext_n] = (uint32_t)ext;
+    t->ext_base[t->ext_n++] = (uint32_t)base;
+    return 0;
+}
+
+// Interpreta los registros de 'lista' (ordenados; NULL = todos, 0 .. n - 1) y agrega sus filas,
+// que quedan en orden de registro. No toca 'recuperable' ni las sumas de los trozos.
+static int escanear_registros(const VolumenNtfs *v, TablaMft *t, const uint32_t *lista, uint64_t n) {
+    unsigned char *reg = malloc(v->tam_registro);
+    if (!reg) return -1;
+    TramosPendientes pend = { 0 };
+    InfosPendientes infos = { 0 };
+    FlujosPendientes fp = { 0 };
+    Extent *datos = NULL; // runlist del $DATA sin nombre del registro actual
+    int datos_n = 0, datos_cap = 0;
+    int error = 0;
+    // se cuentan aparte y se suman a 'contadores' al final: el bucle no toca memoria compartida
+    uint64_t leidos = 0, sin_firma = 0, fixups_rotos = 0, extensiones = 0, descartados = 0, atributos = 0;
+
+    for (uint64_t x = 0; x < n && !error; x++) {
+        uint64_t i = lista ? lista[x] : x;
+        leidos++;
+        int r = leer_registro(v, i, reg);
+        if (r != 0) {
+            if (r == -2) fixups_rotos++;
+            else sin_firma++;
+            continue;
+        }
+        struct NTFS_MFT_FILE *hdr = (struct NTFS_MFT_FILE *)reg;
+        long long reg_off = offset_registro(v, i); // -1 si el registro cruza tramos
+        int borrado = !(hdr->wFlags & 0x01);
+        uint64_t base = REFERENCIA_REGISTRO(hdr->n64BaseMftRec);
+        int extension = base != 0 && base != i;
+        int runlist_roto = 0, hay_lista = 0, tiene_tam = 0;
+        uint8_t compresion = 0;
+        uint64_t tam_datos = 0;
+        // para deshacer lo agregado si el registro no termina aportando nada
+        size_t flujos_antes = t->flujos_n, nombres_antes = t->nombres_len, residentes_antes = t->residentes_len;
+        int flujo_tramos_antes = t->flujo_tramos_n;
+        datos_n = 0;
+
+        ATTR_FILENAME *fn_elegido = NULL;
+        ATTR_STANDARD *std_info = NULL;
+        long found_data_offset = -1;
+        size_t found_data_len = 0;
+        uint32_t found_data_res = SIN_RESIDENTE;
+
+        for (NTFS_ATTRIBUTE *attr = primer_atributo(reg, v->tam_registro); attr;
+             attr = siguiente_atributo(reg, v->tam_registro, attr)) {
+            atributos++;
+
+            if (attr->dwType == 0x10) { // $STANDARD_INFORMATION
+                std_info = valor_residente(attr, 36);
+            }
+            else if (attr->dwType == 0x20) { // $ATTRIBUTE_LIST: parte de los atributos esta en extensiones
+                hay_lista = 1;
+            }
+            else if (attr->dwType == 0x30) { // $FILE_NAME
+                ATTR_FILENAME *fn = valor_residente(attr, 66);
+                if (!fn || 66u + fn->chFileNameLength * 2u > attr->Attr.Resident.dwLength) continue;
+                // el nombre DOS 8.3 (tipo 2) solo se usa si no hay otro
+                if (!fn_elegido || fn_elegido->chFileNameType == 2) fn_elegido = fn;
+            }
+            else if (attr->dwType == 0x80 && attr->uchNameLength != 0) { // flujo con nombre (ADS)
+                if ((uint32_t)attr->wNameOffset + attr->uchNameLength * 2u > attr->dwFullLength) continue;
+                long f = flujo_agregar(t, &fp, attr, extension ? base : i, (uint8_t)borrado);
+                if (f < 0) {
+                    error = 1;
+                    break;
+                }
+                if (attr->uchNonResFlag == 0) {
+                    t->flujo_tamano[f] = attr->Attr.Resident.dwLength;
+                    size_t len;
+                    const unsigned char *valor = valor_datos(attr, &len);
+                    if (valor) {
+                        t->flujo_res[f] = residente_guardar(t, valor, len);
+                        t->flujo_len[f] = len;
+                        if (reg_off >= 0) t->flujo_off[f] = (long)(reg_off + (valor - reg));
+                    }
+                    continue;
+                }
+                if (attr->Attr.NonResident.n64StartVCN == 0) t->flujo_tamano[f] = attr->Attr.NonResident.n64RealSize;
+                unsigned char *run = (unsigned char *)attr + attr->Attr.NonResident.wDatarunOffset;
+                int desde = t->flujo_tramos_n;
+                if (decodificar_runlist(run, (unsigned char *)attr + attr->dwFullLength, attr->Attr.NonResident.n64StartVCN,
+                                        &t->flujo_tramos, &t->flujo_tramos_n, &t->flujo_tramos_cap) < 0 ||
+                    (borrado && !tramos_validos(v, t->flujo_tramos + desde, t->flujo_tramos_n - desde))) runlist_roto = 1;
+                t->flujo_tramo_n[f] = (uint32_t)(t->flujo_tramos_n - desde);
+                t->flujo_off[f] = offset_primer_tramo(v, t->flujo_tramos + desde, t->flujo_tramos_n - desde, &t->flujo_len[f]);
+            }
+            else if (attr->dwType == 0x80) { // $DATA sin nombre: el contenido del archivo
+                if (attr->uchNonResFlag == 0) {
+                    // residente: data en el mismo atributo. El offset en el mapa queda para ver los
+                    // bytes crudos; el contenido se lee de la copia, que ya tiene los fixups
+                    size_t len;
+                    const unsigned char *valor = valor_datos(attr, &len);
+                    if (valor && !extension) {
+                        found_data_res = residente_guardar(t, valor, len);
+                        found_data_len = len;
+                        if (reg_off >= 0) found_data_offset = (long)(reg_off + (valor - reg));
+                    }
+                    tam_datos = attr->Attr.Resident.dwLength;
+                    tiene_tam = 1;
+                } else {
+                    // no-residente: el runlist completo va a la tabla (o a pendientes si este es un
+                    // registro de extension); data_off es el primer run
+                    if (attr->Attr.NonResident.n64StartVCN == 0) {
+                        tam_datos = attr->Attr.NonResident.n64RealSize;
+                        tiene_tam = 1;
+                    }
+                    compresion = compresion_atributo(attr);
+                    unsigned char *run = (unsigned char *)attr + attr->Attr.NonResident.wDatarunOffset;
+                    int desde = datos_n;
+                    if (decodificar_runlist(run, (unsigned char *)attr + attr->dwFullLength,
+                                            attr->Attr.NonResident.n64StartVCN, &datos, &datos_n, &datos_cap) < 0 ||
+                        (borrado && !tramos_validos(v, datos + desde, datos_n - desde))) runlist_roto = 1;
+                    size_t len;
+                    long off = offset_primer_tramo(v, datos + desde, datos_n - desde, &len);
+                    if (off >= 0) {
+                        found_data_offset = off;
+                        found_data_len = len;
+                    }
+                }
+            }
+        }
+        if (error) break;
+
+        if (extension) {
+            // no es una fila: lo que tenga se guarda para su registro base
+            extensiones++;
+            if (extension_agregar(t, i, base) != 0) {
+                error = 1;
+                break;
+            }
+            if (runlist_roto) {
+                t->flujos_n = flujos_antes;
+                t->flujo_tramos_n = flujo_tramos_antes;
+                t->nombres_len = nombres_antes;
+                t->residentes_len = residentes_antes;
+                continue;
+            }
+            int desde = pend.n;
+            if (agregar_tramos(&pend.ext, &pend.n, &pend.cap, datos, datos_n) != 0 ||
+                pendientes_marcar(&pend, desde, base, (uint8_t)borrado) != 0) {
+                error = 1;
+                break;
+            }
+            if (tiene_tam || fn_elegido || compresion) {
+                InfoPendiente *x = info_agregar(&infos, base, (uint8_t)borrado);
+                if (!x) {
+                    error = 1;
+                    break;
+                }
+                x->tiene_tam = (uint8_t)tiene_tam;
+                x->tamano = tam_datos;
+                x->compresion = compresion;
+                if (fn_elegido) {
+                    long off = guardar_nombre(t, fn_elegido->wFilename, fn_elegido->chFileNameLength);
+                    if (off < 0) {
+                        error = 1;
+                        break;
+                    }
+                    x->tiene_nombre = 1;
+                    x->nombre_off = (uint32_t)off;
+                    x->es_dir = (fn_elegido->dwFlags & 0x10000000) != 0;
+                    x->fn_fechas = fechas_nombre(fn_elegido);
+                    x->padre = fn_elegido->dwMftParentDir;
+                }
+            }
+            continue;
+        }
+
+        // sin $FILE_NAME propio solo se lista si $ATTRIBUTE_LIST dice que esta en una extension
+        if ((!fn_elegido && !hay_lista) || (borrado && runlist_roto)) {
+            descartados++;
+            t->flujos_n = flujos_antes;
+            t->flujo_tramos_n = flujo_tramos_antes;
+            t->nombres_len = nombres_antes;
+            t->residentes_len = residentes_antes;
+            continue;
+        }
+
+        if (t->n == t->cap && tabla_reservar(t, t->cap ? t->cap * 2 : 4096) != 0) {
+            error = 1;
+            break;
+        }
+        long off = fn_elegido ? guardar_nombre(t, fn_elegido->wFilename, fn_elegido->chFileNameLength)
+                              : arena_reservar(t, 1);
+        int tramo_ini = t->tramos_n;
+        if (off < 0 || agregar_tramos(&t->tramos, &t->tramos_n, &t->tramos_cap, datos, datos_n) != 0) {
+            error = 1;
+            break;
+        }
+        if (!fn_elegido) t->nombres[off] = '\0'; // lo completa fusionar_extensiones()
+
+        size_t k = t->n++;
+        t->registro[k] = (uint32_t)i;
+        // el tamano real es el de $DATA; $FILE_NAME solo se actualiza al renombrar
+        t->tamano[k] = tiene_tam ? tam_datos : fn_elegido ? fn_elegido->n64RealSize : 0;
+        t->atributos[k] = std_info ? std_info->dwFATAttributes : 0;
+        // las fechas de $STANDARD_INFORMATION son las que ve el usuario; $FILE_NAME si no hay
+        t->creado[k] = std_info ? std_info->n64Create : fn_elegido ? fn_elegido->n64Create : 0;
+        t->modificado[k] = std_info ? std_info->n64Modify : fn_elegido ? fn_elegido->n64Modify : 0;
+        t->cambiado[k] = std_info ? std_info->n64Modfil : fn_elegido ? fn_elegido->n64Modfil : 0;
+        t->accedido[k] = std_info ? std_info->n64Access : fn_elegido ? fn_elegido->n64Access : 0;
+        t->secuencia[k] = hdr->wSequence;
+        if (fn_elegido) {
+            FechasNtfs f = fechas_nombre(fn_elegido);
+            poner_padre(t, k, fn_elegido->dwMftParentDir, &f);
+        } else {
+            FechasNtfs f = { 0 };
+            poner_padre(t, k, SIN_PADRE, &f); // lo completa fusionar_extensiones()
+        }
+        t->es_dir[k] = fn_elegido && (fn_elegido->dwFlags & 0x10000000) != 0;
+        poner_nombre(t, k, (uint32_t)off);
+        t->contenido[k] = TIPO_ARCHIVO;
+        t->marcas[k] = borrado ? MARCA_BORRADO : 0;
+        t->recuperable[k] = RECUPERABLE_NS;
+        t->data_off[k] = found_data_offset;
+        t->data_len[k] = found_data_len;
+        t->data_res[k] = found_data_res;
+        t->tramo_ini[k] = (uint32_t)tramo_ini;
+        t->tramo_n[k] = (uint32_t)datos_n;
+        t->compresion[k] = compresion;
+    }
+    free(reg);
+    free(datos);
+    if (contadores.activos) {
+        contadores.registros_leidos += leidos;
+        contadores.sin_firma += sin_firma;
+        contadores.fixups_rotos += fixups_rotos;
+        contadores.extensiones += extensiones;
+        contadores.descartados += descartados;
+        contadores.atributos += atributos;
+        contadores.bytes += leidos * v->tam_registro;
+    }
+
+    if (!error) error = fusionar_extensiones(v, t, &pend, &infos) != 0;
+    if (!error) error = agrupar_flujos(v, t, &fp) != 0;
+    free(pend.ext);
+    free(pend.base);
+    free(pend.borrado);
+    free(infos.v);
+    free(fp.dueno);
+    free(fp.vcn);
+    free(fp.borrado);
+    return error ? -1 : 0;
+}
+
+// De un borrado interesa cuanto de sus clusters no se volvio a asignar; con los tramos
+// ya completos (incluidos los de sus extensiones)
+static void calcular_recuperable(TablaMft *t, const BitmapNtfs *bm) {
+    for (size_t k = 0; k < t->n; k++) {
+        if (!(t->marcas[k] & MARCA_BORRADO)) continue;
+        uint64_t total = 0, ocupados = 0;
+        for (uint32_t e = t->tramo_ini[k]; e < t->tramo_ini[k] + t->tramo_n[k]; e++) {
+            if (t->tramos[e].lcn < 0) continue;
+            total += t->tramos[e].len;
+            ocupados += contar_ocupados(bm, (uint64_t)t->tramos[e].lcn, t->tramos[e].len);
+        }
+        // sin clusters (residente o vacio) todo sigue en el registro
+        t->recuperable[k] = total ? (uint8_t)(100 * (total - ocupados) / total) : 100;
+    }
+}
+
+// Mezcla de 64 bits sobre los bytes crudos (sin fixups) de un registro; solo tiene que
+// cambiar cuando cambia el registro, no resistir a nadie. Cuatro carriles independientes para
+// que las multiplicaciones no se esperen unas a otras (n es multiplo de 512).
+static uint64_t sumar_bytes(uint64_t h, const unsigned char *p, size_t n) {
+    uint64_t c[4] = { h, h ^ 1, h ^ 2, h ^ 3 };
+    for (size_t i = 0; i + 32 <= n; i += 32) {
+        for (int j = 0; j < 4; j++) {
+            uint64_t w;
+            memcpy(&w, p + i + 8 * j, 8);
+            c[j] = (c[j] ^ w) * 0x9E3779B97F4A7C15ULL;
+            c[j] ^= c[j] >> 29;
+        }
+    }
+    return (c[0] ^ (c[1] * 3) ^ (c[2] * 5) ^ (c[3] * 7)) * 0x9E3779B97F4A7C15ULL;
+}
+
+static uint64_t sumar_registro(const VolumenNtfs *v, uint64_t num, uint64_t h) {
+    if (v->tam_registro <= v->tam_cluster) {
+        long long off = offset_registro(v, num);
+        return off < 0 ? h * 31 + 1 : sumar_bytes(h, v->map + off, v->tam_registro);
+    }
+    // registro mayor que el cluster: como en leer_registro(), cluster a cluster
+    for (uint32_t hecho = 0; hecho < v->tam_registro; hecho += v->tam_cluster) {
+        uint64_t vcn = (num * v->tam_registro + hecho) / v->tam_cluster;
+        int e = buscar_tramo(v->mft_ext, v->mft_n, vcn);
+        long long off = e < 0 || v->mft_ext[e].lcn < 0 ? -1
+                      : v->base + (long long)(v->mft_ext[e].lcn + (vcn - v->mft_ext[e].vcn)) * v->tam_cluster;
+        if (off < 0 || off + v->tam_cluster > v->map_size) return h * 31 + 1;
+        h = sumar_bytes(h, v->map + off, v->tam_cluster);
+    }
+    return h;
+}
+
+typedef struct {
+    const VolumenNtfs *v;
+    uint64_t *suma;
+    size_t trozos;
+    int h, nhilos;
+} HiloSuma;
+
+static void *sumar_intercalados(void *arg) {
+    HiloSuma *hs = arg;
+    // trozos intercalados: cada hilo lee de todo el $MFT y ninguno se queda con la cola
+    for (size_t c = (size_t)hs->h; c < hs->trozos; c += (size_t)hs->nhilos) {
+        uint64_t h = c;
+        uint64_t fin = (c + 1) * (uint64_t)REGISTROS_TROZO;
+        if (fin > hs->v->num_registros) fin = hs->v->num_registros;
+        for (uint64_t i = c * (uint64_t)REGISTROS_TROZO; i < fin; i++) h = sumar_registro(hs->v, i, h);
+        hs->suma[c] = h;
+    }
+    return NULL;
+}
+
+// Suma de cada trozo de REGISTROS_TROZO registros del $MFT, un hilo por nucleo
+static uint64_t *sumar_trozos(const VolumenNtfs *v, size_t *trozos) {
+    *trozos = (size_t)((v->num_registros + REGISTROS_TROZO - 1) / REGISTROS_TROZO);
+    uint64_t *suma = malloc((*trozos ? *trozos : 1) * sizeof(uint64_t));
+    if (!suma) return NULL;
+    long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    int nhilos = nucleos < 1 ? 1 : nucleos > MAX_HILOS_SUMA ? MAX_HILOS_SUMA : (int)nucleos;
+    if ((size_t)nhilos > *trozos) nhilos = *trozos ? (int)*trozos : 1;
+    HiloSuma hs[MAX_HILOS_SUMA];
+    pthread_t hilos[MAX_HILOS_SUMA];
+    int creados[MAX_HILOS_SUMA] = { 0 };
+    for (int h = 0; h < nhilos; h++) hs[h] = (HiloSuma){ v, suma, *trozos, h, nhilos };
+    for (int h = 1; h < nhilos; h++) creados[h] = pthread_create(&hilos[h], NULL, sumar_intercalados, &hs[h]) == 0;
+    sumar_intercalados(&hs[0]);
+    for (int h = 1; h < nhilos; h++) {
+        if (creados[h]) pthread_join(hilos[h], NULL);
+        else sumar_intercalados(&hs[h]);
+    }
+    contar_bytes(v->num_registros * v->tam_registro);
+    return suma;
+}
+
+int escanear_mft(const VolumenNtfs *v, const BitmapNtfs *bm, TablaMft *t) {
+    memset(t, 0, sizeof(*t));
+    if (escanear_registros(v, t, NULL, v->num_registros) != 0) return -1;
+    if (bm) calcular_recuperable(t, bm);
+    t->suma_trozo = sumar_trozos(v, &t->trozos_n);
+    if (!t->suma_trozo) return -1;
+    t->registros_n = v->num_registros;
+    t->tam_registro = v->tam_registro;
+    return 0;
+}
+
+static double ahora_seg(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#define REGISTROS_SISTEMA 16
+
+// Filas consecutivas que pasan juntas de una tabla (la vieja o la del reescaneo) a la nueva
+typedef struct {
+    uint32_t destino, origen, n;
+    uint8_t parcial;        // 1 = de la tabla del reescaneo
+} Corrida;
+
+// Arma una columna de la tabla nueva copiando las corridas. En sitio las filas viejas ya estan
+// donde van y solo se pisan las nuevas; con parcial NULL las filas nuevas quedan sin llenar.
+static int reubicar(void **col, size_t elem, const void *parcial, const Corrida *c, size_t nc, size_t n,
+                    int en_sitio) {
+    unsigned char *dest = *col;
+    if (!en_sitio) {
+        dest = malloc((n ? n : 1) * elem);
+        if (!dest) return -1;
+    }
+    for (size_t i = 0; i < nc; i++) {
+        const unsigned char *src = c[i].parcial ? parcial : *col;
+        if (!src || (en_sitio && !c[i].parcial)) continue;
+        memcpy(dest + (size_t)c[i].destino * elem, src + (size_t)c[i].origen * elem, (size_t)c[i].n * elem);
+    }
+    if (!en_sitio) {
+        free(*col);
+        *col = dest;
+    }
+    return 0;
+}
+
+// Vuelve a armar las columnas flujo_* en el orden de las filas ya reubicadas: flujo_ini de cada
+// fila todavia apunta a los flujos de la tabla de donde vino
+static int rehacer_flujos(TablaMft *t, const TablaMft *p, const Corrida *c, size_t nc) {
+    size_t nf = 0;
+    for (size_t d = 0; d < t->n; d++) nf += t->flujo_cnt[d];
+    TablaMft g = { 0 };
+    if (nf && flujos_reservar(&g, nf) != 0) {
+        tabla_liberar(&g);
+        return -1;
+    }
+    size_t m = 0;
+    for (size_t i = 0; i < nc; i++) {
+        const TablaMft *s = c[i].parcial ? p : t;
+        for (uint32_t d = c[i].destino; d < c[i].destino + c[i].n; d++) {
+            uint32_t ini = t->flujo_ini[d];
+            t->flujo_ini[d] = (uint32_t)m;
+            for (uint32_t f = ini; f < ini + t->flujo_cnt[d]; f++, m++) {
+                g.flujo_fila[m] = d;
+                g.flujo_nombre_off[m] = s->flujo_nombre_off[f];
+                g.flujo_tamano[m] = s->flujo_tamano[f];
+                g.flujo_off[m] = s->flujo_off[f];
+                g.flujo_len[m] = s->flujo_len[f];
+                g.flujo_res[m] = s->flujo_res[f];
+                g.flujo_tramo_ini[m] = s->flujo_tramo_ini[f];
+                g.flujo_tramo_n[m] = s->flujo_tramo_n[f];
+                g.flujo_compresion[m] = s->flujo_compresion[f];
+            }
+        }
+    }
+    // los tramos de los flujos no se mueven
+    g.flujo_tramos = t->flujo_tramos;
+    g.flujo_tramos_n = t->flujo_tramos_n;
+    g.flujo_tramos_cap = t->flujo_tramos_cap;
+    t->flujo_tramos = NULL;
+    reemplazar_flujos(t, &g, m);
+    return 0;
+}
+
+// Pasa a 't' las filas de 'p' (el reescaneo) en lugar de las de los registros marcados en
+// 'releer'. Los nombres, residentes y tramos de 'p' se agregan al final de las arenas de 't'; los de las
+// filas reemplazadas quedan sin uso hasta el proximo escaneo completo.
+static int empalmar(TablaMft *t, TablaMft *p, const uint8_t *releer, uint64_t num_registros,
+                    EstadisticaReescaneo *est) {
+    Corrida *c = NULL;
+    size_t nc = 0, cap = 0, k = 0, j = 0, d = 0;
+    while (k < t->n || j < p->n) {
+        if (k < t->n && (t->registro[k] >= num_registros || releer[t->registro[k]])) {
+            k++;
+            est->filas_quitadas++;
+            continue;
+        }
+        uint8_t de_p = k >= t->n || (j < p->n && p->registro[j] < t->registro[k]);
+        uint32_t origen = (uint32_t)(de_p ? j++ : k++);
+        if (nc && c[nc - 1].parcial == de_p && c[nc - 1].origen + c[nc - 1].n == origen &&
+            c[nc - 1].destino + c[nc - 1].n == d) {
+            c[nc - 1].n++;
+        } else {
+            if (nc == cap) {
+                cap = cap ? cap * 2 : 64;
+                Corrida *x = realloc(c, cap * sizeof(Corrida));
+                if (!x) {
+                    free(c);
+                    return -1;
+                }
+                c = x;
+            }
+            c[nc++] = (Corrida){ (uint32_t)d, origen, 1, de_p };
+        }
+        d++;
+    }
+
+    // si no cambio la cantidad de filas y las viejas no se corrieron, se pisan las columnas
+    int en_sitio = d == t->n;
+    for (size_t i = 0; i < nc && en_sitio; i++) en_sitio = c[i].parcial || c[i].destino == c[i].origen;
+    est->en_sitio = en_sitio;
+
+    // nombres, residentes y tramos del reescaneo al final de las arenas, con los offsets corridos
+    long off = arena_reservar(t, p->nombres_len);
+    uint32_t res = residente_guardar(t, p->residentes, p->residentes_len);
+    uint32_t base_tramos = (uint32_t)t->tramos_n, base_ftramos = (uint32_t)t->flujo_tramos_n;
+    if (off < 0 || res == SIN_RESIDENTE || agregar_tramos(&t->tramos, &t->tramos_n, &t->tramos_cap, p->tramos, p->tramos_n) != 0 ||
+        agregar_tramos(&t->flujo_tramos, &t->flujo_tramos_n, &t->flujo_tramos_cap, p->flujo_tramos,
+                       p->flujo_tramos_n) != 0) {
+        free(c);
+        return -1;
+    }
+    if (p->nombres_len) memcpy(t->nombres + off, p->nombres, p->nombres_len);
+    for (size_t i = 0; i < p->n; i++) {
+        p->nombre_off[i] += (uint32_t)off;
+        p->tramo_ini[i] += base_tramos;
+        if (p->data_res[i] != SIN_RESIDENTE) p->data_res[i] += res;
+    }
+    for (size_t f = 0; f < p->flujos_n; f++) {
+        p->flujo_nombre_off[f] += (uint32_t)off;
+        p->flujo_tramo_ini[f] += base_ftramos;
+        if (p->flujo_res[f] != SIN_RESIDENTE) p->flujo_res[f] += res;
+    }
+
+#define REUBICAR(col) reubicar((void **)&t->col, sizeof(*t->col), p->col, c, nc, d, en_sitio)
+    int error = REUBICAR(registro) || REUBICAR(nombre_off) || REUBICAR(clave_nom) || REUBICAR(tamano) ||
+                REUBICAR(atributos) || REUBICAR(creado) || REUBICAR(modificado) || REUBICAR(cambiado) ||
+                REUBICAR(accedido) || REUBICAR(fn_fechas) || REUBICAR(padre) || REUBICAR(padre_sec) ||
+                REUBICAR(secuencia) || REUBICAR(es_dir) || REUBICAR(tipo) || REUBICAR(contenido) ||
+                REUBICAR(marcas) || REUBICAR(recuperable) || REUBICAR(data_off) || REUBICAR(data_len) ||
+                REUBICAR(data_res) || REUBICAR(tramo_ini) || REUBICAR(tramo_n) || REUBICAR(compresion) ||
+                REUBICAR(flujo_ini) || REUBICAR(flujo_cnt);
+#undef REUBICAR
+    // las filas nuevas no tienen MARCA_HASH: sus hashes quedan sin llenar
+    if (!error && t->hashes) error = reubicar((void **)&t->hashes, LARGO_HASHES, NULL, c, nc, d, en_sitio) != 0;
+    if (!error) {
+        t->n = d;
+        if (!en_sitio) t->cap = d;
+        // los archivos del sistema ($MFT, $Bitmap, $LogFile...) cambian de contenido sin que
+        // cambie su registro
+        for (size_t k = 0; k < d && t->registro[k] < REGISTROS_SISTEMA; k++) t->marcas[k] &= (uint8_t)~MARCA_HASH;
+        error = rehacer_flujos(t, p, c, nc) != 0;
+    }
+    free(c);
+    return error ? -1 : 0;
+}
+
+int reescanear_mft(const VolumenNtfs *v, const BitmapNtfs *bm, TablaMft *t, EstadisticaReescaneo *est) {
+    double t0 = ahora_seg();
+    memset(est, 0, sizeof(*est));
+    size_t trozos;
+    uint64_t *suma = sumar_trozos(v, &trozos);
+    if (!suma) {
+        tabla_liberar(t);
+        return -1;
+    }
+    size_t max_trozos = trozos > t->trozos_n ? trozos : t->trozos_n;
+    for (size_t c = 0; c < max_trozos; c++) {
+        if (c >= trozos || c >= t->trozos_n || suma[c] != t->suma_trozo[c]) est->trozos_cambiados++;
+    }
+    est->trozos = trozos;
+
+    if (!t->suma_trozo || t->tam_registro != v->tam_registro || est->trozos_cambiados * 2 > max_trozos) {
+        // cambio casi todo (o es otro volumen): sale mas barato de cero, y compacta las arenas
+        free(suma);
+        tabla_liberar(t);
+        int r = escanear_mft(v, bm, t);
+        est->completo = 1;
+        est->registros = (size_t)v->num_registros;
+        est->filas_nuevas = t->n;
+        est->segundos = ahora_seg() - t0;
+        return r;
+    }
+
+    uint64_t nreg = v->num_registros > t->registros_n ? v->num_registros : t->registros_n;
+    uint8_t *releer = calloc(nreg ? nreg : 1, 1); // bit 0: trozo cambiado, bit 1: base o extension
+    uint32_t *lista = NULL;
+    TablaMft p = { 0 };
+    int error = !releer;
+    for (size_t c = 0; c < max_trozos && !error; c++) {
+        if (c < trozos && c < t->trozos_n && suma[c] == t->suma_trozo[c]) continue;
+        uint64_t ini = c * (uint64_t)REGISTROS_TROZO, fin = ini + REGISTROS_TROZO;
+        memset(releer + ini, 1, (size_t)((fin < nreg ? fin : nreg) - ini));
+    }
+
+    if (!error) {
+        // un registro base se vuelve a leer si cambio alguna de sus extensiones, antes o despues
+        for (size_t e = 0; e < t->ext_n; e++) {
+            if (releer[t->ext_registro[e]] && t->ext_base[e] < nreg) releer[t->ext_base[e]] |= 2;
+        }
+        for (uint64_t i = 0; i < v->num_registros; i++) {
+            if (!(releer[i] & 1)) continue;
+            long long off = offset_registro(v, i);
+            if (off < 0 || memcmp(v->map + off, "FILE", 4) != 0) continue;
+            uint64_t base;
+            memcpy(&base, v->map + off + offsetof(struct NTFS_MFT_FILE, n64BaseMftRec), sizeof(base));
+            base = REFERENCIA_REGISTRO(base);
+            if (base != 0 && base != i && base < nreg) releer[base] |= 2;
+        }
+        // y con el todas sus extensiones; las de trozos sin cambios son las que ya se conocian
+        for (size_t e = 0; e < t->ext_n; e++) {
+            if (t->ext_base[e] < nreg && releer[t->ext_base[e]]) releer[t->ext_registro[e]] |= 2;
+        }
+
+        size_t nl = 0;
+        for (uint64_t i = 0; i < v->num_registros; i++) nl += releer[i] != 0;
+        lista = malloc((nl ? nl : 1) * sizeof(uint32_t));
+        error = !lista;
+        for (uint64_t i = 0, x = 0; i < v->num_registros && !error; i++) {
+            if (releer[i]) lista[x++] = (uint32_t)i;
+        }
+        est->registros = nl;
+        if (!error) error = escanear_registros(v, &p, lista, nl) != 0;
+    }
+    est->filas_nuevas = p.n;
+    if (!error) error = empalmar(t, &p, releer, v->num_registros, est) != 0;
+
+    if (!error) {
+        // las extensiones que se volvieron a leer ya estan en p
+        size_t m = 0;
+        for (size_t e = 0; e < t->ext_n; e++) {
+            uint32_t r = t->ext_registro[e];
+            if (r >= v->num_registros || releer[r]) continue;
+            t->ext_registro[m] = r;
+            t->ext_base[m++] = t->ext_base[e];
+        }
+        t->ext_n = m;
+        for (size_t e = 0; e < p.ext_n && !error; e++) {
+            error = extension_agregar(t, p.ext_registro[e], p.ext_base[e]) != 0;
+        }
+    }
+    free(releer);
+    free(lista);
+    tabla_liberar(&p);
+    if (error) {
+        free(suma);
+        tabla_liberar(t);
+        return -1;
+    }
+
+    free(t->suma_trozo);
+    t->suma_trozo = suma;
+    t->trozos_n = trozos;
+    t->registros_n = v->num_registros;
+    // el $Bitmap pudo cambiar aunque el registro del borrado no
+    if (bm) calcular_recuperable(t, bm);
+    est->segundos = ahora_seg() - t0;
+    return 0;
+}
+
+int indice_registros(const TablaMft *t, IndiceRegistros *ix) {
+    ix->n = 0;
+    for (size_t k = 0; k < t->n; k++) {
+        if (t->registro[k] >= ix->n) ix->n = (size_t)t->registro[k] + 1;
+    }
+    ix->fila = malloc((ix->n ? ix->n : 1) * sizeof(uint32_t));
+    if (!ix->fila) return -1;
+    memset(ix->fila, 0xFF, ix->n * sizeof(uint32_t)); // SIN_PADRE
+    for (size_t k = 0; k < t->n; k++) ix->fila[t->registro[k]] = (uint32_t)k;
+    return 0;
+}
+
+void liberar_indice_registros(IndiceRegistros *ix) {
+    free(ix->fila);
+    ix->fila = NULL;
+    ix->n = 0;
+}
+
+#define REGISTRO_RAIZ 5
+#define MAX_PROFUNDIDAD 256
+
+// Fila del padre de k o SIN_PADRE si la cadena se corta. Al borrar un registro NTFS sube su
+// secuencia, asi que un padre borrado puede tener la esperada + 1.
+static uint32_t fila_padre(const TablaMft *t, const IndiceRegistros *ix, size_t k) {
+    uint32_t p = t->padre[k];
+    if (p == SIN_PADRE || p >= ix->n || ix->fila[p] == SIN_PADRE) return SIN_PADRE;
+    uint32_t f = ix->fila[p];
+    if (!t->es_dir[f]) return SIN_PADRE;
+    uint16_t esperada = t->padre_sec[k], tiene = t->secuencia[f];
+    if (esperada != 0 && esperada != tiene &&
+        !((t->marcas[f] & MARCA_BORRADO) && (uint16_t)(esperada + 1) == tiene)) return SIN_PADRE;
+    return f;
+}
+
+size_t ruta_completa(const TablaMft *t, const IndiceRegistros *ix, size_t fila, char *buf, size_t sz) {
+    uint32_t cadena[MAX_PROFUNDIDAD];
+    int n = 0, huerfano = 0;
+    size_t k = fila;
+    // de la fila hacia arriba; un ciclo termina por profundidad
+    while (t->registro[k] != REGISTRO_RAIZ) {
+        if (n == MAX_PROFUNDIDAD) {
+            huerfano = 1;
+            break;
+        }
+        cadena[n++] = (uint32_t)k;
+        uint32_t p = fila_padre(t, ix, k);
+        if (p == SIN_PADRE || p == k) {
+            huerfano = 1;
+            break;
+        }
+        k = p;
+    }
+    size_t len = 0;
+    if (sz == 0) return 0;
+    buf[0] = '\0';
+    if (huerfano) len += (size_t)snprintf(buf, sz, "/$OrphanFiles");
+    if (n == 0 && !huerfano) len += (size_t)snprintf(buf, sz, "/");
+    for (int i = n - 1; i >= 0 && len < sz - 1; i--) {
+        len += (size_t)snprintf(buf + len, sz - len, "/%s", tabla_nombre(t, cadena[i]));
+    }
+    return len < sz ? len : sz - 1;
+}
@@ -0,0 +1,177 @@
+#ifndef TABLAMFT_H
+#define TABLAMFT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "ntfsVolumen.h"
+#include "bitmapNtfs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Las cuatro fechas (FILETIME) de $STANDARD_INFORMATION o de $FILE_NAME
+typedef struct {
+    uint64_t creado, modificado, cambiado, accedido; // cambiado = ultima modificacion del registro MFT
+} FechasNtfs;
+
+#define SIN_PADRE UINT32_MAX
+#define SIN_RESIDENTE UINT32_MAX
+
+// Tabla de entradas del MFT guardada por columnas (un arreglo por campo).
+// Los nombres viven todos seguidos en una sola arena terminados en '\0'.
+typedef struct {
+    size_t n, cap;
+    uint32_t *registro;     // numero de registro MFT
+    uint32_t *nombre_off;   // offset del nombre dentro de 'nombres'
+    uint64_t *clave_nom;    // clave_nombre() precalculada para ordenar sin tocar la arena
+    uint64_t *tamano;       // tamano real segun $DATA ($FILE_NAME si no hay)
+    uint32_t *atributos;    // atributos FAT de $STANDARD_INFORMATION
+    uint64_t *creado;       // FILETIME de creacion
+    uint64_t *modificado;   // FILETIME de ultima modificacion
+    uint64_t *cambiado;     // FILETIME del ultimo cambio del registro MFT
+    uint64_t *accedido;     // FILETIME del ultimo acceso
+    FechasNtfs *fn_fechas;  // las de $FILE_NAME (todo 0 si no hay)
+    uint32_t *padre;        // registro del directorio padre segun $FILE_NAME, SIN_PADRE si no se sabe
+    uint16_t *padre_sec;    // numero de secuencia esperado del padre
+    uint16_t *secuencia;    // numero de secuencia del registro
+    uint8_t  *es_dir;
+    uint8_t  *tipo;         // TipoArchivo segun la extension
+    uint8_t  *contenido;    // TipoArchivo segun los bytes magicos (TIPO_ARCHIVO si no se analizo)
+    uint8_t  *marcas;       // MARCA_*
+    uint8_t  *recuperable;  // borrados: % de los clusters de datos que siguen libres (RECUPERABLE_NS si no se sabe)
+    long     *data_off;     // offset absoluto de los datos en el mapa, -1 si no se conoce
+    size_t   *data_len;
+    uint32_t *data_res;     // $DATA residente: offset de la copia (con los fixups) en 'residentes', o SIN_RESIDENTE
+    uint32_t *tramo_ini;    // runlist completo de $DATA: tramos[tramo_ini .. tramo_ini + tramo_n)
+    uint32_t *tramo_n;      // ordenados por VCN, incluidos los de registros de extension
+    uint8_t  *compresion;   // log2 de los clusters por unidad de compresion de $DATA, 0 = sin comprimir
+    uint32_t *flujo_ini;    // flujos con nombre de la fila: flujo_ini .. flujo_ini + flujo_cnt
+    uint16_t *flujo_cnt;
+
+    Extent *tramos;
+    int tramos_n, tramos_cap;
+
+    // Flujos de datos alternativos ($DATA con nombre), tambien por columnas y agrupados por
+    // fila en el orden de las filas; el nombre del flujo vive en la misma arena 'nombres'
+    size_t flujos_n, flujos_cap;
+    uint32_t *flujo_fila;       // fila del archivo al que pertenece
+    uint32_t *flujo_nombre_off;
+    uint64_t *flujo_tamano;
+    long     *flujo_off;        // como data_off: residente o primer tramo, -1 si no se conoce
+    size_t   *flujo_len;
+    uint32_t *flujo_res;        // como data_res
+    uint32_t *flujo_tramo_ini;  // en 'flujo_tramos'
+    uint32_t *flujo_tramo_n;
+    uint8_t  *flujo_compresion;
+
+    Extent *flujo_tramos;
+    int flujo_tramos_n, flujo_tramos_cap;
+
+    unsigned char *hashes;      // NULL hasta calcular_hashes(): LARGO_HASHES bytes por fila
+
+    // Para reescanear_mft(): suma de los bytes crudos de cada trozo de REGISTROS_TROZO registros
+    // y que registro base tiene cada registro de extension, tal como estaban al escanear
+    uint64_t *suma_trozo;
+    size_t trozos_n;
+    uint64_t registros_n;
+    uint32_t tam_registro;
+    uint32_t *ext_registro, *ext_base;
+    size_t ext_n, ext_cap;
+
+    char *nombres;
+    size_t nombres_len, nombres_cap;
+
+    // Valores de los $DATA residentes copiados del registro ya corregido por leer_registro(): en
+    // el mapa los 2 ultimos bytes de cada sector del registro son el numero de secuencia
+    unsigned char *residentes;
+    size_t residentes_len, residentes_cap;
+} TablaMft;
+
+#define MARCA_DISCORDANTE 0x01 // la extension no cuadra con el contenido
+#define MARCA_BORRADO     0x02 // registro sin el bit "en uso" (archivo borrado)
+#define MARCA_FLUJOS      0x04 // tiene flujos de datos alternativos
+#define MARCA_HASH        0x08 // t->hashes de la fila ya calculados
+
+#define RECUPERABLE_NS 255
+
+#define REGISTROS_TROZO 1024 // registros del $MFT por suma en reescanear_mft()
+
+// Recorre todo el $MFT del volumen y llena la tabla, incluidos los registros borrados cuyo
+// $FILE_NAME y runlist siguen siendo validos. Los registros de extension (n64BaseMftRec != 0,
+// los que apunta $ATTRIBUTE_LIST) no son filas: al final se juntan con su registro base.
+// Con bm (puede ser NULL) se calcula que parte de los datos de cada borrado sigue libre. Devuelve 0 o -1 si falta memoria.
+int escanear_mft(const VolumenNtfs *v, const BitmapNtfs *bm, TablaMft *t);
+void tabla_liberar(TablaMft *t);
+
+typedef struct {
+    size_t trozos, trozos_cambiados;
+    size_t registros;           // registros que se volvieron a interpretar
+    size_t filas_nuevas;        // filas que salieron de esos registros
+    size_t filas_quitadas;      // filas viejas que reemplazaron
+    int completo;               // 1 si hubo que escanear todo de nuevo
+    int en_sitio;               // 1 si las filas nuevas cayeron donde estaban las viejas
+    double segundos;
+} EstadisticaReescaneo;
+
+// Vuelve a leer el $MFT de un volumen ya escaneado en 't' (la misma imagen despues de un cambio,
+// abierta otra vez con abrir_volumen()) y solo interpreta los trozos cuya suma cambio, mas los
+// registros base y de extension que dependen de ellos. Las filas de esos registros se cambian en
+// la tabla; el resto, sus hashes (salvo los de los archivos del sistema) y su contenido analizado
+// quedan como estaban. Los indices que
+// salen de la tabla (indice_registros(), vistas) hay que rehacerlos. Si cambio mas de la mitad de
+// los trozos o el tamano de registro escanea todo. Devuelve 0 o -1 si falta memoria (la tabla
+// queda vacia).
+int reescanear_mft(const VolumenNtfs *v, const BitmapNtfs *bm, TablaMft *t, EstadisticaReescaneo *est);
+
+// Primeros 8 bytes del nombre con las mayusculas ASCII pasadas a minusculas, en big-endian:
+// comparar claves da el mismo orden que strcasecmp sobre esos 8 bytes
+static inline uint64_t clave_nombre(const char *nombre) {
+    uint64_t k = 0;
+    int fin = 0;
+    for (int j = 0; j < 8; j++) {
+        unsigned char c = fin ? 0 : (unsigned char)nombre[j];
+        if (c == 0) fin = 1;
+        if (c >= 'A' && c <= 'Z') c |= 0x20;
+        k = (k << 8) | c;
+    }
+    return k;
+}
+
+static inline const char *tabla_nombre(const TablaMft *t, size_t i) {
+    return t->nombres + t->nombre_off[i];
+}
+
+// Contenido de un $DATA residente (data_len bytes), NULL si la fila no lo tiene
+static inline const unsigned char *tabla_residente(const TablaMft *t, size_t i) {
+    return t->data_res[i] == SIN_RESIDENTE ? NULL : t->residentes + t->data_res[i];
+}
+
+static inline const char *flujo_nombre(const TablaMft *t, size_t f) {
+    return t->nombres + t->flujo_nombre_off[f];
+}
+
+static inline const unsigned char *flujo_residente(const TablaMft *t, size_t f) {
+    return t->flujo_res[f] == SIN_RESIDENTE ? NULL : t->residentes + t->flujo_res[f];
+}
+
+// Fila de cada numero de registro, para subir por los directorios padre
+typedef struct {
+    uint32_t *fila;         // SIN_PADRE si el registro no es una fila
+    size_t n;
+} IndiceRegistros;
+
+int indice_registros(const TablaMft *t, IndiceRegistros *ix);
+void liberar_indice_registros(IndiceRegistros *ix);
+
+// Ruta completa de la fila ("/dir/sub/nombre") siguiendo el padre de $FILE_NAME hasta la raiz
+// (registro 5). Si la cadena se corta (padre que no existe, reusado con otra secuencia o un
+// ciclo) lo que queda cuelga de "/$OrphanFiles". Devuelve el largo (se trunca a sz - 1).
+size_t ruta_completa(const TablaMft *t, const IndiceRegistros *ix, size_t fila, char *buf, size_t sz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,234 @@
+// tablaTipos.h: generado por tiposArchivo.c (-DGENERAR_TABLA_TIPOS) desde extensiones.def.
+// No editar a mano. 368 extensiones en 1024 casillas.
+#ifndef TABLATIPOS_H
+#define TABLATIPOS_H
+
+static const uint16_t tabla_tipos_desp[256] = {
+    0, 1, 0, 0, 1, 1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0,
+    0, 0, 2, 2, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 1, 1,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 1, 0, 0,
+    0, 0, 0, 1, 0, 0, 2, 0, 0, 0, 1, 1, 0, 0, 0, 0,
+    0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0,
+    1, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 1, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0,
+    2, 0, 0, 0, 0, 3, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 1, 0, 0, 0, 0, 1, 1, 0, 0, 0, 1, 0, 0, 0,
+    0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 2, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 6,
+    0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 1, 0, 0, 0, 0, 2,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 1,
+    0, 0, 1, 1, 1, 1, 0, 2, 0, 1, 0, 0, 1, 1, 0, 1,
+    0, 0, 2, 0, 0, 0, 0, 0, 8, 0, 0, 1, 0, 0, 1, 0,
+};
+
+static const uint64_t tabla_tipos_claves[1024] = {
+    0x7861ULL, 0x666967ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x6276ULL,
+    0x6e6f736aULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x666d65ULL, 0x706d62ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x767363ULL,
+    0x0ULL, 0x636161ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x68736162ULL, 0x0ULL, 0x0ULL, 0x787374ULL,
+    0x747331ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x61756cULL, 0x0ULL, 0x0ULL, 0x726373ULL,
+    0x0ULL, 0x31647370ULL, 0x666378ULL, 0x6c7173ULL, 0x0ULL, 0x636f6c626577ULL,
+    0x0ULL, 0x6c616974726170ULL, 0x7375706fULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x78636fULL, 0x0ULL, 0x707773ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x696e69ULL, 0x32706aULL, 0x0ULL, 0x0ULL, 0x6f73ULL,
+    0x0ULL, 0x0ULL, 0x68736bULL, 0x0ULL, 0x0ULL, 0x687377ULL,
+    0x78647376ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x667361ULL, 0x6d626577ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x766173ULL, 0x747874ULL, 0x0ULL, 0x0ULL, 0x6172ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x666376ULL, 0x0ULL, 0x0ULL, 0x66666f77ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x33706dULL, 0x0ULL,
+    0x0ULL, 0x727265ULL, 0x0ULL, 0x7374ULL, 0x623770ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x626964ULL, 0x7372ULL, 0x0ULL, 0x62757065ULL,
+    0x0ULL, 0x677673ULL, 0x0ULL, 0x0ULL, 0x6c6d78ULL, 0x0ULL,
+    0x323170ULL, 0x0ULL, 0x0ULL, 0x78626dULL, 0x0ULL, 0x0ULL,
+    0x7a37ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x6574696c7173ULL, 0x746164ULL,
+    0x0ULL, 0x0ULL, 0x746c78ULL, 0x0ULL, 0x0ULL, 0x6f727661ULL,
+    0x0ULL, 0x0ULL, 0x66646eULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x707061ULL, 0x0ULL, 0x78746f70ULL, 0x0ULL, 0x6176616aULL,
+    0x73ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x6669666aULL,
+    0x0ULL, 0x78747070ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x786670ULL, 0x0ULL, 0x0ULL, 0x667474ULL, 0x0ULL, 0x0ULL,
+    0x667472ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x6b6277ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x646876ULL, 0x626e797069ULL,
+    0x6d636f64ULL, 0x336574696c7173ULL, 0x6765706dULL, 0x666470ULL, 0x666e69ULL, 0x0ULL,
+    0x0ULL, 0x65706aULL, 0x727363ULL, 0x0ULL, 0x726174ULL, 0x0ULL,
+    0x6c6d6179ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x6b646d76ULL, 0x0ULL,
+    0x0ULL, 0x6568636163ULL, 0x0ULL, 0x787868ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x646d63ULL, 0x666961ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x746163ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x68736966ULL, 0x0ULL, 0x777a61ULL,
+    0x0ULL, 0x6b6162ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x73646fULL, 0x0ULL,
+    0x0ULL, 0x73746dULL, 0x0ULL, 0x0ULL, 0x6c7063ULL, 0x6d746c78ULL,
+    0x0ULL, 0x616c78ULL, 0x616d77ULL, 0x69736dULL, 0x0ULL, 0x666e63ULL,
+    0x6f7773ULL, 0x0ULL, 0x7363ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x6264ULL,
+    0x74646fULL, 0x7a67ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x74737aULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x6d6570ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x6d72ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x74786574ULL, 0x66646cULL, 0x0ULL,
+    0x0ULL, 0x6d746f64ULL, 0x0ULL, 0x0ULL, 0x726564ULL, 0x706f746b736564ULL,
+    0x0ULL, 0x0ULL, 0x317370ULL, 0x0ULL, 0x736a63ULL, 0x74726164ULL,
+    0x0ULL, 0x0ULL, 0x736c6eULL, 0x746162ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x78746c78ULL, 0x0ULL, 0x62696c7964ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x6e776f646b72616dULL, 0x0ULL, 0x726172ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x6c7465ULL, 0x647077ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x657865ULL, 0x70646fULL,
+    0x647370ULL, 0x0ULL, 0x626564ULL, 0x0ULL, 0x0ULL, 0x646269ULL,
+    0x6d6f63ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x737265626d756eULL, 0x786d6461ULL, 0x32776f6371ULL,
+    0x6c6d6461ULL, 0x0ULL, 0x6f666eULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x786f626dULL, 0x766c66ULL, 0x0ULL, 0x0ULL, 0x676572ULL,
+    0x726563ULL, 0x0ULL, 0x666570ULL, 0x6c6d6178ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x76676fULL, 0x0ULL, 0x687a6cULL, 0x0ULL,
+    0x647376ULL, 0x676d64ULL, 0x0ULL, 0x676f6cULL, 0x0ULL, 0x706770ULL,
+    0x666e6f63ULL, 0x0ULL, 0x0ULL, 0x776172ULL, 0x0ULL, 0x0ULL,
+    0x7a78ULL, 0x0ULL, 0x63616c66ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x6c6d74686dULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x6b6e6cULL, 0x0ULL, 0x0ULL, 0x656e6fULL, 0x66666961ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x6e6f736a646eULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x67676fULL, 0x0ULL, 0x707068ULL,
+    0x0ULL, 0x6d7361ULL, 0x0ULL, 0x6b326aULL, 0x0ULL, 0x68ULL,
+    0x0ULL, 0x706d64ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x6d736c78ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x6e6962ULL, 0x0ULL, 0x6b7061ULL, 0x657061ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x6563617274ULL,
+    0x706d6574ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x63696568ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x746f65ULL,
+    0x65746973626577ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x6d7266ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x66ULL, 0x766f6dULL, 0x0ULL,
+    0x633770ULL, 0x7970ULL, 0x0ULL, 0x0ULL, 0x626163ULL, 0x0ULL,
+    0x0ULL, 0x67646fULL, 0x696665ULL, 0x727563ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x67736dULL, 0x6d70ULL, 0x0ULL, 0x736276ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x787863ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x747372ULL, 0x666473ULL, 0x0ULL, 0x736170ULL, 0x0ULL,
+    0x74736fULL, 0x0ULL, 0x0ULL, 0x6c70ULL, 0x0ULL, 0x73746bULL,
+    0x0ULL, 0x74657571726170ULL, 0x66697661ULL, 0x7370786fULL, 0x726d61ULL, 0x64796dULL,
+    0x0ULL, 0x7862646bULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x75766a64ULL, 0x0ULL, 0x777261ULL, 0x0ULL, 0x0ULL, 0x337263ULL,
+    0x0ULL, 0x0ULL, 0x6363ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x676e70ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x767374ULL, 0x0ULL, 0x6c6d746878ULL,
+    0x0ULL, 0x6c6d79ULL, 0x6264636361ULL, 0x786c6d65ULL, 0x706d646dULL, 0x637474ULL,
+    0x0ULL, 0x666172ULL, 0x0ULL, 0x0ULL, 0x747373ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x70697aULL, 0x0ULL, 0x747263ULL, 0x7a6964ULL,
+    0x0ULL, 0x65706dULL, 0x326733ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x766b6dULL, 0x626670ULL, 0x666974ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x7a6774ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x327273ULL,
+    0x0ULL, 0x0ULL, 0x72616aULL, 0x0ULL, 0x0ULL, 0x6d7072ULL,
+    0x67706aULL, 0x0ULL, 0x0ULL, 0x747070ULL, 0x676e7061ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x6c7275ULL, 0x747665ULL, 0x0ULL, 0x616d7a6cULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x313065ULL,
+    0x0ULL, 0x0ULL, 0x66646dULL, 0x6670ULL, 0x0ULL, 0x0ULL,
+    0x737865ULL, 0x0ULL, 0x0ULL, 0x677067ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x6c7265ULL, 0x737973ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x706870ULL, 0x62646dULL, 0x0ULL, 0x6c6c64ULL, 0x676e64ULL,
+    0x6dULL, 0x0ULL, 0x0ULL, 0x746e66ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x31307865ULL, 0x707063ULL, 0x0ULL,
+    0x0ULL, 0x786574ULL, 0x0ULL, 0x697661ULL, 0x78646876ULL, 0x626f76ULL,
+    0x0ULL, 0x0ULL, 0x676663ULL, 0x62346dULL, 0x0ULL, 0x6964696dULL,
+    0x0ULL, 0x736c78ULL, 0x0ULL, 0x0ULL, 0x657668ULL, 0x316d7370ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x74726170ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x666661ULL, 0x0ULL,
+    0x736a6dULL, 0x62766d72ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x6961ULL, 0x637361ULL, 0x6e6f66ULL, 0x0ULL,
+    0x0ULL, 0x626c74ULL, 0x327263ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x627570ULL, 0x766177ULL,
+    0x7865ULL, 0x69796dULL, 0x70736dULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x66666974ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x616c616373ULL, 0x327a6274ULL,
+    0x0ULL, 0x0ULL, 0x666264ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x7368ULL, 0x0ULL, 0x746bULL, 0x636f64ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x617069ULL, 0x0ULL, 0x706276ULL, 0x746f70ULL, 0x0ULL, 0x0ULL,
+    0x776f6371ULL, 0x61676fULL, 0x0ULL, 0x6769666e6f63ULL, 0x0ULL, 0x0ULL,
+    0x69626f6dULL, 0x0ULL, 0x78737070ULL, 0x0ULL, 0x6c6d7468ULL, 0x0ULL,
+    0x666d77ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x78736aULL, 0x0ULL,
+    0x0ULL, 0x646dULL, 0x0ULL, 0x7466697773ULL, 0x6272ULL, 0x0ULL,
+    0x0ULL, 0x656dULL, 0x736369ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x6d7468ULL, 0x737065ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x737078ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x64ULL, 0x6765706aULL, 0x74736566696e616dULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x7a677673ULL, 0x0ULL, 0x0ULL, 0x66746fULL, 0x0ULL,
+    0x0ULL, 0x63ULL, 0x327a62ULL, 0x0ULL, 0x0ULL, 0x656d64616572ULL,
+    0x7374326dULL, 0x0ULL, 0x0ULL, 0x67706dULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x62736c78ULL, 0x0ULL, 0x0ULL, 0x777970ULL, 0x78736c78ULL,
+    0x0ULL, 0x786370ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x667377ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x647365ULL, 0x0ULL, 0x6d6670ULL, 0x0ULL,
+    0x33777a61ULL, 0x0ULL, 0x6c7473ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x68737aULL, 0x61346dULL, 0x34706dULL, 0x66726fULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x78746f64ULL, 0x0ULL, 0x78747665ULL,
+    0x766d77ULL, 0x6c6d6f74ULL, 0x6a6c63ULL, 0x0ULL, 0x0ULL, 0x6a7261ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x7aULL, 0x76346dULL, 0x69756dULL, 0x0ULL, 0x7963696c6f70ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x7366657270ULL, 0x327772ULL, 0x0ULL, 0x74686dULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x6873ULL, 0x66656eULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x7561ULL, 0x0ULL, 0x0ULL,
+    0x74756fULL, 0x0ULL, 0x7a7874ULL, 0x7365676170ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x687363ULL, 0x737363ULL, 0x646c6fULL, 0x6d6977ULL, 0x3266666f77ULL,
+    0x0ULL, 0x0ULL, 0x746f64ULL, 0x737077ULL, 0x0ULL, 0x7a6cULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x7869736dULL, 0x0ULL, 0x0ULL, 0x6d6863ULL, 0x0ULL,
+    0x313030ULL, 0x0ULL, 0x747370ULL, 0x6d747070ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x78766964ULL, 0x0ULL,
+    0x0ULL, 0x6c786aULL, 0x0ULL, 0x6b6861ULL, 0x72ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x303966ULL, 0x736aULL, 0x0ULL, 0x696476ULL,
+    0x66696568ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x6d616c78ULL, 0x737070ULL,
+    0x706d74ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x64696dULL, 0x676d69ULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x70626577ULL, 0x0ULL, 0x666c65ULL,
+    0x6f7369ULL, 0x0ULL, 0x0ULL, 0x7473696c70ULL, 0x0ULL, 0x79656bULL,
+    0x6c6d65ULL, 0x0ULL, 0x6f67ULL, 0x6f6369ULL, 0x656276ULL, 0x666e70ULL,
+    0x78707061ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+    0x0ULL, 0x0ULL, 0x616774ULL, 0x0ULL, 0x0ULL, 0x706733ULL,
+    0x767264ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x6c6d746873ULL,
+    0x0ULL, 0x0ULL, 0x78636f64ULL, 0x0ULL, 0x0ULL, 0x75736dULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL, 0x6d6dULL,
+    0x0ULL, 0x0ULL, 0x0ULL, 0x0ULL,
+};
+
+static const uint8_t tabla_tipos_tipos[1024] = {
+    19, 10, 0, 0, 0, 17, 16, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 10, 10, 0, 0, 0, 16, 0, 11, 0, 0, 0, 0, 0, 0,
+    18, 0, 0, 17, 2, 0, 0, 0, 0, 0, 0, 0, 17, 0, 0, 4, 0, 18, 10, 17, 0, 26, 0, 28, 11, 0, 0, 0, 4, 0, 28, 0,
+    0, 0, 0, 20, 10, 0, 0, 4, 0, 0, 18, 0, 0, 18, 15, 0, 0, 0, 0, 0, 12, 12, 0, 0, 0, 0, 16, 2, 0, 0, 11, 0,
+    0, 0, 0, 0, 0, 0, 0, 22, 0, 0, 24, 0, 0, 0, 0, 0, 11, 0, 0, 27, 0, 12, 25, 0, 0, 0, 10, 17, 0, 15, 0, 10,
+    0, 0, 16, 0, 25, 0, 0, 22, 0, 0, 13, 0, 0, 0, 21, 16, 0, 0, 9, 0, 0, 16, 0, 0, 21, 0, 0, 0, 0, 4, 0, 14,
+    0, 17, 17, 0, 0, 0, 0, 5, 0, 14, 0, 0, 0, 0, 25, 0, 0, 24, 0, 0, 15, 0, 0, 0, 0, 8, 0, 0, 0, 0, 23, 17,
+    8, 21, 12, 7, 19, 0, 0, 5, 25, 0, 13, 0, 16, 0, 0, 0, 23, 0, 0, 28, 0, 17, 0, 0, 0, 0, 0, 0, 18, 11, 0, 0,
+    0, 0, 0, 19, 0, 0, 0, 18, 0, 15, 0, 28, 0, 0, 0, 0, 0, 0, 0, 0, 15, 0, 0, 12, 0, 0, 4, 9, 0, 9, 11, 4,
+    0, 20, 28, 0, 17, 0, 0, 0, 0, 0, 0, 0, 0, 21, 15, 13, 0, 0, 0, 0, 0, 13, 0, 0, 0, 25, 0, 0, 0, 12, 0, 0,
+    0, 0, 0, 2, 21, 0, 0, 8, 0, 0, 25, 26, 0, 0, 18, 0, 17, 17, 0, 0, 19, 18, 0, 0, 0, 0, 0, 9, 0, 4, 0, 0,
+    0, 2, 0, 13, 0, 0, 0, 19, 15, 0, 0, 0, 0, 0, 4, 14, 10, 0, 4, 0, 0, 21, 4, 0, 0, 0, 0, 0, 0, 0, 0, 15,
+    20, 23, 20, 0, 2, 0, 0, 0, 0, 22, 12, 0, 0, 18, 25, 0, 10, 20, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 12, 0, 13, 0,
+    15, 23, 0, 27, 0, 25, 20, 0, 0, 10, 0, 0, 13, 0, 11, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 26, 0, 0, 15, 11, 0, 0,
+    0, 0, 16, 0, 0, 0, 0, 11, 0, 17, 0, 17, 0, 10, 0, 17, 0, 19, 0, 0, 0, 0, 0, 9, 0, 0, 0, 0, 0, 16, 0, 4,
+    11, 0, 0, 0, 0, 0, 0, 27, 28, 0, 0, 0, 0, 0, 0, 10, 0, 0, 0, 24, 26, 0, 0, 0, 0, 21, 0, 0, 0, 17, 12, 0,
+    25, 17, 0, 0, 13, 0, 0, 15, 4, 10, 0, 0, 0, 0, 22, 17, 0, 18, 0, 0, 0, 0, 0, 17, 0, 0, 0, 0, 0, 0, 0, 2,
+    21, 0, 17, 0, 22, 0, 0, 17, 0, 17, 0, 16, 10, 15, 11, 21, 0, 21, 0, 0, 0, 0, 15, 0, 10, 0, 0, 10, 0, 0, 17, 0,
+    0, 0, 0, 6, 0, 0, 0, 0, 0, 0, 0, 16, 0, 3, 0, 16, 21, 22, 19, 24, 0, 10, 0, 0, 25, 0, 0, 0, 13, 0, 25, 2,
+    0, 12, 12, 0, 0, 0, 12, 24, 10, 0, 0, 0, 0, 13, 0, 0, 0, 10, 0, 0, 4, 0, 0, 4, 5, 0, 0, 14, 6, 0, 0, 0,
+    26, 19, 0, 13, 0, 0, 0, 0, 0, 23, 0, 0, 21, 19, 0, 0, 17, 0, 0, 25, 0, 0, 0, 0, 17, 19, 0, 0, 0, 17, 21, 0,
+    4, 10, 17, 0, 0, 24, 0, 0, 0, 0, 0, 23, 17, 0, 0, 2, 0, 12, 23, 12, 0, 0, 20, 11, 0, 11, 0, 9, 0, 0, 19, 18,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 28, 0, 0, 0, 0, 23, 0, 17, 12, 0, 0, 0, 0, 0, 0, 10, 2, 24, 0, 0, 19,
+    10, 0, 0, 0, 0, 0, 0, 0, 15, 11, 17, 21, 4, 0, 0, 0, 10, 0, 0, 0, 17, 13, 0, 0, 21, 0, 0, 0, 0, 17, 0, 17,
+    8, 0, 0, 0, 0, 0, 0, 0, 4, 0, 17, 14, 0, 0, 23, 11, 0, 20, 0, 0, 15, 0, 14, 0, 3, 0, 10, 0, 0, 0, 17, 0,
+    0, 2, 0, 17, 17, 0, 0, 2, 22, 0, 0, 0, 3, 10, 0, 0, 0, 15, 0, 0, 0, 0, 0, 0, 17, 5, 19, 0, 0, 0, 0, 10,
+    0, 0, 24, 0, 0, 17, 13, 0, 0, 2, 12, 0, 0, 12, 0, 0, 0, 9, 0, 0, 17, 9, 0, 10, 0, 0, 0, 0, 0, 0, 0, 0,
+    18, 0, 0, 0, 0, 0, 0, 0, 0, 0, 23, 0, 24, 0, 15, 0, 25, 0, 0, 0, 0, 0, 18, 11, 12, 10, 0, 0, 0, 8, 0, 19,
+    12, 16, 17, 0, 0, 13, 0, 0, 0, 0, 0, 0, 13, 12, 19, 0, 20, 0, 0, 0, 20, 10, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0,
+    18, 10, 0, 0, 0, 0, 0, 11, 0, 0, 27, 0, 13, 15, 0, 0, 0, 18, 3, 28, 23, 24, 0, 0, 8, 15, 0, 13, 0, 0, 0, 0,
+    0, 0, 0, 4, 0, 0, 15, 0, 13, 0, 22, 14, 0, 0, 0, 0, 0, 0, 12, 0, 0, 10, 0, 18, 17, 0, 0, 0, 17, 17, 0, 23,
+    10, 0, 0, 0, 9, 14, 28, 0, 0, 0, 11, 23, 0, 0, 0, 10, 0, 4, 23, 0, 0, 16, 0, 14, 22, 0, 17, 10, 18, 19, 4, 0,
+    0, 0, 0, 0, 0, 0, 10, 0, 0, 12, 19, 0, 0, 0, 0, 3, 0, 0, 8, 0, 0, 4, 0, 0, 0, 0, 0, 17, 0, 0, 0, 0,
+};
+
+#endif
@@ -0,0 +1,280 @@
+// tallado.c
+#include "tallado.h"
+#include "firmas.h"
+#include "tiposArchivo.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define MAX_HILOS_TALLADO 16
+
+typedef enum { CAB_JPEG, CAB_PNG, CAB_PDF, CAB_ZIP, CAB_SQLITE, NUM_CABECERAS } Cabecera;
+
+// Patron y mascara de 16 bytes por cabecera: se comparan todas a la vez con SSE2
+typedef struct {
+    unsigned char patron[16];
+    unsigned char mascara[16];
+    uint8_t tipo;
+    uint64_t maximo;    // si no aparece el pie se corta aqui
+} FirmaTallado;
+
+static const FirmaTallado cabeceras[NUM_CABECERAS] = {
+    [CAB_JPEG]   = { "\xff\xd8\xff", "\xff\xff\xff", TIPO_JPEG, 32ULL << 20 },
+    [CAB_PNG]    = { "\x89PNG\r\n\x1a\n", "\xff\xff\xff\xff\xff\xff\xff\xff", TIPO_PNG, 64ULL << 20 },
+    [CAB_PDF]    = { "%PDF-", "\xff\xff\xff\xff\xff", TIPO_PDF, 256ULL << 20 },
+    [CAB_ZIP]    = { "PK\x03\x04", "\xff\xff\xff\xff", TIPO_COMPRIMIDO, 1ULL << 30 },
+    [CAB_SQLITE] = { "SQLite format 3\0", "\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff",
+                     TIPO_BASE_DATOS, 1ULL << 30 },
+};
+
+// Devuelve la cabecera que empieza en p (hay al menos 16 bytes) o -1
+static int buscar_cabecera(const unsigned char *p) {
+#ifdef __SSE2__
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    for (int c = 0; c < NUM_CABECERAS; c++) {
+        __m128i m = _mm_loadu_si128((const __m128i *)cabeceras[c].mascara);
+        __m128i x = _mm_cmpeq_epi8(_mm_and_si128(v, m), _mm_loadu_si128((const __m128i *)cabeceras[c].patron));
+        if (_mm_movemask_epi8(x) == 0xffff) return c;
+    }
+#else
+    for (int c = 0; c < NUM_CABECERAS; c++) {
+        int j;
+        for (j = 0; j < 16 && (p[j] & cabeceras[c].mascara[j]) == cabeceras[c].patron[j]; j++) {}
+        if (j == 16) return c;
+    }
+#endif
+    return -1;
+}
+
+// Primera aparicion de pat (m >= 2 bytes) en p; compara el primer y el ultimo byte de 16
+// posiciones a la vez y solo verifica las candidatas
+static const unsigned char *buscar_bytes(const unsigned char *p, size_t n, const char *pat, size_t m) {
+    if (n < m) return NULL;
+    size_t i = 0;
+#ifdef __SSE2__
+    __m128i primero = _mm_set1_epi8(pat[0]);
+    __m128i ultimo = _mm_set1_epi8(pat[m - 1]);
+    for (; i + 16 + m - 1 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(p + i + m - 1));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, primero),
+                                                                  _mm_cmpeq_epi8(b, ultimo)));
+        while (mask) {
+            int bit = __builtin_ctz(mask);
+            if (memcmp(p + i + bit + 1, pat + 1, m - 2) == 0) return p + i + bit;
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i + m <= n; i++) {
+        if (p[i] == (unsigned char)pat[0] && memcmp(p + i + 1, pat + 1, m - 1) == 0) return p + i;
+    }
+    return NULL;
+}
+
+static uint32_t be32(const unsigned char *p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+// Largo del archivo que empieza en p (hasta n bytes disponibles), 0 si no se encontro el fin
+static uint64_t largo_jpeg(const unsigned char *p, uint64_t n) {
+    // se saltan los segmentos por su largo (asi las miniaturas EXIF no cortan el archivo)
+    // y desde el SOS se busca el EOI
+    uint64_t i = 2;
+    while (i + 4 <= n) {
+        if (p[i] != 0xff) return 0;
+        unsigned char marca = p[i + 1];
+        if (marca == 0xff) { i++; continue; }
+        if (marca == 0xda) {
+            const unsigned char *fin = buscar_bytes(p + i, n - i, "\xff\xd9", 2);
+            return fin ? (uint64_t)(fin - p) + 2 : 0;
+        }
+        i += 2 + ((uint64_t)p[i + 2] << 8 | p[i + 3]);
+    }
+    return 0;
+}
+
+static uint64_t largo_png(const unsigned char *p, uint64_t n) {
+    uint64_t i = 8;
+    while (i + 12 <= n) {
+        uint64_t len = be32(p + i);
+        if (memcmp(p + i + 4, "IEND", 4) == 0) return i + 12;
+        i += 12 + len;
+    }
+    return 0;
+}
+
+static uint64_t largo_pdf(const unsigned char *p, uint64_t n) {
+    // el primer %%EOF: una actualizacion incremental posterior queda fuera
+    const unsigned char *fin = buscar_bytes(p, n, "%%EOF", 5);
+    if (!fin) return 0;
+    uint64_t l = (uint64_t)(fin - p) + 5;
+    while (l < n && l < (uint64_t)(fin - p) + 7 && (p[l] == '\r' || p[l] == '\n')) l++;
+    return l;
+}
+
+static uint64_t largo_zip(const unsigned char *p, uint64_t n) {
+    // fin del directorio central + comentario
+    const unsigned char *fin = buscar_bytes(p, n, "PK\x05\x06", 4);
+    if (!fin || (uint64_t)(fin - p) + 22 > n) return 0;
+    uint64_t l = (uint64_t)(fin - p) + 22 + (fin[20] | (uint64_t)fin[21] << 8);
+    return l <= n ? l : 0;
+}
+
+static uint64_t largo_sqlite(const unsigned char *p, uint64_t n) {
+    // el tamano en paginas del header solo vale si "version-valid-for" coincide con el contador
+    uint64_t pagina = (uint64_t)p[16] << 8 | p[17];
+    if (pagina == 1) pagina = 65536;
+    if (pagina < 512 || (pagina & (pagina - 1)) != 0 || n < 100) return 0;
+    if (be32(p + 24) != be32(p + 92) || be32(p + 28) == 0) return 0;
+    uint64_t l = pagina * be32(p + 28);
+    return l <= n ? l : 0;
+}
+
+typedef struct {
+    const unsigned char *map;
+    uint64_t inicio, fin;           // rango total (los pies pueden pasar del trozo)
+    uint64_t bloque_ini, bloque_fin; // bloques que revisa este hilo
+    uint32_t alineacion;
+    const uint8_t *bitmap;
+    Hallazgo *v;
+    size_t n, cap;
+    int error;
+} TrozoTallado;
+
+static int agregar(Hallazgo **v, size_t *n, size_t *cap, const Hallazgo *h) {
+    if (*n == *cap) {
+        size_t nuevo = *cap ? *cap * 2 : 256;
+        Hallazgo *p = realloc(*v, nuevo * sizeof(Hallazgo));
+        if (!p) return -1;
+        *v = p;
+        *cap = nuevo;
+    }
+    (*v)[(*n)++] = *h;
+    return 0;
+}
+
+static void *tallar_trozo(void *arg) {
+    TrozoTallado *tr = arg;
+    for (uint64_t b = tr->bloque_ini; b < tr->bloque_fin; b++) {
+        if (tr->bitmap) {
+            // 64 clusters ocupados seguidos se saltan de una vez
+            if ((b & 63) == 0 && b + 64 <= tr->bloque_fin) {
+                uint64_t w;
+                memcpy(&w, tr->bitmap + (b >> 3), 8);
+                if (w == ~0ULL) {
+                    b += 63;
+                    continue;
+                }
+            }
+            if (tr->bitmap[b >> 3] >> (b & 7) & 1) continue;
+        }
+        uint64_t off = tr->inicio + b * tr->alineacion;
+        if (off + 16 > tr->fin) break;
+        const unsigned char *p = tr->map + off;
+        int c = buscar_cabecera(p);
+        if (c < 0) continue;
+
+        uint64_t disponible = tr->fin - off;
+        if (disponible > cabeceras[c].maximo) disponible = cabeceras[c].maximo;
+        uint64_t largo = 0;
+        switch (c) {
+            case CAB_JPEG:   largo = largo_jpeg(p, disponible); break;
+            case CAB_PNG:    largo = largo_png(p, disponible); break;
+            case CAB_PDF:    largo = largo_pdf(p, disponible); break;
+            case CAB_ZIP:    largo = largo_zip(p, disponible); break;
+            case CAB_SQLITE: largo = largo_sqlite(p, disponible); break;
+        }
+
+        Hallazgo h = { off, largo ? largo : disponible, cabeceras[c].tipo, largo != 0 };
+        if (c == CAB_ZIP) {
+            // docx/xlsx/odt/jar: el tipo sale de los nombres de las primeras entradas
+            h.tipo = detectar_contenido(p, disponible < BYTES_ANALISIS ? disponible : BYTES_ANALISIS, NULL);
+        }
+        if (agregar(&tr->v, &tr->n, &tr->cap, &h) != 0) {
+            tr->error = 1;
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+static int comparar_hallazgos(const void *a, const void *b) {
+    const Hallazgo *x = a, *y = b;
+    return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+int tallar(const unsigned char *map, uint64_t inicio, uint64_t largo, uint32_t alineacion,
+           const uint8_t *bitmap, ResultadoTallado *r) {
+    memset(r, 0, sizeof(*r));
+    if (alineacion < 16) return -1;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    uint64_t bloques = largo / alineacion;
+    long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    int nhilos = nucleos < 1 ? 1 : nucleos > MAX_HILOS_TALLADO ? MAX_HILOS_TALLADO : (int)nucleos;
+    if ((uint64_t)nhilos > bloques) nhilos = bloques ? (int)bloques : 1;
+
+    TrozoTallado trozos[MAX_HILOS_TALLADO];
+    pthread_t hilos[MAX_HILOS_TALLADO];
+    int creados[MAX_HILOS_TALLADO] = { 0 };
+    for (int h = 0; h < nhilos; h++) {
+        trozos[h] = (TrozoTallado){ map, inicio, inicio + largo, bloques * h / nhilos, bloques * (h + 1) / nhilos,
+                                    alineacion, bitmap, NULL, 0, 0, 0 };
+    }
+    for (int h = 1; h < nhilos; h++) {
+        creados[h] = pthread_create(&hilos[h], NULL, tallar_trozo, &trozos[h]) == 0;
+    }
+    tallar_trozo(&trozos[0]);
+    for (int h = 1; h < nhilos; h++) {
+        if (creados[h]) pthread_join(hilos[h], NULL);
+        else tallar_trozo(&trozos[h]);
+    }
+
+    int error = 0;
+    for (int h = 0; h < nhilos; h++) {
+        for (size_t i = 0; i < trozos[h].n && !error; i++) {
+            if (agregar(&r->v, &r->n, &r->cap, &trozos[h].v[i]) != 0) error = 1;
+        }
+        error |= trozos[h].error;
+        free(trozos[h].v);
+    }
+    if (error) {
+        liberar_tallado(r);
+        return -1;
+    }
+    qsort(r->v, r->n, sizeof(Hallazgo), comparar_hallazgos);
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    r->segundos = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    r->bytes = bloques * alineacion;
+    r->hilos = nhilos;
+    return 0;
+}
+
+void liberar_tallado(ResultadoTallado *r) {
+    free(r->v);
+    memset(r, 0, sizeof(*r));
+}
+
+const char *extension_tallado(uint8_t tipo) {
+    switch (tipo) {
+        case TIPO_JPEG:         return "jpg";
+        case TIPO_PNG:          return "png";
+        case TIPO_PDF:          return "pdf";
+        case TIPO_WORD:         return "docx";
+        case TIPO_EXCEL:        return "xlsx";
+        case TIPO_PRESENTACION: return "pptx";
+        case TIPO_DOCUMENTO:    return "odt";
+        case TIPO_EJECUTABLE:   return "jar";
+        case TIPO_BASE_DATOS:   return "sqlite";
+        default:                return "zip";
+    }
+}
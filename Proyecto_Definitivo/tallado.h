@@ -0,0 +1,42 @@
+#ifndef TALLADO_H
+#define TALLADO_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Archivo recuperado por firma (carving): de la cabecera al pie, sin usar el MFT
+typedef struct {
+    uint64_t offset;    // absoluto dentro del mapa
+    uint64_t largo;
+    uint8_t tipo;       // TipoArchivo
+    uint8_t completo;   // 0 si no se encontro el pie y 'largo' es el maximo del tipo
+} Hallazgo;
+
+typedef struct {
+    Hallazgo *v;
+    size_t n, cap;
+    uint64_t bytes;     // bytes de cabeceras revisados (clusters * alineacion)
+    double segundos;
+    int hilos;
+} ResultadoTallado;
+
+// Busca cabeceras JPEG, PNG, PDF, ZIP (y OOXML/ODF/JAR) y SQLite al principio de cada bloque de
+// 'alineacion' bytes en [inicio, inicio + largo) y sigue cada una hasta su pie. Reparte el rango
+// entre todos los nucleos. Si bitmap no es NULL (un bit por bloque, 1 = ocupado) solo mira los
+// bloques libres. Devuelve 0 o -1 si falta memoria; los hallazgos quedan ordenados por offset.
+int tallar(const unsigned char *map, uint64_t inicio, uint64_t largo, uint32_t alineacion,
+           const uint8_t *bitmap, ResultadoTallado *r);
+void liberar_tallado(ResultadoTallado *r);
+
+// Extension sugerida para guardar un hallazgo de ese tipo
+const char *extension_tallado(uint8_t tipo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,293 @@
+// tiposArchivo.c
+//
+// La tabla de extensiones es una tabla hash perfecta (hash y desplazamiento): la extension
+// se empaqueta en un uint64, un primer hash elige la cubeta y el desplazamiento de la cubeta
+// elige la casilla, asi que cada busqueda es una sola comparacion. La tabla inicial se genera
+// a partir de extensiones.def:
+//
+//     gcc -DGENERAR_TABLA_TIPOS tiposArchivo.c -o generar_tipos && ./generar_tipos > tablaTipos.h
+#include "tiposArchivo.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+#define HASH_BITS      10
+#define HASH_CASILLAS  (1u << HASH_BITS)
+#define CUBETAS_BITS   8
+#define HASH_CUBETAS   (1u << CUBETAS_BITS)
+#define MAX_EXTENSIONES (HASH_CASILLAS * 3 / 4) // mas carga y cuesta encontrar desplazamientos
+
+#ifndef GENERAR_TABLA_TIPOS
+#include "tablaTipos.h"
+#endif
+
+static const char *nombres_tipo[NUM_TIPOS] = {
+    "Archivo", "Directorio", "Texto", "HTML", "Ejecutable",
+    "Imagen JPEG", "Imagen PNG", "PDF", "Documento Word", "Hoja de cálculo",
+    "Imagen", "Audio", "Video", "Comprimido", "Presentacion",
+    "Documento", "Datos", "Codigo fuente", "Script", "Sistema",
+    "Configuracion", "Base de datos", "Correo", "Disco virtual", "Fuente",
+    "Certificado", "Acceso directo", "Log", "Temporal"
+};
+
+// tipos agregados desde la configuracion
+static char *nombres_extra[MAX_TIPOS - NUM_TIPOS];
+static int num_tipos = NUM_TIPOS;
+
+const char *nombre_tipo(int tipo) {
+    if (tipo >= 0 && tipo < NUM_TIPOS) return nombres_tipo[tipo];
+    if (tipo >= NUM_TIPOS && tipo < num_tipos) return nombres_extra[tipo - NUM_TIPOS];
+    return nombres_tipo[TIPO_ARCHIVO];
+}
+
+int tipos_total(void) {
+    return num_tipos;
+}
+
+// Extension en minusculas empaquetada en little-endian; 0 si no es ASCII o pasa de 8 bytes
+static uint64_t clave_extension(const char *ext) {
+    uint64_t k = 0;
+    for (int i = 0; ext[i]; i++) {
+        unsigned char c = (unsigned char)ext[i];
+        if (i == 8 || c >= 0x80) return 0;
+        if (c >= 'A' && c <= 'Z') c |= 0x20;
+        k |= (uint64_t)c << (8 * i);
+    }
+    return k;
+}
+
+// Finalizador de MurmurHash3
+static inline uint64_t mezclar(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+static inline unsigned cubeta_hash(uint64_t h) {
+    return (unsigned)(h >> (64 - CUBETAS_BITS));
+}
+
+static inline unsigned casilla_hash(uint64_t h, uint16_t desp) {
+    return (unsigned)(mezclar(h + desp * 0x9e3779b97f4a7c15ULL) >> (64 - HASH_BITS));
+}
+
+typedef struct {
+    uint16_t desp[HASH_CUBETAS];
+    uint64_t claves[HASH_CASILLAS]; // 0 = casilla vacia
+    uint8_t tipos[HASH_CASILLAS];
+} TablaTipos;
+
+#ifndef GENERAR_TABLA_TIPOS
+static const uint16_t *hash_desp = tabla_tipos_desp;
+static const uint64_t *hash_claves = tabla_tipos_claves;
+static const uint8_t *hash_tipos = tabla_tipos_tipos;
+
+uint8_t determinar_tipo_archivo(const char *nombre) {
+    const char *ext = strrchr(nombre, '.');
+    if (!ext) return TIPO_ARCHIVO;
+
+    uint64_t k = clave_extension(ext + 1); // saltar el punto
+    if (k == 0) return TIPO_ARCHIVO;
+    uint64_t h = mezclar(k);
+    unsigned i = casilla_hash(h, hash_desp[cubeta_hash(h)]);
+    return hash_claves[i] == k ? hash_tipos[i] : TIPO_ARCHIVO;
+}
+#endif
+
+// Busca un desplazamiento por cubeta (de la mas llena a la mas vacia) tal que ninguna
+// clave choque. Devuelve 0 o -1 si alguna cubeta no encuentra lugar.
+static int construir_tabla(const uint64_t *claves, const uint8_t *tipos, size_t n, TablaTipos *t) {
+    static unsigned tam[HASH_CUBETAS], orden[HASH_CUBETAS];
+    static uint32_t miembros[MAX_EXTENSIONES];
+    unsigned inicio[HASH_CUBETAS + 1];
+
+    if (n > MAX_EXTENSIONES) return -1;
+    memset(t, 0, sizeof(*t));
+    memset(tam, 0, sizeof(tam));
+    for (size_t i = 0; i < n; i++) tam[cubeta_hash(mezclar(claves[i]))]++;
+    inicio[0] = 0;
+    for (unsigned b = 0; b < HASH_CUBETAS; b++) inicio[b + 1] = inicio[b] + tam[b];
+    unsigned pos[HASH_CUBETAS];
+    memcpy(pos, inicio, sizeof(pos));
+    for (size_t i = 0; i < n; i++) miembros[pos[cubeta_hash(mezclar(claves[i]))]++] = (uint32_t)i;
+
+    // cubetas de mayor a menor (insercion: son pocas y esto corre una vez)
+    for (unsigned b = 0; b < HASH_CUBETAS; b++) {
+        unsigned j = b;
+        for (; j > 0 && tam[orden[j - 1]] < tam[b]; j--) orden[j] = orden[j - 1];
+        orden[j] = b;
+    }
+
+    for (unsigned o = 0; o < HASH_CUBETAS && tam[orden[o]]; o++) {
+        unsigned b = orden[o];
+        unsigned casillas[HASH_CASILLAS];
+        uint32_t d;
+        for (d = 0; d <= 0xffff; d++) {
+            unsigned j;
+            for (j = inicio[b]; j < inicio[b + 1]; j++) {
+                unsigned c = casilla_hash(mezclar(claves[miembros[j]]), (uint16_t)d);
+                if (t->claves[c]) break;
+                unsigned m;
+                for (m = 0; m < j - inicio[b] && casillas[m] != c; m++) {}
+                if (m < j - inicio[b]) break;
+                casillas[j - inicio[b]] = c;
+            }
+            if (j == inicio[b + 1]) break;
+        }
+        if (d > 0xffff) return -1;
+        t->desp[b] = (uint16_t)d;
+        for (unsigned j = inicio[b]; j < inicio[b + 1]; j++) {
+            t->claves[casillas[j - inicio[b]]] = claves[miembros[j]];
+            t->tipos[casillas[j - inicio[b]]] = tipos[miembros[j]];
+        }
+    }
+    return 0;
+}
+
+#ifndef GENERAR_TABLA_TIPOS
+static int buscar_tipo_por_nombre(const char *nombre) {
+    for (int i = 0; i < num_tipos; i++) {
+        if (strcasecmp(nombre_tipo(i), nombre) == 0) return i;
+    }
+    return -1;
+}
+
+int cargar_tipos_config(const char *ruta, int *linea_error) {
+    static TablaTipos nueva; // queda en uso despues de cargar
+    static uint64_t claves[MAX_EXTENSIONES];
+    static uint8_t tipos[MAX_EXTENSIONES];
+
+    FILE *f = fopen(ruta, "r");
+    if (!f) return -1;
+
+    // se parte de las extensiones que ya estan en la tabla
+    size_t n = 0;
+    for (unsigned i = 0; i < HASH_CASILLAS; i++) {
+        if (hash_claves[i]) {
+            claves[n] = hash_claves[i];
+            tipos[n++] = hash_tipos[i];
+        }
+    }
+
+    char linea[256];
+    int num_linea = 0, aplicadas = 0, res = 0;
+    while (fgets(linea, sizeof(linea), f)) {
+        num_linea++;
+        char *p = linea;
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '#' || *p == '\0') continue;
+
+        char *ext = p;
+        while (*p && !isspace((unsigned char)*p)) p++;
+        if (*p) *p++ = '\0';
+        while (isspace((unsigned char)*p)) p++;
+        char *nom = p;
+        size_t largo = strlen(nom);
+        while (largo > 0 && isspace((unsigned char)nom[largo - 1])) nom[--largo] = '\0';
+
+        if (*ext == '.') ext++;
+        uint64_t k = clave_extension(ext);
+        if (k == 0 || largo == 0) {
+            res = -2;
+            break;
+        }
+
+        int tipo = buscar_tipo_por_nombre(nom);
+        if (tipo < 0) {
+            if (num_tipos == MAX_TIPOS) {
+                res = -3;
+                break;
+            }
+            char *copia = strdup(nom);
+            if (!copia) {
+                res = -3;
+                break;
+            }
+            nombres_extra[num_tipos - NUM_TIPOS] = copia;
+            tipo = num_tipos++;
+        }
+
+        // una extension repetida cambia de tipo; si no, se agrega al final
+        size_t i;
+        for (i = 0; i < n && claves[i] != k; i++) {}
+        if (i == n) {
+            if (n == MAX_EXTENSIONES) {
+                res = -3;
+                break;
+            }
+            claves[n++] = k;
+        }
+        tipos[i] = (uint8_t)tipo;
+        aplicadas++;
+    }
+    fclose(f);
+    if (res != 0) {
+        if (linea_error) *linea_error = num_linea;
+        return res;
+    }
+
+    if (construir_tabla(claves, tipos, n, &nueva) != 0) return -3;
+    hash_desp = nueva.desp;
+    hash_claves = nueva.claves;
+    hash_tipos = nueva.tipos;
+    return aplicadas;
+}
+#else
+
+// Generador de tablaTipos.h a partir de extensiones.def
+int main(void) {
+    static const struct { const char *ext; TipoArchivo tipo; } lista[] = {
+#define EXT(e, t) { e, t },
+#include "extensiones.def"
+#undef EXT
+    };
+    size_t n = sizeof(lista) / sizeof(lista[0]);
+    static uint64_t claves[MAX_EXTENSIONES];
+    static uint8_t tipos[MAX_EXTENSIONES];
+    static TablaTipos t;
+
+    if (n > MAX_EXTENSIONES) {
+        fprintf(stderr, "demasiadas extensiones (%zu)\n", n);
+        return 1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        claves[i] = clave_extension(lista[i].ext);
+        tipos[i] = (uint8_t)lista[i].tipo;
+        if (claves[i] == 0) {
+            fprintf(stderr, "extension no valida: %s\n", lista[i].ext);
+            return 1;
+        }
+        for (size_t j = 0; j < i; j++) {
+            if (claves[j] == claves[i]) {
+                fprintf(stderr, "extension repetida: %s\n", lista[i].ext);
+                return 1;
+            }
+        }
+    }
+    if (construir_tabla(claves, tipos, n, &t) != 0) {
+        fprintf(stderr, "no se encontro una tabla perfecta\n");
+        return 1;
+    }
+
+    printf("// tablaTipos.h: generado por tiposArchivo.c (-DGENERAR_TABLA_TIPOS) desde extensiones.def.\n");
+    printf("// No editar a mano. %zu extensiones en %u casillas.\n", n, HASH_CASILLAS);
+    printf("#ifndef TABLATIPOS_H\n#define TABLATIPOS_H\n\n");
+    printf("static const uint16_t tabla_tipos_desp[%u] = {\n", HASH_CUBETAS);
+    for (unsigned i = 0; i < HASH_CUBETAS; i++)
+        printf("%s%u,%s", i % 16 ? " " : "    ", t.desp[i], i % 16 == 15 ? "\n" : "");
+    printf("};\n\nstatic const uint64_t tabla_tipos_claves[%u] = {\n", HASH_CASILLAS);
+    for (unsigned i = 0; i < HASH_CASILLAS; i++)
+        printf("%s0x%llxULL,%s", i % 6 ? " " : "    ", (unsigned long long)t.claves[i], i % 6 == 5 ? "\n" : "");
+    printf("%s};\n\nstatic const uint8_t tabla_tipos_tipos[%u] = {\n", HASH_CASILLAS % 6 ? "\n" : "", HASH_CASILLAS);
+    for (unsigned i = 0; i < HASH_CASILLAS; i++)
+        printf("%s%u,%s", i % 32 ? " " : "    ", t.tipos[i], i % 32 == 31 ? "\n" : "");
+    printf("};\n\n#endif\n");
+    return 0;
+}
+#endif
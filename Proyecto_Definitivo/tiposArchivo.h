@@ -0,0 +1,66 @@
+#ifndef TIPOSARCHIVO_H
+#define TIPOSARCHIVO_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Tipo de archivo compacto (cabe en un byte de la tabla del MFT)
+typedef enum {
+    TIPO_ARCHIVO = 0,   // sin extension o desconocida
+    TIPO_DIRECTORIO,
+    TIPO_TEXTO,
+    TIPO_HTML,
+    TIPO_EJECUTABLE,
+    TIPO_JPEG,
+    TIPO_PNG,
+    TIPO_PDF,
+    TIPO_WORD,
+    TIPO_EXCEL,
+    TIPO_IMAGEN,        // otras imagenes
+    TIPO_AUDIO,
+    TIPO_VIDEO,
+    TIPO_COMPRIMIDO,
+    TIPO_PRESENTACION,
+    TIPO_DOCUMENTO,     // otros documentos (odt, rtf, epub...)
+    TIPO_DATOS,         // csv, json, xml...
+    TIPO_CODIGO,
+    TIPO_SCRIPT,
+    TIPO_SISTEMA,       // sys, drv, cat, mui...
+    TIPO_CONFIG,
+    TIPO_BASE_DATOS,
+    TIPO_CORREO,
+    TIPO_DISCO_VIRTUAL,
+    TIPO_FUENTE,
+    TIPO_CERTIFICADO,
+    TIPO_ACCESO_DIRECTO,
+    TIPO_LOG,
+    TIPO_TEMPORAL,
+    NUM_TIPOS
+} TipoArchivo;
+
+// Los tipos que se definen en el archivo de configuracion van despues de NUM_TIPOS;
+// como mucho 64 en total para que el filtro los guarde en una mascara de 64 bits
+#define MAX_TIPOS 64
+
+// Clasifica un nombre de archivo por su extension. Tiempo constante y sin reservar memoria:
+// la extension (hasta 8 bytes) se empaqueta en un entero y se busca en una tabla hash perfecta.
+uint8_t determinar_tipo_archivo(const char *nombre);
+const char *nombre_tipo(int tipo);
+
+// Numero de tipos validos (NUM_TIPOS mas los agregados desde la configuracion)
+int tipos_total(void);
+
+// Lee lineas "extension Nombre del tipo" ('#' comenta) y reconstruye la tabla hash con las
+// extensiones agregadas o cambiadas; un nombre de tipo que no existe crea un tipo nuevo.
+// Devuelve cuantas lineas se aplicaron, -1 si no se pudo abrir, -2 si una linea no se
+// entiende (queda en *linea_error) o -3 si hay demasiados tipos o extensiones.
+int cargar_tipos_config(const char *ruta, int *linea_error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,266 @@
+// usnJrnl.c
+#include "usnJrnl.h"
+#include "exportar.h"
+#include "extraer.h"
+#include "fechas.h"
+#include "utf16.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#define REGISTRO_EXTEND   11
+#define LARGO_RUTA        4096
+#define RUTAS_CACHE       1024          // rutas de directorios padre recordadas (mapeo directo)
+#define ADELANTO_USN      (32u << 20)   // cuanto se pide por adelantado al kernel (madvise)
+#define MAX_REGISTRO_USN  65536
+#define MIN_REGISTRO_V2   60
+#define MIN_REGISTRO_V3   76
+#define MAX_NOMBRE_NTFS   255           // unidades UTF-16
+
+static double ahora_seg(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint16_t leer16(const unsigned char *p) { return (uint16_t)(p[0] | p[1] << 8); }
+static uint32_t leer32(const unsigned char *p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; }
+static uint64_t leer64(const unsigned char *p) { return leer32(p) | (uint64_t)leer32(p + 4) << 32; }
+
+long buscar_usn_jrnl(const TablaMft *t) {
+    long elegido = -1;
+    for (size_t k = 0; k < t->n; k++) {
+        if (t->padre[k] != REGISTRO_EXTEND || strcmp(tabla_nombre(t, k), "$UsnJrnl") != 0) continue;
+        for (uint32_t f = t->flujo_ini[k]; f < t->flujo_ini[k] + t->flujo_cnt[k]; f++) {
+            if (strcmp(flujo_nombre(t, f), "$J") != 0) continue;
+            // uno vivo gana a uno borrado
+            if (elegido < 0 || !(t->marcas[k] & MARCA_BORRADO)) elegido = (long)f;
+        }
+    }
+    return elegido;
+}
+
+static const struct {
+    uint32_t bit;
+    const char *nombre;
+} RAZONES[] = {
+    { 0x00000001, "DATA_OVERWRITE" },      { 0x00000002, "DATA_EXTEND" },
+    { 0x00000004, "DATA_TRUNCATION" },     { 0x00000010, "NAMED_DATA_OVERWRITE" },
+    { 0x00000020, "NAMED_DATA_EXTEND" },   { 0x00000040, "NAMED_DATA_TRUNCATION" },
+    { 0x00000100, "FILE_CREATE" },         { 0x00000200, "FILE_DELETE" },
+    { 0x00000400, "EA_CHANGE" },           { 0x00000800, "SECURITY_CHANGE" },
+    { 0x00001000, "RENAME_OLD_NAME" },     { 0x00002000, "RENAME_NEW_NAME" },
+    { 0x00004000, "INDEXABLE_CHANGE" },    { 0x00008000, "BASIC_INFO_CHANGE" },
+    { 0x00010000, "HARD_LINK_CHANGE" },    { 0x00020000, "COMPRESSION_CHANGE" },
+    { 0x00040000, "ENCRYPTION_CHANGE" },   { 0x00080000, "OBJECT_ID_CHANGE" },
+    { 0x00100000, "REPARSE_POINT_CHANGE" }, { 0x00200000, "STREAM_CHANGE" },
+    { 0x00400000, "TRANSACTED_CHANGE" },   { 0x00800000, "INTEGRITY_CHANGE" },
+    { 0x80000000, "CLOSE" },
+};
+
+static void escribir_razones(FILE *out, uint32_t r) {
+    int primero = 1;
+    for (size_t i = 0; i < sizeof(RAZONES) / sizeof(RAZONES[0]); i++) {
+        if (!(r & RAZONES[i].bit)) continue;
+        if (!primero) fputc('|', out);
+        fputs(RAZONES[i].nombre, out);
+        primero = 0;
+        r &= ~RAZONES[i].bit;
+    }
+    if (r) fprintf(out, "%s0x%x", primero ? "" : "|", r); // bits sin nombre
+}
+
+typedef struct {
+    const TablaMft *t;
+    IndiceRegistros ix;
+    struct {
+        uint64_t ref;       // referencia completa (con secuencia); 0 = vacia
+        char *ruta;
+    } cache[RUTAS_CACHE];
+    FILE *out;
+    EstadisticaUsn *est;
+} ContextoUsn;
+
+// Ruta del directorio con referencia 'ref' (registro + secuencia), recordada por referencia: los
+// registros seguidos del journal suelen caer en los mismos directorios
+static const char *ruta_padre(ContextoUsn *c, uint64_t ref) {
+    size_t h = (size_t)((ref * 0x9E3779B97F4A7C15ULL) >> 54) % RUTAS_CACHE;
+    if (c->cache[h].ref == ref && c->cache[h].ruta) return c->cache[h].ruta;
+
+    char ruta[LARGO_RUTA];
+    const TablaMft *t = c->t;
+    uint64_t reg = ref & 0xFFFFFFFFFFFFULL;
+    uint16_t sec = (uint16_t)(ref >> 48);
+    uint32_t f = reg < c->ix.n ? c->ix.fila[reg] : SIN_PADRE;
+    // al borrar un registro NTFS sube su secuencia: un padre borrado puede tener la esperada + 1
+    if (f == SIN_PADRE || !t->es_dir[f] ||
+        (sec != 0 && sec != t->secuencia[f] &&
+         !((t->marcas[f] & MARCA_BORRADO) && (uint16_t)(sec + 1) == t->secuencia[f]))) {
+        snprintf(ruta, sizeof(ruta), "/$OrphanFiles");
+    } else {
+        ruta_completa(t, &c->ix, f, ruta, sizeof(ruta));
+        if (strcmp(ruta, "/") == 0) ruta[0] = '\0'; // la raiz: "/nombre", no "//nombre"
+    }
+    char *copia = strdup(ruta);
+    if (!copia) return "/$OrphanFiles";
+    free(c->cache[h].ruta);
+    c->cache[h].ref = ref;
+    c->cache[h].ruta = copia;
+    return copia;
+}
+
+// Interpreta el registro en p (ya se sabe que entra entero). Devuelve 0 o -1 si no es valido.
+static int registro_usn(ContextoUsn *c, const unsigned char *p, uint32_t largo) {
+    uint16_t mayor = leer16(p + 4);
+    uint64_t ref, padre, usn, fecha;
+    uint32_t razon, atributos;
+    uint16_t nombre_len, nombre_off;
+    if (mayor == 2) {
+        if (largo < MIN_REGISTRO_V2) return -1;
+        ref = leer64(p + 8);
+        padre = leer64(p + 16);
+        usn = leer64(p + 24);
+        fecha = leer64(p + 32);
+        razon = leer32(p + 40);
+        atributos = leer32(p + 52);
+        nombre_len = leer16(p + 56);
+        nombre_off = leer16(p + 58);
+    } else if (mayor == 3) {
+        // referencias de 128 bits; en NTFS la parte alta es 0 y la baja es la de siempre
+        if (largo < MIN_REGISTRO_V3) return -1;
+        ref = leer64(p + 8);
+        padre = leer64(p + 24);
+        usn = leer64(p + 40);
+        fecha = leer64(p + 48);
+        razon = leer32(p + 56);
+        atributos = leer32(p + 68);
+        nombre_len = leer16(p + 72);
+        nombre_off = leer16(p + 74);
+        c->est->v3++;
+    } else {
+        return -1;
+    }
+    if ((nombre_len & 1) || nombre_len > 2 * MAX_NOMBRE_NTFS || (uint32_t)nombre_off + nombre_len > largo) return -1;
+
+    char nombre[UTF8_MAX_BYTES(MAX_NOMBRE_NTFS) + 1], fecha_txt[FECHA_LARGO_PREC + 1];
+    uint16_t nombre16[MAX_NOMBRE_NTFS];
+    memcpy(nombre16, p + nombre_off, nombre_len); // puede no estar alineado
+    nombre[utf16le_a_utf8(nombre16, nombre_len / 2, nombre)] = '\0';
+    filetime_to_str_prec(fecha, 7, fecha_txt, sizeof(fecha_txt));
+
+    FILE *out = c->out;
+    fprintf(out, "%llu,%s,", (unsigned long long)usn, fecha_txt);
+    escribir_razones(out, razon);
+    fprintf(out, ",%llu,%u,%llu,0x%08x,%u,", (unsigned long long)(ref & 0xFFFFFFFFFFFFULL), (unsigned)(ref >> 48),
+            (unsigned long long)(padre & 0xFFFFFFFFFFFFULL), atributos, mayor);
+    char ruta[LARGO_RUTA + sizeof(nombre) + 1];
+    snprintf(ruta, sizeof(ruta), "%s/%s", ruta_padre(c, padre), nombre);
+    escribir_campo_csv(out, ruta);
+    fputc('\n', out);
+    c->est->registros++;
+    return 0;
+}
+
+// Pide al kernel [off, off + largo) del mapa antes de recorrerlo
+static void adelantar(const VolumenNtfs *v, long long off, uint64_t largo) {
+    uintptr_t ini = (uintptr_t)(v->map + off) & ~(uintptr_t)4095;
+    uintptr_t fin = (uintptr_t)(v->map + off + largo);
+    madvise((void *)ini, fin - ini, MADV_WILLNEED);
+}
+
+int exportar_usn(const VolumenNtfs *v, const TablaMft *t, size_t flujo, FILE *out, EstadisticaUsn *est) {
+    memset(est, 0, sizeof(*est));
+    double inicio = ahora_seg();
+    ContextoUsn *c = calloc(1, sizeof(ContextoUsn));
+    if (!c) return -1;
+    c->t = t;
+    c->out = out;
+    c->est = est;
+    if (indice_registros(t, &c->ix) != 0) {
+        free(c);
+        return -1;
+    }
+    const Extent *ext = t->flujo_tramos + t->flujo_tramo_ini[flujo];
+    int n = (int)t->flujo_tramo_n[flujo];
+    uint64_t tamano = t->flujo_tamano[flujo];
+    LectorTramos lt;
+    tramos_abrir(&lt, v, ext, n, tamano);
+    unsigned char *cruce = malloc(MAX_REGISTRO_USN); // registro partido entre dos tramos
+    if (!cruce) {
+        liberar_indice_registros(&c->ix);
+        free(c);
+        return -1;
+    }
+
+    fprintf(out, "usn,fecha,razones,registro,secuencia,padre,atributos,version,ruta\n");
+    uint64_t tc = v->tam_cluster;
+    uint64_t siguiente = 0; // posicion logica del proximo registro: uno partido ya se leyo entero
+    for (int e = 0; e < n; e++) {
+        uint64_t desde = (uint64_t)ext[e].vcn * tc, hasta = desde + ext[e].len * tc;
+        if (desde >= tamano) break;
+        if (hasta > tamano) hasta = tamano;
+        if (ext[e].lcn < 0) {
+            // disperso: lo purgado del principio del journal, no se lee
+            est->bytes_dispersos += hasta - desde;
+            continue;
+        }
+        long long fisico = v->base + ext[e].lcn * (long long)tc;
+        if (fisico < 0 || fisico + (long long)(hasta - desde) > v->map_size) continue;
+        const unsigned char *p = v->map + fisico;
+        est->bytes_datos += hasta - desde;
+
+        // los registros van alineados a 8 bytes y un hueco de ceros rellena el final de cada pagina
+        uint64_t pos = desde > siguiente ? desde : siguiente, adelantado = pos;
+        while (pos + 8 <= hasta) {
+            if (pos >= adelantado) {
+                uint64_t k = hasta - pos < ADELANTO_USN ? hasta - pos : ADELANTO_USN;
+                adelantar(v, fisico + (long long)(pos - desde), k);
+                adelantado = pos + k;
+            }
+            const unsigned char *r = p + (pos - desde);
+            uint32_t largo = leer32(r);
+            if (largo == 0) {
+                pos += 8;
+                continue;
+            }
+            uint16_t mayor = leer16(r + 4);
+            if (largo < 8 || (largo & 7) || largo > MAX_REGISTRO_USN) {
+                est->invalidos++;
+                pos += 8;
+                continue;
+            }
+            const unsigned char *dato = r;
+            if (pos + largo > hasta) {
+                // sigue en el tramo siguiente (clusters de menos de una pagina)
+                if (pos + largo > tamano || tramos_leer(&lt, pos, cruce, largo) != largo) break;
+                dato = cruce;
+            }
+            if (mayor != 2 && mayor != 3) {
+                if (mayor == 4) {
+                    est->otros++; // V4: rangos modificados, sin nombre
+                    pos += largo;
+                } else {
+                    est->invalidos++;
+                    pos += 8;
+                }
+                continue;
+            }
+            if (registro_usn(c, dato, largo) != 0) {
+                est->invalidos++;
+                pos += 8;
+                continue;
+            }
+            pos += largo;
+        }
+        siguiente = pos;
+    }
+
+    for (int i = 0; i < RUTAS_CACHE; i++) free(c->cache[i].ruta);
+    liberar_indice_registros(&c->ix);
+    free(c);
+    free(cruce);
+    est->segundos = ahora_seg() - inicio;
+    return ferror(out) ? -2 : 0;
+}
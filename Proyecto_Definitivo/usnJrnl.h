@@ -0,0 +1,39 @@
+#ifndef USNJRNL_H
+#define USNJRNL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "ntfsVolumen.h"
+#include "tablaMft.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint64_t registros;     // USN_RECORD_V2 y V3 escritos
+    uint64_t v3;
+    uint64_t otros;         // versiones que no se interpretan (V4: rangos), se saltean
+    uint64_t invalidos;     // posiciones de 8 bytes descartadas buscando el siguiente registro
+    uint64_t bytes_datos;   // bytes de $J con clusters asignados que se recorrieron
+    uint64_t bytes_dispersos; // prefijo disperso (ya purgado) que no se leyo
+    double segundos;
+} EstadisticaUsn;
+
+// Flujo $J de $Extend\$UsnJrnl en la tabla (indice en las columnas flujo_*), o -1 si no esta
+long buscar_usn_jrnl(const TablaMft *t);
+
+// Recorre $J siguiendo su runlist: los tramos dispersos (lo que el journal ya purgo) se saltean
+// sin leerlos y los asignados se leen directo del mapa. Escribe un CSV con una linea por
+// USN_RECORD_V2/V3 (usn, fecha UTC, razones, registro, secuencia, registro padre, atributos,
+// version, ruta) donde la ruta sale del directorio padre segun la tabla; si el padre ya no existe
+// o se reuso queda bajo "/$OrphanFiles". Devuelve 0, -1 si falta memoria o -2 si fallo la escritura.
+int exportar_usn(const VolumenNtfs *v, const TablaMft *t, size_t flujo, FILE *out, EstadisticaUsn *est);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
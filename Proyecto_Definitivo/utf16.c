@@ -0,0 +1,105 @@
+// utf16.c
+#include "utf16.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__SSE2__)
+#include <immintrin.h>
+#define UTF16_SIMD 1
+#endif
+
+// Convierte un caracter que no es ASCII. Devuelve cuantas unidades de entrada consumio.
+static inline size_t convertir_unidad(const uint16_t *in, size_t resto, char **pout) {
+    unsigned char *o = (unsigned char *)*pout;
+    uint32_t c = in[0];
+    size_t usadas = 1;
+
+    if (c >= 0xD800 && c <= 0xDBFF && resto > 1 && in[1] >= 0xDC00 && in[1] <= 0xDFFF) {
+        c = 0x10000 + ((c - 0xD800) << 10) + (in[1] - 0xDC00);
+        usadas = 2;
+    }
+
+    if (c < 0x80) {
+        *o++ = (unsigned char)c;
+    } else if (c < 0x800) {
+        *o++ = 0xC0 | (c >> 6);
+        *o++ = 0x80 | (c & 0x3F);
+    } else if (c < 0x10000) { // incluye sustitutos sueltos
+        *o++ = 0xE0 | (c >> 12);
+        *o++ = 0x80 | ((c >> 6) & 0x3F);
+        *o++ = 0x80 | (c & 0x3F);
+    } else {
+        *o++ = 0xF0 | (c >> 18);
+        *o++ = 0x80 | ((c >> 12) & 0x3F);
+        *o++ = 0x80 | ((c >> 6) & 0x3F);
+        *o++ = 0x80 | (c & 0x3F);
+    }
+    *pout = (char *)o;
+    return usadas;
+}
+
+size_t utf16le_a_utf8_escalar(const uint16_t *in, size_t n, char *out) {
+    char *o = out;
+    size_t i = 0;
+    while (i < n) {
+        if (in[i] < 0x80) *o++ = (char)in[i++];
+        else i += convertir_unidad(in + i, n - i, &o);
+    }
+    return (size_t)(o - out);
+}
+
+#ifdef UTF16_SIMD
+// 16 unidades por vuelta; solo si las 16 son ASCII, si no se sigue con el camino escalar
+__attribute__((target("avx2")))
+static size_t ascii_avx2(const uint16_t *in, size_t n, char *out) {
+    size_t i = 0;
+    const __m256i alto = _mm256_set1_epi16((short)0xFF80);
+    for (; i + 16 <= n; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(in + i));
+        if (!_mm256_testz_si256(v, alto)) break;
+        // packus trabaja por mitades de 128 bits: se empaqueta y se juntan las dos mitades
+        __m256i p = _mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), 0x08);
+        _mm_storeu_si128((__m128i *)(out + i), _mm256_castsi256_si128(p));
+    }
+    return i;
+}
+
+static size_t ascii_sse2(const uint16_t *in, size_t n, char *out) {
+    size_t i = 0;
+    const __m128i alto = _mm_set1_epi16((short)0xFF80);
+    const __m128i cero = _mm_setzero_si128();
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, alto), cero)) != 0xFFFF) break;
+        _mm_storel_epi64((__m128i *)(out + i), _mm_packus_epi16(v, v));
+    }
+    return i;
+}
+
+typedef size_t (*FnAscii)(const uint16_t *, size_t, char *);
+
+static FnAscii elegir_ascii(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? ascii_avx2 : ascii_sse2;
+}
+#endif
+
+size_t utf16le_a_utf8(const uint16_t *in, size_t n, char *out) {
+#ifdef UTF16_SIMD
+    static FnAscii ascii = NULL;
+    if (!ascii) ascii = elegir_ascii();
+#endif
+    char *o = out;
+    size_t i = 0;
+    while (i < n) {
+#ifdef UTF16_SIMD
+        size_t k = ascii(in + i, n - i, o);
+        i += k;
+        o += k;
+#endif
+        // resto del tramo (o cola de menos de 8 unidades) y el caracter no ASCII que lo corto
+        while (i < n && in[i] < 0x80) *o++ = (char)in[i++];
+        if (i < n) i += convertir_unidad(in + i, n - i, &o);
+    }
+    return (size_t)(o - out);
+}
@@ -0,0 +1,27 @@
+#ifndef UTF16_H
+#define UTF16_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Peor caso de bytes UTF-8 para n unidades UTF-16 (sin contar el '\0')
+#define UTF8_MAX_BYTES(n) ((size_t)(n) * 3)
+
+// Convierte n unidades UTF-16LE (nombres NTFS) a UTF-8 sin perder nada: los pares
+// sustitutos se combinan y un sustituto suelto se codifica tal cual (WTF-8) en vez de
+// cambiarlo por '?'. 'out' debe tener UTF8_MAX_BYTES(n) bytes. Devuelve los bytes escritos,
+// no agrega '\0'. Los tramos ASCII se copian con SSE2/AVX2 si la CPU los tiene.
+size_t utf16le_a_utf8(const uint16_t *in, size_t n, char *out);
+
+// Misma conversion byte a byte, sin vectorizar (referencia para medir)
+size_t utf16le_a_utf8_escalar(const uint16_t *in, size_t n, char *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -107,7 +107,7 @@ void recorrer_mft(unsigned char *map, unsigned int lba_inicio);
 uint32_t read_uint32_le(const unsigned char *data);
 uint64_t read_uint64_le(const unsigned char *data);
 uint16_t read_uint16_le(const unsigned char *data);
-void unicode_to_ascii(const uint16_t *unicode, char *ascii, int len);
+void unicode_to_utf8(const uint16_t *unicode, int len, char *out, size_t out_sz);
 void determinar_tipo_archivo(const char *nombre, char *tipo);
 
 // Función principal
@@ -312,7 +312,7 @@ void recorrer_mft(unsigned char *map, unsigned int lba_inicio) {
         
         if (memcmp(mft_file->szSignature, "FILE", 4) != 0) continue;
         
-        char nombre[256] = "(sin nombre)";
+        char nombre[256 * 3] = "(sin nombre)";
         char tipo[16] = "Archivo";
         char atributos[64] = "";
         int tiene_nombre_valido = 0;
@@ -325,7 +325,7 @@ void recorrer_mft(unsigned char *map, unsigned int lba_inicio) {
             if (attr->dwType == 0x30) { // $FILE_NAME
                 if (attr->uchNonResFlag == 0) {
                     ATTR_FILENAME *fn = (ATTR_FILENAME *)((char *)attr + attr->Attr.Resident.wAttrOffset);
-                    unicode_to_ascii(fn->wFilename, nombre, fn->chFileNameLength);
+                    unicode_to_utf8(fn->wFilename, fn->chFileNameLength, nombre, sizeof(nombre));
                     tiene_nombre_valido = 1;
                     
                     // Verificar si es directorio (bit 4 en dwFlags)
@@ -377,11 +377,33 @@ void recorrer_mft(unsigned char *map, unsigned int lba_inicio) {
     getch();
 }
 
-void unicode_to_ascii(const uint16_t *unicode, char *ascii, int len) {
-    for (int i = 0; i < len && i < 255; i++) {
-        ascii[i] = (unicode[i] < 128) ? (char)unicode[i] : '?';
+// UTF-16LE -> UTF-8 combinando pares sustitutos; nunca escribe mas de out_sz bytes
+void unicode_to_utf8(const uint16_t *unicode, int len, char *out, size_t out_sz) {
+    size_t o = 0;
+    for (int i = 0; i < len; i++) {
+        uint32_t c = unicode[i];
+        if (c >= 0xD800 && c <= 0xDBFF && i + 1 < len && unicode[i + 1] >= 0xDC00 && unicode[i + 1] <= 0xDFFF) {
+            c = 0x10000 + ((c - 0xD800) << 10) + (unicode[++i] - 0xDC00);
+        }
+        size_t n = (c < 0x80) ? 1 : (c < 0x800) ? 2 : (c < 0x10000) ? 3 : 4;
+        if (o + n >= out_sz) break;
+        if (n == 1) {
+            out[o++] = (char)c;
+        } else if (n == 2) {
+            out[o++] = (char)(0xC0 | (c >> 6));
+            out[o++] = (char)(0x80 | (c & 0x3F));
+        } else if (n == 3) {
+            out[o++] = (char)(0xE0 | (c >> 12));
+            out[o++] = (char)(0x80 | ((c >> 6) & 0x3F));
+            out[o++] = (char)(0x80 | (c & 0x3F));
+        } else {
+            out[o++] = (char)(0xF0 | (c >> 18));
+            out[o++] = (char)(0x80 | ((c >> 12) & 0x3F));
+            out[o++] = (char)(0x80 | ((c >> 6) & 0x3F));
+            out[o++] = (char)(0x80 | (c & 0x3F));
+        }
     }
-    ascii[len] = '\0';
+    out[o] = '\0';
 }
 
 uint32_t read_uint32_le(const unsigned char *data) {